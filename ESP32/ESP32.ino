@@ -1,80 +1,55 @@
 #include <Arduino.h> 
 #include <WiFi.h>
 #include <Firebase_ESP_Client.h>
-#include "initSetup.h"
-#include "firestoreServices.h"
+#include "InitSetup.h"
+#include "FirestoreServices.h"
 #include "command.h"
-#include "modeHandler.h"
-#include "ntpTime.h"
+#include "irTransmitter.h"
+#include "ledAnimation.h"
+#include "buzzer.h"
+#include "deadlines.h"
+#include "deviceTasks.h"
+#include "powerSave.h"
+#include "radar.h"
+#include "sensorHistory.h"
+#include "configStore.h"
+#include "bootReport.h"
+#include "metrics.h"
 #include "sensors.h"
 #include "log.h"
 
-//unsigned long countyy = 0;
-
-// --- Firebase Task ---
-/*
-void firebaseTask(void* parameter) {
-  initFirebase();  // Init stream, load state
-  initIR();        // IR init
-
-  while (true) {
-    if (WiFi.status() == WL_CONNECTED) {
-      Firebase.ready();             // Refresh Firebase token
-      updateOnlineStatus();        // Heartbeat
-      updateSensorReadings();      // Push sensors
-      updateTotalHours();          // Maintenance
-      handleFirebaseStream();      // Stream listen
-      handleMode();                // Mode handler
-    }
-    delay(200); // Avoid CPU overload
-  }
-}
-*/
-
 // ----------------------- Setup -----------------------
+// Nothing here waits on the network: the AC is under local control from the
+// state saved in NVS, and the network task brings up the station, the clock,
+// the LAN API and the cloud behind it (bootReport.h).
 void setup() {
   Serial.begin(115200);
-  initSetup();
-/*
-  if (WiFi.status() == WL_CONNECTED) {
-    initTime(); // NTP time
-
-    // 🎯 Launch Firebase task with bigger stack
-    xTaskCreatePinnedToCore(
-      firebaseTask,       // Task function
-      "FirebaseTask",     // Name
-      10000,              // Stack size in words (10,000 * 4 = 40 KB)
-      NULL,               // Parameters
-      1,                  // Priority
-      NULL,               // Task handle
-      1                   // Core (typically 1 for WiFi/Firebase)
-    );
-  }
-  */
-  if(WiFi.status() == WL_CONNECTED){
-    initTime();
-    delay(5000);
-    initFirebase();
-    initIR();
-  }
+  startLogTask();
+  loadConfigStore();
+  bootMark(BOOT_CONFIG);
+  initSetup(); // starts joining the stored network
+  initWakeSources();
+  if (!isProvisioned()) return;
+  initFirebase();
+  restoreCachedState();
+  bootMark(BOOT_STATE);
+  initSensorHistory();
+  initIR();
+  setPowerSave(POWER_SAVE_DEFAULT);
+  startDeviceTasks();
+  startRadar();
+  bootMark(BOOT_CONTROL);
 }
 
 void loop() {
-/*  if (millis() - countyy > 5000) {
-    countyy = millis();
-    LOGF("Free heap: %u", ESP.getFreeHeap());
-    LOGF("Free stack: %u", uxTaskGetStackHighWaterMark(NULL));
-  }*/
   if (isButtonPressed()) resetDevice(); // Factory reset
   if (WiFi.getMode() == WIFI_AP) {
+    unsigned long startUs = micros();
+    runDueDeadlines(controlDeadlines); // IR, LEDs and buzzer
     handleWebRequests(); // Setup mode handler
+    recordMetricUs(METRIC_LOOP, micros() - startUs);
   }
-  else if (WiFi.status() == WL_CONNECTED) {
-    Firebase.ready();
-    updateOnlineStatus();
-    updateSensorReadings();
-    handleFirebaseStream();
-    updateTotalHours();
-    handleMode();
+  else {
+    waitForButton(60 * 1000UL); // the device tasks do the rest
   }
-}
\ No newline at end of file
+}
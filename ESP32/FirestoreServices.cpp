@@ -3,39 +3,49 @@
 #include <addons/RTDBHelper.h>
 #include <addons/TokenHelper.h>
 #include <Preferences.h>
-#include "firestoreServices.h"
+#include "FirestoreServices.h"
 #include "command.h"
 #include "log.h"
 #include "secrets.h"
 #include "parameters.h"
 #include "sensors.h"
 #include "modeHandler.h"
+#include "buzzer.h"
+#include "deviceTasks.h"
+#include "scheduleEngine.h"
+#include "rtdbPublisher.h"
+#include "deadlines.h"
+#include "sensorHistory.h"
+#include "stateJournal.h"
+#include "jsonScan.h"
+#include "configStore.h"
+#include "bootReport.h"
+#include "ntpTime.h"
+#include "InitSetup.h"
+#include "lanApi.h"
+#include "metrics.h"
+#include "sensorFilter.h"
+#include "airQuality.h"
 
 
 FirebaseAuth auth;
 FirebaseConfig config;
 FirebaseData commandFbdo;
 FirebaseData accessFbdo;
-FirebaseData statusFbdo;
-FirebaseData resultFbdo;
-FirebaseData notifyFbdo;
-FirebaseData maintenanceFbdo;
-FirebaseData sensorFbdo;
-FirebaseJson commandData;
 String deviceMacPath;
 
 bool testMode = false;
 bool lights_on = false;
 bool relay_on = false;
-String model = "Electra";
-String mode = "regular";
+AcModel model = MODEL_ELECTRA;
+AcMode mode = MODE_REGULAR;
 bool acPowered = false;
 float totalHours = 0.0;
 int duration = 30;
 bool shouldBuzz = true;
 float currTemp = 24;
 bool ecoCanTurnOn = true;
-String idleFlag = "active";
+IdleFlag idleFlag = IDLE_ACTIVE;
 WeeklySchedule schedule;
 
 
@@ -43,16 +53,222 @@ WeeklySchedule schedule;
 void onCommandDataChange(FirebaseStream data);
 void onCommandStreamTimeout(bool timeout);
 void updateTotalHours();
-void initLastState(FirebaseJson& json);
-void loadScheduleFromJson(FirebaseJson &json);
-void handleFirebaseStream();
 void updateOnlineStatus();
 void updateSensorReadings();
 void fetchSchedule();
 void notifyUser(const String& prompt);
 void resetDevice();
 
+// The last state as the device node holds it. It is filled in place from
+// the scanned responses (jsonScan.h) and the journal, so restoring it needs
+// no heap beyond the response body being read.
+#define STORED_TEXT_LEN 16
+
+// A day holds either intervals/[i]/{start,end} or, as the app has always
+// written it, a single start/end pair, kept aside until the day is done.
+struct StoredSchedule {
+    WeeklySchedule week;
+    ScheduleInterval legacy[7];
+    bool hasLegacy[7];
+};
+
+struct StoredState {
+    char model[STORED_TEXT_LEN];
+    bool testing;
+    float currentTemperature;
+    char idleFlag[STORED_TEXT_LEN];
+    char mode[STORED_TEXT_LEN];
+    int currentTimer;
+    bool lightsOn;
+    bool relayOn;
+    bool powered;
+    float totalHours;
+    StoredSchedule schedule;
+};
+
+enum StoredType : uint8_t { STORED_TEXT, STORED_BOOL, STORED_INT, STORED_FLOAT };
+
+struct StoredField {
+    const char* path;
+    StoredType type;
+    size_t offset;
+};
+
+static const StoredField storedFields[] = {
+    {"/config/model", STORED_TEXT, offsetof(StoredState, model)},
+    {"/config/testing", STORED_BOOL, offsetof(StoredState, testing)},
+    {"/status/currentTemperature", STORED_FLOAT, offsetof(StoredState, currentTemperature)},
+    {"/status/idleFlag", STORED_TEXT, offsetof(StoredState, idleFlag)},
+    {"/status/mode", STORED_TEXT, offsetof(StoredState, mode)},
+    {"/status/currentTimer", STORED_INT, offsetof(StoredState, currentTimer)},
+    {"/status/lightsOn", STORED_BOOL, offsetof(StoredState, lightsOn)},
+    {"/status/relayOn", STORED_BOOL, offsetof(StoredState, relayOn)},
+    {"/status/powered", STORED_BOOL, offsetof(StoredState, powered)},
+    {"/maintenance/totalHours", STORED_FLOAT, offsetof(StoredState, totalHours)},
+};
+
+static const char* const scheduleDays[] = {"sunday", "monday", "tuesday", "wednesday", "thursday", "friday", "saturday"};
+
+static StoredState stored;
+
+static DaySchedule* scheduleDay(WeeklySchedule& week, int i) {
+    DaySchedule* days[] = {&week.sun, &week.mon, &week.tue, &week.wed, &week.thu, &week.fri, &week.sat};
+    return days[i];
+}
 
+static const StoredField* findStoredField(const char* path) {
+    for (const StoredField& field : storedFields) {
+        if (strcmp(field.path, path) == 0) return &field;
+    }
+    return nullptr;
+}
+
+// Paths below /schedule, e.g. "/schedule/monday/intervals/[0]/start".
+static void storeScheduleScalar(const JsonScalar& value, void* context) {
+    StoredSchedule& out = *(StoredSchedule*)context;
+    if (strncmp(value.path, "/schedule/", 10) != 0) return;
+    const char* path = value.path + 10;
+    for (int i = 0; i < 7; ++i) {
+        size_t n = strlen(scheduleDays[i]);
+        if (strncmp(path, scheduleDays[i], n) != 0 || path[n] != '/') continue;
+        const char* key = path + n + 1;
+        DaySchedule* d = scheduleDay(out.week, i);
+        int index;
+        char end[6];
+        if (strcmp(key, "active") == 0) {
+            d->active = jsonBool(value);
+        } else if (strcmp(key, "start") == 0) {
+            out.legacy[i].start = jsonInt(value);
+            out.hasLegacy[i] = true;
+        } else if (strcmp(key, "end") == 0) {
+            out.legacy[i].end = jsonInt(value);
+        } else if (sscanf(key, "intervals/[%d]/%5s", &index, end) == 2 && index >= 0 &&
+                   index < SCHEDULE_MAX_INTERVALS) {
+            if (strcmp(end, "start") == 0) {
+                d->intervals[index].start = jsonInt(value);
+                if (d->count <= index) d->count = index + 1;
+            } else if (strcmp(end, "end") == 0) {
+                d->intervals[index].end = jsonInt(value);
+            }
+        }
+        return;
+    }
+}
+
+static void storeScalar(const JsonScalar& value, void* context) {
+    StoredState& state = *(StoredState*)context;
+    const StoredField* field = findStoredField(value.path);
+    if (!field) {
+        storeScheduleScalar(value, &state.schedule);
+        return;
+    }
+    char* at = (char*)&state + field->offset;
+    switch (field->type) {
+        case STORED_TEXT: jsonString(value, at, STORED_TEXT_LEN); break;
+        case STORED_BOOL: *(bool*)at = jsonBool(value); break;
+        case STORED_INT: *(int*)at = jsonInt(value); break;
+        case STORED_FLOAT: *(float*)at = jsonFloat(value); break;
+    }
+}
+
+static void storeJournaled(StoredState& state, const NetRequest& request) {
+    const StoredField* field = findStoredField(request.path);
+    if (!field) return;
+    char* at = (char*)&state + field->offset;
+    switch (request.op) {
+        case NET_SET_STRING:
+            if (field->type == STORED_TEXT) snprintf(at, STORED_TEXT_LEN, "%s", request.s);
+            break;
+        case NET_SET_BOOL:
+            if (field->type == STORED_BOOL) *(bool*)at = request.b;
+            break;
+        case NET_SET_INT:
+            if (field->type == STORED_INT) *(int*)at = request.i;
+            if (field->type == STORED_FLOAT) *(float*)at = request.i;
+            break;
+        case NET_SET_FLOAT:
+            if (field->type == STORED_FLOAT) *(float*)at = request.f;
+            break;
+        default: break;
+    }
+}
+
+static WeeklySchedule storedSchedule(const StoredSchedule& in) {
+    WeeklySchedule week = in.week;
+    for (int i = 0; i < 7; ++i) {
+        DaySchedule* d = scheduleDay(week, i);
+        if (d->count == 0 && in.hasLegacy[i]) {
+            d->intervals[0] = in.legacy[i];
+            d->count = 1;
+        }
+    }
+    return week;
+}
+
+// Reads one part of the device node, e.g. "/status", through `store`. A part
+// that is not there is not an error; `exists` tells them apart.
+static bool readStored(const char* part, JsonScanCallback store, void* context, bool& exists) {
+    accessFbdo.clear();
+    unsigned long startUs = micros();
+    exists = Firebase.RTDB.getJSON(&accessFbdo, deviceMacPath + part);
+    recordMetricUs(METRIC_RTDB_READ, micros() - startUs);
+    if (!exists) {
+        bool missing = accessFbdo.errorReason() == "path not exist";
+        if (!missing) {
+            countMetric(METRIC_RTDB_ERRORS);
+            LOGF_ERROR("❌ Failed to read %s: %s", part, accessFbdo.errorReason().c_str());
+        }
+        accessFbdo.clear();
+        return missing;
+    }
+    if (!scanJson(accessFbdo.payload().c_str(), part, store, context)) {
+        LOGF_WARN("⚠️ Unreadable %s, restored what came before the error", part);
+    }
+    accessFbdo.clear();
+    return true;
+}
+
+static void initLastState(const StoredState& state);
+
+static bool beginCommandStream() {
+    unsigned long startUs = micros();
+    bool ok = Firebase.RTDB.beginStream(&commandFbdo, deviceMacPath + "/command");
+    recordMetricUs(METRIC_RTDB_STREAM, micros() - startUs);
+    if (!ok) countMetric(METRIC_RTDB_ERRORS);
+    return ok;
+}
+
+// The state as the control task last left it, kept through the config store
+// so a restart shows it before the network is up. Captured in the layout of
+// StoredState, zero-filled, so an unchanged state compares equal.
+#define CACHED_STATE_VERSION 1
+
+struct CachedState {
+    uint8_t version;
+    StoredState state;
+};
+
+// The state right after the NVS restore. A field that differs from it when
+// the cloud's state arrives was changed here since boot and is kept.
+static StoredState bootState;
+
+static void captureState(StoredState& state) {
+    memset(&state, 0, sizeof(state));
+    strncpy(state.model, acModelName(model), STORED_TEXT_LEN - 1);
+    state.testing = testMode;
+    state.currentTemperature = currTemp;
+    strncpy(state.idleFlag, idleFlagName(idleFlag), STORED_TEXT_LEN - 1);
+    strncpy(state.mode, acModeName(mode), STORED_TEXT_LEN - 1);
+    state.currentTimer = duration;
+    state.lightsOn = lights_on;
+    state.relayOn = relay_on;
+    state.powered = acPowered;
+    state.totalHours = totalHours;
+    state.schedule.week = schedule;
+}
+
+// No network here: the sign-in, the state in the node and the stream come
+// later, from connectCloud() on the network task.
 void initFirebase() {
     #if defined(ESP32)
     accessFbdo.setBSSLBufferSize(4096, 1024);
@@ -72,96 +288,214 @@ void initFirebase() {
     auth.user.email = AuthEmail;
     auth.user.password = AuthPass;
 
-    Firebase.begin(&config, &auth);
-    Firebase.reconnectWiFi(true);
-    LOG_INFO("\nFirebase Authenticating");
-    while (auth.token.uid == "") {
-        Serial.print(".");
-        delay(200);
-    }
-    LOG_INFO("\nFirebase Authenticated!");
     String mac = WiFi.macAddress();
     mac.replace(":", "");
     deviceMacPath = "/devices/" + mac;
+    initRtdbPublisher(deviceMacPath);
+}
 
-    // 🔍 Check if the device node exists
-    accessFbdo.clear();
-    if (!Firebase.RTDB.getJSON(&accessFbdo, deviceMacPath)) {
-        LOG_WARN("📭 Device data does not exist — Initializing...");
-        return;
+void restoreCachedState() {
+    CachedState cached;
+    if (configBytes(CONFIG_LAST_STATE, &cached, sizeof(cached)) && cached.version == CACHED_STATE_VERSION) {
+        LOG_INFO("💾 Last state restored from flash");
+        initLastState(cached.state);
     } else {
-        LOG_INFO("📦 Device data already exists - Recovering Last State...");
-        initLastState(accessFbdo.to<FirebaseJson>());
+        // Nothing saved by this firmware yet: the model from provisioning,
+        // the rest once the cloud answers.
+        parseAcModel(configString(CONFIG_MODEL), model);
+        ecoCanTurnOn = configBool(CONFIG_ECO_CAN_TURN_ON);
     }
-    accessFbdo.clear();
-    // 🎧 Start stream
-    if (!Firebase.RTDB.beginStream(&commandFbdo, deviceMacPath + "/command")) {
-        LOGF("⚠️ Failed to start command stream: %s", commandFbdo.errorReason().c_str());
-        return;
+    captureState(bootState);
+}
+
+// Control task, after every wake. Committed once the state has been quiet
+// for CONFIG_COMMIT_DELAY_MS, and not at all if it ends up as saved. The room
+// temperature and the idle flag follow the sensors and are measured again
+// after a restart, so they are saved along with a change but never cause one.
+void saveLastState() {
+    CachedState saved;
+    bool haveSaved = configBytes(CONFIG_LAST_STATE, &saved, sizeof(saved)) &&
+                     saved.version == CACHED_STATE_VERSION;
+    CachedState cached;
+    memset(&cached, 0, sizeof(cached));
+    cached.version = CACHED_STATE_VERSION;
+    captureState(cached.state);
+    if (haveSaved) {
+        cached.state.currentTemperature = saved.state.currentTemperature;
+        memcpy(cached.state.idleFlag, saved.state.idleFlag, STORED_TEXT_LEN);
+        if (memcmp(&cached, &saved, sizeof(cached)) == 0) return;
+        captureState(cached.state);
+    }
+    setConfigBytes(CONFIG_LAST_STATE, &cached, sizeof(cached));
+}
+
+static size_t storedSize(StoredType type) {
+    switch (type) {
+        case STORED_TEXT: return STORED_TEXT_LEN;
+        case STORED_BOOL: return sizeof(bool);
+        case STORED_INT: return sizeof(int);
+        case STORED_FLOAT: return sizeof(float);
+    }
+    return 0;
+}
+
+// Control task: the node's state, with the journal over it, as the network
+// task read it into `stored`.
+void applyCloudState() {
+    StoredState current;
+    captureState(current);
+    StoredState merged = stored;
+    int kept = 0;
+    for (const StoredField& field : storedFields) {
+        const char* now = (const char*)&current + field.offset;
+        if (memcmp(now, (const char*)&bootState + field.offset, storedSize(field.type)) != 0) {
+            memcpy((char*)&merged + field.offset, now, storedSize(field.type));
+            kept++;
+        }
     }
-    else {
-        Firebase.RTDB.setStreamCallback(&commandFbdo, onCommandDataChange, onCommandStreamTimeout);
+    WeeklySchedule week = storedSchedule(stored.schedule);
+    if (memcmp(&current.schedule.week, &bootState.schedule.week, sizeof(WeeklySchedule)) != 0) {
+        week = current.schedule.week;
+        kept++;
     }
+    memset(&merged.schedule, 0, sizeof(merged.schedule));
+    merged.schedule.week = week;
+    AcModel was = model;
+    initLastState(merged);
+    if (model != was) initIR();
+    captureState(bootState);
+    bootMark(BOOT_CLOUD_STATE);
+    LOGF("☁️ Cloud state applied, %d local change(s) kept", kept);
 }
 
-void loadScheduleFromJson(FirebaseJson &json) {
-  FirebaseJsonData result;
-  const char* days[] = {"sunday", "monday", "tuesday", "wednesday", "thursday", "friday", "saturday"};
-  DaySchedule* dayPtrs[] = {
-    &schedule.sun, &schedule.mon, &schedule.tue, &schedule.wed,
-    &schedule.thu, &schedule.fri, &schedule.sat
-  };
+// Bring-up on the network task, a stage per call until it waits: the
+// station, the sign-in, the node's state, then the stream. Writes stay in
+// the publisher (and its journal) until the stream is open.
+enum CloudStage : uint8_t { CLOUD_WIFI, CLOUD_AUTH, CLOUD_STATE, CLOUD_STREAM, CLOUD_UP };
+
+static CloudStage cloudStage = CLOUD_WIFI;
+static unsigned long wifiBegunMs = 0; // setup() started the first join
+
+// Reads the parts of the node the device restores into `stored` and hands
+// them to the control task. False to try again later.
+static bool readCloudState() {
+    memset(&stored, 0, sizeof(stored));
+    // 🔍 Check if the device node exists. Only the parts the device restores
+    // are read, one at a time, so the users, sensors and history the app
+    // keeps next to them never come down.
+    bool exists;
+    if (!readStored("/config", storeScalar, &stored, exists)) return false;
+    if (!exists) {
+        LOG_WARN("📭 Device data does not exist — Initializing...");
+        bootMark(BOOT_CLOUD_STATE);
+        return true;
+    }
+    LOG_INFO("📦 Device data already exists - Recovering Last State...");
+    const char* parts[] = {"/status", "/maintenance", "/schedule"};
+    for (const char* part : parts) {
+        if (!readStored(part, storeScalar, &stored, exists)) return false;
+    }
+    if (journalPending()) { // changes the cloud never got win over it
+        NetRequest journal[JOURNAL_MAX_PATHS];
+        size_t n = loadJournal(journal, JOURNAL_MAX_PATHS);
+        for (size_t i = 0; i < n; i++) storeJournaled(stored, journal[i]);
+    }
+    ControlEvent event = {};
+    event.type = CONTROL_RESTORE;
+    return postControlEvent(event);
+}
 
-  for (int i = 0; i < 7; ++i) {
-    String path = "schedule/" + String(days[i]) + "/active";
-    json.get(result, path);  dayPtrs[i]->active = result.to<bool>();
+unsigned long connectCloud() {
+    if (cloudStage != CLOUD_WIFI && !bootReached(BOOT_TIME) && timeSynced()) bootMark(BOOT_TIME);
+    for (;;) {
+        switch (cloudStage) {
+            case CLOUD_WIFI:
+                if (WiFi.status() != WL_CONNECTED) {
+                    if (millis() - wifiBegunMs >= WIFI_REJOIN_MS) {
+                        LOG_WARN("⏱️ Wi-Fi join timed out, starting over");
+                        connectToWifi();
+                        wifiBegunMs = millis();
+                    }
+                    return CLOUD_POLL_MS;
+                }
+                LOG_INFO("✅ Connected to Wi-Fi!");
+                bootMark(BOOT_WIFI);
+                startTimeSync();
+                startLanApi();
+                LOG_INFO("Firebase Authenticating");
+                Firebase.begin(&config, &auth);
+                Firebase.reconnectWiFi(true);
+                cloudStage = CLOUD_AUTH;
+                break;
+            case CLOUD_AUTH:
+                if (auth.token.uid == "") Firebase.ready(); // signs in if begin() could not
+                if (auth.token.uid == "") return CLOUD_POLL_MS;
+                LOG_INFO("Firebase Authenticated!");
+                bootMark(BOOT_AUTH);
+                cloudStage = CLOUD_STATE;
+                break;
+            case CLOUD_STATE:
+                if (!readCloudState()) return CLOUD_RETRY_MS;
+                accessFbdo.clear();
+                cloudStage = CLOUD_STREAM;
+                break;
+            case CLOUD_STREAM:
+                // 🎧 Start stream
+                if (!beginCommandStream()) {
+                    LOGF_WARN("⚠️ Failed to start command stream: %s", commandFbdo.errorReason().c_str());
+                    return CLOUD_RETRY_MS;
+                }
+                Firebase.RTDB.setStreamCallback(&commandFbdo, onCommandDataChange, onCommandStreamTimeout);
+                bootMark(BOOT_STREAM);
+                rtdbPublisherOnline();
+                logBootReport();
+                cloudStage = CLOUD_UP;
+                break;
+            case CLOUD_UP:
+                // SNTP may still be on its way; the schedule waits for it.
+                if (!bootReached(BOOT_TIME) && !timeSynced()) return CLOUD_CLOCK_MS;
+                bootMark(BOOT_TIME);
+                return 0;
+        }
+    }
+}
 
-    path = "schedule/" + String(days[i]) + "/start";
-    json.get(result, path);  dayPtrs[i]->startHour = result.to<int>();
+bool cloudConnected() {
+    return cloudStage == CLOUD_UP;
+}
 
-    path = "schedule/" + String(days[i]) + "/end";
-    json.get(result, path);  dayPtrs[i]->endHour = result.to<int>();
-  }
-    alreadyTurnedOn = false;
-    alreadyTurnedOff = false;
+// Control task: a schedule fetched by the network task replaces the current one.
+void applySchedule(const WeeklySchedule& fetched) {
+    schedule = fetched;
+    compileSchedule(schedule);
 }
 
-void initLastState(FirebaseJson& json){
-    FirebaseJsonData result;
-    json.get(result, "config/model");
-    model = result.stringValue;
-    json.get(result, "status/currentTemperature");
-    currTemp = result.floatValue;
-    json.get(result, "status/idleFlag");
-    idleFlag = result.stringValue;
-    json.get(result, "status/mode");
-    mode = result.stringValue;
-    json.get(result, "config/testing");
-    testMode = result.boolValue;
-    json.get(result, "status/currentTimer");
-    duration = testMode ? 1 : result.intValue;
-    json.get(result, "status/lightsOn");
-    lights_on = result.boolValue;
-    json.get(result, "status/relayOn");
-    relay_on = result.boolValue;
-    json.get(result, "status/powered");
-    acPowered = result.boolValue;
-    json.get(result, "maintenance/totalHours");
-    totalHours = result.floatValue;
-    Preferences prefs;
-    prefs.begin("eco", true);
-    ecoCanTurnOn = prefs.getBool("ecoCanTurnOn", true);
-    prefs.end();
-    loadScheduleFromJson(json);
-    if(lights_on){
-        lights_on= false;
+static void initLastState(const StoredState& state){
+    float shownTemp = currTemp;
+    if (!parseAcModel(state.model, model)) {
+        LOGF_WARN("🚫 Unknown AC model: '%s', using the learned IR codes.", state.model);
+        model = MODEL_CUSTOM;
+    }
+    currTemp = state.currentTemperature;
+    parseIdleFlag(state.idleFlag, idleFlag);
+    parseAcMode(state.mode, mode);
+    testMode = state.testing;
+    duration = testMode ? 1 : state.currentTimer;
+    acPowered = state.powered;
+    if (acPowered) noteCommand(); // motion mode counts from the boot, not from nobody
+    totalHours = state.totalHours;
+    ecoCanTurnOn = configBool(CONFIG_ECO_CAN_TURN_ON);
+    applySchedule(storedSchedule(state.schedule));
+    // Only what differs from what is shown is rendered again.
+    if (state.lightsOn != lights_on) {
         switchLed();
-        lights_on = true;
+        lights_on = state.lightsOn;
+    } else if (lights_on && currTemp != shownTemp) {
+        validateLedColor();
     }
-    if(relay_on){
-        relay_on = false;
+    if (state.relayOn != relay_on) {
         switchRelay();
-        relay_on = true;
+        relay_on = state.relayOn;
     }
     float capacityHours = testMode ? 1 : 250;
     if(totalHours >= capacityHours){
@@ -169,71 +503,95 @@ void initLastState(FirebaseJson& json){
     }
 }
 
-void handleFirebaseStream() {
-    if (!Firebase.RTDB.readStream(&commandFbdo)) {
-        delay(500);
+
+// Control-side writes: the value is copied into a NetRequest and staged by
+// the network task, which combines writes into multi-path updates.
+static NetRequest netRequest(NetOp op, const char* path, const char* okLog,
+                             PublishPriority priority = PUBLISH_SOON) {
+    NetRequest request = {};
+    request.op = op;
+    request.priority = priority;
+    snprintf(request.path, sizeof(request.path), "%s", path);
+    request.okLog = okLog;
+    return request;
+}
+
+static void publishString(const char* path, const String& value, const char* okLog,
+                          PublishPriority priority = PUBLISH_SOON) {
+    NetRequest request = netRequest(NET_SET_STRING, path, okLog, priority);
+    snprintf(request.s, sizeof(request.s), "%s", value.c_str());
+    postNetRequest(request);
+}
+
+static void publishBool(const char* path, bool value, const char* okLog) {
+    NetRequest request = netRequest(NET_SET_BOOL, path, okLog);
+    request.b = value;
+    postNetRequest(request);
+}
+
+static void publishFloat(const char* path, float value, const char* okLog, PublishPriority priority) {
+    NetRequest request = netRequest(NET_SET_FLOAT, path, okLog, priority);
+    request.f = value;
+    postNetRequest(request);
+}
+
+// Network task.
+void performNetRequest(const NetRequest& request) {
+    if (request.op == NET_FETCH_SCHEDULE) {
+        fetchSchedule();
+    } else if (request.op == NET_HISTORY) {
+        uploadHistoryBatch();
+    } else {
+        rtdbPublish(request);
     }
 }
 
+// Runs on the library's stream task: the command is only parsed here and
+// executed by the control task.
 void onCommandDataChange(FirebaseStream data) {
     if (data.dataType() != "json") {
         return;
     }
+    LOG_INFO("📦 Received New Command - Executing...");
+    postCommandJson(data.to<FirebaseJson>());
+}
+
+bool postCommandJson(FirebaseJson& commandData) {
     FirebaseJsonData result;
-    commandData.clear();
-    commandData = data.to<FirebaseJson>();
+    ControlEvent event = {};
+    event.type = CONTROL_COMMAND;
     commandData.get(result, "action");
-    String action = result.stringValue;
-    LOG_INFO("📦 Received New Command - Executing...");
-    String commandResult = "Success";
-    if(action == "set_mode"){
+    event.action = lookupCommandAction(result.stringValue.c_str());
+    if (event.action == ACTION_UNKNOWN) {
+        LOGF_WARN("🚫 Unknown action '%s'", result.stringValue.c_str());
+    }
+    // Only the fields the action declares are read.
+    uint8_t args = commandSpec(event.action).args;
+    event.mode = AC_MODES;
+    if (args & COMMAND_ARG_MODE) {
         result.clear();
         commandData.get(result, "mode");
-        if(mode != result.stringValue){
-            mode = result.stringValue;
-            if(mode == "timer" && !testMode){
-                commandData.get(result, "duration");
-                duration = result.intValue;
-            }
-            if(mode == "motion"){
-                lastMotionMillis = millis();
-           }
-        }
+        parseAcMode(result.stringValue.c_str(), event.mode);
     }
-    else if(action == "apply_schedule"){
-        fetchSchedule();
-    }
-    else if(action == "reset_maintenance"){
-        shouldBuzz = true;
-        totalHours = 0.0;
-    }
-    else if(action == "ignore_motion"){
-        idleFlag = "continue";
-    }
-    else if(action == "switch_lights"){
-        switchLed();
-        lights_on = !lights_on;
-    }
-    else if(action == "switch_relay"){
-        switchRelay();
-        relay_on = !relay_on;
-    }
-    else if(action == "reset_device"){
-        resetDevice();
-    }
-    else{
-        commandResult = execute(action) ? "Success" : "Failed";
-    }
-    resultFbdo.clear();
-    if(Firebase.RTDB.setString(&resultFbdo, deviceMacPath + "/result", commandResult)){
-        LOG_INFO("Command Executed");
-    }
-    else{
-        LOGF("❌ Failed To Send Result: %s", resultFbdo.errorReason().c_str());
+    if (args & COMMAND_ARG_DURATION) {
+        result.clear();
+        commandData.get(result, "duration");
+        event.duration = result.intValue;
     }
-    commandData.clear();
-    resultFbdo.clear();
-    return;
+    return postControlEvent(event);
+}
+
+// Control task.
+void handleCommand(const ControlEvent& command) {
+    bool ok = runCommand(command);
+    countMetric(METRIC_COMMANDS);
+    playBuzzerPattern(ok ? BUZZER_ACK : BUZZER_ERROR);
+    // An acknowledgement, not state: replayed from the journal it would
+    // read as the result of a new command.
+    NetRequest result = netRequest(NET_SET_STRING, "/result", "Command Executed", PUBLISH_NOW);
+    snprintf(result.s, sizeof(result.s), "%s", ok ? "Success" : "Failed");
+    result.transient = true;
+    postNetRequest(result);
 }
 
 void onCommandStreamTimeout(bool timeout) {
@@ -245,6 +603,7 @@ void onCommandStreamTimeout(bool timeout) {
     if (!timeout) return;
 
     LOG_WARN("⚠️ Stream timed out — attempting to reconnect...");
+    countMetric(METRIC_STREAM_TIMEOUTS);
 
     unsigned long now = millis();
     if (now - lastReconnectAttempt < RECONNECT_COOLDOWN_MS) {
@@ -255,187 +614,174 @@ void onCommandStreamTimeout(bool timeout) {
     lastReconnectAttempt = now;
     retryCount++;
 
-    if (Firebase.RTDB.beginStream(&commandFbdo, deviceMacPath + "/command")) {
+    if (beginCommandStream()) {
+        countMetric(METRIC_STREAM_RECONNECTS);
         LOG_INFO("🔄 Stream reconnected successfully.");
         retryCount = 0;  // reset on success
     } else {
-        LOGF("❌ Stream reconnect failed (Attempt %d): %s", retryCount, commandFbdo.errorReason().c_str());
+        LOGF_ERROR("❌ Stream reconnect failed (Attempt %d): %s", retryCount, commandFbdo.errorReason().c_str());
         if (retryCount >= MAX_RETRIES) {
             LOG_ERROR("🚨 Max stream retry attempts reached. Consider resetting the device or switching to AP mode.");
             delay(100);
             LOG_INFO("Restarting ESP...");
+            flushConfigStore();
+            logFlush();
             ESP.restart();
         }
     }
 }
 
+// Network task, every HEARTBEAT_INTERVAL.
 void updateOnlineStatus() {
-    unsigned long now = millis();
-    static unsigned long lastPush = 0;
-    if (now - lastPush >= HEARTBEAT_INTERVAL) {
-        unsigned long timestamp = time(nullptr);
-        statusFbdo.clear();
-        if (Firebase.RTDB.setInt(&statusFbdo, deviceMacPath + "/status/online", timestamp)) {
-            lastPush = now;
-            LOG_INFO("📶 Online heartbeat sent");
-        } else {
-            LOGF("❌ Failed to send heartbeat: %s", statusFbdo.errorReason().c_str());
-        }
-        statusFbdo.clear();
+    NetRequest heartbeat = netRequest(NET_SET_INT, "/status/online", "📶 Online heartbeat sent");
+    heartbeat.i = time(nullptr);
+    heartbeat.transient = true;
+    rtdbPublish(heartbeat);
+}
+
+static bool motion = false;
+static bool currMotion = false;
+static float currRoomTemp = 0.0;
+static float currRoomHum = 0.0;
+static unsigned long lastSensorPush = 0;
+
+// DHT11 readings, in hundredths. The rate limits allow a couple of degrees a
+// minute, faster than a room changes; the bands are the change thresholds.
+static const SensorFilterConfig tempFilterConfig = {
+    -1000, 6000, 5, 64, 50, (int32_t)(TEMP_CHANGE_THRESHOLD * 100),
+};
+static const SensorFilterConfig humFilterConfig = {
+    100, 10000, 5, 64, 200, (int32_t)(HUM_CHANGE_THRESHOLD * 100),
+};
+static SensorFilter tempFilter = {&tempFilterConfig};
+static SensorFilter humFilter = {&humFilterConfig};
+
+static void uploadSensorReadings();
+static Deadline sensorUploadDeadline = {"upload", uploadSensorReadings};
+
+static void uploadSensorReadings() {
+    NetRequest request = netRequest(NET_SENSORS, "/sensors", "📶 Sensor Readings sent", PUBLISH_LAZY);
+    // At the sensor's resolution, as the history keeps them.
+    request.sensors.temperature = roundf(currRoomTemp * 10) / 10;
+    request.sensors.humidity = roundf(currRoomHum);
+    request.sensors.motion = currMotion;
+    request.sensors.air = airQualityValid();
+    request.sensors.eco2 = airQualityEco2();
+    request.sensors.tvoc = airQualityTvoc();
+    request.transient = true;
+    if (postNetRequest(request)) {
+        lastSensorPush = millis();
+    } else {
+        armDeadline(sensorDeadlines, sensorUploadDeadline, READ_INTERVAL);
     }
 }
 
+static void queueSensorUpload() {
+    if (deadlineArmed(sensorUploadDeadline)) return;
+    unsigned long sinceLast = millis() - lastSensorPush;
+    armDeadline(sensorDeadlines, sensorUploadDeadline,
+                lastSensorPush == 0 || sinceLast >= SENSORS_INTERVAL ? 0 : SENSORS_INTERVAL - sinceLast);
+}
+
+// Sensor task, every READ_INTERVAL: the DHT readings go through their
+// filters (sensorFilter.h), and a change of motion or of a reported value
+// is uploaded at most once per SENSORS_INTERVAL, as soon as the interval
+// since the last upload allows. Uploads carry the latest filtered values,
+// and the air quality (airQuality.h) once there is one; while a reading is
+// lost they keep the last one.
 void updateSensorReadings() {
-    unsigned long now = millis();
-    static unsigned long lastRead = 0;
-    static unsigned long lastPush = 0;
-    static bool motion = false;
-    static float roomTemp = 0.0;
-    static float roomHum = 0.0;
-    static bool currMotion = false;
-    static float currRoomTemp = 0.0;
-    static float currRoomHum = 0.0;
-    static bool shouldUpdate = false;
-    if(now - lastRead > READ_INTERVAL){
-        lastRead = now;
-        currMotion = readMotionSensor();
-        currRoomTemp = readTemperature();
-        currRoomHum = readHumidity();
-        if(currMotion != motion){
-            motion = currMotion;
-            shouldUpdate = true;
-        }
-        if(abs(currRoomTemp - roomTemp) >= TEMP_CHANGE_THRESHOLD){
-            roomTemp = currRoomTemp;
-            shouldUpdate = true;;
-        }
-        if(abs(currRoomHum - roomHum) >= HUM_CHANGE_THRESHOLD){
-            roomHum = currRoomHum;
-            shouldUpdate = true;
-        }
-    }
-    if (now - lastPush >= SENSORS_INTERVAL && shouldUpdate) {
-        FirebaseJson json;
-        json.set("roomHumidity", currRoomHum);
-        json.set("roomTemperature", currRoomTemp);
-        json.set("motion", currMotion);
-        sensorFbdo.clear();
-        if (Firebase.RTDB.updateNode(&sensorFbdo, deviceMacPath + "/sensors", &json)) {
-            lastPush = now;
-            shouldUpdate = false;
-            LOG_INFO("📶 Sensor Readings sent");
-        } else {
-            LOGF("❌ Failed to send sensor readings: %s", sensorFbdo.errorReason().c_str());
-        }
-        sensorFbdo.clear();
+    bool shouldUpdate = false;
+    currMotion = readMotionSensor();
+    shouldUpdate |= filterReading(tempFilter, readTemperature());
+    shouldUpdate |= filterReading(humFilter, readHumidity());
+    if (tempFilter.valid) currRoomTemp = filteredValue(tempFilter);
+    if (humFilter.valid) currRoomHum = filteredValue(humFilter);
+    noteHistoryReading(tempFilter.faults ? NAN : filteredValue(tempFilter),
+                       humFilter.faults ? NAN : filteredValue(humFilter), currMotion);
+    compensateAirQuality(filteredValue(tempFilter), filteredValue(humFilter));
+    if(currMotion != motion){
+        motion = currMotion;
+        shouldUpdate = true;
     }
+    if (shouldUpdate) queueSensorUpload();
+}
+
+// Sensor task, when the CCS811 has a result: uploaded like a DHT change.
+void updateAirQuality() {
+    if (readAirQuality()) queueSensorUpload();
 }
 
+// Network task: the parsed schedule is handed to the control task. No
+// schedule stored means none is active.
 void fetchSchedule() {
-  accessFbdo.clear();
-  if (Firebase.RTDB.getJSON(&accessFbdo, deviceMacPath)) {
-    loadScheduleFromJson(accessFbdo.to<FirebaseJson>());
+  StoredSchedule fetched = {};
+  bool exists;
+  if (!readStored("/schedule", storeScheduleScalar, &fetched, exists)) return;
+  ControlEvent event = {};
+  event.type = CONTROL_SCHEDULE;
+  event.schedule = storedSchedule(fetched);
+  postControlEvent(event);
+  if (exists) {
     LOG_INFO("📥 Schedule fetched");
   } else {
-    LOGF("❌ Failed to load schedule: %s", accessFbdo.errorReason().c_str());
+    LOG_INFO("📥 No schedule stored");
   }
-  accessFbdo.clear();
 }
 
+static void addRunningHours(){
+  totalHours += 0.25;
+  publishFloat("/maintenance/totalHours", totalHours, "Total Hours increased in 15 minutes", PUBLISH_LAZY);
+}
+
+static Deadline hoursDeadline = {"hours", addRunningHours};
+
+// Control task, after every wake: a quarter hour is counted for each full
+// HOURS_UPDATE_INTERVAL the AC stays on.
 void updateTotalHours(){
-  // Track total working hours
-  static unsigned long acOnStartMillis = 0;
   float capacityHours = testMode ? 1 : 250;
-  static bool wasACOn = false;
   if (shouldBuzz && totalHours >= capacityHours) {
-    buzz();
+    playBuzzerPattern(BUZZER_MAINTENANCE);
     shouldBuzz = false;
     notifyUser("maintenance");
   }
-  if (acPowered) {
-    if (!wasACOn) { 
-      acOnStartMillis = millis();  // AC just turned on
-    } else {
-      unsigned long elapsed = millis() - acOnStartMillis;
-      int  hoursUpdateInterval = testMode ? 1 : 15;
-      if (elapsed >= hoursUpdateInterval * MINUTES_CONVERT) {
-        acOnStartMillis = millis();  // reset timer
-        totalHours += 0.25;
-        maintenanceFbdo.clear();
-        if (Firebase.RTDB.setFloat(&maintenanceFbdo, deviceMacPath + "/maintenance/totalHours", totalHours)) {
-            LOG_INFO("Total Hours increased in 15 minutes");
-        } else {
-            LOGF("❌ Failed to update maintenance hours: %s", maintenanceFbdo.errorReason().c_str());
-        }
-        maintenanceFbdo.clear();
-      }
-    }
-  } else {
-    acOnStartMillis = millis();  // Reset if turned off
+  if (acPowered && !deadlineArmed(hoursDeadline)) {
+    hoursDeadline.periodMs = (testMode ? 1 : HOURS_UPDATE_INTERVAL) * MINUTES_CONVERT;
+    armDeadline(controlDeadlines, hoursDeadline, hoursDeadline.periodMs);
+  } else if (!acPowered) {
+    cancelDeadline(hoursDeadline);
   }
-  wasACOn = acPowered;
-
 }
 
 void notifyUser(const String& prompt){
-    notifyFbdo.clear();
     if(prompt == "motion"){
-        if (Firebase.RTDB.setString(&notifyFbdo, deviceMacPath + "/status/idleFlag", idleFlag)) {
-            LOG_INFO("Notified RTDB About Motion");
-        } else {
-            LOGF("❌ Failed to Notify RTDB About Motion: %s", notifyFbdo.errorReason().c_str());
-        }
+        publishString("/status/idleFlag", idleFlagName(idleFlag), "Notified RTDB About Motion");
     }
     else if (prompt == "maintenance"){
-        if (Firebase.RTDB.setBool(&notifyFbdo, deviceMacPath + "/status/maintenanceFlag", !shouldBuzz)) {
-            LOG_INFO("Notified RTDB About Maintenance");
-        } else {
-            LOGF("❌ Failed to Notify RTDB About Maintenance: %s", notifyFbdo.errorReason().c_str());
-        }
-
+        publishBool("/status/maintenanceFlag", !shouldBuzz, "Notified RTDB About Maintenance");
     }
     else if (prompt == "system_switch_power"){
-        if (Firebase.RTDB.setBool(&notifyFbdo, deviceMacPath + "/status/powered", acPowered)) {
-            LOG_INFO("Notified RTDB About System Turn Off");
-        } else {
-            LOGF("❌ Failed to Notify RTDB About System Turn Off: %s", notifyFbdo.errorReason().c_str());
-        }
+        publishBool("/status/powered", acPowered, "Notified RTDB About System Turn Off");
     }
     else if (prompt == "reset_mode"){
-        if (Firebase.RTDB.setString(&notifyFbdo, deviceMacPath + "/status/mode", mode)) {
-            LOG_INFO("Notified RTDB About Resetting Mode");
-        } else {
-            LOGF("❌ Failed to Notify RTDB About Resetting Mode: %s", notifyFbdo.errorReason().c_str());
-        }
+        publishString("/status/mode", acModeName(mode), "Notified RTDB About Resetting Mode");
     }
     else if (prompt == "system_switch_power_due_to_motion"){
-        if (Firebase.RTDB.setBool(&notifyFbdo, deviceMacPath + "/status/powered", acPowered)) {
-            LOG_INFO("Notified RTDB About System Turn Off");
-        } else {
-            LOGF("❌ Failed to Notify RTDB About System Turn Off: %s", notifyFbdo.errorReason().c_str());
-        }
-        idleFlag = "active";
-        if (Firebase.RTDB.setString(&notifyFbdo, deviceMacPath + "/status/idleFlag", idleFlag)) {
-            LOG_INFO("Notified RTDB About Motion Auto Off");
-        } else {
-            LOGF("❌ Failed to Notify RTDB About Motion Auto Off: %s", notifyFbdo.errorReason().c_str());
-        }
+        publishBool("/status/powered", acPowered, "Notified RTDB About System Turn Off");
+        idleFlag = IDLE_ACTIVE;
+        publishString("/status/idleFlag", idleFlagName(idleFlag), "Notified RTDB About Motion Auto Off");
     }
-    notifyFbdo.clear();
-    return;
 }
 
 void resetDevice(){
+    resetLanApi();
+    resetConfigStore();
+    resetStateJournal();
+    resetSensorHistory();
     Preferences prefs;
-    prefs.begin("setup", false);
-    prefs.clear();
-    prefs.end();
     prefs.begin("daytrack", false);
     prefs.clear();
     prefs.end();
-    prefs.begin("eco", false);
-    prefs.clear();
-    prefs.end();
     delay(2000);
+    logFlush();
     ESP.restart();
 }
\ No newline at end of file
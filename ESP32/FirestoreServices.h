@@ -3,24 +3,37 @@
 
 #include <Arduino.h> 
 #include <ArduinoJson.h>
+#include <Firebase_ESP_Client.h>
+#include "deviceState.h"
 
+// Device state. Once startDeviceTasks() has run it belongs to the control
+// task; the other tasks reach it only through the queues in deviceTasks.h.
 extern bool testMode;
 extern bool lights_on;
 extern bool relay_on;
-extern String model;
-extern String mode;
+extern AcModel model;
+extern AcMode mode;
 extern bool acPowered;
 extern float totalHours;
 extern int duration;
 extern bool shouldBuzz;
 extern float currTemp;
-extern String idleFlag;
+extern IdleFlag idleFlag;
 extern bool ecoCanTurnOn;
 
+#define SCHEDULE_MAX_INTERVALS 4
+
+// Times are HHMM local. An interval whose end is not after its start runs
+// past midnight.
+struct ScheduleInterval {
+  int16_t start;
+  int16_t end;
+};
+
 struct DaySchedule {
   bool active;
-  int startHour;
-  int endHour;
+  uint8_t count;
+  ScheduleInterval intervals[SCHEDULE_MAX_INTERVALS];
 };
 
 struct WeeklySchedule {
@@ -35,11 +48,33 @@ struct WeeklySchedule {
 
 extern WeeklySchedule schedule;
 
-void initFirebase();
-void handleFirebaseStream();
-void updateOnlineStatus();
-void updateSensorReadings();
-void updateTotalHours();
+struct ControlEvent;
+struct NetRequest;
+
+// Cloud bring-up on the network task; see connectCloud().
+#define CLOUD_POLL_MS 100     // waiting on the station or the sign-in
+#define CLOUD_RETRY_MS 5000   // after a failed read or stream start
+#define CLOUD_CLOCK_MS 1000   // cloud up, SNTP not answered yet
+#define WIFI_REJOIN_MS 10000  // a join not done by then is started over
+
+void initFirebase();          // no network
+void restoreCachedState();    // the last state from NVS, before the tasks start
+void saveLastState();         // control task, after every wake
+void applyCloudState();       // control task, on CONTROL_RESTORE
+// Network task: takes the next bring-up steps and returns the ms until it
+// wants to run again, 0 once the stream is open and the clock is set.
+unsigned long connectCloud();
+bool cloudConnected();
+void updateOnlineStatus();   // network task
+void performNetRequest(const NetRequest& request); // network task
+void updateSensorReadings(); // sensor task
+void updateAirQuality();     // sensor task, on the CCS811 interrupt or poll
+void updateTotalHours();     // control task
+void handleCommand(const ControlEvent& command);   // control task
+// Parses a command as the app writes it and queues it for the control task.
+// The RTDB stream and the LAN API (lanApi.h) both come through here.
+bool postCommandJson(FirebaseJson& commandData);
+void applySchedule(const WeeklySchedule& fetched); // control task
 void resetDevice();
 void notifyUser(const String& prompt);
 #endif
\ No newline at end of file
@@ -3,30 +3,29 @@
 #include <ArduinoJson.h>
 #include <IRutils.h>
 #include <IRrecv.h>
-#include <IRsend.h>
-#include "initSetup.h"
+#include "InitSetup.h"
 #include "log.h"
 #include "secrets.h"
 #include "parameters.h"
-#include "firestoreServices.h"
+#include "FirestoreServices.h"
 #include "sensors.h"
+#include "irCodes.h"
+#include "irTransmitter.h"
+#include "ledAnimation.h"
+#include "configStore.h"
 
 WebServer server(80);
-IRrecv irrecv(IRREC);
-IRsend irtest(IRLED);
+IRrecv irrecv(IRREC, IR_CAPTURE_BUFFER, IR_CAPTURE_TIMEOUT_MS, true);
 
 Preferences prefs;
 
 bool isProvisioned() {
-    prefs.begin("setup", true);
-    bool ready = prefs.getBool("provisioned", false);
-    prefs.end();
-    return debugssid == "" ? ready : true;
+    return debugssid == "" ? configBool(CONFIG_PROVISIONED) : true;
 }
 
 void initIRLearning() {
     irrecv.enableIRIn();
-    irtest.begin();
+    initIrTransmitter();
     LOG_INFO("📥 IR receiver initialized (learning mode)");
 }
 
@@ -43,19 +42,16 @@ bool captureAndSaveIR(const String &keyLabel) {
         delay(50);
     }
 
-    String rawStr = "";
-    for (uint16_t i = 1; i < results.rawlen && i < kRawBuf; i++) {
-        rawStr += String(results.rawbuf[i] * kRawTick);
-        if (i < results.rawlen - 1) rawStr += ",";
+    if (results.overflow) {
+        LOGF_WARN("⚠️ %s IR frame longer than %d timings, storing the truncated frame", keyLabel.c_str(), IR_CAPTURE_BUFFER);
     }
-    prefs.begin("setup", false);
-    prefs.putString(keyLabel.c_str(), rawStr);
-    prefs.end();
+    // rawbuf[0] is the gap before the frame; the rest are ticks of kRawTick us.
+    bool saved = saveIrCode(keyLabel.c_str(), results.rawbuf + 1, results.rawlen - 1, kRawTick);
+    irrecv.resume();
+    if (!saved) return false;
 
     LOGF("✅ Captured %s IR signal.", keyLabel.c_str());
-    LOGF("📏 Captured length: %d entries", results.rawlen);
-    LOGF("[Raw] %s", rawStr.c_str());
-    irrecv.resume();
+    LOGF("📏 Captured length: %d entries", results.rawlen - 1);
     return true;
 }
 
@@ -67,55 +63,30 @@ void registerIRTestHandler() {
         }
         String keyLabel = server.arg("key");
 
-        prefs.begin("setup", true);
-        String rawStr = prefs.getString(keyLabel.c_str(), "");
-        prefs.end();
-
-        if (rawStr.isEmpty()) {
+        static uint16_t rawData[IR_CAPTURE_BUFFER];
+        uint8_t carrierKhz = IR_CARRIER_KHZ;
+        uint16_t count = loadIrCode(keyLabel.c_str(), rawData, IR_CAPTURE_BUFFER, &carrierKhz);
+        if (count == 0) {
             server.send(404, "text/plain", "❌ No signal found for " + keyLabel);
             return;
         }
 
-        // Parse string into vector
-        std::vector<uint16_t> rawVector;
-        char* rawBuffer = strdup(rawStr.c_str());
-        char* token = strtok(rawBuffer, ",");
-
-        while (token != nullptr) {
-            rawVector.push_back(atoi(token));
-            token = strtok(nullptr, ",");
-        }
-        free(rawBuffer);
-
-        if (rawVector.empty()) {
-            server.send(500, "text/plain", "⚠️ Parsed IR signal is empty.");
+        if (!irTransmit(rawData, count, carrierKhz)) {
+            server.send(503, "text/plain", "❌ IR transmitter busy");
             return;
         }
 
-        // Convert vector to raw array
-        uint16_t rawData[rawVector.size()];
-        for (size_t i = 0; i < rawVector.size(); i++) {
-            rawData[i] = rawVector[i];
-        }
-
-        noInterrupts();
-        irtest.sendRaw(rawData, sizeof(rawData)/sizeof(rawData[0]), 38);  // 38 kHz carrier
-        interrupts();
-
-        // Debug print
-        Serial.printf("📤 Sent test signal for key: %s\n", keyLabel.c_str());
-        for (size_t i = 0; i < rawVector.size(); i += 10) {
-            Serial.print("🔹 Signal [");
-            Serial.print(i);
-            Serial.print(" - ");
-            Serial.print(min(i + 9, rawVector.size() - 1));
-            Serial.print("]: ");
-            for (size_t j = i; j < i + 10 && j < rawVector.size(); j++) {
-                Serial.print(rawVector[j]);
-                if (j < i + 9 && j < rawVector.size() - 1) Serial.print(",");
+        LOGF("📤 Sent test signal for key: %s (%u timings @ %u kHz)", keyLabel.c_str(), count, carrierKhz);
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+        for (uint16_t i = 0; i < count; i += 10) {
+            char timings[80];
+            size_t len = 0;
+            for (uint16_t j = i; j < i + 10 && j < count; j++) {
+                len += snprintf(timings + len, sizeof(timings) - len, j == i ? "%u" : ",%u", rawData[j]);
             }
-            Serial.println();
+            LOGF_DEBUG("🔹 Signal [%u - %u]: %s", i, min<uint16_t>(i + 9, count - 1), timings);
         }
+#endif
 
         server.send(200, "text/plain", "✅ IR test sent for key: " + keyLabel);
     });
@@ -157,6 +128,7 @@ void startAPMode() {
     apName.replace(":", "");
 
     WiFi.softAP(apName.c_str(), "Breezio123");
+    startLedAnimation(LED_EFFECT_PULSE, Adafruit_NeoPixel::Color(0, 0, 255)); // setup mode indicator
     LOGF("📡 AP Mode Started: %s | IP address: %s", apName.c_str(), WiFi.softAPIP().toString().c_str());
 
     server.on("/", HTTP_GET, []() {
@@ -197,13 +169,11 @@ void startAPMode() {
         }
         prefs.end(); 
 
-        prefs.begin("setup", false);
-        prefs.putString("model", model);
-        prefs.putString("name", name);
-        prefs.putString("ssid", ssid);
-        prefs.putString("pass", password);
-        prefs.putBool("provisioned", true);
-        prefs.end();
+        setConfigString(CONFIG_MODEL, model.c_str());
+        setConfigString(CONFIG_NAME, name.c_str());
+        setConfigString(CONFIG_SSID, ssid.c_str());
+        setConfigString(CONFIG_PASS, password.c_str());
+        setConfigBool(CONFIG_PROVISIONED, true);
 
         // ✅ Return MAC in the response
         String mac = WiFi.macAddress();
@@ -213,6 +183,8 @@ void startAPMode() {
 
         server.send(200, "text/plain", "✅ Setup complete. Rebooting...");
         delay(1000);
+        flushConfigStore();
+        logFlush();
         ESP.restart();
     });
 
@@ -223,47 +195,28 @@ void startAPMode() {
     server.begin();
 }
 
+// Starts joining the stored network and returns at once; the network task
+// waits for the station (connectCloud() in FirestoreServices.cpp) and calls
+// this again if a join takes longer than WIFI_REJOIN_MS.
 void connectToWifi(){
     if (WiFi.status() == WL_CONNECTED) {
         LOG_INFO("✅ Already connected to Wi-Fi.");
         return;
     }
-    WiFi.disconnect();  // Force stop any previous attempt
-    delay(100); 
-    const int maxRetries = 3;
-    const unsigned long timeoutMs = 10000;
-    prefs.begin("setup", true);
-    String ssid = prefs.getString("ssid", "");
-    String pass = prefs.getString("pass", "");
-    prefs.end();
-    if ((ssid == "" || pass == "") && debugssid == "") {
+    String ssid = configString(CONFIG_SSID);
+    String pass = configString(CONFIG_PASS);
+    if(debugssid != ""){
+        ssid = debugssid;
+        pass = debugpass;
+    }
+    if (ssid == "" || pass == "") {
         LOG_ERROR("No stored Wi-Fi credentials found.");
         return;
     }
-    for (int attempt = 1; attempt <= maxRetries; ++attempt) {
-        if(debugssid != ""){
-            ssid = debugssid;
-            pass = debugpass;
-        }
-        LOGF("🔄 Attempt %d to connect to Wi-Fi: %s", attempt, ssid.c_str());
-        WiFi.begin(ssid.c_str(), pass.c_str());
-
-        unsigned long startTime = millis();
-        while (WiFi.status() != WL_CONNECTED && millis() - startTime < timeoutMs) {
-            Serial.print(".");
-            delay(300);
-        }
-
-        if (WiFi.status() == WL_CONNECTED) {
-            LOG_INFO("\n✅ Connected to Wi-Fi!");
-            return;
-        } else {
-            LOG_WARN("\n⏱️ Connection attempt timed out.");
-            WiFi.disconnect(true);  
-            delay(1000);
-        }
-    }
-    LOG_ERROR("❌ Failed to connect to Wi-Fi after multiple attempts.");
+    LOGF("🔄 Connecting to Wi-Fi: %s", ssid.c_str());
+    WiFi.disconnect();  // Force stop any previous attempt
+    WiFi.setAutoReconnect(true);
+    WiFi.begin(ssid.c_str(), pass.c_str());
 }
 
 void initSetup(){
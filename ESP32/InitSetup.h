@@ -6,6 +6,7 @@
 
 void initSetup(); 
 bool isProvisioned();
+void connectToWifi(); // returns without waiting for the station
 void handleWebRequests();
 
 #endif
\ No newline at end of file
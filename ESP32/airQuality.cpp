@@ -0,0 +1,114 @@
+#include <Adafruit_CCS811.h>
+#include <driver/gpio.h>
+#include "airQuality.h"
+#include "sensorFilter.h"
+#include "configStore.h"
+#include "deadlines.h"
+#include "deviceTasks.h"
+#include "parameters.h"
+#include "log.h"
+
+static Adafruit_CCS811 ccs;
+static bool present = false;
+static AirQualityStats stats;
+
+// In hundredths, over the ranges the sensor reports. Its algorithm already
+// averages, so a short median and a light EMA only take out single spikes.
+static const SensorFilterConfig eco2FilterConfig = {
+    40000, 819200, 3, 128, 0, ECO2_CHANGE_THRESHOLD * 100,
+};
+static const SensorFilterConfig tvocFilterConfig = {
+    0, 118700, 3, 128, 0, TVOC_CHANGE_THRESHOLD * 100,
+};
+static SensorFilter eco2Filter = {&eco2FilterConfig};
+static SensorFilter tvocFilter = {&tvocFilterConfig};
+
+static bool envWritten = false;
+static float envTemperature = 0;
+static float envHumidity = 0;
+
+static void restoreBaseline() {
+  uint16_t baseline = configNumber(CONFIG_AIR_BASELINE);
+  ccs.setBaseline(baseline);
+  LOGF("🌬️ CCS811 baseline %04X restored", baseline);
+}
+
+static void saveBaseline() {
+  uint16_t baseline = ccs.getBaseline();
+  if (baseline == 0) return;
+  setConfigNumber(CONFIG_AIR_BASELINE, baseline, CONFIG_COMMIT_NOW);
+  stats.baselineSaves++;
+}
+
+static Deadline restoreDeadline = {"baseline", restoreBaseline};
+static Deadline saveDeadline = {"baseline save", saveBaseline, AIR_BASELINE_SAVE_MS};
+
+void startAirQuality() {
+  if (present) return;
+  if (!ccs.begin()) {
+    LOG_WARN("⚠️ No CCS811 found, air quality not measured");
+    return;
+  }
+  present = true;
+  pinMode(CCS811_INT_PIN, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(CCS811_INT_PIN), wakeSensorTaskFromISR, FALLING);
+  gpio_wakeup_enable((gpio_num_t)CCS811_INT_PIN, GPIO_INTR_LOW_LEVEL);
+  ccs.setDriveMode(AIR_DRIVE_MODE);
+  ccs.enableInterrupt();
+  if (configNumber(CONFIG_AIR_BASELINE)) armDeadline(sensorDeadlines, restoreDeadline, AIR_BASELINE_RESTORE_MS);
+  armDeadline(sensorDeadlines, saveDeadline, AIR_BASELINE_SAVE_MS);
+  LOG_INFO("🌬️ CCS811 started");
+}
+
+bool airQualityPresent() {
+  return present;
+}
+
+bool readAirQuality() {
+  static bool firstError = true;
+  if (!present || !ccs.available()) return false;
+  if (ccs.readData() != 0) {
+    if (firstError) LOG_ERROR("❌ Failed to read air quality");
+    firstError = false;
+    stats.errors++;
+    return false;
+  }
+  firstError = true;
+  stats.results++;
+  bool changed = filterReading(eco2Filter, ccs.geteCO2());
+  changed |= filterReading(tvocFilter, ccs.getTVOC());
+  return changed;
+}
+
+bool airQualityPending() {
+  return present && digitalRead(CCS811_INT_PIN) == LOW;
+}
+
+void compensateAirQuality(float temperature, float humidity) {
+  if (!present || isnan(temperature) || isnan(humidity)) return;
+  if (envWritten && fabsf(temperature - envTemperature) < AIR_ENV_STEP &&
+      fabsf(humidity - envHumidity) < AIR_ENV_STEP) {
+    return;
+  }
+  ccs.setEnvironmentalData(humidity, temperature);
+  envWritten = true;
+  envTemperature = temperature;
+  envHumidity = humidity;
+  stats.envWrites++;
+}
+
+bool airQualityValid() {
+  return eco2Filter.valid && tvocFilter.valid;
+}
+
+uint16_t airQualityEco2() {
+  return (eco2Filter.reported + 50) / 100;
+}
+
+uint16_t airQualityTvoc() {
+  return (tvocFilter.reported + 50) / 100;
+}
+
+AirQualityStats airQualityStats() {
+  return stats;
+}
@@ -0,0 +1,50 @@
+#ifndef AIR_QUALITY_H
+#define AIR_QUALITY_H
+
+#include <Arduino.h>
+
+// The CCS811 eCO2/TVOC sensor on I2C, owned by the sensor task. It measures
+// on its own every AIR_DRIVE_MODE period and pulls nINT (CCS811_INT_PIN) low
+// once a result is ready; the interrupt notifies the sensor task, which reads
+// the result, so between results the sensor costs no task any time and nINT
+// also wakes the chip from light sleep. nINT stays low until a read succeeds,
+// so a failed or missed read raises no further edge; the sensor task looks
+// at the pin every AIR_POLL_MS and reads a result still waiting.
+//
+// eCO2 and TVOC go through SensorFilters (sensorFilter.h), and a change past
+// ECO2_CHANGE_THRESHOLD or TVOC_CHANGE_THRESHOLD is uploaded with the DHT
+// readings. The filtered DHT readings are written to the sensor for its
+// humidity and temperature compensation when they move by AIR_ENV_STEP.
+//
+// The baseline the sensor learns is saved in the config store
+// (CONFIG_AIR_BASELINE) every AIR_BASELINE_SAVE_MS, and written back
+// AIR_BASELINE_RESTORE_MS after a start, once the sensor has warmed up.
+// Without a sensor, startAirQuality() says so once and nothing else runs.
+
+#define AIR_DRIVE_MODE CCS811_DRIVE_MODE_10SEC
+#define AIR_BASELINE_RESTORE_MS (20 * 60 * 1000UL)
+#define AIR_BASELINE_SAVE_MS (24 * 60 * 60 * 1000UL)
+#define AIR_ENV_STEP 0.5 // °C or %
+#define AIR_POLL_MS 30000UL
+
+struct AirQualityStats {
+  unsigned long results;  // read after an interrupt or by the poll
+  unsigned long errors;   // results the sensor flagged
+  unsigned long envWrites;
+  unsigned long baselineSaves;
+};
+
+void startAirQuality(); // sensor task, once at its start
+bool airQualityPresent();
+// Sensor task, when the data-ready interrupt woke it; true if a reported
+// value changed.
+bool readAirQuality();
+bool airQualityPending(); // nINT low: a result waiting, whether or not its edge woke the task
+void compensateAirQuality(float temperature, float humidity); // sensor task, NAN if not read
+// Whether eCO2 and TVOC hold a reading, which they keep while reads fail.
+bool airQualityValid();
+uint16_t airQualityEco2(); // ppm, as reported
+uint16_t airQualityTvoc(); // ppb
+AirQualityStats airQualityStats();
+
+#endif
@@ -0,0 +1,34 @@
+#include "bootReport.h"
+#include "log.h"
+
+static const char* const phaseNames[BOOT_PHASES] = {
+  "config", "last state", "local control", "wifi", "clock", "auth", "cloud state", "stream",
+};
+
+// Each phase is written once, by setup() or the network task.
+static bool reached[BOOT_PHASES];
+static unsigned long reachedMs[BOOT_PHASES];
+
+void bootMark(BootPhase phase) {
+  if (reached[phase]) return;
+  reachedMs[phase] = millis();
+  reached[phase] = true;
+}
+
+bool bootReached(BootPhase phase) {
+  return reached[phase];
+}
+
+unsigned long bootPhaseMs(BootPhase phase) {
+  return reached[phase] ? reachedMs[phase] : 0;
+}
+
+void logBootReport() {
+  for (int i = 0; i < BOOT_PHASES; i++) {
+    if (reached[i]) {
+      LOGF("⏱️ Boot: %-13s %6lu ms", phaseNames[i], reachedMs[i]);
+    } else {
+      LOGF("⏱️ Boot: %-13s not reached", phaseNames[i]);
+    }
+  }
+}
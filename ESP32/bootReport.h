@@ -0,0 +1,29 @@
+#ifndef BOOT_REPORT_H
+#define BOOT_REPORT_H
+
+#include <Arduino.h>
+
+// Milestones of a boot, in the order a normal one reaches them. setup()
+// gets through the first three without waiting on the network, so the AC
+// answers local control from the state kept in NVS; the rest happen on the
+// network task (connectCloud() in FirestoreServices.cpp), in the background.
+
+enum BootPhase : uint8_t {
+  BOOT_CONFIG,      // NVS settings loaded
+  BOOT_STATE,       // last state restored from NVS and shown
+  BOOT_CONTROL,     // device tasks running: IR, modes, schedule, sensors
+  BOOT_WIFI,        // station joined
+  BOOT_TIME,        // SNTP set the clock
+  BOOT_AUTH,        // signed in to Firebase
+  BOOT_CLOUD_STATE, // the device node's state merged in
+  BOOT_STREAM,      // command stream open, writes go out
+  BOOT_PHASES
+};
+
+void bootMark(BootPhase phase); // only the first mark counts
+bool bootReached(BootPhase phase);
+unsigned long bootPhaseMs(BootPhase phase); // millis() at the mark, 0 if not reached
+// Logs each phase reached with its time since power-on.
+void logBootReport();
+
+#endif
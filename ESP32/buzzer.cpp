@@ -0,0 +1,88 @@
+#include "buzzer.h"
+#include "deadlines.h"
+#include "powerSave.h"
+#include "log.h"
+
+static const BuzzerNote maintenanceNotes[] = {
+  {784, 1000}, {0, 250}, {784, 1000}, {0, 250}, {784, 1000}, {0, 250}, {784, 1250}
+};
+static const BuzzerNote ackNotes[] = {{1568, 60}};
+static const BuzzerNote errorNotes[] = {{392, 200}, {0, 100}, {392, 200}};
+
+struct BuzzerSequence {
+  const BuzzerNote* notes;
+  uint8_t count;
+};
+
+static const BuzzerSequence buzzerSequences[BUZZER_PATTERNS] = {
+  {maintenanceNotes, sizeof(maintenanceNotes) / sizeof(maintenanceNotes[0])},
+  {ackNotes, sizeof(ackNotes) / sizeof(ackNotes[0])},
+  {errorNotes, sizeof(errorNotes) / sizeof(errorNotes[0])},
+};
+
+static uint8_t buzzerQueue[BUZZER_QUEUE];
+static uint8_t buzzerHead = 0;   // pattern playing (or next to play)
+static uint8_t buzzerQueued = 0; // patterns waiting, including the one playing
+static int buzzerNote = -1;      // note playing in the head pattern, -1 before it starts
+static unsigned long buzzerNoteEndMs = 0;
+static Deadline buzzerDeadline = {"buzzer", handleBuzzer};
+
+void initBuzzer() {
+  ledcSetup(BUZZER_LEDC_CHANNEL, 2000, 8);
+  ledcAttachPin(BUZZER, BUZZER_LEDC_CHANNEL);
+  ledcWrite(BUZZER_LEDC_CHANNEL, 0);
+  buzzerQueued = 0;
+  buzzerNote = -1;
+}
+
+bool playBuzzerPattern(BuzzerPattern pattern) {
+  if (buzzerQueued == BUZZER_QUEUE) {
+    LOG_WARN("🔇 Buzzer queue full, pattern dropped");
+    return false;
+  }
+  buzzerQueue[(buzzerHead + buzzerQueued) % BUZZER_QUEUE] = pattern;
+  buzzerQueued++;
+  holdAwake(AWAKE_BUZZER, true); // LEDC stops in light sleep
+  handleBuzzer();
+  return true;
+}
+
+void handleBuzzer() {
+  if (buzzerQueued == 0) return;
+  if (buzzerNote >= 0 && (long)(millis() - buzzerNoteEndMs) < 0) return;
+
+  const BuzzerSequence& sequence = buzzerSequences[buzzerQueue[buzzerHead]];
+  if (buzzerNote + 1 >= sequence.count) {
+    ledcWrite(BUZZER_LEDC_CHANNEL, 0);
+    buzzerHead = (buzzerHead + 1) % BUZZER_QUEUE;
+    buzzerQueued--;
+    buzzerNote = -1;
+    if (buzzerQueued == 0) holdAwake(AWAKE_BUZZER, false);
+    handleBuzzer(); // next pattern starts right away
+    return;
+  }
+  // Notes are timed back to back from the previous deadline so a late loop()
+  // shortens the next note instead of stretching the whole pattern.
+  unsigned long start = buzzerNote < 0 ? millis() : buzzerNoteEndMs;
+  const BuzzerNote& note = sequence.notes[++buzzerNote];
+  if (note.freqHz) {
+    ledcWriteTone(BUZZER_LEDC_CHANNEL, note.freqHz);
+  } else {
+    ledcWrite(BUZZER_LEDC_CHANNEL, 0);
+  }
+  buzzerNoteEndMs = start + note.durationMs;
+  long left = (long)(buzzerNoteEndMs - millis());
+  armDeadline(controlDeadlines, buzzerDeadline, left > 0 ? left : 0);
+}
+
+bool buzzerBusy() {
+  return buzzerQueued > 0;
+}
+
+unsigned long buzzerPatternMs(BuzzerPattern pattern) {
+  unsigned long total = 0;
+  for (uint8_t i = 0; i < buzzerSequences[pattern].count; i++) {
+    total += buzzerSequences[pattern].notes[i].durationMs;
+  }
+  return total;
+}
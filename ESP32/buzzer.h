@@ -0,0 +1,30 @@
+#ifndef BUZZER_H
+#define BUZZER_H
+
+#include <Arduino.h>
+#include "parameters.h"
+
+// Tone patterns played on the buzzer through an LEDC channel. Playing only
+// queues the pattern; handleBuzzer() switches notes as their durations run
+// out, on a deadline of the control task, so a pattern never holds it up.
+struct BuzzerNote {
+  uint16_t freqHz; // 0 for a rest
+  uint16_t durationMs;
+};
+
+enum BuzzerPattern {
+  BUZZER_MAINTENANCE, // filter/maintenance alert, ~5 s
+  BUZZER_ACK,         // command executed
+  BUZZER_ERROR,       // command failed
+  BUZZER_PATTERNS
+};
+
+#define BUZZER_QUEUE 4
+
+void initBuzzer();
+bool playBuzzerPattern(BuzzerPattern pattern); // false if the queue is full
+void handleBuzzer();
+bool buzzerBusy();
+unsigned long buzzerPatternMs(BuzzerPattern pattern);
+
+#endif
@@ -5,146 +5,287 @@
 #include <ir_Electra.h>
 #include <ir_Samsung.h>
 #include <ir_LG.h>
-#include <Preferences.h>
 #include <Firebase_ESP_Client.h>
-#include "initSetup.h"
-#include "firestoreServices.h"
+#include "InitSetup.h"
+#include "FirestoreServices.h"
 #include "command.h"
 #include "parameters.h"
 #include "log.h"
 #include "sensors.h"
 #include "modeHandler.h"
+#include "irCodes.h"
+#include "irTransmitter.h"
+#include "deviceTasks.h"
+#include "configStore.h"
 
 
-IRsend irsend(IRLED);
 IRElectraAc acElectra(IRLED);
 IRSamsungAc acSamsung(IRLED);
 IRLgAc acLG(IRLED);
+static bool irInitialized = false;
 
 
 
-void initIR() {
-    if (model == "Electra") {
-        acElectra.begin();
-        acElectra.setMode(kElectraAcCool);
-        acElectra.setFan(kElectraAcFanAuto);
-        LOG_INFO("✅ Electra IR initialized and default state initialized.");
-
-    } else if (model == "Samsung") {
-        acSamsung.begin();
-        acSamsung.setMode(kSamsungAcCool);
-        acSamsung.setFan(kSamsungAcFanAuto);
-        LOG_INFO("✅ Samsung IR initialized and default state initialized.");
-
-    } else if (model == "LG") {
-        acLG.begin();
-        acLG.setMode(kLgAcCool);
-        acLG.setFan(kLgAcFanAuto);
-        LOG_INFO("✅ LG IR initialized and default state initialized.");
-
-    } else if (model == "Custom") {
-        irsend.begin();
-        LOG_INFO("🛠️ Manual IR mode activated — waiting for commands.");
-    } else {
-        LOGF("🚫 Unknown AC model: '%s'. IR not initialized.", model.c_str());
-    }
+// Samsung power frames need the library's extended message, so that model is
+// still bit-banged; the RMT queue is drained first so the two never overlap.
+static void sendSamsung() {
+    waitIrTransmitter();
+    acSamsung.send();
 }
 
-void transmitSignal(const String& signal){
-    std::vector<uint16_t> rawVector;
-    char* rawBuffer = strdup(signal.c_str());
-    char* token = strtok(rawBuffer, ",");
-
-    while (token != nullptr) {
-        rawVector.push_back(atoi(token));
-        token = strtok(nullptr, ",");
-    }
-    free(rawBuffer);
-    uint16_t rawData[rawVector.size()];
-    for (size_t i = 0; i < rawVector.size(); i++) {
-        rawData[i] = rawVector[i];
+void transmitSignal(IrFrameKey key){
+    const IrFrame* frame = getIrFrame(key);
+    if (frame == nullptr) {
+        LOGF_WARN("🚫 No learned IR code for '%s'", irFrameName(key));
+        return;
     }
-    noInterrupts();
-    irsend.sendRaw(rawData, sizeof(rawData)/sizeof(rawData[0]), 38);   // 38kHz
-    interrupts();
+    irTransmit(frame->timings, frame->count, frame->carrierKhz);
     return;
 }
 
-void controlACTemp(const String& action){
-    if (action == "temp_up") {
-        currTemp += 1;
-    } else {
-        currTemp -= 1;
-    }
-    if(model == "Electra"){
-        acElectra.setTemp(currTemp);
-        acElectra.send();
-    }
-    else if(model == "Samsung"){
-        acSamsung.setTemp(currTemp);
-        acSamsung.send();
-    }
-    else if(model == "LG"){
-        acLG.setTemp(currTemp);
-        acLG.send();
-    }
-    else{ //Custom mode
-        Preferences prefs;
-        prefs.begin("setup", true);
-        String signal = action == "temp_up" ? prefs.getString("tempUp", "") : prefs.getString("tempDown", "");
-        prefs.end();
-        transmitSignal(signal);
-    }
+static void initElectra() {
+    acElectra.begin();
+    acElectra.setMode(kElectraAcCool);
+    acElectra.setFan(kElectraAcFanAuto);
+    LOG_INFO("✅ Electra IR initialized and default state initialized.");
+}
+
+static void initSamsung() {
+    acSamsung.begin();
+    acSamsung.setMode(kSamsungAcCool);
+    acSamsung.setFan(kSamsungAcFanAuto);
+    LOG_INFO("✅ Samsung IR initialized and default state initialized.");
+}
+
+static void initLg() {
+    acLG.begin();
+    acLG.setMode(kLgAcCool);
+    acLG.setFan(kLgAcFanAuto);
+    LOG_INFO("✅ LG IR initialized and default state initialized.");
+}
+
+static void initCustom() {
+    loadIrFrames();
+    LOG_INFO("🛠️ Manual IR mode activated — waiting for commands.");
+}
+
+static void electraTemp(bool /*up*/) {
+    acElectra.setTemp(currTemp);
+    irTransmitElectra(acElectra.getRaw(), kElectraAcStateLength);
+}
+
+static void samsungTemp(bool /*up*/) {
+    acSamsung.setTemp(currTemp);
+    sendSamsung();
+}
+
+static void lgTemp(bool /*up*/) {
+    acLG.setTemp(currTemp);
+    irTransmitLg(acLG.getRaw());
+}
+
+static void customTemp(bool up) {
+    transmitSignal(up ? IR_FRAME_TEMP_UP : IR_FRAME_TEMP_DOWN);
+}
+
+static void electraPower(bool on) {
+    acElectra.setPower(on);
+    irTransmitElectra(acElectra.getRaw(), kElectraAcStateLength);
+}
+
+static void samsungPower(bool on) {
+    acSamsung.setPower(on);
+    sendSamsung();
+}
+
+static void lgPower(bool on) {
+    acLG.setPower(on);
+    irTransmitLg(acLG.getRaw());
+}
+
+static void customPower(bool on) {
+    transmitSignal(on ? IR_FRAME_ON : IR_FRAME_OFF);
+}
+
+// Per AC brand: set up the encoder, and send a temperature (currTemp, already
+// stepped) or power change. Only the custom frames need the step direction.
+struct AcBrand {
+    void (*init)();
+    void (*sendTemp)(bool up);
+    void (*sendPower)(bool on);
+};
+
+static const AcBrand brands[AC_MODELS] = {
+    {initElectra, electraTemp, electraPower}, // MODEL_ELECTRA
+    {initSamsung, samsungTemp, samsungPower}, // MODEL_SAMSUNG
+    {initLg, lgTemp, lgPower},                // MODEL_LG
+    {initCustom, customTemp, customPower},    // MODEL_CUSTOM
+};
+
+void initIR() {
+    initIrTransmitter();
+    brands[model].init();
+    irInitialized = true;
+}
+
+bool irReady() {
+    return irInitialized;
+}
+
+static void controlACTemp(bool up){
+    currTemp += up ? 1 : -1;
+    brands[model].sendTemp(up);
     validateLedColor();
     return;
 }
 
-void controlACPower(const String& action){
-    if(action == "eco_switch_power" && !acPowered && ecoCanTurnOn == false){
+static void controlACPower(CommandAction action){
+    if(action == ACTION_ECO_SWITCH_POWER && !acPowered && ecoCanTurnOn == false){
         return;
     }
-    if (model == "Electra"){
-        acElectra.setPower(!acPowered);
-        acElectra.send();
-    }
-    else if (model == "Samsung"){
-        acSamsung.setPower(!acPowered);
-        acSamsung.send();
-    }
-    else if (model == "LG"){
-        acLG.setPower(!acPowered);
-        acLG.send();
-    }
-    else{ //Custom model
-        Preferences prefs;
-        prefs.begin("setup", true);
-        String signal = acPowered ? prefs.getString("off", "") : prefs.getString("on", "");
-        prefs.end();
-        transmitSignal(signal);
-    }
-    if(action != "eco_switch_power" && acPowered){
+    brands[model].sendPower(!acPowered);
+    if(action != ACTION_ECO_SWITCH_POWER && acPowered){
         ecoCanTurnOn = false;
-        Preferences prefs;
-        prefs.begin("eco", false);
-        prefs.putBool("ecoCanTurnOn", ecoCanTurnOn);
-        prefs.end();
+        setConfigBool(CONFIG_ECO_CAN_TURN_ON, ecoCanTurnOn);
     }
     else if (!acPowered){
         ecoCanTurnOn = true;
-        Preferences prefs;
-        prefs.begin("eco", false);
-        prefs.putBool("ecoCanTurnOn", ecoCanTurnOn);
-        prefs.end();
-        lastMotionMillis = millis();
+        setConfigBool(CONFIG_ECO_CAN_TURN_ON, ecoCanTurnOn);
     }
     acPowered = !acPowered;
+    if (acPowered) noteCommand(); // someone wants it on, whether by hand or by the schedule
 }
 
-bool execute(const String& action) {
-    if(action == "switch_power" || action == "eco_switch_power") controlACPower(action);
-    else if(action == "temp_up" || action == "temp_down") controlACTemp(action);
-    else{
-        return false;
+// ----------------------- Action handlers (control task) -----------------------
+static bool runSetMode(const ControlEvent& command) {
+    if (command.mode == AC_MODES) return false;
+    if (mode != command.mode) {
+        mode = command.mode;
+        if (mode == MODE_TIMER && !testMode) {
+            duration = command.duration;
+        }
+        if (mode == MODE_MOTION) noteCommand();
     }
     return true;
 }
+
+static bool runApplySchedule(const ControlEvent& /*command*/) {
+    NetRequest request = {};
+    request.op = NET_FETCH_SCHEDULE;
+    return postNetRequest(request);
+}
+
+static bool runResetMaintenance(const ControlEvent& /*command*/) {
+    shouldBuzz = true;
+    totalHours = 0.0;
+    return true;
+}
+
+static bool runIgnoreMotion(const ControlEvent& /*command*/) {
+    idleFlag = IDLE_CONTINUE;
+    return true;
+}
+
+static bool runSwitchLights(const ControlEvent& /*command*/) {
+    switchLed();
+    lights_on = !lights_on;
+    return true;
+}
+
+static bool runSwitchRelay(const ControlEvent& /*command*/) {
+    switchRelay();
+    relay_on = !relay_on;
+    return true;
+}
+
+static bool runResetDevice(const ControlEvent& /*command*/) {
+    resetDevice();
+    return true;
+}
+
+static bool runPower(const ControlEvent& command) {
+    controlACPower(command.action);
+    return true;
+}
+
+static bool runTemp(const ControlEvent& command) {
+    controlACTemp(command.action == ACTION_TEMP_UP);
+    return true;
+}
+
+static bool runUnknown(const ControlEvent& /*command*/) {
+    return false;
+}
+
+// ----------------------- Registry -----------------------
+// In CommandAction order. The hash slots are checked at compile time below.
+static constexpr CommandSpec commandSpecs[COMMAND_ACTIONS] = {
+    {"set_mode", COMMAND_ARG_MODE | COMMAND_ARG_DURATION, false, runSetMode},
+    {"apply_schedule", 0, false, runApplySchedule},
+    {"reset_maintenance", 0, false, runResetMaintenance},
+    {"ignore_motion", 0, false, runIgnoreMotion},
+    {"switch_lights", 0, false, runSwitchLights},
+    {"switch_relay", 0, false, runSwitchRelay},
+    {"reset_device", 0, false, runResetDevice},
+    {"switch_power", 0, true, runPower},
+    {"eco_switch_power", 0, true, runPower},
+    {"temp_up", 0, true, runTemp},
+    {"temp_down", 0, true, runTemp},
+};
+static constexpr CommandSpec unknownSpec = {"unknown", 0, false, runUnknown};
+
+// FNV-1a with a seed picked so the top COMMAND_HASH_BITS bits of every
+// registered name differ: a lookup is one hash, one slot and one strcmp.
+#define COMMAND_HASH_BITS 5
+#define COMMAND_HASH_SEED 2u
+#define COMMAND_HASH_SLOTS (1 << COMMAND_HASH_BITS)
+
+static constexpr uint32_t actionHash(const char* s, uint32_t h = COMMAND_HASH_SEED) {
+    return *s ? actionHash(s + 1, (h ^ (uint8_t)*s) * 16777619u) : h;
+}
+
+static constexpr uint8_t actionSlot(const char* name) {
+    return (uint8_t)(actionHash(name) >> (32 - COMMAND_HASH_BITS));
+}
+
+static constexpr bool slotsDistinct(size_t i = 0, size_t j = 1) {
+    return i >= COMMAND_ACTIONS ? true
+         : j >= COMMAND_ACTIONS ? slotsDistinct(i + 1, i + 2)
+         : actionSlot(commandSpecs[i].name) != actionSlot(commandSpecs[j].name) && slotsDistinct(i, j + 1);
+}
+static_assert(slotsDistinct(), "two actions share a hash slot; pick another COMMAND_HASH_SEED");
+
+struct ActionSlots {
+    uint8_t action[COMMAND_HASH_SLOTS];
+    ActionSlots() {
+        memset(action, ACTION_UNKNOWN, sizeof(action));
+        for (uint8_t i = 0; i < COMMAND_ACTIONS; i++) action[actionSlot(commandSpecs[i].name)] = i;
+    }
+};
+static const ActionSlots actionSlots;
+
+CommandAction lookupCommandAction(const char* name) {
+    if (name == nullptr) return ACTION_UNKNOWN;
+    uint8_t action = actionSlots.action[actionSlot(name)];
+    if (action == ACTION_UNKNOWN || strcmp(commandSpecs[action].name, name) != 0) return ACTION_UNKNOWN;
+    return (CommandAction)action;
+}
+
+const CommandSpec& commandSpec(CommandAction action) {
+    return action < COMMAND_ACTIONS ? commandSpecs[action] : unknownSpec;
+}
+
+bool runCommand(const ControlEvent& command) {
+    const CommandSpec& spec = commandSpec(command.action);
+    if (spec.needsIr && !irReady()) {
+        LOGF_WARN("🚫 IR not initialized, '%s' not sent", spec.name);
+        return false;
+    }
+    return spec.run(command);
+}
+
+bool execute(CommandAction action) {
+    ControlEvent command = {};
+    command.action = action;
+    return runCommand(command);
+}
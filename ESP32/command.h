@@ -1,10 +1,47 @@
 #ifndef IR_COMMAND_H
 #define IR_COMMAND_H
 
-#include <Arduino.h> 
+#include <Arduino.h>
 #include <ArduinoJson.h>
 
+struct ControlEvent;
+
+// Every action the device accepts, from the app or from its own modes. New
+// actions are added here and registered in the table in command.cpp.
+enum CommandAction : uint8_t {
+    ACTION_SET_MODE,
+    ACTION_APPLY_SCHEDULE,
+    ACTION_RESET_MAINTENANCE,
+    ACTION_IGNORE_MOTION,
+    ACTION_SWITCH_LIGHTS,
+    ACTION_SWITCH_RELAY,
+    ACTION_RESET_DEVICE,
+    ACTION_SWITCH_POWER,
+    ACTION_ECO_SWITCH_POWER,
+    ACTION_TEMP_UP,
+    ACTION_TEMP_DOWN,
+    COMMAND_ACTIONS,
+    ACTION_UNKNOWN = COMMAND_ACTIONS
+};
+
+// Command fields an action reads besides "action".
+#define COMMAND_ARG_MODE 0x01
+#define COMMAND_ARG_DURATION 0x02
+
+struct CommandSpec {
+    const char* name;
+    uint8_t args;   // COMMAND_ARG_* parsed into the ControlEvent
+    bool needsIr;   // fails without an initialized IR encoder
+    bool (*run)(const ControlEvent& command);
+};
+
 void initIR();
-bool execute(const String& action);
+bool irReady();
+// Perfect-hash lookup of an action name; ACTION_UNKNOWN if not registered.
+CommandAction lookupCommandAction(const char* name);
+const CommandSpec& commandSpec(CommandAction action);
+// Runs an action on the control task. Returns false if it failed.
+bool runCommand(const ControlEvent& command);
+bool execute(CommandAction action);
 
-#endif
\ No newline at end of file
+#endif
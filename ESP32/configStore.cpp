@@ -0,0 +1,269 @@
+#include <Preferences.h>
+#include "configStore.h"
+#include "deadlines.h"
+#include "log.h"
+
+enum ConfigType : uint8_t { CONFIG_BOOL, CONFIG_NUMBER, CONFIG_TEXT, CONFIG_BLOB };
+
+struct ConfigEntry {
+  const char* space;
+  const char* key;
+  ConfigType type;
+  bool defaultBool;
+};
+
+static const ConfigEntry entries[CONFIG_KEYS] = {
+  {"setup", "provisioned", CONFIG_BOOL, false},
+  {"setup", "model", CONFIG_TEXT, false},
+  {"setup", "name", CONFIG_TEXT, false},
+  {"setup", "ssid", CONFIG_TEXT, false},
+  {"setup", "pass", CONFIG_TEXT, false},
+  {"eco", "ecoCanTurnOn", CONFIG_BOOL, true},
+  {"lan", "token", CONFIG_TEXT, false},
+  {"state", "last", CONFIG_BLOB, false},
+  {"air", "baseline", CONFIG_NUMBER, false},
+};
+
+// Values and the dirty mask are shared by the setters and the flush, under
+// `lock`. NVS is written outside it, from a copy.
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+static bool bools[CONFIG_KEYS];
+static bool storedBools[CONFIG_KEYS]; // what NVS holds
+static uint32_t numbers[CONFIG_KEYS];
+static uint32_t storedNumbers[CONFIG_KEYS];
+static char texts[CONFIG_KEYS][CONFIG_TEXT_MAX];
+// The one blob key, and what NVS holds of it.
+static uint8_t blob[CONFIG_BLOB_MAX];
+static size_t blobLen = 0;
+static uint8_t storedBlob[CONFIG_BLOB_MAX];
+static size_t storedBlobLen = 0;
+static uint32_t dirty = 0;
+static unsigned long firstDirtyMs = 0;
+static ConfigStoreStats stats;
+
+static Deadline commitDeadline = {"config", flushConfigStore};
+
+void loadConfigStore() {
+  Preferences prefs;
+  const char* open = nullptr;
+  for (int i = 0; i < CONFIG_KEYS; i++) {
+    const ConfigEntry& entry = entries[i];
+    if (!open || strcmp(open, entry.space) != 0) {
+      if (open) prefs.end();
+      prefs.begin(entry.space, true);
+      open = entry.space;
+    }
+    switch (entry.type) {
+      case CONFIG_BOOL:
+        bools[i] = storedBools[i] = prefs.getBool(entry.key, entry.defaultBool);
+        break;
+      case CONFIG_NUMBER:
+        numbers[i] = storedNumbers[i] = prefs.getUInt(entry.key, 0);
+        break;
+      case CONFIG_TEXT:
+        snprintf(texts[i], CONFIG_TEXT_MAX, "%s", prefs.getString(entry.key, "").c_str());
+        break;
+      case CONFIG_BLOB:
+        blobLen = prefs.getBytesLength(entry.key);
+        if (blobLen > CONFIG_BLOB_MAX || prefs.getBytes(entry.key, blob, blobLen) != blobLen) blobLen = 0;
+        memcpy(storedBlob, blob, blobLen);
+        storedBlobLen = blobLen;
+        break;
+    }
+  }
+  if (open) prefs.end();
+  dirty = 0;
+}
+
+bool configBool(ConfigKey key) {
+  return bools[key];
+}
+
+const char* configString(ConfigKey key) {
+  return texts[key];
+}
+
+uint32_t configNumber(ConfigKey key) {
+  return numbers[key];
+}
+
+static void armCommit() {
+  unsigned long now = millis();
+  if (!deadlineArmed(commitDeadline)) firstDirtyMs = now;
+  unsigned long held = now - firstDirtyMs;
+  unsigned long left = held < CONFIG_COMMIT_MAX_MS ? CONFIG_COMMIT_MAX_MS - held : 0;
+  armDeadline(controlDeadlines, commitDeadline, min(CONFIG_COMMIT_DELAY_MS, left));
+}
+
+static void changed(ConfigCommit commit) {
+  if (commit == CONFIG_COMMIT_NOW) {
+    flushConfigStore();
+  } else {
+    armCommit();
+  }
+}
+
+void setConfigBool(ConfigKey key, bool value, ConfigCommit commit) {
+  portENTER_CRITICAL(&lock);
+  bool same = bools[key] == value;
+  bools[key] = value;
+  if (!same) dirty |= 1UL << key;
+  portEXIT_CRITICAL(&lock);
+  if (!same) changed(commit);
+}
+
+void setConfigNumber(ConfigKey key, uint32_t value, ConfigCommit commit) {
+  portENTER_CRITICAL(&lock);
+  bool same = numbers[key] == value;
+  numbers[key] = value;
+  if (!same) dirty |= 1UL << key;
+  portEXIT_CRITICAL(&lock);
+  if (!same) changed(commit);
+}
+
+void setConfigString(ConfigKey key, const char* value, ConfigCommit commit) {
+  portENTER_CRITICAL(&lock);
+  bool same = strncmp(texts[key], value, CONFIG_TEXT_MAX - 1) == 0;
+  if (!same) {
+    snprintf(texts[key], CONFIG_TEXT_MAX, "%s", value);
+    dirty |= 1UL << key;
+  }
+  portEXIT_CRITICAL(&lock);
+  if (!same) changed(commit);
+}
+
+bool configBytes(ConfigKey key, void* out, size_t size) {
+  (void)key;
+  portENTER_CRITICAL(&lock);
+  bool found = blobLen == size;
+  if (found) memcpy(out, blob, size);
+  portEXIT_CRITICAL(&lock);
+  return found;
+}
+
+void setConfigBytes(ConfigKey key, const void* value, size_t size, ConfigCommit commit) {
+  if (size > CONFIG_BLOB_MAX) return;
+  portENTER_CRITICAL(&lock);
+  bool same = blobLen == size && memcmp(blob, value, size) == 0;
+  if (!same) {
+    memcpy(blob, value, size);
+    blobLen = size;
+    dirty |= 1UL << key;
+  }
+  portEXIT_CRITICAL(&lock);
+  if (!same) changed(commit);
+}
+
+bool configDirty() {
+  return dirty != 0;
+}
+
+void flushConfigStore() {
+  bool values[CONFIG_KEYS];
+  uint32_t numberValues[CONFIG_KEYS];
+  char text[CONFIG_TEXT_MAX];
+  uint8_t bytes[CONFIG_BLOB_MAX];
+  size_t bytesLen = 0;
+  portENTER_CRITICAL(&lock);
+  uint32_t writing = dirty;
+  dirty = 0;
+  for (int i = 0; i < CONFIG_KEYS; i++) {
+    if (!(writing & 1UL << i) || entries[i].type == CONFIG_TEXT) continue;
+    bool unchanged;
+    if (entries[i].type == CONFIG_BLOB) {
+      memcpy(bytes, blob, blobLen);
+      bytesLen = blobLen;
+      unchanged = bytesLen == storedBlobLen && memcmp(bytes, storedBlob, bytesLen) == 0;
+    } else if (entries[i].type == CONFIG_NUMBER) {
+      numberValues[i] = numbers[i];
+      unchanged = numberValues[i] == storedNumbers[i];
+    } else {
+      values[i] = bools[i];
+      unchanged = values[i] == storedBools[i];
+    }
+    if (unchanged) {
+      writing &= ~(1UL << i); // changed back before the commit
+      stats.unchanged++;
+    }
+  }
+  portEXIT_CRITICAL(&lock);
+  if (!writing) return;
+
+  stats.commits++;
+  Preferences prefs;
+  uint32_t failed = 0;
+  for (int i = 0; i < CONFIG_KEYS; i++) {
+    if (!(writing & 1UL << i)) continue;
+    const ConfigEntry& entry = entries[i];
+    prefs.begin(entry.space, false);
+    // The rest of this namespace goes in the same session.
+    for (int k = i; k < CONFIG_KEYS; k++) {
+      if (!(writing & 1UL << k) || strcmp(entries[k].space, entry.space) != 0) continue;
+      writing &= ~(1UL << k);
+      bool written = false;
+      switch (entries[k].type) {
+        case CONFIG_TEXT:
+          portENTER_CRITICAL(&lock);
+          memcpy(text, texts[k], CONFIG_TEXT_MAX);
+          portEXIT_CRITICAL(&lock);
+          written = prefs.putString(entries[k].key, text) == strlen(text);
+          break;
+        case CONFIG_BOOL:
+          written = prefs.putBool(entries[k].key, values[k]) != 0;
+          if (written) storedBools[k] = values[k];
+          break;
+        case CONFIG_NUMBER:
+          written = prefs.putUInt(entries[k].key, numberValues[k]) != 0;
+          if (written) storedNumbers[k] = numberValues[k];
+          break;
+        case CONFIG_BLOB:
+          written = prefs.putBytes(entries[k].key, bytes, bytesLen) == bytesLen;
+          if (written) {
+            memcpy(storedBlob, bytes, bytesLen);
+            storedBlobLen = bytesLen;
+          }
+          break;
+      }
+      if (written) {
+        stats.writes++;
+      } else {
+        failed |= 1UL << k;
+      }
+    }
+    prefs.end();
+  }
+  if (failed) {
+    LOGF_ERROR("❌ Config commit failed for %u key(s), kept for the next one", (unsigned)__builtin_popcount(failed));
+    portENTER_CRITICAL(&lock);
+    dirty |= failed;
+    portEXIT_CRITICAL(&lock);
+  }
+}
+
+// From the button in loop() as well as the control task, so the commit
+// deadline is left armed; with nothing dirty it writes nothing.
+void resetConfigStore() {
+  portENTER_CRITICAL(&lock);
+  dirty = 0;
+  for (int i = 0; i < CONFIG_KEYS; i++) {
+    bools[i] = storedBools[i] = entries[i].defaultBool;
+    numbers[i] = storedNumbers[i] = 0;
+    texts[i][0] = '\0';
+  }
+  blobLen = storedBlobLen = 0;
+  portEXIT_CRITICAL(&lock);
+
+  Preferences prefs;
+  for (int i = 0; i < CONFIG_KEYS; i++) {
+    bool cleared = false;
+    for (int k = 0; k < i && !cleared; k++) cleared = strcmp(entries[k].space, entries[i].space) == 0;
+    if (cleared) continue;
+    prefs.begin(entries[i].space, false);
+    prefs.clear();
+    prefs.end();
+  }
+}
+
+ConfigStoreStats configStoreStats() {
+  return stats;
+}
@@ -0,0 +1,71 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <Arduino.h>
+
+// The small settings kept in NVS, read once at boot into RAM. Readers never
+// open Preferences; writers change the RAM copy and mark the key dirty, and
+// the dirty keys are written together, one Preferences session per
+// namespace:
+//
+//   CONFIG_COMMIT_LATER  from controlDeadlines, CONFIG_COMMIT_DELAY_MS after
+//                        the last change and at most CONFIG_COMMIT_MAX_MS
+//                        after the first, so a value flipped back and forth
+//                        costs one write or none. Only from the task that
+//                        runs controlDeadlines (the control task, or loop()
+//                        in setup mode).
+//   CONFIG_COMMIT_NOW    before returning, from any task.
+//
+// A bool, number or blob that ends up where NVS already has it is not
+// written at all.
+// flushConfigStore() goes before every ESP.restart(), so a restart loses
+// nothing; a power cut loses at most the last CONFIG_COMMIT_DELAY_MS.
+//
+// IR codes stay in irCodes.cpp: they are blobs written once per learning.
+// CONFIG_LAST_STATE is the one blob here, the state snapshot the device
+// shows at boot before the cloud answers (FirestoreServices.cpp).
+
+#define CONFIG_TEXT_MAX 65 // a WPA2 passphrase and its terminator
+#define CONFIG_BLOB_MAX 320
+#define CONFIG_COMMIT_DELAY_MS 5000UL
+#define CONFIG_COMMIT_MAX_MS 60000UL
+
+enum ConfigKey : uint8_t {
+  CONFIG_PROVISIONED,     // setup/provisioned
+  CONFIG_MODEL,           // setup/model
+  CONFIG_NAME,            // setup/name
+  CONFIG_SSID,            // setup/ssid
+  CONFIG_PASS,            // setup/pass
+  CONFIG_ECO_CAN_TURN_ON, // eco/ecoCanTurnOn
+  CONFIG_LAN_TOKEN,       // lan/token
+  CONFIG_LAST_STATE,      // state/last, a blob
+  CONFIG_AIR_BASELINE,    // air/baseline, the CCS811's (airQuality.h); 0 if none
+  CONFIG_KEYS
+};
+
+enum ConfigCommit : uint8_t { CONFIG_COMMIT_LATER, CONFIG_COMMIT_NOW };
+
+struct ConfigStoreStats {
+  unsigned long commits;   // flushes that found dirty keys
+  unsigned long writes;    // keys written to NVS
+  unsigned long unchanged; // dirty bools, numbers and blobs already in NVS, not written
+};
+
+void loadConfigStore(); // first thing in setup()
+bool configBool(ConfigKey key);
+const char* configString(ConfigKey key); // "" when unset
+uint32_t configNumber(ConfigKey key);    // 0 when unset
+void setConfigBool(ConfigKey key, bool value, ConfigCommit commit = CONFIG_COMMIT_LATER);
+void setConfigString(ConfigKey key, const char* value, ConfigCommit commit = CONFIG_COMMIT_LATER);
+void setConfigNumber(ConfigKey key, uint32_t value, ConfigCommit commit = CONFIG_COMMIT_LATER);
+// False, leaving `out` alone, unless NVS held exactly `size` bytes.
+bool configBytes(ConfigKey key, void* out, size_t size);
+void setConfigBytes(ConfigKey key, const void* value, size_t size, ConfigCommit commit = CONFIG_COMMIT_LATER);
+bool configDirty();
+void flushConfigStore();
+// Factory reset: clears every namespace above in NVS and drops the RAM copy
+// and anything not yet committed, so the next boot finds the defaults.
+void resetConfigStore();
+ConfigStoreStats configStoreStats();
+
+#endif
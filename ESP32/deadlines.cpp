@@ -0,0 +1,126 @@
+#include "deadlines.h"
+#include "log.h"
+
+DeadlineQueue networkDeadlines = {"network"};
+DeadlineQueue controlDeadlines = {"control"};
+DeadlineQueue sensorDeadlines = {"sensor"};
+
+static bool before(const Deadline* a, const Deadline* b) {
+  return (long)(a->dueMs - b->dueMs) < 0;
+}
+
+static void place(DeadlineQueue& queue, uint8_t i, Deadline* job) {
+  queue.heap[i] = job;
+  job->slot = i + 1;
+}
+
+static void siftUp(DeadlineQueue& queue, uint8_t i) {
+  Deadline* job = queue.heap[i];
+  while (i > 0) {
+    uint8_t parent = (i - 1) / 2;
+    if (!before(job, queue.heap[parent])) break;
+    place(queue, i, queue.heap[parent]);
+    i = parent;
+  }
+  place(queue, i, job);
+}
+
+static void siftDown(DeadlineQueue& queue, uint8_t i) {
+  Deadline* job = queue.heap[i];
+  for (;;) {
+    uint8_t child = 2 * i + 1;
+    if (child >= queue.count) break;
+    if (child + 1 < queue.count && before(queue.heap[child + 1], queue.heap[child])) child++;
+    if (!before(queue.heap[child], job)) break;
+    place(queue, i, queue.heap[child]);
+    i = child;
+  }
+  place(queue, i, job);
+}
+
+static void remove(DeadlineQueue& queue, Deadline& job) {
+  uint8_t i = job.slot - 1;
+  job.slot = 0;
+  if (--queue.count == i) return;
+  Deadline* moved = queue.heap[queue.count];
+  place(queue, i, moved);
+  siftDown(queue, i);
+  siftUp(queue, moved->slot - 1);
+}
+
+static void armAt(DeadlineQueue& queue, Deadline& job, unsigned long dueMs) {
+  if (!job.queue) {
+    if (queue.jobCount == DEADLINE_QUEUE_MAX) {
+      LOGF_WARN("🚫 No room for deadline %s on %s", job.name, queue.task);
+      return;
+    }
+    job.queue = &queue;
+    queue.jobs[queue.jobCount++] = &job;
+  }
+  job.dueMs = dueMs;
+  if (job.slot) {
+    siftDown(queue, job.slot - 1);
+    siftUp(queue, job.slot - 1);
+    return;
+  }
+  place(queue, queue.count++, &job);
+  siftUp(queue, queue.count - 1);
+}
+
+void armDeadline(DeadlineQueue& queue, Deadline& job, unsigned long delayMs) {
+  armAt(queue, job, millis() + delayMs);
+}
+
+void cancelDeadline(Deadline& job) {
+  if (job.slot) remove(*job.queue, job);
+}
+
+bool deadlineArmed(const Deadline& job) {
+  return job.slot != 0;
+}
+
+static void record(Deadline& job, unsigned long now) {
+  DeadlineStats& s = job.stats;
+  unsigned long late = now - job.dueMs;
+  if (s.runs > 0) {
+    unsigned long jitter = late > s.lastLateMs ? late - s.lastLateMs : s.lastLateMs - late;
+    if (jitter > s.jitterMaxMs) s.jitterMaxMs = jitter;
+  }
+  s.runs++;
+  s.lateSumMs += late;
+  if (late > s.lateMaxMs) s.lateMaxMs = late;
+  s.lastLateMs = late;
+}
+
+void runDueDeadlines(DeadlineQueue& queue) {
+  unsigned long now = millis();
+  // Bounded by what was queued on entry: a job that re-arms itself for "now"
+  // runs on the next pass instead of spinning here.
+  for (uint8_t n = queue.count; n > 0 && queue.count > 0; n--) {
+    Deadline& job = *queue.heap[0];
+    if ((long)(now - job.dueMs) < 0) break;
+    record(job, now);
+    remove(queue, job);
+    if (job.periodMs) {
+      unsigned long next = job.dueMs + job.periodMs;
+      if ((long)(now - next) >= 0) next = now + job.periodMs; // fell behind: skip
+      armAt(queue, job, next);
+    }
+    if (job.run) job.run();
+  }
+}
+
+unsigned long deadlineDueInMs(const DeadlineQueue& queue) {
+  if (queue.count == 0) return DEADLINE_IDLE_MS;
+  long left = (long)(queue.heap[0]->dueMs - millis());
+  return left > 0 ? (unsigned long)left : 0;
+}
+
+void logDeadlineStats(const DeadlineQueue& queue) {
+  for (uint8_t i = 0; i < queue.jobCount; i++) {
+    const Deadline& job = *queue.jobs[i];
+    const DeadlineStats& s = job.stats;
+    LOGF("⏲️ %s/%s: %lu runs, late avg %lu max %lu ms, jitter max %lu ms", queue.task, job.name, s.runs,
+         s.runs ? s.lateSumMs / s.runs : 0, s.lateMaxMs, s.jitterMaxMs);
+  }
+}
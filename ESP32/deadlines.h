@@ -0,0 +1,62 @@
+#ifndef DEADLINES_H
+#define DEADLINES_H
+
+#include <Arduino.h>
+
+// Every periodic or delayed job of a task sits on that task's DeadlineQueue,
+// a min-heap ordered by due time. The task blocks for deadlineDueInMs() (or
+// until its event queue wakes it) and then runDueDeadlines() runs whatever
+// is due, so no task wakes on a fixed tick just to find nothing to do.
+//
+// A job is a static Deadline. Periodic jobs re-arm themselves one period
+// after their previous due time, so lateness does not accumulate; a job that
+// fell more than a period behind skips the missed runs. A job without `run`
+// only wakes the task, for owners that re-evaluate their state after every
+// wake (the modes). Only the owning task touches a queue.
+
+#define DEADLINE_QUEUE_MAX 8
+#define DEADLINE_IDLE_MS (60 * 1000UL) // wait when nothing is armed
+
+struct DeadlineQueue;
+
+struct DeadlineStats {
+  unsigned long runs;
+  unsigned long lateSumMs;  // due time to run, summed over runs
+  unsigned long lateMaxMs;
+  unsigned long jitterMaxMs; // largest change in lateness between two runs
+  unsigned long lastLateMs;
+};
+
+struct Deadline {
+  const char* name = nullptr;
+  void (*run)() = nullptr;
+  unsigned long periodMs = 0;     // 0 for a one-shot
+  unsigned long dueMs = 0;
+  uint8_t slot = 0;               // heap index + 1, 0 while not armed
+  DeadlineQueue* queue = nullptr; // set when first armed
+  DeadlineStats stats = {};
+};
+
+struct DeadlineQueue {
+  const char* task = nullptr;
+  Deadline* heap[DEADLINE_QUEUE_MAX] = {};
+  uint8_t count = 0;
+  Deadline* jobs[DEADLINE_QUEUE_MAX] = {}; // every job ever armed here, for the stats
+  uint8_t jobCount = 0;
+};
+
+extern DeadlineQueue networkDeadlines;
+extern DeadlineQueue controlDeadlines; // also run by loop() in setup mode
+extern DeadlineQueue sensorDeadlines;
+
+// (Re)arms a job to run `delayMs` from now, replacing its previous due time.
+void armDeadline(DeadlineQueue& queue, Deadline& job, unsigned long delayMs);
+void cancelDeadline(Deadline& job);
+bool deadlineArmed(const Deadline& job);
+// Runs the jobs that were due when it was called, earliest first.
+void runDueDeadlines(DeadlineQueue& queue);
+// Milliseconds until the earliest job is due, DEADLINE_IDLE_MS if none is.
+unsigned long deadlineDueInMs(const DeadlineQueue& queue);
+void logDeadlineStats(const DeadlineQueue& queue);
+
+#endif
@@ -0,0 +1,47 @@
+#include "deviceState.h"
+
+static const char* const modeNames[AC_MODES] = {"regular", "timer", "eco", "motion"};
+static const char* const idleFlagNames[IDLE_FLAGS] = {"active", "user_prompt", "continue"};
+static const char* const modelNames[AC_MODELS] = {"Electra", "Samsung", "LG", "Custom"};
+
+const char* acModeName(AcMode mode) {
+  return mode < AC_MODES ? modeNames[mode] : "regular";
+}
+
+const char* idleFlagName(IdleFlag flag) {
+  return flag < IDLE_FLAGS ? idleFlagNames[flag] : "active";
+}
+
+const char* acModelName(AcModel model) {
+  return model < AC_MODELS ? modelNames[model] : "unknown";
+}
+
+static int findName(const char* const* names, int count, const char* name, bool ignoreCase) {
+  if (name == nullptr) return -1;
+  for (int i = 0; i < count; i++) {
+    if ((ignoreCase ? strcasecmp(names[i], name) : strcmp(names[i], name)) == 0) return i;
+  }
+  return -1;
+}
+
+bool parseAcMode(const char* name, AcMode& out) {
+  int i = findName(modeNames, AC_MODES, name, false);
+  if (i < 0) return false;
+  out = (AcMode)i;
+  return true;
+}
+
+bool parseIdleFlag(const char* name, IdleFlag& out) {
+  int i = findName(idleFlagNames, IDLE_FLAGS, name, false);
+  if (i < 0) return false;
+  out = (IdleFlag)i;
+  return true;
+}
+
+// The setup page stores "custom" while the app writes "Custom".
+bool parseAcModel(const char* name, AcModel& out) {
+  int i = findName(modelNames, AC_MODELS, name, true);
+  if (i < 0) return false;
+  out = (AcModel)i;
+  return true;
+}
@@ -0,0 +1,24 @@
+#ifndef DEVICE_STATE_H
+#define DEVICE_STATE_H
+
+#include <Arduino.h>
+
+// Typed device state. The RTDB and the setup page carry these as strings;
+// they are converted here, at the boundary, and compared as enums elsewhere.
+
+enum AcMode : uint8_t { MODE_REGULAR, MODE_TIMER, MODE_ECO, MODE_MOTION, AC_MODES };
+
+enum IdleFlag : uint8_t { IDLE_ACTIVE, IDLE_USER_PROMPT, IDLE_CONTINUE, IDLE_FLAGS };
+
+enum AcModel : uint8_t { MODEL_ELECTRA, MODEL_SAMSUNG, MODEL_LG, MODEL_CUSTOM, AC_MODELS };
+
+const char* acModeName(AcMode mode);
+const char* idleFlagName(IdleFlag flag);
+const char* acModelName(AcModel model);
+
+// Return false and leave `out` untouched for a name they do not know.
+bool parseAcMode(const char* name, AcMode& out);
+bool parseIdleFlag(const char* name, IdleFlag& out);
+bool parseAcModel(const char* name, AcModel& out); // case-insensitive
+
+#endif
@@ -0,0 +1,179 @@
+#include <Firebase_ESP_Client.h>
+#include "deviceTasks.h"
+#include "FirestoreServices.h"
+#include "modeHandler.h"
+#include "rtdbPublisher.h"
+#include "sensorHistory.h"
+#include "airQuality.h"
+#include "lanApi.h"
+#include "deadlines.h"
+#include "metrics.h"
+#include "parameters.h"
+#include "log.h"
+
+static QueueHandle_t controlQueue = nullptr;
+static QueueHandle_t netQueue = nullptr;
+static TaskHandle_t taskHandles[DEVICE_TASKS];
+static const char* const taskNames[DEVICE_TASKS] = {"network", "control", "sensor"};
+
+static void checkToken() {
+  Firebase.ready();
+}
+
+static void reportTasks() {
+  sampleTaskStacks();
+  sampleMetrics();
+  logMetrics();
+  logDeadlineStats(networkDeadlines);
+  logDeadlineStats(controlDeadlines);
+  logDeadlineStats(sensorDeadlines);
+}
+
+static void sendDiagnostics() {
+  sampleTaskStacks();
+  sampleMetrics();
+  publishMetrics();
+}
+
+static void bringUpCloud();
+
+static Deadline cloudDeadline = {"cloud", bringUpCloud};
+static Deadline tokenDeadline = {"token", checkToken, FIREBASE_CHECK_MS};
+static Deadline heartbeatDeadline = {"heartbeat", updateOnlineStatus, HEARTBEAT_INTERVAL};
+static Deadline reportDeadline = {"report", reportTasks, TASK_STACK_REPORT_MS};
+static Deadline diagnosticsDeadline = {"diagnostics", sendDiagnostics, DIAGNOSTICS_INTERVAL_MS};
+// A CCS811 result whose edge was missed, or whose read failed, holds nINT low
+// and raises no edge after it.
+static void pollAirQuality() {
+  if (airQualityPending()) updateAirQuality();
+}
+
+static Deadline readDeadline = {"read", updateSensorReadings, READ_INTERVAL};
+static Deadline airPollDeadline = {"air poll", pollAirQuality, AIR_POLL_MS};
+static Deadline historyDeadline = {"history", recordHistorySample, HISTORY_SAMPLE_INTERVAL};
+static Deadline batchDeadline = {"batch", queueHistoryUpload, HISTORY_UPLOAD_INTERVAL};
+
+// The token upkeep, the heartbeat and the diagnostics start once the stream
+// is open.
+static void bringUpCloud() {
+  unsigned long againMs = connectCloud();
+  if (cloudConnected() && !deadlineArmed(tokenDeadline)) {
+    armDeadline(networkDeadlines, tokenDeadline, FIREBASE_CHECK_MS);
+    armDeadline(networkDeadlines, heartbeatDeadline, 0);
+    armDeadline(networkDeadlines, diagnosticsDeadline, DIAGNOSTICS_INTERVAL_MS);
+  }
+  if (againMs) armDeadline(networkDeadlines, cloudDeadline, againMs);
+}
+
+static void networkTask(void* param) {
+  (void)param;
+  armDeadline(networkDeadlines, cloudDeadline, 0);
+  armDeadline(networkDeadlines, reportDeadline, TASK_STACK_REPORT_MS);
+  for (;;) {
+    // Take everything queued before flushing, so it shares one request.
+    NetRequest request;
+    bool received = xQueueReceive(netQueue, &request, pdMS_TO_TICKS(deadlineDueInMs(networkDeadlines))) == pdTRUE;
+    unsigned long startUs = micros();
+    while (received) {
+      performNetRequest(request);
+      received = xQueueReceive(netQueue, &request, 0) == pdTRUE;
+    }
+    runDueDeadlines(networkDeadlines);
+    recordMetricUs(METRIC_NETWORK_RUN, micros() - startUs);
+  }
+}
+
+static void controlTask(void* param) {
+  (void)param;
+  for (;;) {
+    ControlEvent event;
+    bool received = xQueueReceive(controlQueue, &event, pdMS_TO_TICKS(deadlineDueInMs(controlDeadlines))) == pdTRUE;
+    unsigned long startUs = micros();
+    if (received) {
+      switch (event.type) {
+        case CONTROL_COMMAND:
+          noteCommand();
+          handleCommand(event);
+          break;
+        case CONTROL_SCHEDULE: applySchedule(event.schedule); break;
+        case CONTROL_MOTION: noteMotion(); break;
+        case CONTROL_RESTORE: applyCloudState(); break;
+      }
+    }
+    runDueDeadlines(controlDeadlines);
+    // Whatever woke the task may have changed the power or the mode.
+    updateTotalHours();
+    handleMode();
+    saveLastState();
+    recordMetricUs(METRIC_CONTROL_RUN, micros() - startUs);
+  }
+}
+
+static void sensorTask(void* param) {
+  (void)param;
+  armDeadline(sensorDeadlines, readDeadline, 0);
+  armDeadline(sensorDeadlines, historyDeadline, HISTORY_SAMPLE_INTERVAL);
+  armDeadline(sensorDeadlines, batchDeadline, HISTORY_UPLOAD_INTERVAL);
+  startAirQuality();
+  if (airQualityPresent()) armDeadline(sensorDeadlines, airPollDeadline, AIR_POLL_MS);
+  for (;;) {
+    bool notified = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(deadlineDueInMs(sensorDeadlines))) > 0;
+    unsigned long startUs = micros();
+    if (notified) updateAirQuality();
+    runDueDeadlines(sensorDeadlines);
+    recordMetricUs(METRIC_SENSOR_RUN, micros() - startUs);
+  }
+}
+
+void startDeviceTasks() {
+  if (controlQueue) return;
+  controlQueue = xQueueCreate(CONTROL_QUEUE_LEN, sizeof(ControlEvent));
+  netQueue = xQueueCreate(NET_QUEUE_LEN, sizeof(NetRequest));
+  // Control outranks network so a command is on air before its result is written.
+  xTaskCreatePinnedToCore(networkTask, taskNames[TASK_NETWORK], NETWORK_TASK_STACK, nullptr, 2,
+                          &taskHandles[TASK_NETWORK], NETWORK_TASK_CORE);
+  xTaskCreatePinnedToCore(controlTask, taskNames[TASK_CONTROL], CONTROL_TASK_STACK, nullptr, 3,
+                          &taskHandles[TASK_CONTROL], CONTROL_TASK_CORE);
+  xTaskCreatePinnedToCore(sensorTask, taskNames[TASK_SENSOR], SENSOR_TASK_STACK, nullptr, 1,
+                          &taskHandles[TASK_SENSOR], SENSOR_TASK_CORE);
+  LOG_INFO("🧵 Network, control and sensor tasks started");
+}
+
+bool deviceTasksRunning() {
+  return controlQueue != nullptr;
+}
+
+bool postControlEvent(const ControlEvent& event) {
+  if (controlQueue && xQueueSend(controlQueue, &event, 0) == pdTRUE) return true;
+  LOG_WARN("⚠️ Control queue full, event dropped");
+  return false;
+}
+
+bool postNetRequest(const NetRequest& request) {
+  lanPublish(request); // LAN clients need not wait for a round trip in progress
+  if (netQueue && xQueueSend(netQueue, &request, 0) == pdTRUE) return true;
+  LOGF_WARN("⚠️ Network queue full, %s not sent", request.path);
+  return false;
+}
+
+void IRAM_ATTR postMotionFromISR() {
+  if (!controlQueue) return;
+  static ControlEvent motion = {CONTROL_MOTION, {}, {}, 0, {}};
+  BaseType_t woken = pdFALSE;
+  xQueueSendFromISR(controlQueue, &motion, &woken);
+  portYIELD_FROM_ISR(woken);
+}
+
+void IRAM_ATTR wakeSensorTaskFromISR() {
+  if (!taskHandles[TASK_SENSOR]) return;
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(taskHandles[TASK_SENSOR], &woken);
+  portYIELD_FROM_ISR(woken);
+}
+
+void sampleTaskStacks() {
+  static const MetricGauge gauges[DEVICE_TASKS] = {METRIC_STACK_NETWORK, METRIC_STACK_CONTROL, METRIC_STACK_SENSOR};
+  for (int i = 0; i < DEVICE_TASKS; i++) {
+    if (taskHandles[i]) setMetricGauge(gauges[i], uxTaskGetStackHighWaterMark(taskHandles[i]));
+  }
+}
@@ -0,0 +1,103 @@
+#ifndef DEVICE_TASKS_H
+#define DEVICE_TASKS_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include "FirestoreServices.h"
+#include "command.h"
+
+// The device runs as three tasks that only talk over queues, started by
+// setup() before the network is up:
+//
+//   network (core 0)  Cloud bring-up (connectCloud() in FirestoreServices.h),
+//                     then Firebase token upkeep, heartbeat, and every RTDB write
+//                     or fetch, taken from netQueue in order. Writes are
+//                     combined by the publisher in rtdbPublisher.h.
+//   control (core 1)  Owns the device state in FirestoreServices.h. It
+//                     executes commands and schedules from controlQueue and
+//                     runs the modes, IR, LEDs and buzzer.
+//   sensor  (core 1)  Samples the DHT and PIR and queues uploads when the
+//                     readings change, and keeps the room history in
+//                     sensorHistory.h. It reads the CCS811 (airQuality.h)
+//                     when its data-ready interrupt notifies the task. PIR
+//                     edges also reach the control task directly, from the
+//                     interrupt in powerSave.cpp.
+//
+// Each task sleeps until its queue or a notification delivers or its next
+// deadline in deadlines.h is due; nothing runs on a fixed tick.
+//
+// The library's stream task and the LAN server (lanApi.h) only parse
+// commands and post them to controlQueue. Anything bound for the cloud is
+// copied into a NetRequest, so the network task never reads control-owned
+// state; postNetRequest() also hands it to LAN clients.
+
+#define NETWORK_TASK_STACK 8192
+#define CONTROL_TASK_STACK 6144
+#define SENSOR_TASK_STACK 4096 // LittleFS calls for the history spill
+#define NETWORK_TASK_CORE 0
+#define CONTROL_TASK_CORE 1
+#define SENSOR_TASK_CORE 1
+#define CONTROL_QUEUE_LEN 8
+#define NET_QUEUE_LEN 16
+#define FIREBASE_CHECK_MS 1000 // token upkeep
+#define TASK_STACK_REPORT_MS (10 * 60 * 1000UL) // metrics and deadline stats on serial
+
+enum DeviceTask { TASK_NETWORK, TASK_CONTROL, TASK_SENSOR, DEVICE_TASKS };
+
+// CONTROL_RESTORE: the node's state is ready for applyCloudState().
+enum ControlEventType : uint8_t { CONTROL_COMMAND, CONTROL_SCHEDULE, CONTROL_MOTION, CONTROL_RESTORE };
+
+struct ControlEvent {
+  ControlEventType type;
+  CommandAction action;
+  AcMode mode; // AC_MODES when the command named no known mode
+  int duration;
+  WeeklySchedule schedule;
+};
+
+enum NetOp : uint8_t {
+  NET_SET_STRING,
+  NET_SET_BOOL,
+  NET_SET_INT,
+  NET_SET_FLOAT,
+  NET_SENSORS,
+  NET_FETCH_SCHEDULE,
+  NET_HISTORY, // the batch staged in sensorHistory.cpp
+};
+
+// How soon a write must reach the cloud; see rtdbPublisher.h.
+enum PublishPriority : uint8_t { PUBLISH_NOW, PUBLISH_SOON, PUBLISH_LAZY };
+
+struct NetRequest {
+  NetOp op;
+  PublishPriority priority;
+  bool transient;     // replaced soon anyway, so not journaled (stateJournal.h)
+  char path[32];      // below the device node, e.g. "/status/mode"
+  const char* okLog;  // string literal logged on success
+  union {
+    bool b;
+    long long i;
+    float f;
+    char s[24];
+    struct {
+      float temperature;
+      float humidity;
+      bool motion;
+      bool air;      // eco2 and tvoc hold a reading
+      uint16_t eco2; // ppm
+      uint16_t tvoc; // ppb
+    } sensors;
+  };
+};
+
+void startDeviceTasks();
+bool deviceTasksRunning();
+bool postControlEvent(const ControlEvent& event);
+bool postNetRequest(const NetRequest& request);
+void postMotionFromISR(); // PIR rising edge
+void wakeSensorTaskFromISR(); // CCS811 data ready
+void sampleTaskStacks(); // into the stack gauges of metrics.h
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef HOST_BENCH_UTIL_H
+#define HOST_BENCH_UTIL_H
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// Sample collector with nearest-rank percentiles.
+class LatencySeries {
+public:
+    void reserve(size_t n) { v_.reserve(n); }
+    void add(double v) { v_.push_back(v); sorted_ = false; }
+    size_t count() const { return v_.size(); }
+
+    double percentile(double p) const {
+        if (v_.empty()) return 0;
+        sort();
+        size_t rank = (size_t)(p / 100.0 * v_.size() + 0.5);
+        if (rank == 0) rank = 1;
+        if (rank > v_.size()) rank = v_.size();
+        return v_[rank - 1];
+    }
+
+    double max() const { return percentile(100); }
+
+    double mean() const {
+        if (v_.empty()) return 0;
+        double sum = 0;
+        for (double x : v_) sum += x;
+        return sum / v_.size();
+    }
+
+    size_t countAbove(double threshold) const {
+        return (size_t)std::count_if(v_.begin(), v_.end(), [&](double x) { return x > threshold; });
+    }
+
+    static void printHeader(const char* unitLabel) {
+        printf("%-22s %10s %10s %10s %10s %10s %10s\n", unitLabel, "mean", "p50", "p90", "p99", "p99.9", "max");
+    }
+
+    void printRow(const char* label) const {
+        printf("%-22s %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f\n", label, mean(),
+               percentile(50), percentile(90), percentile(99), percentile(99.9), max());
+    }
+
+private:
+    void sort() const {
+        if (!sorted_) std::sort(v_.begin(), v_.end());
+        sorted_ = true;
+    }
+    mutable std::vector<double> v_;
+    mutable bool sorted_ = true;
+};
+
+inline double hostMicros() {
+    using namespace std::chrono;
+    return duration<double, std::micro>(steady_clock::now().time_since_epoch()).count();
+}
+
+// "--name value" lookup with a default.
+inline long benchArg(int argc, char** argv, const char* name, long def) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], name) == 0) return strtol(argv[i + 1], nullptr, 10);
+    }
+    return def;
+}
+
+inline const char* benchArgStr(int argc, char** argv, const char* name, const char* def) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], name) == 0) return argv[i + 1];
+    }
+    return def;
+}
+
+#endif
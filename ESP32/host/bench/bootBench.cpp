@@ -0,0 +1,168 @@
+// Boot time: how soon after power-on the device shows its last state and
+// answers a command, from the phone on the LAN (retrying every 100 ms from
+// power-on) or through the cloud (queued before power-on), and when the
+// clock is set. Each boot runs in a child process so the firmware's statics
+// start fresh, as on the chip; a restart carries over the NVS the previous
+// run left, as an image.
+//
+//   first boot       NVS as provisioning leaves it
+//   restart          NVS after a minute of running
+//   router down      restart with the access point back only after
+//                    --router-down-s
+//
+//   bootBench [--router-down-s 30]
+
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "benchUtil.h"
+#include "deviceFixture.h"
+#include "FirestoreServices.h"
+#include "deviceTasks.h"
+#include "parameters.h"
+
+void setup();
+void loop();
+
+static const char* const kToken = "Zk3q8Hd2kPz0bXvLm4T9wY";
+static const unsigned long kGiveUpMs = 90000;
+
+enum Probe { PROBE_LAN, PROBE_CLOUD };
+
+struct BootTimes {
+    double setupMs;
+    double stateMs; // lights, relay and timer as the node has them
+    double timeMs;
+    double commandMs;
+};
+
+static void seedNode() {
+    fakeReset();
+    fakeSetSerialEcho(false);
+    fakeSetWallClock(1752468900);
+    fakeSetPin(PIRPIN, LOW);
+    seedFixtureDevice("Custom");
+    FirebaseJson status;
+    status.set("status/lightsOn", true);
+    status.set("status/relayOn", true);
+    status.set("status/currentTimer", 45);
+    fakeRtdbSeed(kFixtureDevicePath, status);
+    Preferences prefs;
+    prefs.begin("lan", false);
+    prefs.putString("token", kToken);
+    prefs.end();
+}
+
+static double nowMs() {
+    return fakeMicros() / 1000.0;
+}
+
+// Runs in the child. -1 for what never happened.
+static BootTimes boot(Probe probe, unsigned long routerDownMs) {
+    BootTimes times = {-1, -1, -1, -1};
+    fakeColdBoot();
+    if (routerDownMs) fakeSetWifiConnected(false);
+    if (probe == PROBE_CLOUD) fakePushCommandAt(fixtureCommand("switch_power"), 0);
+
+    // The phone's requests cannot reach a device still inside setup(); the
+    // first one goes out when it returns.
+    setup();
+    times.setupMs = nowMs();
+    fakeStartLoopTask(loop);
+    int request = 0;
+    unsigned long long nextSendUs = 0;
+    while (fakeMicros() < kGiveUpMs * 1000ULL) {
+        if (routerDownMs && fakeMicros() >= routerDownMs * 1000ULL) fakeSetWifiConnected(true);
+        if (times.stateMs < 0 && lights_on && relay_on && duration == 45) times.stateMs = nowMs();
+        if (times.timeMs < 0 && time(nullptr) > 1000000000) times.timeMs = nowMs();
+        if (times.commandMs < 0 && !fakeIrFrames().empty()) times.commandMs = fakeIrFrames()[0].atUs / 1000.0;
+        if (probe == PROBE_LAN && times.commandMs < 0 && fakeMicros() >= nextSendUs) {
+            const FakeLanReply* reply = request ? fakeLanReply(request) : nullptr;
+            if (!request || (reply && reply->status != 200)) {
+                request = fakeLanRequestAt("POST", "/command", kToken, "{\"action\":\"switch_power\"}", fakeMicros());
+                nextSendUs = fakeMicros() + 100000ULL;
+            }
+        }
+        if (times.stateMs >= 0 && times.timeMs >= 0 && times.commandMs >= 0) break;
+        fakeRunTasksFor(10);
+    }
+    return times;
+}
+
+// Forks, loads `image` into the child's NVS and runs `run` there.
+template <typename Run>
+static std::string inChild(const std::string& image, Run run) {
+    int fds[2];
+    if (pipe(fds) != 0) exit(1);
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        fakeLoadNvsImage(image);
+        std::string out = run();
+        fflush(stdout);
+        if (write(fds[1], out.data(), out.size()) != (ssize_t)out.size()) _exit(1);
+        _exit(0);
+    }
+    close(fds[1]);
+    std::string out;
+    char buf[4096];
+    ssize_t n;
+    while ((n = read(fds[0], buf, sizeof(buf))) > 0) out.append(buf, n);
+    close(fds[0]);
+    waitpid(pid, nullptr, 0);
+    return out;
+}
+
+static BootTimes bootInChild(const std::string& image, Probe probe, unsigned long routerDownMs) {
+    std::string out = inChild(image, [&]() {
+        BootTimes times = boot(probe, routerDownMs);
+        return std::string((const char*)&times, sizeof(times));
+    });
+    BootTimes times = {-1, -1, -1, -1};
+    if (out.size() == sizeof(times)) memcpy(&times, out.data(), sizeof(times));
+    return times;
+}
+
+static void printTime(double ms) {
+    if (ms < 0) {
+        printf(" %12s", "never");
+    } else {
+        printf(" %12.0f", ms);
+    }
+}
+
+static void printScenario(const char* label, const std::string& image, unsigned long routerDownMs) {
+    BootTimes lan = bootInChild(image, PROBE_LAN, routerDownMs);
+    BootTimes cloud = bootInChild(image, PROBE_CLOUD, routerDownMs);
+    printf("%-14s", label);
+    printTime(lan.setupMs);
+    printTime(lan.stateMs);
+    printTime(lan.commandMs);
+    printTime(cloud.commandMs);
+    printTime(lan.timeMs);
+    printf("\n");
+}
+
+int main(int argc, char** argv) {
+    long routerDownS = benchArg(argc, argv, "--router-down-s", 30);
+
+    seedNode();
+    std::string provisioned = fakeNvsImage();
+    // A minute of running leaves whatever the firmware keeps across a restart.
+    std::string running = inChild(provisioned, []() {
+        fakeColdBoot();
+        setup();
+        fakeStartLoopTask(loop);
+        fakeRunTasksFor(60000);
+        return fakeNvsImage();
+    });
+
+    printf("boot timeline, virtual ms from power-on (model Custom, router down %lds)\n\n", routerDownS);
+    printf("%-14s %12s %12s %12s %12s %12s\n", "", "setup done", "last state", "LAN cmd IR", "cloud cmd IR",
+           "clock set");
+    printScenario("first boot", provisioned, 0);
+    printScenario("restart", running, 0);
+    printScenario("router down", running, routerDownS * 1000);
+    return 0;
+}
@@ -0,0 +1,60 @@
+// Action dispatch cost for every registered action plus an unknown one:
+// the registry's perfect-hash lookup against the String compare chain that
+// handleCommand() and execute() used to walk (reproduced below), in host ns.
+//
+//   commandBench [--calls 2000000]
+
+#include "benchUtil.h"
+#include "deviceFixture.h"
+#include "command.h"
+
+// The old dispatch: handleCommand()'s chain, then execute()'s.
+static int stringChain(const char* name) {
+    String action = name;
+    if (action == "set_mode") return ACTION_SET_MODE;
+    else if (action == "apply_schedule") return ACTION_APPLY_SCHEDULE;
+    else if (action == "reset_maintenance") return ACTION_RESET_MAINTENANCE;
+    else if (action == "ignore_motion") return ACTION_IGNORE_MOTION;
+    else if (action == "switch_lights") return ACTION_SWITCH_LIGHTS;
+    else if (action == "switch_relay") return ACTION_SWITCH_RELAY;
+    else if (action == "reset_device") return ACTION_RESET_DEVICE;
+    if (action == "switch_power" || action == "eco_switch_power") {
+        return action == "eco_switch_power" ? ACTION_ECO_SWITCH_POWER : ACTION_SWITCH_POWER;
+    } else if (action == "temp_up" || action == "temp_down") {
+        return action == "temp_up" ? ACTION_TEMP_UP : ACTION_TEMP_DOWN;
+    }
+    return ACTION_UNKNOWN;
+}
+
+static volatile int sink;
+
+template <typename Fn>
+static double nsPerCall(Fn fn, const char* name, long calls) {
+    double t0 = hostMicros();
+    for (long i = 0; i < calls; i++) sink = fn(name);
+    return (hostMicros() - t0) * 1000.0 / calls;
+}
+
+int main(int argc, char** argv) {
+    long calls = benchArg(argc, argv, "--calls", 2000000);
+    char names[COMMAND_ACTIONS + 1][24];
+    for (int i = 0; i < COMMAND_ACTIONS; i++) snprintf(names[i], sizeof(names[i]), "%s", commandSpec((CommandAction)i).name);
+    snprintf(names[COMMAND_ACTIONS], sizeof(names[COMMAND_ACTIONS]), "open_window");
+
+    printf("action dispatch, %ld calls per action, host ns/call\n\n", calls);
+    printf("%-20s %12s %12s\n", "action", "chain", "registry");
+    double chainSum = 0, registrySum = 0;
+    for (int i = 0; i <= COMMAND_ACTIONS; i++) {
+        if (stringChain(names[i]) != lookupCommandAction(names[i])) {
+            printf("%s: lookup mismatch\n", names[i]);
+            return 1;
+        }
+        double chain = nsPerCall(stringChain, names[i], calls);
+        double registry = nsPerCall(lookupCommandAction, names[i], calls);
+        chainSum += chain;
+        registrySum += registry;
+        printf("%-20s %12.1f %12.1f\n", names[i], chain, registry);
+    }
+    printf("%-20s %12.1f %12.1f\n", "mean", chainSum / (COMMAND_ACTIONS + 1), registrySum / (COMMAND_ACTIONS + 1));
+    return 0;
+}
@@ -0,0 +1,88 @@
+#ifndef HOST_DEVICE_FIXTURE_H
+#define HOST_DEVICE_FIXTURE_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <Firebase_ESP_Client.h>
+#include <IRrecv.h>
+#include "fakeBoard.h"
+#include "irCodes.h"
+
+// RTDB node of the fake device (WiFi.macAddress() without colons).
+const char* const kFixtureDevicePath = "/devices/246F28AABBCC";
+
+// A learned 104-bit AC frame in receiver ticks (kRawTick us), as IRrecv
+// captures it: 9000/4500 us header, 560 us marks, 560/1690 us spaces, a
+// trailing mark, and a few ticks of receiver jitter on every edge.
+inline uint16_t fixtureFrameTicks(uint32_t seed, uint16_t* ticks, uint16_t bits = 104) {
+    uint16_t n = 0;
+    auto jitter = [&seed](uint16_t us) {
+        seed = seed * 1103515245u + 12345u;
+        return (uint16_t)(us / kRawTick + (int)((seed >> 16) % 7) - 3);
+    };
+    ticks[n++] = jitter(9000);
+    ticks[n++] = jitter(4500);
+    for (uint16_t bit = 0; bit < bits; bit++) {
+        ticks[n++] = jitter(560);
+        ticks[n++] = jitter((seed >> 20) & 1 ? 1690 : 560);
+    }
+    ticks[n++] = jitter(560);
+    return n;
+}
+
+inline void seedFixtureIrCode(const char* key, uint32_t seed) {
+    uint16_t ticks[2 * 104 + 3];
+    uint16_t n = fixtureFrameTicks(seed, ticks);
+    saveIrCode(key, ticks, n, kRawTick);
+}
+
+// Seeds the cloud node and NVS the way a provisioned device finds them.
+inline void seedFixtureDevice(const char* model) {
+    FirebaseJson node;
+    node.set("config/model", model);
+    node.set("config/testing", false);
+    node.set("status/currentTemperature", 24);
+    node.set("status/idleFlag", "active");
+    node.set("status/mode", "regular");
+    node.set("status/currentTimer", 30);
+    node.set("status/lightsOn", false);
+    node.set("status/relayOn", false);
+    node.set("status/powered", false);
+    node.set("maintenance/totalHours", 12.5);
+    const char* days[] = {"sunday", "monday", "tuesday", "wednesday", "thursday", "friday", "saturday"};
+    for (int i = 0; i < 7; i++) {
+        String day = String("schedule/") + days[i];
+        node.set(day + "/active", i >= 1 && i <= 5);
+        node.set(day + "/start", 800);
+        node.set(day + "/end", 1700);
+    }
+    fakeRtdbSeed(kFixtureDevicePath, node);
+
+    Preferences prefs;
+    prefs.begin("setup", false);
+    prefs.putString("model", model);
+    prefs.putString("ssid", "home");
+    prefs.putString("pass", "hunter22");
+    prefs.putBool("provisioned", true);
+    prefs.end();
+    seedFixtureIrCode("on", 1);
+    seedFixtureIrCode("off", 2);
+    seedFixtureIrCode("tempUp", 3);
+    seedFixtureIrCode("tempDown", 4);
+    fakeStats = FakeStats();
+}
+
+inline FirebaseJson fixtureCommand(const char* action) {
+    FirebaseJson cmd;
+    cmd.set("action", action);
+    return cmd;
+}
+
+inline FirebaseJson fixtureModeCommand(const char* mode, int duration = 0) {
+    FirebaseJson cmd = fixtureCommand("set_mode");
+    cmd.set("mode", mode);
+    if (duration) cmd.set("duration", duration);
+    return cmd;
+}
+
+#endif
@@ -0,0 +1,80 @@
+// What reading the device node costs: the device boots against a node that
+// also holds what the app and the device keep there besides the state
+// (users, sensors, LAN details and the room history), then the app asks it
+// to apply the schedule. Reports the peak heap the Firebase responses take
+// in the heap model of fakeBoard.h, the bytes and requests on the wire, and
+// the FirebaseJson lookups.
+//
+//   fetchBench [--history-days 7]
+
+#include "benchUtil.h"
+#include "deviceFixture.h"
+#include "parameters.h"
+
+void setup();
+void loop();
+
+// A node as it looks after a while in use.
+static void seedLivedInNode(long historyDays) {
+    seedFixtureDevice("Electra");
+    FirebaseJson node;
+    const char* users[] = {"q8Hd2kPz0bXv", "Lm4T9wYc1sNe"};
+    for (const char* user : users) {
+        String base = String("users/") + user;
+        node.set(base + "/name", "Breezio owner");
+        node.set(base + "/email", String(user) + "@example.com");
+        node.set(base + "/fcmToken", String("fcm:") + String(user) +
+                 ":APA91bHPRgkF3JUikC4ENAHEeMrd41Zxv3hVZjC9KtT8OvPVGJ-hQMRKRrZuJAEcl7B338qju59zJMjw2DELjzEvxwYv7hH5Ynpc1ODQ0aT4U4OFEeco8ohsN5PjL1iC2dNtk2BAokeMCg2ZXKqpc8FXKmhX94kIxQ");
+    }
+    node.set("sensors/roomTemperature", 24.6);
+    node.set("sensors/roomHumidity", 51.0);
+    node.set("sensors/motion", false);
+    node.set("status/online", 1752468000);
+    node.set("result", "Success");
+    node.set("command/action", "temp_up");
+    node.set("lan/host", "breezio-246f28aabbcc");
+    node.set("lan/token", "Zk3q8Hd2kPz0bXvLm4T9wY");
+    node.set("lan/ip", "192.168.1.50");
+    // One block of about 92 bytes an hour, base64 encoded.
+    String block;
+    for (int i = 0; i < 124; i++) block += "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"[(i * 37) % 64];
+    for (long hour = 0; hour < historyDays * 24; hour++) {
+        node.set("history/" + String(1752000000L + hour * 3600), block);
+    }
+    fakeRtdbSeed(kFixtureDevicePath, node);
+    fakeStats = FakeStats();
+}
+
+static void printRow(const char* label, size_t peak, const FakeStats& before) {
+    printf("%-18s %10lu %10lu %10lu %10lu %10lu\n", label, (unsigned long)peak,
+           fakeStats.rtdbBytesDown - before.rtdbBytesDown, fakeStats.rtdbRequests - before.rtdbRequests,
+           fakeStats.heapAllocs - before.heapAllocs, fakeStats.jsonGets - before.jsonGets);
+}
+
+int main(int argc, char** argv) {
+    long historyDays = benchArg(argc, argv, "--history-days", 7);
+
+    fakeReset();
+    fakeSetSerialEcho(false);
+    fakeSetWallClock(1752468900);
+    fakeSetPin(PIRPIN, LOW);
+    seedLivedInNode(historyDays);
+
+    printf("device node reads, %ld day(s) of history in the node\n\n", historyDays);
+    printf("%-18s %10s %10s %10s %10s %10s\n", "", "peak heap", "bytes down", "requests", "allocs", "json gets");
+
+    FakeStats before = fakeStats;
+    fakeResetHeapPeak();
+    setup();
+    fakeStartLoopTask(loop);
+    fakeRunTasksFor(5000); // the node is read once the cloud is up
+    printRow("boot", fakeHeapPeak(), before);
+
+    before = fakeStats;
+    fakeResetHeapPeak();
+    fakePushCommand(fixtureCommand("apply_schedule"));
+    fakeRunTasksFor(5000);
+    printRow("schedule refresh", fakeHeapPeak(), before);
+    printf("\nheap held after both: %lu bytes\n", (unsigned long)fakeHeapUsed());
+    return 0;
+}
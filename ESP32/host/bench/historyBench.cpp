@@ -0,0 +1,96 @@
+// Storage per day of room history. The device boots once and runs a room
+// that drifts through the day with DHT noise, the AC cycling and bursts of
+// motion: first online, where the history goes up hourly, then with every
+// write failing, where it spills to LittleFS. Reports encoded bytes per day
+// and per sample, what the batches cost on the wire, and what the spill
+// costs on flash, against a raw 8-byte record and one JSON object per sample.
+//
+//   historyBench [--days 1]
+
+#include <math.h>
+#include <LittleFS.h>
+#include "benchUtil.h"
+#include "deviceFixture.h"
+#include "parameters.h"
+#include "sensorHistory.h"
+
+void setup();
+void loop();
+
+static uint32_t rng = 1;
+static uint32_t next() {
+    rng = rng * 1103515245u + 12345u;
+    return rng >> 8;
+}
+
+// One day at 5 s resolution: a 3 °C daily swing, the AC pulling the room
+// down for an hour every four, and DHT11 rounding on top.
+static void runRoomFor(long minutes) {
+    for (long s = 0; s < minutes * 60; s += READ_INTERVAL / 1000) {
+        double hour = fmod(time(nullptr) / 3600.0, 24.0);
+        double temp = 25.0 + 1.5 * sin((hour - 9) / 24 * 2 * M_PI);
+        if (fmod(hour, 4.0) < 1.0) temp -= 2.0 * fmod(hour, 4.0);
+        double hum = 55.0 - 5.0 * sin((hour - 9) / 24 * 2 * M_PI) + (next() % 3) - 1;
+        fakeSetRoom(roundf(temp * 10 + (int)(next() % 3) - 1) / 10, roundf(hum));
+        if (next() % 60 == 0) fakeSetPin(PIRPIN, fakeGetPin(PIRPIN) == HIGH ? LOW : HIGH);
+        fakeRunTasksFor(READ_INTERVAL);
+    }
+}
+
+int main(int argc, char** argv) {
+    long days = benchArg(argc, argv, "--days", 1);
+
+    fakeReset();
+    fakeSetSerialEcho(false);
+    fakeSetWallClock(1752440400);
+    fakeSetPin(PIRPIN, LOW);
+    seedFixtureDevice("Electra");
+    setup();
+    fakeStartLoopTask(loop);
+    fakeRunTasksFor(5000); // through the cloud bring-up
+
+    printf("room history, %ld simulated day(s) per phase, one sample per %d s\n\n", days,
+           HISTORY_SAMPLE_INTERVAL / 1000);
+
+    HistoryStats before = sensorHistoryStats();
+    FakeStats wireBefore = fakeStats;
+    runRoomFor(days * 24 * 60);
+    HistoryStats online = sensorHistoryStats();
+    unsigned long samples = (online.samples - before.samples) / days;
+    unsigned long encoded = (online.bytesEncoded - before.bytesEncoded) / days;
+    unsigned long uploaded = (online.bytesUploaded - before.bytesUploaded) / days;
+    printf("online\n");
+    printf("  samples/day           %8lu\n", samples);
+    printf("  encoded B/day         %8lu  (%.2f B/sample, %lu blocks)\n", encoded, (double)encoded / samples,
+           (online.blocks - before.blocks) / days);
+    printf("  raw 8 B records B/day %8lu\n", samples * 8);
+    printf("  JSON per sample B/day %8lu  ({\"t\":24.1,\"h\":52,\"m\":false} under its epoch key)\n", samples * 42);
+    printf("  batches/day           %8lu\n", (online.uploads - before.uploads) / days);
+    printf("  uploaded B/day        %8lu  (%lu as base64)\n", uploaded, (uploaded + 2) / 3 * 4);
+    printf("  all RTDB requests/day %8lu  (heartbeats and staged writes included)\n",
+           (fakeStats.rtdbRequests - wireBefore.rtdbRequests) / days);
+
+    fakeSetRtdbFailing(true);
+    before = sensorHistoryStats();
+    FakeStats flashBefore = fakeStats;
+    runRoomFor(days * 24 * 60);
+    HistoryStats offline = sensorHistoryStats();
+    printf("\nwrites failing\n");
+    printf("  spills/day            %8lu  (%u files waiting)\n", (offline.spills - before.spills) / days,
+           historyFlashFiles());
+    printf("  flash B written/day   %8lu  (%lu commits)\n",
+           (fakeStats.fsBytesWritten - flashBefore.fsBytesWritten) / days,
+           (fakeStats.fsWrites - flashBefore.fsWrites) / days);
+    printf("  LittleFS used         %8lu  of %lu\n", (unsigned long)LittleFS.usedBytes(),
+           (unsigned long)LittleFS.totalBytes());
+
+    fakeSetRtdbFailing(false);
+    unsigned long long backAt = fakeMicros();
+    unsigned long long caughtUpAt = 0;
+    for (int minute = 0; minute < 24 * 60 && !caughtUpAt; minute++) {
+        runRoomFor(1);
+        if (historyFlashFiles() == 0) caughtUpAt = fakeMicros();
+    }
+    printf("  flash caught up after %8.0f min back online\n", caughtUpAt ? (caughtUpAt - backAt) / 60e6 : -1.0);
+    return 0;
+}
@@ -0,0 +1,75 @@
+// Command-to-IR latency: commands reach the RTDB stream at random instants
+// while the device runs its normal heartbeat, sensor and mode work, and the
+// bench measures virtual time from the stream event to the first IR edge.
+// "control held" is how long the control task kept the clock in the run
+// that handled the command (NVS commits, bit-banged IR).
+//
+//   irLatencyBench [--commands 2000] [--model Custom]
+
+#include "benchUtil.h"
+#include "deviceFixture.h"
+#include "parameters.h"
+
+void setup();
+void loop();
+
+int main(int argc, char** argv) {
+    long commands = benchArg(argc, argv, "--commands", 2000);
+    const char* model = benchArgStr(argc, argv, "--model", "Custom");
+    const char* actions[] = {"temp_up", "temp_down", "switch_power"};
+
+    fakeReset();
+    fakeSetSerialEcho(false);
+    fakeSetWallClock(1752468900);
+    fakeSetPin(PIRPIN, LOW);
+    seedFixtureDevice(model);
+    setup();
+    fakeStartLoopTask(loop);
+    fakeRunTasksFor(5000); // through the cloud bring-up
+    fakeStats = FakeStats();
+
+    LatencySeries virtualMs;
+    LatencySeries cpuUs;
+    uint32_t rng = 1;
+    for (long i = 0; i < commands; i++) {
+        rng = rng * 1103515245u + 12345u;
+        // At least 500 ms apart so the previous frame is off the air.
+        unsigned long long pushAt = fakeMicros() + (500 + (rng >> 8) % 20000) * 1000ULL;
+        size_t framesBefore = fakeIrFrames().size();
+        fakePushCommandAt(fixtureCommand(actions[i % 3]), pushAt);
+        fakeRunTasksUntil(pushAt);
+
+        // Schedule and mode frames sent before the command arrived do not count.
+        auto commandFrame = [&]() -> const FakeIrFrame* {
+            for (size_t k = framesBefore; k < fakeIrFrames().size(); k++) {
+                if (fakeIrFrames()[k].atUs >= pushAt) return &fakeIrFrames()[k];
+            }
+            return nullptr;
+        };
+        double c0 = hostMicros();
+        unsigned long long giveUp = pushAt + 10000000ULL;
+        while (!commandFrame() && fakeMicros() < giveUp) fakeRunTasksFor(1);
+        cpuUs.add(hostMicros() - c0);
+        if (!commandFrame()) {
+            printf("command %ld (%s) emitted no IR frame\n", i, actions[i % 3]);
+            return 1;
+        }
+        virtualMs.add((commandFrame()->atUs - pushAt) / 1000.0);
+    }
+
+    LatencySeries controlHeld;
+    for (const FakeTaskInfo& task : fakeTasks()) {
+        if (task.name != "control") continue;
+        for (double ms : task.heldMs) {
+            if (ms > 0) controlHeld.add(ms);
+        }
+    }
+
+    printf("command-to-IR latency, model %s, %ld commands\n\n", model, commands);
+    LatencySeries::printHeader("stream event -> IR");
+    virtualMs.printRow("virtual (ms)");
+    cpuUs.printRow("cpu (us)");
+    controlHeld.printRow("control held (ms)");
+    printf("\nNVS opens %lu, reads %lu, writes %lu\n", fakeStats.nvsOpens, fakeStats.nvsReads, fakeStats.nvsWrites);
+    return 0;
+}
@@ -0,0 +1,149 @@
+// LAN versus cloud command latency. A phone sends commands at random
+// instants while the device runs its normal work, over three paths:
+//
+//   cloud      the app writes /command; the stream event reaches the device
+//              one RTDB round trip later (phone to server, server to device),
+//              and the app sees /result half a round trip after it lands
+//   LAN HTTP   POST /command on the local network; the reply is the 202
+//   LAN WS     a command frame on an open, authenticated WebSocket; the
+//              reply is the pushed /result
+//
+// The bench measures virtual time from the phone's send to the first IR
+// edge, and to the reply back at the phone, with the default power save
+// (modem sleep, so traffic waits for a DTIM beacon) and with the radio
+// always listening.
+//
+//   lanBench [--commands 1000] [--model Custom]
+
+#include <functional>
+#include "benchUtil.h"
+#include "deviceFixture.h"
+#include "lanApi.h"
+#include "powerSave.h"
+
+void setup();
+void loop();
+
+enum Path { PATH_CLOUD, PATH_HTTP, PATH_WS, PATHS };
+static const char* const pathNames[PATHS] = {"cloud", "LAN HTTP", "LAN WS"};
+static const char* const actions[] = {"temp_up", "temp_down", "switch_power"};
+
+static uint32_t rng = 1;
+static uint32_t next() {
+    rng = rng * 1103515245u + 12345u;
+    return rng >> 8;
+}
+
+static const FakeIrFrame* frameSince(size_t from, unsigned long long atUs) {
+    for (size_t k = from; k < fakeIrFrames().size(); k++) {
+        if (fakeIrFrames()[k].atUs >= atUs) return &fakeIrFrames()[k];
+    }
+    return nullptr;
+}
+
+static bool runUntil(const std::function<bool()>& done, unsigned long long giveUpUs) {
+    while (!done() && fakeMicros() < giveUpUs) fakeRunTasksFor(1);
+    return done();
+}
+
+static String cloudResult() {
+    FirebaseJsonData result;
+    fakeRtdbGet(String(kFixtureDevicePath) + "/result", result);
+    return result.stringValue;
+}
+
+// Sends one command over `path` and returns false if it never reached the
+// IR LED or never got its reply.
+static bool sendCommand(Path path, int socket, const char* action, LatencySeries& toIr, LatencySeries& toReply) {
+    unsigned long long sendAt = fakeMicros() + (500 + next() % 20000) * 1000ULL;
+    size_t frames = fakeIrFrames().size();
+    size_t seen = fakeWsReceived(socket).size();
+    int request = 0;
+    String body = String("{\"action\":\"") + action + "\"}";
+    if (path == PATH_CLOUD) {
+        FirebaseJson pending;
+        pending.set("result", "pending");
+        fakeRtdbSeed(kFixtureDevicePath, pending);
+        fakePushCommandAt(fixtureCommand(action), sendAt + kFakeRtdbLatencyMs * 1000ULL);
+    } else if (path == PATH_HTTP) {
+        request = fakeLanRequestAt("POST", "/command", lanToken(), body, sendAt);
+    } else {
+        fakeWsSendAt(socket, body, sendAt);
+    }
+    unsigned long long giveUp = sendAt + 10000000ULL;
+    fakeRunTasksUntil(sendAt);
+    if (!runUntil([&] { return frameSince(frames, sendAt) != nullptr; }, giveUp)) return false;
+    toIr.add((frameSince(frames, sendAt)->atUs - sendAt) / 1000.0);
+
+    unsigned long long replyAt = 0;
+    bool replied = runUntil([&] {
+        if (path == PATH_CLOUD) {
+            if (cloudResult() == "pending") return false;
+            replyAt = fakeMicros() + kFakeRtdbLatencyMs * 500ULL;
+        } else if (path == PATH_HTTP) {
+            const FakeLanReply* reply = fakeLanReply(request);
+            if (!reply) return false;
+            replyAt = reply->atUs;
+        } else {
+            const std::vector<FakeWsMessage>& messages = fakeWsReceived(socket);
+            size_t k = seen;
+            while (k < messages.size() && (messages[k].atUs < sendAt || !strstr(messages[k].text.c_str(), "\"/result\""))) k++;
+            if (k == messages.size()) return false;
+            replyAt = messages[k].atUs;
+        }
+        return true;
+    }, giveUp);
+    if (!replied) return false;
+    toReply.add((replyAt - sendAt) / 1000.0);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    long commands = benchArg(argc, argv, "--commands", 1000);
+    const char* model = benchArgStr(argc, argv, "--model", "Custom");
+
+    fakeReset();
+    fakeSetSerialEcho(false);
+    fakeSetWallClock(1752468900);
+    fakeSetPin(PIRPIN, LOW);
+    seedFixtureDevice(model);
+    setup();
+    fakeStartLoopTask(loop);
+    fakeRunTasksFor(5000); // through the cloud bring-up
+
+    int socket = fakeWsOpen();
+    fakeWsSendAt(socket, String("{\"token\":\"") + lanToken() + "\"}", fakeMicros());
+    fakeRunTasksFor(1000);
+    if (!fakeWsConnected(socket)) {
+        printf("WebSocket login failed\n");
+        return 1;
+    }
+
+    printf("command latency, model %s, %ld commands per path, LAN hop %lu us, RTDB round trip %lu ms\n", model,
+           commands, kFakeLanHopUs, kFakeRtdbLatencyMs);
+    const PowerSave levels[] = {POWER_SAVE_DEFAULT, POWER_AWAKE};
+    const char* levelNames[] = {"default power save (DTIM-held traffic)", "radio always listening"};
+    for (int level = 0; level < 2; level++) {
+        setPowerSave(levels[level]);
+        fakeRunTasksFor(1000);
+        LatencySeries toIr[PATHS];
+        LatencySeries toReply[PATHS];
+        for (long i = 0; i < commands; i++) {
+            for (int path = 0; path < PATHS; path++) {
+                if (!sendCommand((Path)path, socket, actions[i % 3], toIr[path], toReply[path])) {
+                    printf("%s command %ld (%s) got no IR frame or reply\n", pathNames[path], i, actions[i % 3]);
+                    return 1;
+                }
+            }
+        }
+        printf("\n%s\n", levelNames[level]);
+        LatencySeries::printHeader("send -> IR (ms)");
+        for (int path = 0; path < PATHS; path++) toIr[path].printRow(pathNames[path]);
+        LatencySeries::printHeader("send -> reply (ms)");
+        for (int path = 0; path < PATHS; path++) toReply[path].printRow(pathNames[path]);
+    }
+    LanStats stats = lanApiStats();
+    printf("\nLAN commands %lu, pushes %lu, RTDB requests %lu\n", stats.commands, stats.pushes,
+           fakeStats.rtdbRequests);
+    return 0;
+}
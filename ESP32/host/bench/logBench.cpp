@@ -0,0 +1,56 @@
+// Logging cost to the caller: a task logs a burst of four typical lines
+// every 100 ms, two text lines and two formatted ones, as the network task
+// does around a report. "caller cpu" is host time per call; "caller held"
+// is virtual time the calling task lost per call, which is where waiting on
+// the 115200 baud UART shows up. The log task, when it runs, is charged
+// everything written to Serial.
+//
+//   logBench [--bursts 2000]
+
+#include "benchUtil.h"
+#include "deviceFixture.h"
+#include "log.h"
+
+static long bursts = 2000;
+static LatencySeries cpuNs, heldUs;
+
+static void loggerTask(void*) {
+    for (long burst = 0; burst < bursts; burst++) {
+        for (int line = 0; line < 4; line++) {
+            double startCpu = hostMicros();
+            unsigned long long start = fakeMicros();
+            switch (line) {
+                case 0: LOG_INFO("📶 Sensor Readings sent"); break;
+                case 1: LOGF("📈 History: %u blocks, %u bytes uploaded", (unsigned)burst, (unsigned)burst * 37); break;
+                case 2: LOG_WARN("⚠️ Stream timed out — attempting to reconnect..."); break;
+                case 3:
+                    LOGF("⏲️ %s/%s: %lu runs, late avg %lu max %lu ms, jitter max %lu ms", "network", "heartbeat",
+                         (unsigned long)burst, 1UL, 3UL, 2UL);
+                    break;
+            }
+            cpuNs.add((hostMicros() - startCpu) * 1000.0);
+            heldUs.add((double)(fakeMicros() - start));
+        }
+        vTaskDelay(100);
+    }
+    vTaskDelete(nullptr);
+}
+
+int main(int argc, char** argv) {
+    bursts = benchArg(argc, argv, "--bursts", 2000);
+    fakeReset();
+    fakeSetSerialEcho(false);
+    startLogTask();
+    xTaskCreatePinnedToCore(loggerTask, "logger", 4096, nullptr, 2, nullptr, 1);
+    fakeRunTasksFor(bursts * 100 + 1000);
+    fakeTakeSerialOutput();
+
+    LatencySeries::printHeader("per line");
+    cpuNs.printRow("caller cpu (ns)");
+    heldUs.printRow("caller held (us)");
+    LogStats stats = logStats();
+    printf("\nlines %lu, dropped %lu, ring peak %lu of %d bytes\n", stats.records, stats.dropped, stats.ringPeak,
+           LOG_RING_BYTES);
+    printf("serial %lu bytes, writers blocked %.1f ms\n", fakeStats.serialBytes, fakeStats.serialBlockedUs / 1000.0);
+    return 0;
+}
@@ -0,0 +1,142 @@
+// Runs the real setup() and then the device tasks (plus loop() in its
+// loopTask) against the host fakes for a scripted stretch of time. Per task
+// it reports wake lateness (how long after its deadline or queue event it
+// actually ran), how long each run kept the clock (NVS commits, DHT
+// transfers, bit-banged IR; RTDB round trips yield), and the host stack the
+// task touched. Per deadline job it reports runs, lateness and jitter.
+//
+//   loopBench [--minutes 60] [--model Electra|Samsung|LG|Custom] [--verbose 1]
+
+#include "benchUtil.h"
+#include "deviceFixture.h"
+#include "parameters.h"
+#include "rtdbPublisher.h"
+#include "deadlines.h"
+#include "log.h"
+
+void setup();
+void loop();
+
+namespace {
+
+struct ScriptedCommand {
+    const char* action;
+    const char* mode;
+    int duration;
+};
+
+const ScriptedCommand kScript[] = {
+    {"switch_power", nullptr, 0},
+    {"temp_up", nullptr, 0},
+    {"temp_down", nullptr, 0},
+    {"switch_lights", nullptr, 0},
+    {"set_mode", "eco", 0},
+    {"temp_up", nullptr, 0},
+    {"set_mode", "motion", 0},
+    {"switch_relay", nullptr, 0},
+    {"set_mode", "timer", 20},
+    {"switch_power", nullptr, 0},
+    {"set_mode", "regular", 0},
+    {"switch_lights", nullptr, 0},
+    {"switch_relay", nullptr, 0},
+};
+const size_t kScriptLen = sizeof(kScript) / sizeof(kScript[0]);
+
+const unsigned long kCommandEveryMs = 45000;
+const unsigned long kRoomStepMs = 5000;
+
+uint32_t rng = 12345;
+uint32_t nextRandom() {
+    rng = rng * 1103515245u + 12345u;
+    return rng >> 16;
+}
+
+}
+
+int main(int argc, char** argv) {
+    long minutes = benchArg(argc, argv, "--minutes", 60);
+    const char* model = benchArgStr(argc, argv, "--model", "Electra");
+
+    fakeReset();
+    fakeSetSerialEcho(benchArg(argc, argv, "--verbose", 0) != 0);
+    fakeSetWallClock(1752468900);   // Monday 2025-07-14 07:55 local, just before the 08:00 schedule edge
+    fakeSetPin(PIRPIN, LOW);
+    seedFixtureDevice(model);
+
+    unsigned long long setupStart = fakeMicros();
+    setup();
+    double setupMs = (fakeMicros() - setupStart) / 1000.0;
+    fakeStats = FakeStats();
+
+    fakeStartLoopTask(loop);
+    unsigned long long start = fakeMicros();
+    unsigned long long end = start + (unsigned long long)minutes * 60000000ULL;
+    unsigned long long nextCommand = start + kCommandEveryMs * 1000ULL;
+    unsigned long long nextRoom = start;
+    size_t scriptPos = 0;
+    float temp = 24.0f;
+    float hum = 50.0f;
+    bool restarted = false;
+
+    double c0 = hostMicros();
+    while (fakeMicros() < end && !restarted) {
+        if (fakeMicros() >= nextCommand) {
+            const ScriptedCommand& c = kScript[scriptPos++ % kScriptLen];
+            fakePushCommand(c.mode ? fixtureModeCommand(c.mode, c.duration) : fixtureCommand(c.action));
+            nextCommand += kCommandEveryMs * 1000ULL;
+        }
+        if (fakeMicros() >= nextRoom) {
+            temp += ((int)(nextRandom() % 7) - 3) * 0.1f;
+            hum += ((int)(nextRandom() % 9) - 4) * 0.5f;
+            fakeSetRoom(temp, hum);
+            fakeSetPin(PIRPIN, nextRandom() % 4 == 0 ? HIGH : LOW);
+            nextRoom += kRoomStepMs * 1000ULL;
+        }
+        try {
+            fakeRunTasksUntil(std::min(std::min(nextCommand, nextRoom), end));
+        } catch (const FakeRestart&) {
+            restarted = true;
+        }
+    }
+    double cpuMs = (hostMicros() - c0) / 1000.0;
+
+    double hours = (fakeMicros() - start) / 3.6e9;
+    printf("device tasks, model %s, %ld simulated min, %.0f ms host cpu\n", model, minutes, cpuMs);
+    printf("setup(): %.1f ms until the tasks start\n", setupMs);
+    for (const FakeTaskInfo& task : fakeTasks()) {
+        LatencySeries lateness;
+        LatencySeries held;
+        for (double ms : task.latenessMs) lateness.add(ms);
+        for (double ms : task.heldMs) held.add(ms);
+        printf("\n%s (core %d, prio %u): %lu runs, host stack %zu bytes\n", task.name.c_str(), task.core,
+               task.priority, task.runs, task.hostStackUsed);
+        LatencySeries::printHeader("per run");
+        lateness.printRow("late (ms)");
+        held.printRow("held (ms)");
+    }
+    printf("\n%-18s %8s %14s %14s %16s\n", "deadline", "runs", "late avg (ms)", "late max (ms)",
+           "jitter max (ms)");
+    for (const DeadlineQueue* queue : {&networkDeadlines, &controlDeadlines, &sensorDeadlines}) {
+        for (uint8_t i = 0; i < queue->jobCount; i++) {
+            const Deadline& job = *queue->jobs[i];
+            const DeadlineStats& s = job.stats;
+            String name = String(queue->task) + "/" + job.name;
+            printf("%-18s %8lu %14.1f %14lu %16lu\n", name.c_str(), s.runs,
+                   s.runs ? (double)s.lateSumMs / s.runs : 0.0, s.lateMaxMs, s.jitterMaxMs);
+        }
+    }
+    printf("\n");
+    printf("RTDB requests: %lu (%.0f/h), bytes up %lu (%.0f/h), down %lu\n", fakeStats.rtdbRequests,
+           fakeStats.rtdbRequests / hours, fakeStats.rtdbBytesUp, fakeStats.rtdbBytesUp / hours,
+           fakeStats.rtdbBytesDown);
+    const PublisherStats& published = rtdbPublisherStats();
+    printf("publisher: %lu values staged, %lu coalesced, %lu flushes, %lu failed\n", published.staged,
+           published.coalesced, published.flushes, published.failures);
+    printf("IR frames: %lu (%.1f ms air time), NVS writes: %lu, delay(): %.1f ms\n", fakeStats.irFrames,
+           fakeStats.irAirTimeUs / 1000.0, fakeStats.nvsWrites, fakeStats.delayedUs / 1000.0);
+    LogStats logged = logStats();
+    printf("log: %lu lines, %lu dropped, ring peak %lu bytes; serial: %lu bytes, writers blocked %.1f ms\n",
+           logged.records, logged.dropped, logged.ringPeak, fakeStats.serialBytes, fakeStats.serialBlockedUs / 1000.0);
+    if (restarted) printf("the firmware restarted the device\n");
+    return restarted ? 1 : 0;
+}
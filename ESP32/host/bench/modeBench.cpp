@@ -0,0 +1,56 @@
+// Per-call cost of handleMode(), the mode dispatch the control task runs
+// after every wake, in each mode with the AC on and nothing due: host ns per call
+// and heap allocations per call.
+//
+//   modeBench [--calls 2000000]
+
+#include <new>
+#include "benchUtil.h"
+#include "deviceFixture.h"
+#include "FirestoreServices.h"
+#include "modeHandler.h"
+#include "ntpTime.h"
+#include "parameters.h"
+
+static unsigned long long heapAllocations = 0;
+
+void* operator new(size_t size) {
+    heapAllocations++;
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+int main(int argc, char** argv) {
+    long calls = benchArg(argc, argv, "--calls", 2000000);
+
+    fakeReset();
+    fakeSetSerialEcho(false);
+    fakeSetPin(PIRPIN, LOW);
+    struct tm now;
+    startTimeSync();
+    while (!getLocalTime(&now, 0)) fakeAdvanceMillis(100);
+    fakeSetWallClock(1752440400); // Monday 00:00 local, hours before the schedule starts
+    model = MODEL_CUSTOM;
+    acPowered = true;
+    duration = MAX_TIMER;
+    handleMode(); // first-run NVS day tracking
+
+    printf("handleMode(), %ld calls per mode, AC on, nothing due\n\n", calls);
+    printf("%-10s %12s %14s\n", "mode", "ns/call", "allocs/call");
+    for (uint8_t m = 0; m < AC_MODES; m++) {
+        mode = (AcMode)m;
+        idleFlag = IDLE_ACTIVE;
+        handleMode();
+        unsigned long long allocs0 = heapAllocations;
+        double t0 = hostMicros();
+        for (long i = 0; i < calls; i++) {
+            if ((i & 1023) == 0) fakeAdvanceMillis(1);
+            handleMode();
+        }
+        double ns = (hostMicros() - t0) * 1000.0 / calls;
+        printf("%-10s %12.1f %14.3f\n", acModeName(mode), ns, (double)(heapAllocations - allocs0) / calls);
+    }
+    return 0;
+}
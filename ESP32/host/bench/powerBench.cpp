@@ -0,0 +1,84 @@
+// Average supply current against command-to-IR latency for each power save
+// level, from the fake power model in fakeBoard.h. The device boots once and
+// then runs the same stretch per level: commands at random instants, room
+// readings and PIR edges every few seconds. Latency runs from the command
+// reaching the AP (the stream waits for the next DTIM beacon under modem
+// sleep) to the first IR edge.
+//
+//   powerBench [--minutes 60] [--model Electra]
+
+#include "benchUtil.h"
+#include "deviceFixture.h"
+#include "parameters.h"
+#include "powerSave.h"
+
+void setup();
+void loop();
+
+static const char* const kLevelNames[] = {"awake", "modem sleep", "light sleep"};
+
+int main(int argc, char** argv) {
+    long minutes = benchArg(argc, argv, "--minutes", 60);
+    const char* model = benchArgStr(argc, argv, "--model", "Electra");
+    const char* actions[] = {"temp_up", "temp_down", "switch_power"};
+
+    fakeReset();
+    fakeSetSerialEcho(false);
+    fakeSetWallClock(1752440400); // Monday 00:00 local, no schedule edges
+    fakeSetPin(PIRPIN, LOW);
+    seedFixtureDevice(model);
+    setup();
+    fakeStartLoopTask(loop);
+    fakeRunTasksFor(5000); // through the cloud bring-up
+
+    printf("power save levels, model %s, %ld simulated min each\n\n", model, minutes);
+    printf("%-12s %9s %9s %9s %8s %9s | %8s %8s %8s %8s\n", "level", "avg mA", "cpu mA", "radio mA", "asleep",
+           "wakes/s", "IR p50", "IR p90", "IR p99", "IR max");
+    uint32_t rng;
+    auto next = [&]() {
+        rng = rng * 1103515245u + 12345u;
+        return rng >> 8;
+    };
+    for (int level = POWER_AWAKE; level <= POWER_LIGHT_SLEEP; level++) {
+        rng = 7; // same commands and room for every level
+        setPowerSave((PowerSave)level);
+        fakeRunTasksFor(1000);
+        fakePower = FakePower();
+        unsigned long long start = fakeMicros();
+        unsigned long long end = start + (unsigned long long)minutes * 60000000ULL;
+        unsigned long long nextRoom = start;
+        LatencySeries irMs;
+        long sent = 0;
+        while (fakeMicros() < end) {
+            unsigned long long pushAt = fakeMicros() + (20000 + next() % 50000) * 1000ULL;
+            while (nextRoom < pushAt) {
+                fakeRunTasksUntil(nextRoom);
+                fakeSetRoom(24.0f + (next() % 30) * 0.1f, 50.0f + (next() % 10));
+                fakeSetPin(PIRPIN, next() % 4 == 0 ? HIGH : LOW);
+                nextRoom += 5000000ULL;
+            }
+            size_t framesBefore = fakeIrFrames().size();
+            fakePushCommandAt(fixtureCommand(actions[sent++ % 3]), pushAt);
+            fakeRunTasksUntil(pushAt);
+            unsigned long long giveUp = pushAt + 2000000ULL;
+            const FakeIrFrame* frame = nullptr;
+            while (!frame && fakeMicros() < giveUp) {
+                fakeRunTasksFor(1);
+                for (size_t k = framesBefore; k < fakeIrFrames().size() && !frame; k++) {
+                    if (fakeIrFrames()[k].atUs >= pushAt) frame = &fakeIrFrames()[k];
+                }
+            }
+            if (!frame) {
+                printf("%s: command %ld emitted no IR frame\n", kLevelNames[level], sent);
+                return 1;
+            }
+            irMs.add((frame->atUs - pushAt) / 1000.0);
+        }
+        double seconds = (fakeMicros() - start) / 1e6;
+        printf("%-12s %9.2f %9.2f %9.2f %7.1f%% %9.1f | %8.1f %8.1f %8.1f %8.1f\n", kLevelNames[level],
+               (fakePower.cpuMaS + fakePower.radioMaS) / seconds, fakePower.cpuMaS / seconds,
+               fakePower.radioMaS / seconds, fakePower.sleptUs / 1e4 / seconds, fakePower.wakes / seconds,
+               irMs.percentile(50), irMs.percentile(90), irMs.percentile(99), irMs.max());
+    }
+    return 0;
+}
@@ -0,0 +1,400 @@
+// Motion mode against presence traces: how often it prompts or switches the
+// AC off on someone who is in the room, and how long the AC runs once they
+// have left. Each trace is replayed through the booted device (the PIR pin,
+// RD-03D frames on UART2 at 10 Hz, commands through the stream) and, for
+// comparison, through the PIR rule motion mode went by before the occupancy
+// estimate (reproduced below). After an off while someone is in, they switch
+// the AC back on two minutes later.
+//
+//   presenceBench [trace ...]
+//
+// A trace is text, one event per line, in ms from its start:
+//
+//   <ms> occupied 0|1                     ground truth, from the labels
+//   <ms> pir 0|1                          PIR output level
+//   <ms> radar <people> still|moving      what the radar reports from then on
+//   <ms> radar off                        no radar, or it stopped streaming
+//   <ms> command <action>                 a command from the app
+//   <ms> end
+//
+// '#' starts a comment. Without arguments the bench replays its scripted
+// traces: a reader, an afternoon nap, someone coming and going, and desk
+// work in a room without a radar. The device boots on a Saturday, so the
+// fixture's weekday schedule stays out of the way.
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <driver/uart.h>
+#include "benchUtil.h"
+#include "deviceFixture.h"
+#include "FirestoreServices.h"
+#include "parameters.h"
+#include "radar.h"
+
+void setup();
+void loop();
+
+enum EventKind { EVENT_OCCUPIED, EVENT_PIR, EVENT_RADAR, EVENT_COMMAND, EVENT_END };
+
+struct TraceEvent {
+    unsigned long ms;
+    EventKind kind;
+    int value;      // occupied, PIR level, radar people (-1 for off)
+    bool moving;
+    std::string action;
+};
+
+struct Trace {
+    std::string name;
+    std::vector<TraceEvent> events; // in time order
+};
+
+static void sortEvents(Trace& trace) {
+    std::stable_sort(trace.events.begin(), trace.events.end(),
+                     [](const TraceEvent& a, const TraceEvent& b) { return a.ms < b.ms; });
+}
+
+static bool parseTrace(const char* path, Trace& trace) {
+    std::ifstream in(path);
+    if (!in) return false;
+    trace.name = path;
+    std::string line;
+    while (std::getline(in, line)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream words(line);
+        TraceEvent event = {};
+        std::string kind, arg;
+        if (!(words >> event.ms >> kind)) continue;
+        if (kind == "occupied" && words >> event.value) {
+            event.kind = EVENT_OCCUPIED;
+        } else if (kind == "pir" && words >> event.value) {
+            event.kind = EVENT_PIR;
+        } else if (kind == "radar" && words >> arg) {
+            event.kind = EVENT_RADAR;
+            event.value = arg == "off" ? -1 : atoi(arg.c_str());
+            event.moving = (words >> arg) && arg == "moving";
+        } else if (kind == "command" && words >> event.action) {
+            event.kind = EVENT_COMMAND;
+        } else if (kind == "end") {
+            event.kind = EVENT_END;
+        } else {
+            fprintf(stderr, "%s: cannot read '%s'\n", path, line.c_str());
+            return false;
+        }
+        trace.events.push_back(event);
+    }
+    sortEvents(trace);
+    return !trace.events.empty();
+}
+
+// ----------------------- Scripted traces -----------------------
+
+static uint32_t rng = 1;
+static unsigned long between(unsigned long lo, unsigned long hi) {
+    rng = rng * 1103515245u + 12345u;
+    return lo + (rng >> 8) % (hi - lo + 1);
+}
+
+static const unsigned long kMinute = 60000;
+
+struct Script {
+    Trace trace;
+    void at(unsigned long ms, EventKind kind, int value = 0, bool moving = false, const char* action = "") {
+        trace.events.push_back({ms, kind, value, moving, action});
+    }
+    void pirPulse(unsigned long ms) {
+        at(ms, EVENT_PIR, 1);
+        at(ms + between(2000, 4000), EVENT_PIR, 0);
+    }
+    void finish(unsigned long ms) {
+        at(ms, EVENT_END);
+        sortEvents(trace);
+    }
+};
+
+// Someone settling in, then sitting still for `stillMs`: the PIR catches a
+// shift every `fidgetLo`..`fidgetHi`, and the radar tracks them but loses
+// them now and then for up to a minute and a half. Then they leave and the
+// room stays empty for an hour.
+static Trace stillScript(const char* name, unsigned long stillMs, unsigned long fidgetLo,
+                         unsigned long fidgetHi, bool radar) {
+    Script s;
+    s.trace.name = name;
+    s.at(0, EVENT_OCCUPIED, 1);
+    if (radar) s.at(0, EVENT_RADAR, 1, true);
+    for (unsigned long t = 0; t < 2 * kMinute; t += between(10000, 30000)) s.pirPulse(t);
+    if (radar) s.at(2 * kMinute, EVENT_RADAR, 1, false);
+    for (unsigned long t = 2 * kMinute + between(fidgetLo, fidgetHi); t < stillMs; t += between(fidgetLo, fidgetHi)) {
+        s.pirPulse(t);
+    }
+    if (radar) {
+        for (unsigned long t = between(5, 25) * kMinute; t < stillMs; t += between(5, 25) * kMinute) {
+            unsigned long back = t + between(20000, 90000);
+            if (back >= stillMs) break;
+            s.at(t, EVENT_RADAR, 0);
+            s.at(back, EVENT_RADAR, 1, false);
+        }
+    }
+    s.pirPulse(stillMs);
+    if (radar) s.at(stillMs, EVENT_RADAR, 1, true);
+    s.at(stillMs + 5000, EVENT_OCCUPIED, 0);
+    if (radar) s.at(stillMs + 5000, EVENT_RADAR, 0);
+    s.finish(stillMs + 60 * kMinute);
+    return s.trace;
+}
+
+// In and out of the room: moving about while in, with a PIR edge every one
+// to eight minutes, away for five to forty.
+static Trace comingAndGoingScript() {
+    Script s;
+    s.trace.name = "coming and going";
+    unsigned long t = 0;
+    while (t < 4 * 60 * kMinute) {
+        s.at(t, EVENT_OCCUPIED, 1);
+        s.at(t, EVENT_RADAR, 1, true);
+        unsigned long leave = t + between(10, 60) * kMinute;
+        for (; t < leave; t += between(1, 8) * kMinute) s.pirPulse(t);
+        s.pirPulse(leave);
+        s.at(leave + 5000, EVENT_OCCUPIED, 0);
+        s.at(leave + 5000, EVENT_RADAR, 0);
+        t = leave + between(5, 40) * kMinute;
+    }
+    s.finish(t);
+    return s.trace;
+}
+
+// Desk work without a radar: the PIR sees typing hands only now and then,
+// and the occupant nudges the temperature from the app every so often.
+static Trace deskScript() {
+    Trace trace = stillScript("desk, no radar", 3 * 60 * kMinute, 2 * kMinute, 40 * kMinute, false);
+    for (unsigned long t = between(20, 60) * kMinute; t < 3 * 60 * kMinute; t += between(20, 60) * kMinute) {
+        trace.events.push_back({t, EVENT_COMMAND, 0, false, t / kMinute % 2 ? "temp_up" : "temp_down"});
+    }
+    sortEvents(trace);
+    return trace;
+}
+
+// ----------------------- Replay -----------------------
+
+struct Outcome {
+    double occupiedHours;
+    int prompts;       // while someone was in
+    int falseOffs;     // while someone was in
+    int offs;          // after they left
+    double vacantOnHours;
+};
+
+// Motion mode before the occupancy estimate: motion at a PIR edge, or at a
+// look while the output is high; a prompt once IDLE_THRESHOLD_MS passed
+// without motion, the AC off SHUTDOWN_WAIT_MS later. Entering the mode and
+// switching the AC on counted as motion.
+struct PirRule {
+    bool powered;
+    bool prompted;
+    unsigned long lastMotionMs;
+    unsigned long idleStartMs;
+
+    void powerOn(unsigned long now) {
+        powered = true;
+        prompted = false;
+        lastMotionMs = now;
+    }
+
+    // Returns whether the AC was switched off.
+    bool look(unsigned long now, bool motion) {
+        if (!powered) return false;
+        if (motion) {
+            lastMotionMs = now;
+            prompted = false;
+            return false;
+        }
+        if (!prompted && now - lastMotionMs > IDLE_THRESHOLD_MS * MINUTES_CONVERT) {
+            prompted = true;
+            idleStartMs = now;
+        }
+        if (prompted && now - idleStartMs > SHUTDOWN_WAIT_MS * MINUTES_CONVERT) {
+            powered = false;
+            return true;
+        }
+        return false;
+    }
+};
+
+static std::vector<uint8_t> radarFrame(int people, bool moving) {
+    std::vector<uint8_t> out = {0xAA, 0xFF, 0x03, 0x00};
+    auto put = [&out](int value) {
+        uint16_t raw = value >= 0 ? 0x8000 | value : -value;
+        out.push_back(raw & 0xFF);
+        out.push_back(raw >> 8);
+    };
+    for (int i = 0; i < 3; i++) {
+        if (i < people) {
+            int jitter = moving ? (int)between(0, 200) - 100 : (int)between(0, 20) - 10;
+            put(-700 + 700 * i + jitter);
+            put(1800 + 600 * i + jitter);
+            put(moving ? 25 : 0);
+            put(360);
+        } else {
+            out.insert(out.end(), 8, 0);
+        }
+    }
+    out.push_back(0x55);
+    out.push_back(0xCC);
+    return out;
+}
+
+static void powerDevice(bool on) {
+    if (acPowered != on) fakePushCommand(fixtureCommand("switch_power"));
+    for (int i = 0; i < 50 && acPowered != on; i++) fakeRunTasksFor(100);
+}
+
+static void replay(const Trace& trace, Outcome& device, Outcome& old) {
+    device = old = Outcome();
+    // Start from an empty room with the AC off long enough for any evidence
+    // of the trace before to be gone.
+    fakeSetPin(PIRPIN, LOW);
+    powerDevice(false);
+    fakeRunTasksFor(3 * 60 * kMinute);
+    fakePushCommand(fixtureModeCommand("motion"));
+    fakeRunTasksFor(1000);
+    powerDevice(true);
+
+    PirRule rule = {};
+    rule.powerOn(0);
+    unsigned long start = millis();
+    bool occupied = false, pir = false, devicePrompted = false;
+    int radarPeople = -1;
+    bool radarMoving = false;
+    unsigned long deviceBackOnMs = 0, oldBackOnMs = 0; // 0: not pending
+    size_t next = 0;
+    unsigned long endMs = trace.events.back().ms;
+    for (unsigned long t = 0; t <= endMs; t += 100) {
+        bool edge = false, command = false;
+        for (; next < trace.events.size() && trace.events[next].ms <= t; next++) {
+            const TraceEvent& event = trace.events[next];
+            switch (event.kind) {
+                case EVENT_OCCUPIED: occupied = event.value; break;
+                case EVENT_PIR:
+                    edge |= event.value && !pir;
+                    pir = event.value;
+                    fakeSetPin(PIRPIN, pir ? HIGH : LOW);
+                    break;
+                case EVENT_RADAR:
+                    radarPeople = event.value;
+                    radarMoving = event.moving;
+                    break;
+                case EVENT_COMMAND:
+                    fakePushCommand(fixtureCommand(event.action.c_str()));
+                    command = true;
+                    break;
+                case EVENT_END: break;
+            }
+        }
+        if (radarPeople >= 0) {
+            std::vector<uint8_t> frame = radarFrame(radarPeople, radarMoving);
+            fakeUartReceive(RADAR_UART, frame.data(), frame.size());
+        }
+        bool wasPowered = acPowered;
+        fakeRunTasksFor(100);
+
+        // The device.
+        if (occupied) device.occupiedHours += 0.1 / 3600;
+        if (!occupied && acPowered) device.vacantOnHours += 0.1 / 3600;
+        bool prompted = idleFlag == IDLE_USER_PROMPT;
+        if (prompted && !devicePrompted && occupied) device.prompts++;
+        devicePrompted = prompted;
+        if (wasPowered && !acPowered) {
+            if (occupied) {
+                device.falseOffs++;
+                deviceBackOnMs = t + 2 * kMinute;
+            } else {
+                device.offs++;
+            }
+        }
+        if (deviceBackOnMs && t >= deviceBackOnMs) {
+            deviceBackOnMs = 0;
+            if (occupied) powerDevice(true);
+        }
+
+        // The PIR rule, looking when the control task would have woken:
+        // at an edge, a command, or its own deadline.
+        unsigned long now = millis() - start;
+        bool wasPrompted = rule.prompted;
+        unsigned long dueMs = rule.prompted ? rule.idleStartMs + SHUTDOWN_WAIT_MS * MINUTES_CONVERT
+                                            : rule.lastMotionMs + IDLE_THRESHOLD_MS * MINUTES_CONVERT;
+        bool off = false;
+        if (edge || command || now > dueMs) off = rule.look(now, edge || pir);
+        if (occupied) old.occupiedHours += 0.1 / 3600;
+        if (!occupied && rule.powered) old.vacantOnHours += 0.1 / 3600;
+        if (rule.prompted && !wasPrompted && occupied) old.prompts++;
+        if (off) {
+            if (occupied) {
+                old.falseOffs++;
+                oldBackOnMs = t + 2 * kMinute;
+            } else {
+                old.offs++;
+            }
+        }
+        if (oldBackOnMs && t >= oldBackOnMs) {
+            oldBackOnMs = 0;
+            if (occupied) rule.powerOn(millis() - start);
+        }
+    }
+    fakeSetPin(PIRPIN, LOW);
+}
+
+static void printRow(const char* trace, const char* rule, const Outcome& o) {
+    printf("%-18s %-6s %9.1f %8d %11d %6d %13.2f\n", trace, rule, o.occupiedHours, o.prompts, o.falseOffs, o.offs,
+           o.vacantOnHours);
+}
+
+int main(int argc, char** argv) {
+    std::vector<Trace> traces;
+    for (int i = 1; i < argc; i++) {
+        Trace trace;
+        if (!parseTrace(argv[i], trace)) {
+            fprintf(stderr, "%s: no trace read\n", argv[i]);
+            return 1;
+        }
+        traces.push_back(trace);
+    }
+    if (traces.empty()) {
+        traces.push_back(stillScript("reader", 3 * 60 * kMinute, 5 * kMinute, 55 * kMinute, true));
+        traces.push_back(stillScript("nap", 2 * 60 * kMinute, 40 * kMinute, 120 * kMinute, true));
+        traces.push_back(comingAndGoingScript());
+        traces.push_back(deskScript());
+    }
+
+    fakeReset();
+    fakeSetSerialEcho(false);
+    fakeSetWallClock(1752267600); // Saturday 00:00 local
+    fakeSetPin(PIRPIN, LOW);
+    seedFixtureDevice("Electra");
+    setup();
+    fakeStartLoopTask(loop);
+    fakeRunTasksFor(5000); // through the cloud bring-up
+
+    printf("motion mode on presence traces: the PIR rule against the occupancy estimate\n\n");
+    printf("%-18s %-6s %9s %8s %11s %6s %13s\n", "trace", "rule", "in (h)", "prompts", "false offs", "offs",
+           "vacant on (h)");
+    Outcome oldTotal = {}, deviceTotal = {};
+    for (const Trace& trace : traces) {
+        Outcome device, old;
+        replay(trace, device, old);
+        printRow(trace.name.c_str(), "PIR", old);
+        printRow("", "fused", device);
+        for (auto [total, o] : {std::make_pair(&oldTotal, &old), std::make_pair(&deviceTotal, &device)}) {
+            total->occupiedHours += o->occupiedHours;
+            total->prompts += o->prompts;
+            total->falseOffs += o->falseOffs;
+            total->offs += o->offs;
+            total->vacantOnHours += o->vacantOnHours;
+        }
+    }
+    printRow("total", "PIR", oldTotal);
+    printRow("", "fused", deviceTotal);
+    printf("\nfalse offs per occupied day: PIR %.2f, fused %.2f\n", oldTotal.falseOffs * 24 / oldTotal.occupiedHours,
+           deviceTotal.falseOffs * 24 / deviceTotal.occupiedHours);
+    return 0;
+}
@@ -0,0 +1,90 @@
+// Sensor uploads per day. The device boots once and reads a room that
+// drifts through the day, through a DHT11 model: readings rounded to its
+// resolution, a little noise, an occasional one-degree glitch and about one
+// read in a hundred failing. Nobody moves, so every upload is down to the
+// temperature and humidity. Reports the uploads, how many carried a failed
+// read, and how far the value in the cloud strays from the room.
+//
+//   sensorBench [--days 1]
+
+#include <math.h>
+#include "benchUtil.h"
+#include "deviceFixture.h"
+#include "parameters.h"
+#include "deadlines.h"
+
+void setup();
+void loop();
+
+static uint32_t rng = 1;
+static uint32_t next() {
+    rng = rng * 1103515245u + 12345u;
+    return rng >> 8;
+}
+
+// Roughly normal, mean 0 and deviation `sigma`.
+static double noise(double sigma) {
+    double sum = 0;
+    for (int i = 0; i < 4; i++) sum += (next() % 1000) / 1000.0 - 0.5;
+    return sum * sigma * 1.73;
+}
+
+static const Deadline* sensorJob(const char* name) {
+    for (uint8_t i = 0; i < sensorDeadlines.jobCount; i++) {
+        if (strcmp(sensorDeadlines.jobs[i]->name, name) == 0) return sensorDeadlines.jobs[i];
+    }
+    return nullptr;
+}
+
+int main(int argc, char** argv) {
+    long days = benchArg(argc, argv, "--days", 1);
+
+    fakeReset();
+    fakeSetSerialEcho(false);
+    fakeSetWallClock(1752440400);
+    fakeSetPin(PIRPIN, LOW);
+    seedFixtureDevice("Electra");
+    setup();
+    fakeStartLoopTask(loop);
+    fakeRunTasksFor(5000); // through the cloud bring-up
+
+    const Deadline* upload = sensorJob("upload");
+    unsigned long uploadsBefore = upload ? upload->stats.runs : 0;
+    unsigned long requestsBefore = fakeStats.rtdbRequests;
+    unsigned long bytesBefore = fakeStats.rtdbBytesUp;
+    LatencySeries tempError, humError;
+    long reads = 0, failed = 0, zeroInCloud = 0;
+    double lastTemp = 0, lastHum = 0;
+    for (long s = 0; s < days * 24 * 3600; s += READ_INTERVAL / 1000) {
+        double hour = fmod(time(nullptr) / 3600.0, 24.0);
+        double temp = 25.0 + 1.5 * sin((hour - 9) / 24 * 2 * M_PI);
+        if (fmod(hour, 4.0) < 1.0) temp -= 2.0 * fmod(hour, 4.0); // the AC pulling it down
+        double hum = 55.0 - 5.0 * sin((hour - 9) / 24 * 2 * M_PI);
+        reads++;
+        if (next() % 100 == 0) {
+            failed++;
+            fakeSetRoom(NAN, NAN);
+        } else {
+            double glitch = next() % 100 == 0 ? (next() % 2 ? 1.0 : -1.0) : 0.0;
+            fakeSetRoom(roundf((temp + noise(0.15) + glitch) * 10) / 10, roundf(hum + noise(0.8)));
+        }
+        fakeRunTasksFor(READ_INTERVAL);
+
+        FirebaseJsonData value;
+        if (fakeRtdbGet(String(kFixtureDevicePath) + "/sensors/roomTemperature", value)) lastTemp = value.floatValue;
+        if (fakeRtdbGet(String(kFixtureDevicePath) + "/sensors/roomHumidity", value)) lastHum = value.floatValue;
+        if (lastTemp == 0 || lastHum == 0) zeroInCloud++;
+        tempError.add(fabs(lastTemp - temp));
+        humError.add(fabs(lastHum - hum));
+    }
+
+    unsigned long uploads = (upload ? upload->stats.runs : 0) - uploadsBefore;
+    printf("%ld day(s), %ld reads, %ld failed\n\n", days, reads, failed);
+    printf("sensor uploads: %lu (%.0f/day), RTDB requests: %lu, bytes up %lu\n", uploads, (double)uploads / days,
+           fakeStats.rtdbRequests - requestsBefore, fakeStats.rtdbBytesUp - bytesBefore);
+    printf("reads with 0 in the cloud: %ld\n\n", zeroInCloud);
+    LatencySeries::printHeader("cloud vs room");
+    tempError.printRow("temperature (°C)");
+    humError.printRow("humidity (%)");
+    return 0;
+}
@@ -0,0 +1,37 @@
+#ifndef HOST_ADAFRUIT_CCS811_H
+#define HOST_ADAFRUIT_CCS811_H
+
+#include <Arduino.h>
+
+#define CCS811_ADDRESS 0x5A
+
+#define CCS811_DRIVE_MODE_IDLE 0x00
+#define CCS811_DRIVE_MODE_1SEC 0x01
+#define CCS811_DRIVE_MODE_10SEC 0x02
+#define CCS811_DRIVE_MODE_60SEC 0x03
+#define CCS811_DRIVE_MODE_250MS 0x04
+
+// The sensor is the one in fakeBoard.h (fakeSetAirSensorPresent(),
+// fakeSetAir()); every register access costs its I2C transfer. As in the
+// Adafruit driver, readData() returns 0 both on success and when no result
+// was ready, so callers check available() first.
+class Adafruit_CCS811 {
+public:
+    bool begin(uint8_t addr = CCS811_ADDRESS);
+    void setDriveMode(uint8_t mode);
+    void enableInterrupt();
+    void disableInterrupt();
+    bool available();
+    uint8_t readData();
+    bool checkError();
+    uint16_t getTVOC() { return tvoc_; }
+    uint16_t geteCO2() { return eco2_; }
+    uint16_t getBaseline();
+    void setBaseline(uint16_t baseline);
+    void setEnvironmentalData(float humidity, float temperature);
+private:
+    uint16_t tvoc_ = 0;
+    uint16_t eco2_ = 0;
+};
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef HOST_ADAFRUIT_NEOPIXEL_H
+#define HOST_ADAFRUIT_NEOPIXEL_H
+
+#include <Arduino.h>
+
+#define NEO_GRB     0x52
+#define NEO_RGB     0x06
+#define NEO_KHZ800  0x0000
+
+class Adafruit_NeoPixel {
+public:
+    Adafruit_NeoPixel(uint16_t n, int16_t pin, uint16_t type) : pixels_(n, 0), pin_(pin), type_(type) {}
+    void begin() {}
+    void show();
+    void clear() { std::fill(pixels_.begin(), pixels_.end(), 0); }
+    void setPixelColor(uint16_t n, uint32_t c) { if (n < pixels_.size()) pixels_[n] = c; }
+    uint32_t getPixelColor(uint16_t n) const { return n < pixels_.size() ? pixels_[n] : 0; }
+    uint16_t numPixels() const { return (uint16_t)pixels_.size(); }
+    void setBrightness(uint8_t b) { brightness_ = b; }
+    static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) {
+        return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+    }
+private:
+    std::vector<uint32_t> pixels_;
+    int16_t pin_;
+    uint16_t type_;
+    uint8_t brightness_ = 255;
+};
+
+#endif
@@ -0,0 +1,187 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Host stand-in for the Arduino-ESP32 core. Only the surface the firmware
+// actually uses is provided; time is virtual and advanced by the fakes
+// (see fakeBoard.h), so blocking calls show up as elapsed milliseconds.
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+using std::abs;
+using std::min;
+using std::max;
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+typedef uint8_t byte;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT        0x01
+#define OUTPUT       0x03
+#define INPUT_PULLUP 0x05
+
+#define RISING  0x01
+#define FALLING 0x02
+#define CHANGE  0x03
+
+#define IRAM_ATTR
+
+class String {
+public:
+    String() {}
+    String(const char* s) : s_(s ? s : "") {}
+    String(const std::string& s) : s_(s) {}
+    String(const String&) = default;
+    String(String&&) = default;
+    explicit String(char c) : s_(1, c) {}
+    String(int v) : s_(std::to_string(v)) {}
+    String(unsigned int v) : s_(std::to_string(v)) {}
+    String(long v) : s_(std::to_string(v)) {}
+    String(unsigned long v) : s_(std::to_string(v)) {}
+    String(float v, unsigned int decimals = 2) { format(v, decimals); }
+    String(double v, unsigned int decimals = 2) { format(v, decimals); }
+
+    String& operator=(const String&) = default;
+    String& operator=(String&&) = default;
+    String& operator=(const char* s) { s_ = s ? s : ""; return *this; }
+
+    const char* c_str() const { return s_.c_str(); }
+    unsigned int length() const { return (unsigned int)s_.size(); }
+    bool isEmpty() const { return s_.empty(); }
+    const std::string& str() const { return s_; }
+
+    char operator[](unsigned int i) const { return i < s_.size() ? s_[i] : 0; }
+    char charAt(unsigned int i) const { return (*this)[i]; }
+
+    String& operator+=(const String& o) { s_ += o.s_; return *this; }
+    String& operator+=(const char* o) { s_ += o ? o : ""; return *this; }
+    String& operator+=(char c) { s_ += c; return *this; }
+    bool concat(const String& o) { s_ += o.s_; return true; }
+
+    bool operator==(const String& o) const { return s_ == o.s_; }
+    bool operator==(const char* o) const { return s_ == (o ? o : ""); }
+    bool operator!=(const String& o) const { return s_ != o.s_; }
+    bool operator!=(const char* o) const { return s_ != (o ? o : ""); }
+    bool operator<(const String& o) const { return s_ < o.s_; }
+    bool equals(const String& o) const { return s_ == o.s_; }
+
+    void toLowerCase() { for (char& c : s_) c = tolower((unsigned char)c); }
+    bool startsWith(const String& p) const { return s_.compare(0, p.s_.size(), p.s_) == 0; }
+    bool endsWith(const String& p) const {
+        return s_.size() >= p.s_.size() && s_.compare(s_.size() - p.s_.size(), p.s_.size(), p.s_) == 0;
+    }
+    int indexOf(char c, unsigned int from = 0) const {
+        size_t i = s_.find(c, from);
+        return i == std::string::npos ? -1 : (int)i;
+    }
+    int indexOf(const String& p, unsigned int from = 0) const {
+        size_t i = s_.find(p.s_, from);
+        return i == std::string::npos ? -1 : (int)i;
+    }
+    String substring(unsigned int from) const { return from < s_.size() ? String(s_.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const {
+        if (from > to) std::swap(from, to);
+        if (from >= s_.size()) return String();
+        return String(s_.substr(from, to - from));
+    }
+    void replace(const String& from, const String& to) {
+        if (from.s_.empty()) return;
+        size_t pos = 0;
+        while ((pos = s_.find(from.s_, pos)) != std::string::npos) {
+            s_.replace(pos, from.s_.size(), to.s_);
+            pos += to.s_.size();
+        }
+    }
+    long toInt() const { return strtol(s_.c_str(), nullptr, 10); }
+    float toFloat() const { return strtof(s_.c_str(), nullptr); }
+
+private:
+    void format(double v, unsigned int decimals) {
+        char buf[48];
+        snprintf(buf, sizeof(buf), "%.*f", (int)decimals, v);
+        s_ = buf;
+    }
+    std::string s_;
+};
+
+inline String operator+(const String& a, const String& b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, const char* b) { String r(a); r += b; return r; }
+inline String operator+(const char* a, const String& b) { String r(a); r += b; return r; }
+inline bool operator==(const char* a, const String& b) { return b == a; }
+inline bool operator!=(const char* a, const String& b) { return b != a; }
+
+class HostSerial {
+public:
+    void begin(unsigned long) {}
+    size_t print(const String& s) { return write(s.c_str()); }
+    size_t print(const char* s) { return write(s); }
+    size_t print(char c) { char b[2] = {c, 0}; return write(b); }
+    size_t print(int v) { return print(String(v)); }
+    size_t print(unsigned int v) { return print(String(v)); }
+    size_t print(long v) { return print(String(v)); }
+    size_t print(unsigned long v) { return print(String(v)); }
+    size_t print(double v, int d = 2) { return print(String(v, d)); }
+    size_t println() { return write("\n"); }
+    template <typename T> size_t println(const T& v) { return print(v) + println(); }
+    size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+    size_t write(const char* s);
+    size_t write(uint8_t c) { char b[2] = {(char)c, 0}; return write(b); }
+    int available() { return 0; }
+    int read() { return -1; }
+    void flush() {}
+};
+extern HostSerial Serial;
+
+class EspClass {
+public:
+    [[noreturn]] void restart();
+    uint32_t getFreeHeap();
+    uint32_t getMinFreeHeap();
+    uint32_t getMaxAllocHeap();
+};
+extern EspClass ESP;
+
+uint32_t esp_random();
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t level);
+// The handler runs from fakeSetPin() when the level changes as `mode` asks.
+void attachInterrupt(uint8_t pin, void (*handler)(), int mode);
+void detachInterrupt(uint8_t pin);
+#define digitalPinToInterrupt(pin) (pin)
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration = 0);
+void noTone(uint8_t pin);
+// esp32-hal-ledc (core 2.x)
+double ledcSetup(uint8_t channel, double freq, uint8_t resolution_bits);
+void ledcAttachPin(uint8_t pin, uint8_t channel);
+void ledcDetachPin(uint8_t pin);
+void ledcWrite(uint8_t channel, uint32_t duty);
+double ledcWriteTone(uint8_t channel, double freq);
+void noInterrupts();
+void interrupts();
+
+void configTime(long gmtOffset_sec, int daylightOffset_sec, const char* server1,
+                const char* server2 = nullptr, const char* server3 = nullptr);
+bool getLocalTime(struct tm* info, uint32_t ms = 5000);
+
+#endif
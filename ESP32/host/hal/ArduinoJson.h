@@ -0,0 +1,8 @@
+#ifndef HOST_ARDUINO_JSON_H
+#define HOST_ARDUINO_JSON_H
+
+// The host build does not compile the provisioning server (InitSetup.cpp),
+// which is the only ArduinoJson user; headers that merely include it are fine.
+#include <Arduino.h>
+
+#endif
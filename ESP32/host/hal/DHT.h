@@ -0,0 +1,25 @@
+#ifndef HOST_DHT_H
+#define HOST_DHT_H
+
+#include <Arduino.h>
+
+#define DHT11 11
+#define DHT22 22
+
+// Readings come from fakeSetRoom(); a fresh read (>2 s after the last one,
+// like the Adafruit driver's cache) costs the DHT11 transfer time.
+class DHT {
+public:
+    DHT(uint8_t pin, uint8_t type) : pin_(pin), type_(type) {}
+    void begin() {}
+    float readTemperature(bool S = false, bool force = false);
+    float readHumidity(bool force = false);
+private:
+    void transfer(bool force);
+    uint8_t pin_;
+    uint8_t type_;
+    unsigned long lastReadMs_ = 0;
+    bool everRead_ = false;
+};
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef HOST_ESP_ASYNC_WEB_SERVER_H
+#define HOST_ESP_ASYNC_WEB_SERVER_H
+
+// Host stand-in for ESPAsyncWebServer (with its AsyncWebSocket). Handlers
+// run on an "async_tcp" task, as AsyncTCP runs them on the device, when a
+// client from fakeBoard.h delivers a request or frame.
+
+#include <Arduino.h>
+#include <functional>
+#include <map>
+#include <vector>
+
+typedef enum {
+    HTTP_GET = 0b00000001,
+    HTTP_POST = 0b00000010,
+    HTTP_ANY = 0b01111111,
+} WebRequestMethod;
+typedef uint8_t WebRequestMethodComposite;
+
+class AsyncWebServerRequest {
+public:
+    ~AsyncWebServerRequest() { free(_tempObject); }
+    WebRequestMethodComposite method() const { return method_; }
+    const String& url() const { return url_; }
+    size_t contentLength() const { return body_.length(); }
+    bool hasHeader(const char* name) const { return headers_.count(name) > 0; }
+    const String& header(const char* name) const;
+    void send(int code, const char* contentType = "", const String& content = String());
+
+    void* _tempObject = nullptr;
+
+    WebRequestMethodComposite method_ = HTTP_GET;
+    String url_;
+    String body_;
+    std::map<std::string, String> headers_;
+    int sentCode_ = 0;
+    String sentBody_;
+};
+
+typedef std::function<void(AsyncWebServerRequest*)> ArRequestHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest*, const String&, size_t, uint8_t*, size_t, bool)>
+    ArUploadHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest*, uint8_t*, size_t, size_t, size_t)> ArBodyHandlerFunction;
+
+typedef enum { WS_EVT_CONNECT, WS_EVT_DISCONNECT, WS_EVT_PONG, WS_EVT_ERROR, WS_EVT_DATA } AwsEventType;
+typedef enum { WS_CONTINUATION, WS_TEXT, WS_BINARY, WS_DISCONNECT = 0x08, WS_PING, WS_PONG } AwsFrameType;
+
+struct AwsFrameInfo {
+    uint8_t message_opcode;
+    uint32_t num;
+    uint8_t final;
+    uint8_t masked;
+    uint8_t opcode;
+    uint64_t len;
+    uint8_t mask[4];
+    uint64_t index;
+};
+
+class AsyncWebSocket;
+
+class AsyncWebSocketClient {
+public:
+    uint32_t id() const { return id_; }
+    void text(const char* message);
+    void text(const String& message) { text(message.c_str()); }
+    void close(uint16_t code = 0, const char* message = nullptr);
+
+    uint32_t id_ = 0;
+    AsyncWebSocket* server_ = nullptr;
+};
+
+typedef std::function<void(AsyncWebSocket*, AsyncWebSocketClient*, AwsEventType, void*, uint8_t*, size_t)>
+    AwsEventHandler;
+
+class AsyncWebHandler {
+public:
+    virtual ~AsyncWebHandler() {}
+};
+
+class AsyncWebSocket : public AsyncWebHandler {
+public:
+    explicit AsyncWebSocket(const char* url) : url_(url) {}
+    void onEvent(AwsEventHandler handler) { handler_ = handler; }
+    size_t count() const { return clients_.size(); }
+    AsyncWebSocketClient* client(uint32_t id);
+    void text(uint32_t id, const char* message);
+    void textAll(const char* message);
+    void close(uint32_t id, uint16_t code = 0, const char* message = nullptr);
+    void cleanupClients(uint16_t maxClients = 8) { (void)maxClients; }
+
+    String url_;
+    AwsEventHandler handler_;
+    std::map<uint32_t, AsyncWebSocketClient> clients_;
+};
+
+class AsyncWebServer {
+public:
+    explicit AsyncWebServer(uint16_t port) : port_(port) {}
+    void on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest);
+    void on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+            ArUploadHandlerFunction onUpload, ArBodyHandlerFunction onBody);
+    void onNotFound(ArRequestHandlerFunction fn) { notFound_ = fn; }
+    AsyncWebHandler& addHandler(AsyncWebHandler* handler);
+    void begin();
+    void end();
+
+    struct Route {
+        String uri;
+        WebRequestMethodComposite method;
+        ArRequestHandlerFunction onRequest;
+        ArBodyHandlerFunction onBody;
+    };
+    uint16_t port_;
+    std::vector<Route> routes_;
+    ArRequestHandlerFunction notFound_;
+    AsyncWebSocket* ws_ = nullptr;
+};
+
+#endif
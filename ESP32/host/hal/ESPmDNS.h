@@ -0,0 +1,18 @@
+#ifndef HOST_ESP_MDNS_H
+#define HOST_ESP_MDNS_H
+
+// Host stand-in for ESPmDNS: records what the device announces, see
+// fakeMdnsHostname() and fakeMdnsServices() in fakeBoard.h.
+
+#include <Arduino.h>
+
+class MDNSResponder {
+public:
+    bool begin(const char* hostName);
+    void end();
+    bool addService(const char* service, const char* proto, uint16_t port);
+    bool addServiceTxt(const char* service, const char* proto, const char* key, const char* value);
+};
+extern MDNSResponder MDNS;
+
+#endif
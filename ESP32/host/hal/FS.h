@@ -0,0 +1,64 @@
+#ifndef HOST_FS_H
+#define HOST_FS_H
+
+// Host stand-in for the Arduino FS API. Files live in memory (fakeFs.cpp)
+// and survive everything but fakeReset(); writes are counted in fakeStats and
+// charged to the clock when the file is closed, as LittleFS commits then.
+
+#include <Arduino.h>
+#include <memory>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+struct FakeFileState;
+
+class File {
+public:
+    File() {}
+    explicit File(std::shared_ptr<FakeFileState> state) : state_(state) {}
+
+    size_t write(const uint8_t* buf, size_t size);
+    size_t write(uint8_t c) { return write(&c, 1); }
+    size_t read(uint8_t* buf, size_t size);
+    int read();
+    int available();
+    size_t size() const;
+    bool seek(uint32_t pos);
+    size_t position() const;
+    void close();
+    bool isDirectory() const;
+    const char* name() const;
+    const char* path() const;
+    File openNextFile();
+    operator bool() const { return state_ != nullptr; }
+
+private:
+    std::shared_ptr<FakeFileState> state_;
+};
+
+class FS {
+public:
+    File open(const char* path, const char* mode = FILE_READ, bool create = false);
+    File open(const String& path, const char* mode = FILE_READ, bool create = false) {
+        return open(path.c_str(), mode, create);
+    }
+    bool exists(const char* path);
+    bool exists(const String& path) { return exists(path.c_str()); }
+    bool remove(const char* path);
+    bool remove(const String& path) { return remove(path.c_str()); }
+    bool rename(const char* from, const char* to);
+    bool mkdir(const char* path);
+    bool mkdir(const String& path) { return mkdir(path.c_str()); }
+    bool rmdir(const char* path);
+};
+
+}
+
+using fs::File;
+using fs::FS;
+
+#endif
@@ -0,0 +1,171 @@
+#ifndef HOST_FIREBASE_ESP_CLIENT_H
+#define HOST_FIREBASE_ESP_CLIENT_H
+
+// Host stand-in for Firebase_ESP_Client backed by an in-memory RTDB.
+// Every request costs one simulated HTTPS round trip on the virtual clock
+// and is counted in fakeStats, so write amplification is measurable.
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <map>
+
+struct FakeJsonValue {
+    enum Type { Null, Bool, Int, Float, Str };
+    Type type = Null;
+    bool b = false;
+    long long i = 0;
+    double f = 0;
+    std::string s;
+
+    std::string encode() const;
+};
+
+class FirebaseJsonData {
+public:
+    bool success = false;
+    String type;
+    String stringValue;
+    int intValue = 0;
+    float floatValue = 0;
+    double doubleValue = 0;
+    bool boolValue = false;
+
+    template <typename T> T to() const;
+    void clear() { *this = FirebaseJsonData(); }
+    void assign(const FakeJsonValue& v);
+};
+
+template <> inline bool FirebaseJsonData::to<bool>() const { return boolValue; }
+template <> inline int FirebaseJsonData::to<int>() const { return intValue; }
+template <> inline float FirebaseJsonData::to<float>() const { return floatValue; }
+template <> inline double FirebaseJsonData::to<double>() const { return doubleValue; }
+template <> inline String FirebaseJsonData::to<String>() const { return stringValue; }
+
+// Flattened JSON: keys are slash-separated paths relative to the node.
+class FirebaseJson {
+public:
+    typedef std::map<std::string, FakeJsonValue> Entries;
+
+    FirebaseJson& set(const String& path, const String& value);
+    FirebaseJson& set(const String& path, const char* value) { return set(path, String(value)); }
+    FirebaseJson& set(const String& path, bool value);
+    FirebaseJson& set(const String& path, int value) { return setInt(path, value); }
+    FirebaseJson& set(const String& path, unsigned int value) { return setInt(path, value); }
+    FirebaseJson& set(const String& path, long value) { return setInt(path, value); }
+    FirebaseJson& set(const String& path, unsigned long value) { return setInt(path, (long long)value); }
+    FirebaseJson& set(const String& path, float value) { return setFloat(path, value); }
+    FirebaseJson& set(const String& path, double value) { return setFloat(path, value); }
+    FirebaseJson& setValue(const String& path, const FakeJsonValue& value);
+
+    bool get(FirebaseJsonData& result, const String& path) const;
+    bool remove(const String& path);
+    void clear() { entries_.clear(); }
+    void toString(String& out, bool prettify = false) const;
+    // Parses a JSON object; arrays flatten to "[i]" keys as in get().
+    bool setJsonData(const String& data);
+
+    const Entries& entries() const { return entries_; }
+
+private:
+    FirebaseJson& setInt(const String& path, long long value);
+    FirebaseJson& setFloat(const String& path, double value);
+    Entries entries_;
+};
+
+class FirebaseStream {
+public:
+    String dataType() const { return type_; }
+    String dataPath() const { return dataPath_; }
+    String streamPath() const { return streamPath_; }
+    template <typename T> T& to();
+
+    String type_;
+    String dataPath_;
+    String streamPath_;
+    FirebaseJson json_;
+};
+
+template <> inline FirebaseJson& FirebaseStream::to<FirebaseJson>() { return json_; }
+
+typedef void (*FirebaseStreamCallback)(FirebaseStream);
+typedef void (*FirebaseStreamTimeoutCallback)(bool);
+
+// Holds the last response the way the library does: the raw body until
+// clear(), plus a parsed tree once to<FirebaseJson>() asks for it. Both are
+// charged to the heap model in fakeBoard.h.
+class FirebaseData {
+public:
+    FirebaseData() = default;
+    FirebaseData(const FirebaseData&) = delete;
+    ~FirebaseData() { clear(); }
+    void setBSSLBufferSize(int rx, int tx) { (void)rx; (void)tx; }
+    void clear();
+    String errorReason() const { return error_; }
+    String dataType() const { return "json"; }
+    // The body as received; a copy, as in the library.
+    String payload() const;
+    template <typename T> T& to();
+    FirebaseJson& parsed();
+
+    FirebaseJson payload_;
+    String raw_;
+    size_t treeBytes_ = 0;
+    String error_;
+    String streamPath_;
+    bool streaming_ = false;
+    FirebaseStreamCallback onData_ = nullptr;
+    FirebaseStreamTimeoutCallback onTimeout_ = nullptr;
+};
+
+template <> inline FirebaseJson& FirebaseData::to<FirebaseJson>() { return parsed(); }
+
+struct TokenInfo {
+    int status = 0;
+};
+
+struct FirebaseAuth {
+    struct { String email; String password; } user;
+    struct { String uid; } token;
+};
+
+struct FirebaseConfig {
+    String api_key;
+    String database_url;
+    struct {
+        unsigned long wifiReconnect = 0;
+        unsigned long socketConnection = 0;
+        unsigned long sslHandshake = 0;
+        unsigned long serverResponse = 0;
+        unsigned long rtdbKeepAlive = 0;
+        unsigned long rtdbStreamReconnect = 0;
+        unsigned long rtdbStreamError = 0;
+    } timeout;
+    void (*token_status_callback)(TokenInfo) = nullptr;
+};
+
+class FB_RTDB {
+public:
+    bool getJSON(FirebaseData* fbdo, const String& path);
+    bool setString(FirebaseData* fbdo, const String& path, const String& value);
+    bool setInt(FirebaseData* fbdo, const String& path, long long value);
+    bool setBool(FirebaseData* fbdo, const String& path, bool value);
+    bool setFloat(FirebaseData* fbdo, const String& path, float value);
+    bool updateNode(FirebaseData* fbdo, const String& path, FirebaseJson* json);
+    bool deleteNode(FirebaseData* fbdo, const String& path);
+    bool beginStream(FirebaseData* fbdo, const String& path);
+    bool endStream(FirebaseData* fbdo);
+    void setStreamCallback(FirebaseData* fbdo, FirebaseStreamCallback onData,
+                           FirebaseStreamTimeoutCallback onTimeout);
+    bool readStream(FirebaseData* fbdo);
+};
+
+class Firebase_ESP_Client {
+public:
+    FB_RTDB RTDB;
+    void begin(FirebaseConfig* config, FirebaseAuth* auth);
+    void reconnectWiFi(bool reconnect) { (void)reconnect; }
+    bool ready();
+};
+extern Firebase_ESP_Client Firebase;
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef HOST_IRRECV_H
+#define HOST_IRRECV_H
+
+#include <IRremoteESP8266.h>
+
+const uint16_t kRawTick = 2;   // Microseconds per rawbuf tick, as in IRremoteESP8266.
+const uint16_t kRawBuf = 100;
+const uint8_t kTimeoutMs = 15;
+
+struct decode_results {
+    volatile uint16_t* rawbuf = nullptr;
+    uint16_t rawlen = 0;
+    bool overflow = false;
+};
+
+class IRrecv {
+public:
+    explicit IRrecv(uint16_t pin, uint16_t bufsize = kRawBuf, uint8_t timeout = kTimeoutMs, bool save_buffer = false)
+        : pin_(pin) { (void)bufsize; (void)timeout; (void)save_buffer; }
+    void enableIRIn() {}
+    bool decode(decode_results* results);
+    void resume() {}
+private:
+    uint16_t pin_;
+};
+
+#endif
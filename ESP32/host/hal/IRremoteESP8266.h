@@ -0,0 +1,6 @@
+#ifndef HOST_IRREMOTEESP8266_H
+#define HOST_IRREMOTEESP8266_H
+
+#include <Arduino.h>
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef HOST_IRSEND_H
+#define HOST_IRSEND_H
+
+#include <IRremoteESP8266.h>
+
+// Emission is synchronous on the real library: the CPU bit-bangs the carrier
+// for the whole frame. The fake charges that air time to the virtual clock.
+class IRsend {
+public:
+    explicit IRsend(uint16_t pin, bool inverted = false, bool use_modulation = true)
+        : pin_(pin) { (void)inverted; (void)use_modulation; }
+    void begin() {}
+    void sendRaw(const uint16_t buf[], uint16_t len, uint16_t hz);
+private:
+    uint16_t pin_;
+};
+
+// Records one emitted frame and blocks the virtual clock for its air time.
+void fakeIrEmit(const char* protocol, unsigned long airTimeUs);
+
+#endif
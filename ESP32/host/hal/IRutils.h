@@ -0,0 +1,6 @@
+#ifndef HOST_IRUTILS_H
+#define HOST_IRUTILS_H
+
+#include <IRremoteESP8266.h>
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef HOST_PREFERENCES_H
+#define HOST_PREFERENCES_H
+
+#include <Arduino.h>
+
+// In-memory NVS. Every put* is counted as a flash write in fakeStats.
+class Preferences {
+public:
+    bool begin(const char* name, bool readOnly = false);
+    void end();
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key);
+
+    size_t putBool(const char* key, bool value);
+    size_t putInt(const char* key, int32_t value);
+    size_t putUInt(const char* key, uint32_t value);
+    size_t putFloat(const char* key, float value);
+    size_t putString(const char* key, const String& value);
+    size_t putBytes(const char* key, const void* value, size_t len);
+
+    bool getBool(const char* key, bool defaultValue = false);
+    int32_t getInt(const char* key, int32_t defaultValue = 0);
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0);
+    float getFloat(const char* key, float defaultValue = NAN);
+    String getString(const char* key, const String& defaultValue = String());
+    size_t getBytesLength(const char* key);
+    size_t getBytes(const char* key, void* buf, size_t maxLen);
+
+private:
+    size_t put(const char* key, char type, const void* data, size_t len);
+    const std::string* find(const char* key, char type);
+    std::string ns_;
+    bool open_ = false;
+    bool readOnly_ = true;
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include <Arduino.h>
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum {
+    WIFI_OFF = 0,
+    WIFI_STA = 1,
+    WIFI_AP = 2,
+    WIFI_AP_STA = 3
+} wifi_mode_t;
+
+class IPAddress {
+public:
+    IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0) : a_(a), b_(b), c_(c), d_(d) {}
+    String toString() const {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%u.%u.%u.%u", a_, b_, c_, d_);
+        return String(buf);
+    }
+private:
+    uint8_t a_, b_, c_, d_;
+};
+
+class WiFiClass {
+public:
+    wl_status_t status();
+    wifi_mode_t getMode();
+    String macAddress();
+    wl_status_t begin(const char* ssid, const char* pass);
+    bool disconnect(bool wifioff = false);
+    bool setAutoReconnect(bool autoReconnect) { (void)autoReconnect; return true; }
+    bool softAP(const char* ssid, const char* pass);
+    bool setSleep(bool enabled); // modem sleep, on by default as in the Arduino core
+    bool getSleep();
+    IPAddress softAPIP() { return IPAddress(192, 168, 4, 1); }
+    IPAddress localIP() { return IPAddress(192, 168, 1, 50); }
+};
+extern WiFiClass WiFi;
+
+#endif
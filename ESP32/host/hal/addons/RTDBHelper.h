@@ -0,0 +1,6 @@
+#ifndef HOST_RTDB_HELPER_H
+#define HOST_RTDB_HELPER_H
+
+#include <Firebase_ESP_Client.h>
+
+#endif
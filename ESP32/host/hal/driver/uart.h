@@ -0,0 +1,70 @@
+#ifndef HOST_DRIVER_UART_H
+#define HOST_DRIVER_UART_H
+
+// Host stand-in for the ESP-IDF UART driver: what fakeUartReceive()
+// (fakeBoard.h) puts on the wire arrives at the configured baud rate, moves
+// into the driver's ring buffer every rx full threshold bytes and once the
+// line has been idle for the rx timeout, and each move posts a UART_DATA
+// event. A full ring drops what does not fit and posts UART_BUFFER_FULL.
+// Nothing is received while the chip is in light sleep (esp_sleep.h).
+// Reads never wait: they return what the ring holds, up to `length`.
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+typedef int uart_port_t;
+#define UART_NUM_0 0
+#define UART_NUM_1 1
+#define UART_NUM_2 2
+#define UART_NUM_MAX 3
+#define UART_PIN_NO_CHANGE (-1)
+
+typedef enum { UART_DATA_5_BITS, UART_DATA_6_BITS, UART_DATA_7_BITS, UART_DATA_8_BITS } uart_word_length_t;
+typedef enum { UART_PARITY_DISABLE = 0, UART_PARITY_EVEN = 2, UART_PARITY_ODD = 3 } uart_parity_t;
+typedef enum { UART_STOP_BITS_1 = 1, UART_STOP_BITS_1_5 = 2, UART_STOP_BITS_2 = 3 } uart_stop_bits_t;
+typedef enum { UART_HW_FLOWCTRL_DISABLE = 0 } uart_hw_flowcontrol_t;
+
+typedef struct {
+    int baud_rate;
+    uart_word_length_t data_bits;
+    uart_parity_t parity;
+    uart_stop_bits_t stop_bits;
+    uart_hw_flowcontrol_t flow_ctrl;
+    uint8_t rx_flow_ctrl_thresh;
+} uart_config_t;
+
+typedef enum {
+    UART_DATA,
+    UART_BREAK,
+    UART_BUFFER_FULL,
+    UART_FIFO_OVF,
+    UART_FRAME_ERR,
+    UART_PARITY_ERR,
+    UART_DATA_BREAK,
+    UART_PATTERN_DET,
+    UART_EVENT_MAX
+} uart_event_type_t;
+
+typedef struct {
+    uart_event_type_t type;
+    size_t size;
+    bool timeout_flag;
+} uart_event_t;
+
+esp_err_t uart_driver_install(uart_port_t port, int rx_buffer_size, int tx_buffer_size, int queue_size,
+                              QueueHandle_t* uart_queue, int intr_alloc_flags);
+esp_err_t uart_param_config(uart_port_t port, const uart_config_t* config);
+esp_err_t uart_set_pin(uart_port_t port, int tx, int rx, int rts, int cts);
+esp_err_t uart_set_rx_full_threshold(uart_port_t port, int threshold);
+esp_err_t uart_set_rx_timeout(uart_port_t port, uint8_t tout_thresh);
+// RX edges that wake the chip from light sleep, 3 to 1023; the port must
+// also be a wakeup source (esp_sleep.h).
+esp_err_t uart_set_wakeup_threshold(uart_port_t port, int wakeup_threshold);
+int uart_read_bytes(uart_port_t port, void* buf, uint32_t length, TickType_t ticks_to_wait);
+int uart_write_bytes(uart_port_t port, const void* src, size_t size);
+esp_err_t uart_flush_input(uart_port_t port);
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef HOST_ESP_PM_H
+#define HOST_ESP_PM_H
+
+// Host stand-in for ESP-IDF power management. With light sleep enabled the
+// fake power model (fakeBoard.h) puts the chip to sleep whenever every task
+// is blocked for long enough and no ESP_PM_NO_LIGHT_SLEEP lock is held.
+
+#include "esp_err.h"
+
+typedef struct {
+    int max_freq_mhz;
+    int min_freq_mhz;
+    bool light_sleep_enable;
+} esp_pm_config_esp32_t;
+
+typedef enum { ESP_PM_CPU_FREQ_MAX, ESP_PM_APB_FREQ_MAX, ESP_PM_NO_LIGHT_SLEEP } esp_pm_lock_type_t;
+typedef struct FakePmLock* esp_pm_lock_handle_t;
+
+esp_err_t esp_pm_configure(const void* config);
+esp_err_t esp_pm_lock_create(esp_pm_lock_type_t lock_type, int arg, const char* name, esp_pm_lock_handle_t* out_handle);
+esp_err_t esp_pm_lock_acquire(esp_pm_lock_handle_t handle);
+esp_err_t esp_pm_lock_release(esp_pm_lock_handle_t handle);
+
+#endif
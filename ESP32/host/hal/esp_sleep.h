@@ -0,0 +1,15 @@
+#ifndef HOST_ESP_SLEEP_H
+#define HOST_ESP_SLEEP_H
+
+#include "esp_err.h"
+
+typedef enum { ESP_SLEEP_WAKEUP_TIMER = 4, ESP_SLEEP_WAKEUP_GPIO = 7, ESP_SLEEP_WAKEUP_UART = 8 } esp_sleep_source_t;
+
+esp_err_t esp_sleep_enable_gpio_wakeup();
+// UART0 and UART1 only, as on the ESP32. The UART does not receive in light
+// sleep: without its wakeup what arrives then is lost, with it the first
+// bytes are, while the chip wakes (driver/uart.h).
+esp_err_t esp_sleep_enable_uart_wakeup(int uart_num);
+esp_err_t esp_sleep_disable_wakeup_source(esp_sleep_source_t source);
+
+#endif
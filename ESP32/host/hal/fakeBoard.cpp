@@ -0,0 +1,785 @@
+#include <stdarg.h>
+#include <map>
+#include <Arduino.h>
+#include <WiFi.h>
+#include <Preferences.h>
+#include <DHT.h>
+#include <Adafruit_CCS811.h>
+#include <Adafruit_NeoPixel.h>
+#include <IRsend.h>
+#include <IRrecv.h>
+#include "driver/rmt.h"
+#include "driver/gpio.h"
+#include "esp_pm.h"
+#include "esp_sleep.h"
+#include <base64.h>
+#include "fakeBoard.h"
+#include "parameters.h"
+
+FakeStats fakeStats;
+FakePower fakePower;
+FakeAirSensor fakeAirSensor;
+HostSerial Serial;
+EspClass ESP;
+WiFiClass WiFi;
+
+namespace {
+
+unsigned long long nowUs = 0;
+time_t wallBase = 1752393600;   // 2025-07-13 08:00 UTC
+long tzOffset = 0;
+bool timeConfigured = false;
+unsigned long long timeConfiguredUs = 0;
+bool timeSynced = false;
+int pins[64];
+float roomTemp = 24.0f;
+float roomHum = 50.0f;
+uint16_t airEco2 = 400;
+uint16_t airTvoc = 0;
+bool airReady = false;            // a result not read yet
+bool airEventArmed = false;
+unsigned long long airNextUs = 0; // the next measurement, kNeverUs while idle
+const unsigned long kAirPeriodMs[] = {0, 1000, 10000, 60000, 250}; // by drive mode
+bool wifiConnected = true;
+const unsigned long long kNeverUs = ~0ULL;
+unsigned long long wifiJoinedUs = 0; // kNeverUs until WiFi.begin()
+bool serialEcho = true;
+unsigned long long serialIdleAtUs = 0; // when the UART has sent all it was given
+std::string serialOutput;
+// NVS entries keep their type, like nvs_get_* which fails on a mismatch.
+struct NvsEntry {
+    char type;
+    std::string data;
+};
+std::map<std::string, std::map<std::string, NvsEntry>> nvs;
+std::vector<FakeIrFrame> irFrames;
+unsigned long long rmtBusyUntilUs[RMT_CHANNEL_MAX];
+std::vector<FakeTone> tones;
+void (*pinHandlers[64])();
+int pinHandlerModes[64];
+int wakeLevels[64]; // -1 when the pin does not wake the chip
+bool gpioWakeup = false;
+bool modemSleep = true;
+bool lightSleep = false;
+int noSleepLocks = 0;
+int uartWakePort = -1;
+unsigned long long uartWokeUs = 0;
+unsigned long long radioBusyUntilUs = 0;
+uint32_t randomState = 1;
+size_t heapUsed = 0;
+size_t heapPeak = 0;
+size_t heapLowWater = 0; // the most ever used, for getMinFreeHeap()
+
+void recordIrFrame(const char* protocol, unsigned long airTimeUs) {
+    irFrames.push_back({String(protocol), nowUs, airTimeUs});
+    fakeStats.irFrames++;
+    fakeStats.irAirTimeUs += airTimeUs;
+}
+
+}
+
+void fakeResetFirebase();
+void fakeResetFs();
+void fakeResetRtos();
+void fakeResetLan();
+void fakeResetUart();
+
+void fakeReset() {
+    fakeStats = FakeStats();
+    nowUs = 0;
+    wallBase = 1752393600;
+    tzOffset = 0;
+    timeConfigured = false;
+    timeConfiguredUs = 0;
+    timeSynced = false;
+    for (int& p : pins) p = HIGH;
+    roomTemp = 24.0f;
+    roomHum = 50.0f;
+    fakeAirSensor = FakeAirSensor();
+    fakeAirSensor.baseline = 0x847B;
+    fakeAirSensor.humidity = fakeAirSensor.temperature = NAN;
+    airEco2 = 400;
+    airTvoc = 0;
+    airReady = false;
+    airEventArmed = false;
+    airNextUs = kNeverUs;
+    wifiConnected = true;
+    wifiJoinedUs = 0;
+    nvs.clear();
+    irFrames.clear();
+    tones.clear();
+    for (auto& busy : rmtBusyUntilUs) busy = 0;
+    for (auto& handler : pinHandlers) handler = nullptr;
+    for (int& level : wakeLevels) level = -1;
+    gpioWakeup = false;
+    modemSleep = true;
+    lightSleep = false;
+    noSleepLocks = 0;
+    uartWakePort = -1;
+    uartWokeUs = 0;
+    radioBusyUntilUs = 0;
+    randomState = 1;
+    heapUsed = 0;
+    heapPeak = 0;
+    heapLowWater = 0;
+    serialIdleAtUs = 0;
+    serialOutput.clear();
+    fakePower = FakePower();
+    fakeResetFirebase();
+    fakeResetFs();
+    fakeResetRtos();
+    fakeResetLan();
+    fakeResetUart();
+}
+
+unsigned long long fakeMicros() { return nowUs; }
+void fakeAdvanceMicros(unsigned long long us) { nowUs += us; }
+void fakeAdvanceMillis(unsigned long ms) { nowUs += (unsigned long long)ms * 1000ULL; }
+void fakeSetWallClock(time_t epochUtc) { wallBase = epochUtc - (time_t)(nowUs / 1000000ULL); }
+void fakeSetPin(uint8_t pin, int level) {
+    if (pin >= 64) return;
+    int was = pins[pin];
+    pins[pin] = level;
+    int mode = pinHandlerModes[pin];
+    if (!pinHandlers[pin] || was == level) return;
+    if (mode == CHANGE || (mode == RISING && level == HIGH) || (mode == FALLING && level == LOW)) pinHandlers[pin]();
+}
+int fakeGetPin(uint8_t pin) { return pin < 64 ? pins[pin] : LOW; }
+void fakeSetRoom(float tempC, float humidity) { roomTemp = tempC; roomHum = humidity; }
+void fakeSetAirSensorPresent(bool present) { fakeAirSensor.present = present; }
+void fakeSetAir(uint16_t eco2, uint16_t tvoc) { airEco2 = eco2; airTvoc = tvoc; }
+void fakeSetWifiConnected(bool connected) { wifiConnected = connected; }
+void fakeColdBoot() {
+    wifiJoinedUs = kNeverUs;
+    timeConfigured = false;
+    timeSynced = false;
+}
+void fakeSetSerialEcho(bool echo) { serialEcho = echo; }
+
+std::string fakeTakeSerialOutput() {
+    std::string out;
+    out.swap(serialOutput);
+    return out;
+}
+const std::vector<FakeIrFrame>& fakeIrFrames() { return irFrames; }
+const std::vector<FakeTone>& fakeTones() { return tones; }
+
+// ----------------------- Core -----------------------
+unsigned long millis() { return (unsigned long)(nowUs / 1000ULL); }
+unsigned long micros() { return (unsigned long)nowUs; }
+
+// Inside a task delay() is vTaskDelay(): the other tasks keep running, so only
+// delays outside tasks count as blocking.
+void delay(unsigned long ms) {
+    if (!fakeInTask()) fakeStats.delayedUs += (unsigned long long)ms * 1000ULL;
+    fakeBlockMicros((unsigned long long)ms * 1000ULL);
+}
+
+void delayMicroseconds(unsigned int us) {
+    fakeStats.delayedUs += us;
+    nowUs += us;
+}
+
+void yield() {}
+
+void attachInterrupt(uint8_t pin, void (*handler)(), int mode) {
+    if (pin >= 64) return;
+    pinHandlers[pin] = handler;
+    pinHandlerModes[pin] = mode;
+}
+
+void detachInterrupt(uint8_t pin) {
+    if (pin < 64) pinHandlers[pin] = nullptr;
+}
+
+String base64::encode(const uint8_t* data, size_t length) {
+    static const char digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    for (size_t i = 0; i < length; i += 3) {
+        uint32_t n = data[i] << 16 | (i + 1 < length ? data[i + 1] << 8 : 0) | (i + 2 < length ? data[i + 2] : 0);
+        out += digits[n >> 18 & 63];
+        out += digits[n >> 12 & 63];
+        out += i + 1 < length ? digits[n >> 6 & 63] : '=';
+        out += i + 2 < length ? digits[n & 63] : '=';
+    }
+    return String(out);
+}
+
+// ----------------------- Power -----------------------
+struct FakePmLock {
+    esp_pm_lock_type_t type;
+    int count;
+};
+
+esp_err_t gpio_wakeup_enable(gpio_num_t gpio_num, gpio_int_type_t intr_type) {
+    if (gpio_num < 0 || gpio_num >= 64) return ESP_FAIL;
+    if (intr_type != GPIO_INTR_LOW_LEVEL && intr_type != GPIO_INTR_HIGH_LEVEL) return ESP_FAIL;
+    wakeLevels[gpio_num] = intr_type == GPIO_INTR_HIGH_LEVEL ? HIGH : LOW;
+    return ESP_OK;
+}
+
+esp_err_t gpio_wakeup_disable(gpio_num_t gpio_num) {
+    if (gpio_num < 0 || gpio_num >= 64) return ESP_FAIL;
+    wakeLevels[gpio_num] = -1;
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_gpio_wakeup() {
+    gpioWakeup = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_uart_wakeup(int uart_num) {
+    if (uart_num != 0 && uart_num != 1) return ESP_ERR_INVALID_ARG;
+    uartWakePort = uart_num;
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_disable_wakeup_source(esp_sleep_source_t source) {
+    switch (source) {
+        case ESP_SLEEP_WAKEUP_GPIO: gpioWakeup = false; return ESP_OK;
+        case ESP_SLEEP_WAKEUP_UART: uartWakePort = -1; return ESP_OK;
+        default: return ESP_ERR_INVALID_STATE;
+    }
+}
+
+esp_err_t esp_pm_configure(const void* config) {
+    lightSleep = ((const esp_pm_config_esp32_t*)config)->light_sleep_enable;
+    return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_create(esp_pm_lock_type_t lock_type, int arg, const char* name, esp_pm_lock_handle_t* out_handle) {
+    (void)arg; (void)name;
+    *out_handle = new FakePmLock{lock_type, 0}; // firmware locks live for the whole process
+    return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_acquire(esp_pm_lock_handle_t handle) {
+    if (handle->count++ == 0 && handle->type == ESP_PM_NO_LIGHT_SLEEP) noSleepLocks++;
+    return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_release(esp_pm_lock_handle_t handle) {
+    if (handle->count == 0) return ESP_FAIL;
+    if (--handle->count == 0 && handle->type == ESP_PM_NO_LIGHT_SLEEP && noSleepLocks > 0) noSleepLocks--;
+    return ESP_OK;
+}
+
+// A pin already at its wake level wakes the chip right back up.
+static bool wakePinActive() {
+    if (!gpioWakeup) return false;
+    for (int pin = 0; pin < 64; pin++) {
+        if (wakeLevels[pin] >= 0 && pins[pin] == wakeLevels[pin]) return true;
+    }
+    return false;
+}
+
+unsigned long long fakeIdleSinceUs();
+
+// For the UART, which stops with the clock: whether the chip was asleep at
+// `us` as fakePowerIdle() will count the gap, and whether the port wakes it.
+bool fakeChipAsleepAt(unsigned long long us) {
+    unsigned long long since = std::max(fakeIdleSinceUs(), uartWokeUs);
+    return lightSleep && modemSleep && noSleepLocks == 0 && !wakePinActive() && us >= since + kFakeLightSleepMinUs;
+}
+
+bool fakeUartWakes(int port) {
+    return port == uartWakePort;
+}
+
+void fakeUartWoke() {
+    uartWokeUs = nowUs;
+}
+
+unsigned long long fakePowerIdle(unsigned long long fromUs, unsigned long long toUs) {
+    if (toUs <= fromUs) return 0;
+    unsigned long long gap = toUs - fromUs;
+    unsigned long long radio = radioBusyUntilUs > fromUs ? std::min(radioBusyUntilUs, toUs) - fromUs : 0;
+    unsigned long long rest = gap - radio;
+    fakePower.radioMaS += (radio * kFakeRadioMa + rest * (modemSleep ? kFakeBeaconMa : kFakeRadioMa)) / 1e6;
+    double idleMa = lightSleep ? kFakeCpuIdleDfsMa : kFakeCpuIdleMa;
+    if (lightSleep && modemSleep && noSleepLocks == 0 && rest >= kFakeLightSleepMinUs && !wakePinActive()) {
+        fakePower.cpuMaS += (radio * idleMa + rest * kFakeLightSleepMa) / 1e6;
+        fakePower.sleptUs += rest;
+        fakePower.lightSleeps++;
+        return kFakeLightSleepWakeUs;
+    }
+    fakePower.cpuMaS += gap * idleMa / 1e6;
+    return 0;
+}
+
+void fakePowerRun(unsigned long long heldUs) {
+    fakePower.wakes++;
+    fakePower.cpuMaS += (kFakeRunUs + heldUs) * kFakeCpuActiveMa / 1e6;
+    fakePower.radioMaS += heldUs * (modemSleep ? kFakeBeaconMa : kFakeRadioMa) / 1e6;
+}
+
+void fakeRadioBusy(unsigned long long us) {
+    radioBusyUntilUs = std::max(radioBusyUntilUs, nowUs + us);
+}
+
+unsigned long long fakeRadioDeliverAt(unsigned long long atUs) {
+    if (!modemSleep) return atUs;
+    return (atUs + kFakeDtimUs - 1) / kFakeDtimUs * kFakeDtimUs;
+}
+void pinMode(uint8_t pin, uint8_t mode) { (void)pin; (void)mode; }
+int digitalRead(uint8_t pin) { return fakeGetPin(pin); }
+void digitalWrite(uint8_t pin, uint8_t level) { fakeSetPin(pin, level); }
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration) { (void)pin; (void)frequency; (void)duration; }
+void noTone(uint8_t pin) { (void)pin; }
+double ledcSetup(uint8_t channel, double freq, uint8_t resolution_bits) { (void)channel; (void)resolution_bits; return freq; }
+void ledcAttachPin(uint8_t pin, uint8_t channel) { (void)pin; (void)channel; }
+void ledcDetachPin(uint8_t pin) { (void)pin; }
+void ledcWrite(uint8_t channel, uint32_t duty) {
+    if (duty == 0) tones.push_back({channel, nowUs, 0});
+}
+double ledcWriteTone(uint8_t channel, double freq) {
+    tones.push_back({channel, nowUs, (unsigned int)freq});
+    return freq;
+}
+void noInterrupts() {}
+void interrupts() {}
+
+void configTime(long gmtOffset_sec, int daylightOffset_sec, const char* server1,
+                const char* server2, const char* server3) {
+    (void)server1; (void)server2; (void)server3;
+    tzOffset = gmtOffset_sec + daylightOffset_sec;
+    if (!timeConfigured) timeConfiguredUs = nowUs;
+    timeConfigured = true;
+}
+
+// SNTP answers kFakeSntpMs after both configTime() and the station are up.
+static bool sntpSynced() {
+    if (!timeSynced && timeConfigured && WiFi.status() == WL_CONNECTED &&
+        nowUs >= std::max(timeConfiguredUs, wifiJoinedUs) + kFakeSntpMs * 1000ULL) {
+        timeSynced = true;
+    }
+    return timeSynced;
+}
+
+// The firmware reads the epoch with time(); on the host it follows the
+// virtual clock, counting from boot until SNTP has set it, as on the chip.
+extern "C" time_t time(time_t* out) {
+    time_t t = (time_t)(nowUs / 1000000ULL) + (sntpSynced() ? wallBase : 0);
+    if (out) *out = t;
+    return t;
+}
+
+bool getLocalTime(struct tm* info, uint32_t ms) {
+    (void)ms;
+    if (!sntpSynced()) return false;
+    time_t t = wallBase + (time_t)(nowUs / 1000000ULL) + tzOffset;
+    gmtime_r(&t, info);
+    return true;
+}
+
+size_t HostSerial::write(const char* s) {
+    size_t n = strlen(s);
+    if (serialEcho) fwrite(s, 1, n, stdout);
+    serialOutput.append(s, n);
+    const double byteUs = 10.0 * 1000000.0 / kFakeSerialBaud;
+    // Another writer may fill the FIFO while this one waits.
+    for (;;) {
+        double queued = serialIdleAtUs > nowUs ? (serialIdleAtUs - nowUs) / byteUs : 0;
+        if (queued + std::min(n, kFakeSerialFifo) <= kFakeSerialFifo + 0.5) break;
+        unsigned long long waitUs = (unsigned long long)((queued + std::min(n, kFakeSerialFifo) - kFakeSerialFifo) * byteUs) + 1;
+        fakeStats.serialBlockedUs += waitUs;
+        fakeBlockMicros(waitUs);
+    }
+    // A line longer than the FIFO keeps the writer until its tail fits.
+    if (n > kFakeSerialFifo) {
+        unsigned long long waitUs = (unsigned long long)((n - kFakeSerialFifo) * byteUs);
+        fakeStats.serialBlockedUs += waitUs;
+        fakeBlockMicros(waitUs);
+        serialIdleAtUs = nowUs + (unsigned long long)(kFakeSerialFifo * byteUs);
+    } else {
+        serialIdleAtUs = std::max(serialIdleAtUs, nowUs) + (unsigned long long)(n * byteUs);
+    }
+    fakeStats.serialBytes += n;
+    return n;
+}
+
+size_t HostSerial::printf(const char* fmt, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    return write(buf);
+}
+
+void EspClass::restart() { throw FakeRestart(); }
+uint32_t EspClass::getFreeHeap() { return 200000 - heapUsed; }
+uint32_t EspClass::getMinFreeHeap() { return 200000 - heapLowWater; }
+uint32_t EspClass::getMaxAllocHeap() { return 110000; }
+
+size_t fakeHeapUsed() { return heapUsed; }
+size_t fakeHeapPeak() { return heapPeak; }
+void fakeResetHeapPeak() { heapPeak = heapUsed; }
+
+void fakeHeapAlloc(size_t bytes) {
+    heapUsed += bytes + kFakeMallocOverhead;
+    heapPeak = std::max(heapPeak, heapUsed);
+    heapLowWater = std::max(heapLowWater, heapUsed);
+    fakeStats.heapAllocs++;
+}
+
+void fakeHeapFree(size_t bytes) {
+    heapUsed -= std::min(heapUsed, bytes + kFakeMallocOverhead);
+}
+
+void fakeHeapTransient(size_t bytes) {
+    heapPeak = std::max(heapPeak, heapUsed + bytes + kFakeMallocOverhead);
+    heapLowWater = std::max(heapLowWater, heapUsed + bytes + kFakeMallocOverhead);
+    fakeStats.heapAllocs++;
+}
+
+// Repeatable across runs, unlike the hardware RNG.
+uint32_t esp_random() {
+    randomState = randomState * 1664525u + 1013904223u;
+    return randomState;
+}
+
+// ----------------------- WiFi -----------------------
+wl_status_t WiFiClass::status() {
+    return wifiConnected && wifiJoinedUs != kNeverUs && nowUs >= wifiJoinedUs ? WL_CONNECTED : WL_DISCONNECTED;
+}
+wifi_mode_t WiFiClass::getMode() { return WIFI_STA; }
+String WiFiClass::macAddress() { return "24:6F:28:AA:BB:CC"; }
+// Joining goes on in the background, as with the Arduino core.
+wl_status_t WiFiClass::begin(const char* ssid, const char* pass) {
+    (void)ssid; (void)pass;
+    if (status() != WL_CONNECTED) wifiJoinedUs = nowUs + kFakeWifiJoinMs * 1000ULL;
+    return status();
+}
+bool WiFiClass::disconnect(bool wifioff) { (void)wifioff; wifiJoinedUs = kNeverUs; return true; }
+bool WiFiClass::softAP(const char* ssid, const char* pass) { (void)ssid; (void)pass; return true; }
+bool WiFiClass::setSleep(bool enabled) { modemSleep = enabled; return true; }
+bool WiFiClass::getSleep() { return modemSleep; }
+
+// ----------------------- NVS -----------------------
+// Length-prefixed namespace, key, type and value of every entry.
+std::string fakeNvsImage() {
+    std::string image;
+    auto add = [&image](const std::string& field) {
+        uint32_t n = field.size();
+        image.append((const char*)&n, sizeof(n));
+        image += field;
+    };
+    for (const auto& space : nvs) {
+        for (const auto& entry : space.second) {
+            add(space.first);
+            add(entry.first);
+            add(std::string(1, entry.second.type));
+            add(entry.second.data);
+        }
+    }
+    return image;
+}
+
+void fakeLoadNvsImage(const std::string& image) {
+    nvs.clear();
+    size_t at = 0;
+    auto next = [&image, &at]() {
+        uint32_t n;
+        memcpy(&n, image.data() + at, sizeof(n));
+        at += sizeof(n);
+        std::string field = image.substr(at, n);
+        at += n;
+        return field;
+    };
+    while (at < image.size()) {
+        std::string space = next();
+        std::string key = next();
+        std::string type = next();
+        nvs[space][key] = NvsEntry{type[0], next()};
+    }
+}
+
+bool Preferences::begin(const char* name, bool readOnly) {
+    fakeStats.nvsOpens++;
+    ns_ = name;
+    readOnly_ = readOnly;
+    open_ = true;
+    return true;
+}
+
+void Preferences::end() { open_ = false; }
+
+bool Preferences::clear() {
+    if (!open_ || readOnly_) return false;
+    fakeStats.nvsWrites++;
+    nowUs += kFakeNvsWriteUs;
+    nvs[ns_].clear();
+    return true;
+}
+
+bool Preferences::remove(const char* key) {
+    if (!open_ || readOnly_) return false;
+    fakeStats.nvsWrites++;
+    nowUs += kFakeNvsWriteUs;
+    return nvs[ns_].erase(key) > 0;
+}
+
+size_t Preferences::put(const char* key, char type, const void* data, size_t len) {
+    if (!open_ || readOnly_) return 0;
+    fakeStats.nvsWrites++;
+    nowUs += kFakeNvsWriteUs;
+    nvs[ns_][key] = NvsEntry{type, std::string((const char*)data, len)};
+    return len;
+}
+
+const std::string* Preferences::find(const char* key, char type) {
+    if (!open_) return nullptr;
+    fakeStats.nvsReads++;
+    nowUs += kFakeNvsReadUs;
+    auto space = nvs.find(ns_);
+    if (space == nvs.end()) return nullptr;
+    auto it = space->second.find(key);
+    if (it == space->second.end() || it->second.type != type) return nullptr;
+    return &it->second.data;
+}
+
+bool Preferences::isKey(const char* key) {
+    if (!open_) return false;
+    auto space = nvs.find(ns_);
+    return space != nvs.end() && space->second.count(key) > 0;
+}
+
+size_t Preferences::putBool(const char* key, bool value) { uint8_t v = value; return put(key, 'b', &v, 1); }
+size_t Preferences::putInt(const char* key, int32_t value) { return put(key, 'i', &value, sizeof(value)); }
+size_t Preferences::putUInt(const char* key, uint32_t value) { return put(key, 'u', &value, sizeof(value)); }
+size_t Preferences::putFloat(const char* key, float value) { return put(key, 'y', &value, sizeof(value)); }
+size_t Preferences::putString(const char* key, const String& value) { return put(key, 's', value.c_str(), value.length()); }
+size_t Preferences::putBytes(const char* key, const void* value, size_t len) { return put(key, 'y', value, len); }
+
+bool Preferences::getBool(const char* key, bool defaultValue) {
+    const std::string* v = find(key, 'b');
+    return v && v->size() == 1 ? (*v)[0] != 0 : defaultValue;
+}
+
+int32_t Preferences::getInt(const char* key, int32_t defaultValue) {
+    const std::string* v = find(key, 'i');
+    int32_t out = defaultValue;
+    if (v && v->size() == sizeof(out)) memcpy(&out, v->data(), sizeof(out));
+    return out;
+}
+
+uint32_t Preferences::getUInt(const char* key, uint32_t defaultValue) {
+    const std::string* v = find(key, 'u');
+    uint32_t out = defaultValue;
+    if (v && v->size() == sizeof(out)) memcpy(&out, v->data(), sizeof(out));
+    return out;
+}
+
+float Preferences::getFloat(const char* key, float defaultValue) {
+    const std::string* v = find(key, 'y');
+    float out = defaultValue;
+    if (v && v->size() == sizeof(out)) memcpy(&out, v->data(), sizeof(out));
+    return out;
+}
+
+String Preferences::getString(const char* key, const String& defaultValue) {
+    const std::string* v = find(key, 's');
+    return v ? String(*v) : defaultValue;
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+    const std::string* v = find(key, 'y');
+    return v ? v->size() : 0;
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t maxLen) {
+    const std::string* v = find(key, 'y');
+    if (!v || v->size() > maxLen) return 0;
+    memcpy(buf, v->data(), v->size());
+    return v->size();
+}
+
+// ----------------------- Peripherals -----------------------
+void DHT::transfer(bool force) {
+    unsigned long now = millis();
+    if (!force && everRead_ && now - lastReadMs_ < 2000) return;
+    everRead_ = true;
+    lastReadMs_ = now;
+    fakeStats.dhtTransfers++;
+    nowUs += kFakeDhtTransferUs;
+}
+
+float DHT::readTemperature(bool S, bool force) {
+    (void)S;
+    transfer(force);
+    return roomTemp;
+}
+
+float DHT::readHumidity(bool force) {
+    transfer(force);
+    return roomHum;
+}
+
+static void i2cTransfer(size_t bytes) {
+    fakeStats.i2cTransfers++;
+    nowUs += bytes * kFakeI2cByteUs;
+}
+
+static void setAirInt() {
+    fakeSetPin(CCS811_INT_PIN, fakeAirSensor.interrupt && airReady ? LOW : HIGH);
+}
+
+// One event is outstanding at a time; a drive mode set since it was armed
+// only moves airNextUs, and the event follows it.
+static void airMeasure() {
+    airEventArmed = false;
+    if (airNextUs == kNeverUs) return;
+    if (nowUs >= airNextUs) {
+        fakeAirSensor.results++;
+        airReady = true;
+        setAirInt();
+        airNextUs += kAirPeriodMs[fakeAirSensor.driveMode] * 1000ULL;
+    }
+    airEventArmed = true;
+    fakeAtMicros(airNextUs, airMeasure);
+}
+
+bool Adafruit_CCS811::begin(uint8_t addr) {
+    (void)addr;
+    i2cTransfer(3);
+    if (!fakeAirSensor.present) return false;
+    delay(200); // the driver's waits after the reset and APP_START
+    disableInterrupt();
+    setDriveMode(CCS811_DRIVE_MODE_1SEC);
+    return true;
+}
+
+void Adafruit_CCS811::setDriveMode(uint8_t mode) {
+    i2cTransfer(7);
+    fakeAirSensor.driveMode = mode <= CCS811_DRIVE_MODE_250MS ? mode : CCS811_DRIVE_MODE_IDLE;
+    if (fakeAirSensor.driveMode == CCS811_DRIVE_MODE_IDLE) {
+        airNextUs = kNeverUs;
+        return;
+    }
+    airNextUs = nowUs + kAirPeriodMs[fakeAirSensor.driveMode] * 1000ULL;
+    if (!airEventArmed) {
+        airEventArmed = true;
+        fakeAtMicros(airNextUs, airMeasure);
+    }
+}
+
+void Adafruit_CCS811::enableInterrupt() {
+    i2cTransfer(7);
+    fakeAirSensor.interrupt = true;
+    setAirInt();
+}
+
+void Adafruit_CCS811::disableInterrupt() {
+    i2cTransfer(7);
+    fakeAirSensor.interrupt = false;
+    setAirInt();
+}
+
+bool Adafruit_CCS811::available() {
+    i2cTransfer(4);
+    return airReady;
+}
+
+uint8_t Adafruit_CCS811::readData() {
+    if (!available()) return false;
+    i2cTransfer(11);
+    if (fakeAirSensor.failReads) {
+        fakeAirSensor.failReads--;
+        return 1;
+    }
+    eco2_ = airEco2;
+    tvoc_ = airTvoc;
+    airReady = false;
+    fakeAirSensor.reads++;
+    setAirInt();
+    return 0;
+}
+
+bool Adafruit_CCS811::checkError() {
+    i2cTransfer(4);
+    return false;
+}
+
+uint16_t Adafruit_CCS811::getBaseline() {
+    i2cTransfer(5);
+    return fakeAirSensor.baseline;
+}
+
+void Adafruit_CCS811::setBaseline(uint16_t baseline) {
+    i2cTransfer(4);
+    fakeAirSensor.baseline = fakeAirSensor.restoredBaseline = baseline;
+}
+
+void Adafruit_CCS811::setEnvironmentalData(float humidity, float temperature) {
+    i2cTransfer(6);
+    fakeAirSensor.humidity = humidity;
+    fakeAirSensor.temperature = temperature;
+    fakeAirSensor.envWrites++;
+}
+
+void Adafruit_NeoPixel::show() {
+    fakeStats.ledShows++;
+    // 24 bits at 1.25 us per pixel plus the 300 us latch.
+    nowUs += pixels_.size() * 30 + 300;
+}
+
+void fakeIrEmit(const char* protocol, unsigned long airTimeUs) {
+    recordIrFrame(protocol, airTimeUs);
+    nowUs += airTimeUs;
+}
+
+void IRsend::sendRaw(const uint16_t buf[], uint16_t len, uint16_t hz) {
+    (void)hz;
+    unsigned long airTime = 0;
+    for (uint16_t i = 0; i < len; i++) airTime += buf[i];
+    fakeIrEmit("Raw", airTime);
+}
+
+bool IRrecv::decode(decode_results* results) {
+    (void)results;
+    return false;
+}
+
+esp_err_t rmt_config(const rmt_config_t* config) { (void)config; return ESP_OK; }
+
+esp_err_t rmt_driver_install(rmt_channel_t channel, size_t rx_buf_size, int intr_alloc_flags) {
+    (void)channel; (void)rx_buf_size; (void)intr_alloc_flags;
+    return ESP_OK;
+}
+
+esp_err_t rmt_set_gpio(rmt_channel_t channel, rmt_mode_t mode, gpio_num_t gpio_num, bool invert_signal) {
+    (void)channel; (void)mode; (void)gpio_num; (void)invert_signal;
+    return ESP_OK;
+}
+
+esp_err_t rmt_set_tx_carrier(rmt_channel_t channel, bool carrier_en, uint16_t high_level, uint16_t low_level,
+                             rmt_carrier_level_t carrier_level) {
+    (void)channel; (void)carrier_en; (void)high_level; (void)low_level; (void)carrier_level;
+    return ESP_OK;
+}
+
+esp_err_t rmt_write_items(rmt_channel_t channel, const rmt_item32_t* items, int item_num, bool wait_tx_done) {
+    if (nowUs < rmtBusyUntilUs[channel]) return ESP_FAIL;
+    unsigned long airTime = 0;
+    for (int i = 0; i < item_num; i++) {
+        airTime += items[i].duration0;
+        if (items[i].duration0 == 0) break;
+        airTime += items[i].duration1;
+        if (items[i].duration1 == 0) break;
+    }
+    recordIrFrame("RMT", airTime);
+    rmtBusyUntilUs[channel] = nowUs + airTime;
+    if (wait_tx_done) nowUs = rmtBusyUntilUs[channel];
+    return ESP_OK;
+}
+
+esp_err_t rmt_wait_tx_done(rmt_channel_t channel, TickType_t wait_time) {
+    if (nowUs >= rmtBusyUntilUs[channel]) return ESP_OK;
+    if (wait_time == 0) return ESP_ERR_TIMEOUT;
+    unsigned long long limit = wait_time == portMAX_DELAY ? rmtBusyUntilUs[channel]
+                                                          : nowUs + (unsigned long long)wait_time * 1000ULL;
+    fakeTaskSleepUntil(std::min(limit, rmtBusyUntilUs[channel]));
+    return nowUs >= rmtBusyUntilUs[channel] ? ESP_OK : ESP_ERR_TIMEOUT;
+}
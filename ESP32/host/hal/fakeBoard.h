@@ -0,0 +1,257 @@
+#ifndef HOST_FAKE_BOARD_H
+#define HOST_FAKE_BOARD_H
+
+// Control surface for the host fakes: benches and tests drive the virtual
+// clock, pin levels, room readings and the cloud from here.
+
+#include <Arduino.h>
+#include <Firebase_ESP_Client.h>
+#include <string>
+
+struct FakeStats {
+    unsigned long rtdbRequests;
+    unsigned long rtdbBytesUp;
+    unsigned long rtdbBytesDown;
+    unsigned long irFrames;
+    unsigned long long irAirTimeUs;
+    unsigned long nvsOpens;
+    unsigned long nvsReads;
+    unsigned long nvsWrites;
+    unsigned long ledShows;
+    unsigned long dhtTransfers;
+    unsigned long i2cTransfers;
+    unsigned long fsWrites;        // LittleFS commits: closed files, removes, renames
+    unsigned long fsBytesWritten;
+    unsigned long long delayedUs;
+    unsigned long heapAllocs;      // charged by the heap model below
+    unsigned long jsonGets;        // FirebaseJson::get() calls, each building a path String
+    unsigned long serialBytes;
+    unsigned long long serialBlockedUs; // writers waiting for room in the UART FIFO
+};
+extern FakeStats fakeStats;
+
+// Charge drawn since the last reset, in mA*s, from the power model below.
+struct FakePower {
+    double cpuMaS;
+    double radioMaS;
+    unsigned long long sleptUs;  // in light sleep
+    unsigned long lightSleeps;
+    unsigned long wakes;         // task runs
+};
+extern FakePower fakePower;
+
+struct FakeIrFrame {
+    String protocol;
+    unsigned long long atUs;
+    unsigned long airTimeUs;
+};
+
+// A change of the tone on an LEDC channel; 0 Hz is silence.
+struct FakeTone {
+    uint8_t channel;
+    unsigned long long atUs;
+    unsigned int freqHz;
+};
+
+// What the cooperative scheduler saw of one task: wake lateness and how long
+// each run kept the clock to itself (NVS commits, DHT transfers, bit-banged
+// IR), in virtual ms, plus the host stack it touched.
+struct FakeTaskInfo {
+    String name;
+    int core;
+    unsigned int priority;
+    uint32_t stackDepth;
+    size_t hostStackUsed;
+    unsigned long runs;
+    std::vector<double> latenessMs;
+    std::vector<double> heldMs;
+};
+
+// Thrown by ESP.restart() so a harness can observe it.
+struct FakeRestart {};
+
+// Simulated HTTPS round trip charged per RTDB request.
+const unsigned long kFakeRtdbLatencyMs = 180;
+// Station bring-up after WiFi.begin(): scan, association, the WPA2
+// handshake and DHCP on a typical home router.
+const unsigned long kFakeWifiJoinMs = 1800;
+// First SNTP answer once the station has an address.
+const unsigned long kFakeSntpMs = 400;
+// Firebase email/password sign-in: two HTTPS requests on fresh TLS sessions.
+const unsigned long kFakeAuthMs = 1200;
+// Bytes every RTDB request carries besides its path and body: the request
+// line with the ?auth= ID token plus headers up, status line and headers down.
+const unsigned long kFakeRtdbRequestOverhead = 1100;
+const unsigned long kFakeRtdbResponseOverhead = 180;
+// nvs_get_* including the hashed entry lookup and the flash read.
+const unsigned long kFakeNvsReadUs = 250;
+// nvs_set + nvs_commit on a page with free entries.
+const unsigned long kFakeNvsWriteUs = 2500;
+// DHT11 start pulse (18 ms) plus the 40-bit transfer.
+const unsigned long kFakeDhtTransferUs = 23000;
+// One byte on I2C at 100 kHz, with its acknowledge.
+const unsigned long kFakeI2cByteUs = 90;
+// UART0 at 115200 8N1 with the core's default of no TX ring buffer: a write
+// goes into the 128-byte FIFO and blocks the writer (it yields) until the
+// rest fits.
+const unsigned long kFakeSerialBaud = 115200;
+const size_t kFakeSerialFifo = 128;
+
+// LittleFS on the default 1.5 MB data partition: 4 KB blocks, files up to
+// the cache size inlined in their directory, and a commit (data plus
+// metadata program) per closed file.
+const size_t kFakeFsBytes = 0x160000;
+const size_t kFakeFsBlock = 4096;
+const size_t kFakeFsInlineMax = 512;
+const unsigned long kFakeFsCommitUs = 4000;
+
+// Power model, ESP32-WROOM-32 datasheet currents rounded. The CPU draws
+// kFakeCpuActiveMa for kFakeRunUs per task run plus any time a run keeps
+// the clock, and the idle current in between: light sleep when power
+// management allows it and every task is blocked for at least
+// kFakeLightSleepMinUs, otherwise WAITI at full (or, with power management,
+// reduced) clock. The radio listens continuously without modem sleep;
+// with it, only for the DTIM beacons, and anything the AP holds for the
+// station (the command stream) arrives at the next beacon.
+const double kFakeCpuActiveMa = 50;
+const double kFakeCpuIdleMa = 30;
+const double kFakeCpuIdleDfsMa = 20;
+const double kFakeLightSleepMa = 0.8;
+const double kFakeRadioMa = 100;
+const double kFakeBeaconMa = 2;
+const unsigned long kFakeRunUs = 200;
+const unsigned long kFakeLightSleepMinUs = 2000;
+const unsigned long kFakeLightSleepWakeUs = 500;
+const unsigned long kFakeDtimUs = 102400;
+
+// Heap model for RTDB responses, after the library's: the body is read into
+// a String in the FirebaseData, payload() copies it, and to<FirebaseJson>()
+// parses it into a tree with a node per object and value, each with its key
+// and string value allocated beside it. Everything is released by clear().
+const size_t kFakeMallocOverhead = 8;
+const size_t kFakeJsonNodeBytes = 36;
+size_t fakeHeapUsed();
+size_t fakeHeapPeak();
+void fakeResetHeapPeak();
+// Used by the stand-ins; a transient block only counts towards the peak.
+void fakeHeapAlloc(size_t bytes);
+void fakeHeapFree(size_t bytes);
+void fakeHeapTransient(size_t bytes);
+
+void fakeReset();
+unsigned long long fakeMicros();
+void fakeAdvanceMicros(unsigned long long us);
+void fakeAdvanceMillis(unsigned long ms);
+
+void fakeSetWallClock(time_t epochUtc);
+void fakeSetPin(uint8_t pin, int level);
+int fakeGetPin(uint8_t pin);
+void fakeSetRoom(float tempC, float humidity);
+// Whether the access point is reachable at all. Regardless, the station is
+// only up once it has joined: fakeReset() leaves it joined, as the module
+// tests expect; fakeColdBoot() leaves it as after a reset of the chip, not
+// joined until kFakeWifiJoinMs after WiFi.begin(), and with no SNTP time.
+void fakeSetWifiConnected(bool connected);
+void fakeColdBoot();
+void fakeSetSerialEcho(bool echo);
+// Everything written to Serial since the last call (or fakeReset()).
+std::string fakeTakeSerialOutput();
+// The CCS811 (Adafruit_CCS811.h), absent after fakeReset() as on boards
+// without one. Once started it measures the air set by fakeSetAir() every
+// drive-mode period and, with its interrupt enabled, holds nINT
+// (CCS811_INT_PIN) low until the result is read.
+struct FakeAirSensor {
+    bool present;
+    uint8_t driveMode;
+    bool interrupt;
+    uint16_t baseline;         // what getBaseline() returns
+    uint16_t restoredBaseline; // the last setBaseline(), 0 if none
+    float humidity;            // the last environmental data, NAN if none
+    float temperature;
+    unsigned long results;     // measurements made
+    unsigned long reads;       // results read
+    unsigned long envWrites;
+    unsigned long failReads;   // the next reads that fail, leaving nINT low
+};
+extern FakeAirSensor fakeAirSensor;
+void fakeSetAirSensorPresent(bool present);
+void fakeSetAir(uint16_t eco2, uint16_t tvoc);
+// Peers on the UARTs (driver/uart.h). Bytes go on the wire after whatever
+// is still arriving, at the port's baud rate.
+void fakeUartReceive(int port, const uint8_t* data, size_t len);
+// Everything the firmware wrote to the port since the last call.
+std::string fakeUartTakeSent(int port);
+// NVS as bytes, to carry it into a fresh process the way flash survives a restart.
+std::string fakeNvsImage();
+void fakeLoadNvsImage(const std::string& image);
+
+void fakeSetRtdbLatencyMs(unsigned long ms);
+void fakeSetStreamConnected(bool connected);
+// Requests fail as if the database were unavailable; the open stream stays up.
+void fakeSetRtdbFailing(bool failing);
+void fakeRtdbSeed(const String& path, const FirebaseJson& json);
+bool fakeRtdbGet(const String& path, FirebaseJsonData& out);
+// Names of the children of a node, sorted.
+std::vector<String> fakeRtdbKeys(const String& path);
+void fakePushCommand(const FirebaseJson& command);
+// Queues a command the stream delivers once the clock reaches atUs.
+void fakePushCommandAt(const FirebaseJson& command, unsigned long long atUs);
+size_t fakePendingCommands();
+
+// FreeRTOS tasks run only inside these calls, in wake-time order, until the
+// clock reaches the given time. A restart inside a task is rethrown here.
+void fakeRunTasksUntil(unsigned long long us);
+void fakeRunTasksFor(unsigned long ms);
+// Runs loop() forever in a "loopTask", as the Arduino core does after setup().
+void fakeStartLoopTask(void (*loopFn)());
+std::vector<FakeTaskInfo> fakeTasks();
+bool fakeInTask();
+// Blocking waits: inside a task they yield to the others, outside they advance the clock.
+void fakeBlockMicros(unsigned long long us);
+void fakeTaskSleepUntil(unsigned long long us);
+void fakeTaskWakeBy(TaskHandle_t task, unsigned long long us);
+// Runs `fn` once the clock reaches `us`, between task runs and outside any
+// task, as a peripheral raising an interrupt would.
+void fakeAtMicros(unsigned long long us, void (*fn)());
+
+// Used by the scheduler and the Firebase fake to charge the power model.
+// fakePowerIdle() returns the wake-up time if the gap was spent asleep.
+unsigned long long fakePowerIdle(unsigned long long fromUs, unsigned long long toUs);
+void fakePowerRun(unsigned long long heldUs);
+void fakeRadioBusy(unsigned long long us);
+unsigned long long fakeRadioDeliverAt(unsigned long long atUs);
+
+// Phones on the same Wi-Fi, for the LAN API (lanApi.h). A message takes
+// kFakeLanHopUs each way and, with modem sleep, waits at the AP for the
+// next DTIM beacon before it reaches the device.
+const unsigned long kFakeLanHopUs = 3000;
+
+struct FakeLanReply {
+    int status; // 0 if nothing was listening
+    String body;
+    unsigned long long atUs; // back at the client
+};
+
+struct FakeWsMessage {
+    String text;
+    unsigned long long atUs;
+};
+
+// An HTTP request sent at atUs, with "Authorization: Bearer <token>" unless
+// the token is empty. Returns an id; the reply shows up once handled.
+int fakeLanRequestAt(const char* method, const char* url, const String& token, const String& body,
+                     unsigned long long atUs);
+const FakeLanReply* fakeLanReply(int request);
+// WebSocket clients on the server's socket; ids are unique per reset.
+int fakeWsOpen();
+void fakeWsSendAt(int client, const String& text, unsigned long long atUs);
+void fakeWsClose(int client);
+bool fakeWsConnected(int client);
+const std::vector<FakeWsMessage>& fakeWsReceived(int client);
+String fakeMdnsHostname();
+std::vector<String> fakeMdnsServices(); // "_service._proto:port"
+
+const std::vector<FakeIrFrame>& fakeIrFrames();
+const std::vector<FakeTone>& fakeTones();
+
+#endif
@@ -0,0 +1,555 @@
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <Firebase_ESP_Client.h>
+#include <WiFi.h>
+#include "fakeBoard.h"
+
+Firebase_ESP_Client Firebase;
+
+namespace {
+
+FirebaseJson::Entries rtdb;
+struct PendingCommand {
+    unsigned long long atUs;
+    FirebaseJson json;
+};
+std::deque<PendingCommand> pendingCommands;
+FirebaseData* streamFbdo = nullptr;
+TaskHandle_t streamTask = nullptr;
+unsigned long rtdbLatencyMs = kFakeRtdbLatencyMs;
+bool streamConnected = true;
+bool rtdbFailing = false;
+FirebaseAuth* signingIn = nullptr; // begun while the station was down
+
+std::string normalize(const String& path) {
+    std::string p = path.str();
+    while (!p.empty() && p.front() == '/') p.erase(0, 1);
+    while (!p.empty() && p.back() == '/') p.pop_back();
+    return p;
+}
+
+void eraseSubtree(const std::string& path) {
+    std::string prefix = path + "/";
+    rtdb.erase(path);
+    auto it = rtdb.lower_bound(prefix);
+    while (it != rtdb.end() && it->first.compare(0, prefix.size(), prefix) == 0) it = rtdb.erase(it);
+}
+
+void store(const std::string& path, const FakeJsonValue& value) {
+    eraseSubtree(path);
+    rtdb[path] = value;
+}
+
+// One HTTPS request: path plus JSON body up, status line/body down.
+bool request(FirebaseData* fbdo, const std::string& path, size_t bodyBytes) {
+    fakeStats.rtdbRequests++;
+    fakeStats.rtdbBytesUp += kFakeRtdbRequestOverhead + path.size() + bodyBytes;
+    fakeStats.rtdbBytesDown += kFakeRtdbResponseOverhead;
+    fakeRadioBusy(rtdbLatencyMs * 1000ULL);
+    fakeBlockMicros(rtdbLatencyMs * 1000ULL);
+    if (WiFi.status() != WL_CONNECTED) {
+        fbdo->error_ = "connection lost";
+        return false;
+    }
+    if (rtdbFailing) {
+        fbdo->error_ = "service unavailable";
+        return false;
+    }
+    return true;
+}
+
+}
+
+void fakeResetFirebase() {
+    rtdb.clear();
+    pendingCommands.clear();
+    streamFbdo = nullptr;
+    streamTask = nullptr;
+    rtdbLatencyMs = kFakeRtdbLatencyMs;
+    streamConnected = true;
+    rtdbFailing = false;
+    signingIn = nullptr;
+}
+
+void fakeSetRtdbLatencyMs(unsigned long ms) { rtdbLatencyMs = ms; }
+void fakeSetStreamConnected(bool connected) { streamConnected = connected; }
+void fakeSetRtdbFailing(bool failing) { rtdbFailing = failing; }
+
+void fakeRtdbSeed(const String& path, const FirebaseJson& json) {
+    std::string base = normalize(path);
+    for (const auto& e : json.entries()) store(base.empty() ? e.first : base + "/" + e.first, e.second);
+}
+
+bool fakeRtdbGet(const String& path, FirebaseJsonData& out) {
+    out.clear();
+    auto it = rtdb.find(normalize(path));
+    if (it == rtdb.end()) return false;
+    out.assign(it->second);
+    return true;
+}
+
+std::vector<String> fakeRtdbKeys(const String& path) {
+    std::string prefix = normalize(path) + "/";
+    std::vector<String> keys;
+    for (auto it = rtdb.lower_bound(prefix); it != rtdb.end() && it->first.compare(0, prefix.size(), prefix) == 0;
+         ++it) {
+        std::string key = it->first.substr(prefix.size(), it->first.find('/', prefix.size()) - prefix.size());
+        if (keys.empty() || keys.back().str() != key) keys.push_back(String(key));
+    }
+    return keys;
+}
+
+void fakePushCommand(const FirebaseJson& command) { fakePushCommandAt(command, fakeMicros()); }
+void fakePushCommandAt(const FirebaseJson& command, unsigned long long atUs) {
+    pendingCommands.push_back({atUs, command});
+    fakeTaskWakeBy(streamTask, fakeRadioDeliverAt(atUs));
+}
+size_t fakePendingCommands() { return pendingCommands.size(); }
+
+// ----------------------- JSON -----------------------
+std::string FakeJsonValue::encode() const {
+    char buf[48];
+    switch (type) {
+        case Bool: return b ? "true" : "false";
+        case Int: snprintf(buf, sizeof(buf), "%lld", i); return buf;
+        case Float: snprintf(buf, sizeof(buf), "%g", f); return buf;
+        case Str: return "\"" + s + "\"";
+        default: return "null";
+    }
+}
+
+void FirebaseJsonData::assign(const FakeJsonValue& v) {
+    clear();
+    success = true;
+    switch (v.type) {
+        case FakeJsonValue::Bool:
+            type = "boolean"; boolValue = v.b; intValue = v.b; floatValue = v.b; doubleValue = v.b;
+            stringValue = v.b ? "true" : "false";
+            break;
+        case FakeJsonValue::Int:
+            type = "int"; intValue = (int)v.i; floatValue = (float)v.i; doubleValue = (double)v.i;
+            boolValue = v.i != 0; stringValue = String(v.encode());
+            break;
+        case FakeJsonValue::Float:
+            type = "double"; intValue = (int)v.f; floatValue = (float)v.f; doubleValue = v.f;
+            boolValue = v.f != 0; stringValue = String(v.encode());
+            break;
+        case FakeJsonValue::Str:
+            type = "string"; stringValue = String(v.s); intValue = atoi(v.s.c_str());
+            floatValue = strtof(v.s.c_str(), nullptr); doubleValue = floatValue; boolValue = v.s == "true";
+            break;
+        default:
+            type = "null"; success = false;
+            break;
+    }
+}
+
+FirebaseJson& FirebaseJson::setValue(const String& path, const FakeJsonValue& value) {
+    std::string p = normalize(path);
+    std::string prefix = p + "/";
+    auto it = entries_.lower_bound(prefix);
+    while (it != entries_.end() && it->first.compare(0, prefix.size(), prefix) == 0) it = entries_.erase(it);
+    entries_[p] = value;
+    return *this;
+}
+
+FirebaseJson& FirebaseJson::set(const String& path, const String& value) {
+    FakeJsonValue v;
+    v.type = FakeJsonValue::Str;
+    v.s = value.str();
+    return setValue(path, v);
+}
+
+FirebaseJson& FirebaseJson::set(const String& path, bool value) {
+    FakeJsonValue v;
+    v.type = FakeJsonValue::Bool;
+    v.b = value;
+    return setValue(path, v);
+}
+
+FirebaseJson& FirebaseJson::setInt(const String& path, long long value) {
+    FakeJsonValue v;
+    v.type = FakeJsonValue::Int;
+    v.i = value;
+    return setValue(path, v);
+}
+
+FirebaseJson& FirebaseJson::setFloat(const String& path, double value) {
+    FakeJsonValue v;
+    v.type = FakeJsonValue::Float;
+    v.f = value;
+    return setValue(path, v);
+}
+
+bool FirebaseJson::get(FirebaseJsonData& result, const String& path) const {
+    fakeStats.jsonGets++;
+    result.clear();
+    auto it = entries_.find(normalize(path));
+    if (it == entries_.end()) return false;
+    result.assign(it->second);
+    return true;
+}
+
+bool FirebaseJson::remove(const String& path) {
+    return entries_.erase(normalize(path)) > 0;
+}
+
+void FirebaseJson::toString(String& out, bool prettify) const {
+    (void)prettify;
+    std::string s = "{";
+    for (const auto& e : entries_) {
+        if (s.size() > 1) s += ",";
+        s += "\"" + e.first + "\":" + e.second.encode();
+    }
+    s += "}";
+    out = String(s);
+}
+
+namespace {
+
+struct JsonParser {
+    const char* p;
+    FirebaseJson::Entries& out;
+
+    void skipSpace() { while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') p++; }
+
+    bool string(std::string& s) {
+        if (*p++ != '"') return false;
+        for (; *p && *p != '"'; p++) {
+            if (*p == '\\') {
+                p++;
+                switch (*p) {
+                    case 'n': s += '\n'; break;
+                    case 't': s += '\t'; break;
+                    case 0: return false;
+                    default: s += *p; break;
+                }
+            } else {
+                s += *p;
+            }
+        }
+        return *p++ == '"';
+    }
+
+    bool value(const std::string& path) {
+        skipSpace();
+        FakeJsonValue v;
+        if (*p == '{' || *p == '[') {
+            char close = *p == '{' ? '}' : ']';
+            bool array = *p++ == '[';
+            skipSpace();
+            if (*p == close) {
+                p++;
+                return true;
+            }
+            for (int i = 0;; i++) {
+                std::string key;
+                if (array) {
+                    key = "[" + std::to_string(i) + "]";
+                } else {
+                    skipSpace();
+                    if (!string(key)) return false;
+                    skipSpace();
+                    if (*p++ != ':') return false;
+                }
+                if (!value(path.empty() ? key : path + "/" + key)) return false;
+                skipSpace();
+                if (*p == ',') { p++; continue; }
+                return *p++ == close;
+            }
+        } else if (*p == '"') {
+            v.type = FakeJsonValue::Str;
+            if (!string(v.s)) return false;
+        } else if (strncmp(p, "true", 4) == 0 || strncmp(p, "false", 5) == 0) {
+            v.type = FakeJsonValue::Bool;
+            v.b = *p == 't';
+            p += v.b ? 4 : 5;
+        } else if (strncmp(p, "null", 4) == 0) {
+            p += 4;
+            return true;
+        } else {
+            char* end;
+            double d = strtod(p, &end);
+            if (end == p) return false;
+            bool integral = std::string(p, (const char*)end).find_first_of(".eE") == std::string::npos;
+            p = end;
+            if (integral) {
+                v.type = FakeJsonValue::Int;
+                v.i = (long long)d;
+            } else {
+                v.type = FakeJsonValue::Float;
+                v.f = d;
+            }
+        }
+        out[path] = v;
+        return true;
+    }
+};
+
+}
+
+bool FirebaseJson::setJsonData(const String& data) {
+    entries_.clear();
+    JsonParser parser = {data.c_str(), entries_};
+    parser.skipSpace();
+    if (*parser.p != '{' || !parser.value("")) {
+        entries_.clear();
+        return false;
+    }
+    parser.skipSpace();
+    if (*parser.p) {
+        entries_.clear();
+        return false;
+    }
+    return true;
+}
+
+// ----------------------- Response bodies -----------------------
+namespace {
+
+struct JsonTree {
+    const FakeJsonValue* value = nullptr;
+    std::map<std::string, JsonTree> children;
+};
+
+bool isIndex(const std::string& key) { return key.size() > 2 && key.front() == '[' && key.back() == ']'; }
+
+void encodeNested(const JsonTree& node, std::string& out) {
+    if (node.value) {
+        out += node.value->encode();
+        return;
+    }
+    bool array = !node.children.empty() && isIndex(node.children.begin()->first);
+    std::vector<std::pair<long, const std::pair<const std::string, JsonTree>*>> order;
+    for (const auto& child : node.children) {
+        order.push_back({array ? atol(child.first.c_str() + 1) : 0, &child});
+    }
+    if (array) std::stable_sort(order.begin(), order.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    out += array ? "[" : "{";
+    for (size_t i = 0; i < order.size(); i++) {
+        if (i > 0) out += ",";
+        if (!array) out += "\"" + order[i].second->first + "\":";
+        encodeNested(order[i].second->second, out);
+    }
+    out += array ? "]" : "}";
+}
+
+JsonTree treeOf(const FirebaseJson::Entries& entries) {
+    JsonTree root;
+    for (const auto& e : entries) {
+        JsonTree* node = &root;
+        size_t start = 0;
+        while (true) {
+            size_t slash = e.first.find('/', start);
+            node = &node->children[e.first.substr(start, slash - start)];
+            if (slash == std::string::npos) break;
+            start = slash + 1;
+        }
+        node->value = &e.second;
+    }
+    return root;
+}
+
+// What MB_JSON allocates for a parsed tree.
+size_t treeBytes(const JsonTree& node, const std::string& key) {
+    size_t bytes = kFakeJsonNodeBytes + kFakeMallocOverhead;
+    if (!key.empty()) bytes += key.size() + 1 + kFakeMallocOverhead;
+    if (node.value && node.value->type == FakeJsonValue::Str) bytes += node.value->s.size() + 1 + kFakeMallocOverhead;
+    for (const auto& child : node.children) bytes += treeBytes(child.second, child.first);
+    return bytes;
+}
+
+}
+
+String nestedJson(const FirebaseJson::Entries& entries) {
+    std::string out;
+    encodeNested(treeOf(entries), out);
+    return String(out);
+}
+
+void FirebaseData::clear() {
+    if (raw_.length()) fakeHeapFree(raw_.length() + 1);
+    if (treeBytes_) fakeHeapFree(treeBytes_);
+    payload_.clear();
+    raw_ = "";
+    treeBytes_ = 0;
+    error_ = "";
+}
+
+String FirebaseData::payload() const {
+    if (raw_.length()) fakeHeapTransient(raw_.length() + 1);
+    return raw_;
+}
+
+FirebaseJson& FirebaseData::parsed() {
+    if (!treeBytes_ && !payload_.entries().empty()) {
+        // Charged as one block: the nodes are freed together by clear().
+        treeBytes_ = treeBytes(treeOf(payload_.entries()), "") - kFakeMallocOverhead;
+        fakeHeapAlloc(treeBytes_);
+        fakeStats.heapAllocs += payload_.entries().size() * 2;
+    }
+    return payload_;
+}
+
+static size_t encodedSize(const FirebaseJson& json) {
+    String s;
+    json.toString(s);
+    return s.length();
+}
+
+// ----------------------- RTDB -----------------------
+// Signs in before returning when the station is up; otherwise the first
+// ready() call with the station up does, as the library does.
+static void signIn(FirebaseAuth* auth) {
+    fakeStats.rtdbRequests++;
+    fakeRadioBusy(kFakeAuthMs * 1000ULL);
+    fakeBlockMicros(kFakeAuthMs * 1000ULL);
+    auth->token.uid = "host-uid";
+}
+
+void Firebase_ESP_Client::begin(FirebaseConfig* config, FirebaseAuth* auth) {
+    (void)config;
+    signingIn = nullptr;
+    if (WiFi.status() == WL_CONNECTED) {
+        signIn(auth);
+    } else {
+        signingIn = auth;
+    }
+}
+
+bool Firebase_ESP_Client::ready() {
+    if (WiFi.status() != WL_CONNECTED) return false;
+    if (signingIn) {
+        FirebaseAuth* auth = signingIn;
+        signingIn = nullptr;
+        signIn(auth);
+    }
+    return true;
+}
+
+bool FB_RTDB::getJSON(FirebaseData* fbdo, const String& path) {
+    std::string base = normalize(path);
+    if (!request(fbdo, base, 0)) return false;
+    fbdo->clear();
+    std::string prefix = base + "/";
+    for (auto it = rtdb.lower_bound(prefix); it != rtdb.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+        fbdo->payload_.setValue(String(it->first.substr(prefix.size())), it->second);
+    }
+    if (fbdo->payload_.entries().empty()) {
+        fbdo->error_ = "path not exist";
+        return false;
+    }
+    fbdo->raw_ = nestedJson(fbdo->payload_.entries());
+    fakeHeapAlloc(fbdo->raw_.length() + 1);
+    fakeStats.rtdbBytesDown += fbdo->raw_.length();
+    return true;
+}
+
+static bool setScalar(FirebaseData* fbdo, const String& path, const FakeJsonValue& v) {
+    std::string p = normalize(path);
+    if (!request(fbdo, p, v.encode().size())) return false;
+    store(p, v);
+    return true;
+}
+
+bool FB_RTDB::setString(FirebaseData* fbdo, const String& path, const String& value) {
+    FakeJsonValue v;
+    v.type = FakeJsonValue::Str;
+    v.s = value.str();
+    return setScalar(fbdo, path, v);
+}
+
+bool FB_RTDB::setInt(FirebaseData* fbdo, const String& path, long long value) {
+    FakeJsonValue v;
+    v.type = FakeJsonValue::Int;
+    v.i = value;
+    return setScalar(fbdo, path, v);
+}
+
+bool FB_RTDB::setBool(FirebaseData* fbdo, const String& path, bool value) {
+    FakeJsonValue v;
+    v.type = FakeJsonValue::Bool;
+    v.b = value;
+    return setScalar(fbdo, path, v);
+}
+
+bool FB_RTDB::setFloat(FirebaseData* fbdo, const String& path, float value) {
+    FakeJsonValue v;
+    v.type = FakeJsonValue::Float;
+    v.f = value;
+    return setScalar(fbdo, path, v);
+}
+
+bool FB_RTDB::updateNode(FirebaseData* fbdo, const String& path, FirebaseJson* json) {
+    std::string base = normalize(path);
+    if (!request(fbdo, base, encodedSize(*json))) return false;
+    for (const auto& e : json->entries()) store(base.empty() ? e.first : base + "/" + e.first, e.second);
+    return true;
+}
+
+bool FB_RTDB::deleteNode(FirebaseData* fbdo, const String& path) {
+    std::string p = normalize(path);
+    if (!request(fbdo, p, 0)) return false;
+    eraseSubtree(p);
+    return true;
+}
+
+bool FB_RTDB::beginStream(FirebaseData* fbdo, const String& path) {
+    if (!request(fbdo, normalize(path), 0)) return false;
+    fbdo->streamPath_ = path;
+    fbdo->streaming_ = true;
+    streamFbdo = fbdo;
+    return true;
+}
+
+bool FB_RTDB::endStream(FirebaseData* fbdo) {
+    fbdo->streaming_ = false;
+    if (streamFbdo == fbdo) streamFbdo = nullptr;
+    return true;
+}
+
+// With a callback set, the library reads the stream from a task of its own
+// and calls back from there; this one sleeps until the next queued command.
+static void streamTaskLoop(void* param) {
+    FirebaseData* fbdo = (FirebaseData*)param;
+    for (;;) {
+        if (!Firebase.RTDB.readStream(fbdo)) {
+            if (fbdo->onTimeout_) fbdo->onTimeout_(true);
+            vTaskDelay(pdMS_TO_TICKS(1000));
+            continue;
+        }
+        unsigned long long next = fakeMicros() + 1000000ULL;
+        if (!pendingCommands.empty()) {
+            next = std::min(next, std::max(fakeRadioDeliverAt(pendingCommands.front().atUs), fakeMicros()));
+        }
+        if (next > fakeMicros()) fakeTaskSleepUntil(next);
+    }
+}
+
+void FB_RTDB::setStreamCallback(FirebaseData* fbdo, FirebaseStreamCallback onData,
+                                FirebaseStreamTimeoutCallback onTimeout) {
+    fbdo->onData_ = onData;
+    fbdo->onTimeout_ = onTimeout;
+    if (!streamTask) xTaskCreatePinnedToCore(streamTaskLoop, "FirebaseStream", 8192, fbdo, 1, &streamTask, 1);
+}
+
+bool FB_RTDB::readStream(FirebaseData* fbdo) {
+    if (!fbdo->streaming_ || !streamConnected || WiFi.status() != WL_CONNECTED) {
+        fbdo->error_ = "stream not connected";
+        return false;
+    }
+    if (pendingCommands.empty() || fakeRadioDeliverAt(pendingCommands.front().atUs) > fakeMicros() ||
+        fbdo != streamFbdo) {
+        return true;
+    }
+    FirebaseStream event;
+    event.type_ = "json";
+    event.dataPath_ = "/";
+    event.streamPath_ = fbdo->streamPath_;
+    event.json_ = pendingCommands.front().json;
+    pendingCommands.pop_front();
+    fakeStats.rtdbBytesDown += encodedSize(event.json_);
+    if (fbdo->onData_) fbdo->onData_(event);
+    return true;
+}
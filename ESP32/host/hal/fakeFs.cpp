@@ -0,0 +1,210 @@
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <set>
+#include <FS.h>
+#include <LittleFS.h>
+#include "fakeBoard.h"
+
+fs::LittleFSFS LittleFS;
+
+namespace {
+
+std::map<std::string, std::string> files;
+std::set<std::string> dirs;
+bool mounted = false;
+bool formatted = false;
+
+std::string parentOf(const std::string& path) {
+    size_t slash = path.rfind('/');
+    return slash == 0 || slash == std::string::npos ? "/" : path.substr(0, slash);
+}
+
+}
+
+namespace fs {
+
+struct FakeFileState {
+    std::string path;
+    bool isDir = false;
+    bool writable = false;
+    bool dirty = false;
+    bool open = true;
+    size_t pos = 0;
+    std::vector<std::string> children; // directories only
+    size_t nextChild = 0;
+};
+
+size_t File::write(const uint8_t* buf, size_t size) {
+    if (!state_ || !state_->open || !state_->writable) return 0;
+    std::string& data = files[state_->path];
+    if (state_->pos + size > data.size()) data.resize(state_->pos + size);
+    memcpy(&data[state_->pos], buf, size);
+    state_->pos += size;
+    state_->dirty = true;
+    fakeStats.fsBytesWritten += size;
+    return size;
+}
+
+size_t File::read(uint8_t* buf, size_t size) {
+    if (!state_ || !state_->open || state_->isDir) return 0;
+    auto it = files.find(state_->path);
+    if (it == files.end() || state_->pos >= it->second.size()) return 0;
+    size_t n = std::min(size, it->second.size() - state_->pos);
+    memcpy(buf, it->second.data() + state_->pos, n);
+    state_->pos += n;
+    return n;
+}
+
+int File::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int File::available() {
+    return state_ && !state_->isDir ? (int)(size() - state_->pos) : 0;
+}
+
+size_t File::size() const {
+    if (!state_) return 0;
+    auto it = files.find(state_->path);
+    return it == files.end() ? 0 : it->second.size();
+}
+
+bool File::seek(uint32_t pos) {
+    if (!state_ || pos > size()) return false;
+    state_->pos = pos;
+    return true;
+}
+
+size_t File::position() const { return state_ ? state_->pos : 0; }
+
+// LittleFS commits a written file's data and metadata on close.
+void File::close() {
+    if (!state_ || !state_->open) return;
+    state_->open = false;
+    if (state_->dirty) {
+        fakeStats.fsWrites++;
+        fakeAdvanceMicros(kFakeFsCommitUs);
+    }
+}
+
+bool File::isDirectory() const { return state_ && state_->isDir; }
+
+const char* File::name() const {
+    if (!state_) return "";
+    size_t slash = state_->path.rfind('/');
+    return state_->path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+}
+
+const char* File::path() const { return state_ ? state_->path.c_str() : ""; }
+
+File File::openNextFile() {
+    if (!state_ || !state_->isDir || state_->nextChild >= state_->children.size()) return File();
+    return LittleFS.open(state_->children[state_->nextChild++].c_str());
+}
+
+File FS::open(const char* path, const char* mode, bool create) {
+    if (!mounted || !path || path[0] != '/') return File();
+    std::string p = path;
+    auto state = std::make_shared<FakeFileState>();
+    state->path = p;
+    if (dirs.count(p)) {
+        state->isDir = true;
+        for (const auto& f : files) {
+            if (parentOf(f.first) == p) state->children.push_back(f.first);
+        }
+        for (const auto& d : dirs) {
+            if (d != p && parentOf(d) == p) state->children.push_back(d);
+        }
+        std::sort(state->children.begin(), state->children.end());
+        return File(state);
+    }
+    bool writing = mode[0] == 'w' || mode[0] == 'a';
+    if (!writing) return files.count(p) ? File(state) : File();
+    if (!dirs.count(parentOf(p))) {
+        if (!create) return File();
+        dirs.insert(parentOf(p));
+    }
+    state->writable = true;
+    std::string& data = files[p];
+    if (mode[0] == 'w') {
+        data.clear();
+        state->dirty = true;
+    }
+    state->pos = data.size();
+    return File(state);
+}
+
+bool FS::exists(const char* path) { return mounted && (files.count(path) || dirs.count(path)); }
+
+bool FS::remove(const char* path) {
+    if (!mounted || !files.erase(path)) return false;
+    fakeStats.fsWrites++;
+    fakeAdvanceMicros(kFakeFsCommitUs);
+    return true;
+}
+
+bool FS::rename(const char* from, const char* to) {
+    auto it = files.find(from);
+    if (!mounted || it == files.end()) return false;
+    files[to] = it->second;
+    files.erase(from);
+    fakeStats.fsWrites++;
+    fakeAdvanceMicros(kFakeFsCommitUs);
+    return true;
+}
+
+bool FS::mkdir(const char* path) {
+    if (!mounted || !dirs.count(parentOf(path))) return false;
+    dirs.insert(path);
+    return true;
+}
+
+bool FS::rmdir(const char* path) {
+    std::string p = path;
+    if (!mounted || p == "/" || !dirs.count(p)) return false;
+    for (const auto& f : files) {
+        if (parentOf(f.first) == p) return false;
+    }
+    dirs.erase(p);
+    return true;
+}
+
+bool LittleFSFS::begin(bool formatOnFail, const char*, uint8_t, const char*) {
+    if (!formatted && !formatOnFail) return false;
+    if (!formatted) format();
+    mounted = true;
+    return true;
+}
+
+bool LittleFSFS::format() {
+    files.clear();
+    dirs.clear();
+    dirs.insert("/");
+    formatted = true;
+    return true;
+}
+
+size_t LittleFSFS::totalBytes() { return kFakeFsBytes; }
+
+// Every directory takes a metadata pair; file data is allocated in whole
+// blocks unless it is small enough to be inlined in the directory.
+size_t LittleFSFS::usedBytes() {
+    size_t blocks = 2 * dirs.size();
+    for (const auto& f : files) {
+        if (f.second.size() > kFakeFsInlineMax) blocks += (f.second.size() + kFakeFsBlock - 1) / kFakeFsBlock;
+    }
+    return blocks * kFakeFsBlock;
+}
+
+void LittleFSFS::end() { mounted = false; }
+
+}
+
+void fakeResetFs() {
+    files.clear();
+    dirs.clear();
+    mounted = false;
+    formatted = false;
+}
@@ -0,0 +1,272 @@
+#include <map>
+#include <ESPAsyncWebServer.h>
+#include <ESPmDNS.h>
+#include "fakeBoard.h"
+
+MDNSResponder MDNS;
+
+namespace {
+
+enum LanEventKind { LAN_HTTP, LAN_WS_OPEN, LAN_WS_TEXT, LAN_WS_CLOSE };
+
+struct LanEvent {
+    LanEventKind kind;
+    int id = 0; // request or client
+    WebRequestMethodComposite method = HTTP_GET;
+    String url{};
+    String token{};
+    String body{};
+};
+
+AsyncWebServer* server = nullptr;
+TaskHandle_t asyncTask = nullptr;
+std::multimap<unsigned long long, LanEvent> pending; // by delivery time
+std::map<int, FakeLanReply> replies;
+std::map<int, std::vector<FakeWsMessage>> received;
+std::map<int, bool> wsOpen;
+int nextId = 1;
+String mdnsHost;
+std::vector<String> mdnsServices;
+
+const String emptyHeader;
+
+void queue(unsigned long long atUs, const LanEvent& event) {
+    unsigned long long deliverAt = fakeRadioDeliverAt(atUs + kFakeLanHopUs);
+    pending.insert({deliverAt, event});
+    fakeTaskWakeBy(asyncTask, deliverAt);
+}
+
+void sendToClient(uint32_t id, const char* message) {
+    fakeRadioBusy(kFakeLanHopUs);
+    received[id].push_back({String(message), fakeMicros() + kFakeLanHopUs});
+}
+
+void deliverHttp(const LanEvent& event) {
+    AsyncWebServerRequest request;
+    request.method_ = event.method;
+    request.url_ = event.url;
+    request.body_ = event.body;
+    if (event.token.length()) request.headers_["Authorization"] = "Bearer " + event.token;
+    const AsyncWebServer::Route* route = nullptr;
+    for (const AsyncWebServer::Route& r : server->routes_) {
+        if (r.uri == event.url && (r.method & event.method)) route = &r;
+    }
+    if (route) {
+        if (route->onBody && event.body.length()) {
+            route->onBody(&request, (uint8_t*)event.body.c_str(), event.body.length(), 0, event.body.length());
+        }
+        route->onRequest(&request);
+    } else if (server->notFound_) {
+        server->notFound_(&request);
+    } else {
+        request.send(404);
+    }
+    fakeRadioBusy(kFakeLanHopUs);
+    replies[event.id] = {request.sentCode_, request.sentBody_, fakeMicros() + kFakeLanHopUs};
+}
+
+void deliverWs(const LanEvent& event) {
+    AsyncWebSocket* ws = server->ws_;
+    if (!ws) return;
+    auto it = ws->clients_.find(event.id);
+    switch (event.kind) {
+        case LAN_WS_OPEN: {
+            AsyncWebSocketClient& client = ws->clients_[event.id];
+            client.id_ = event.id;
+            client.server_ = ws;
+            wsOpen[event.id] = true;
+            if (ws->handler_) ws->handler_(ws, &client, WS_EVT_CONNECT, nullptr, nullptr, 0);
+            break;
+        }
+        case LAN_WS_TEXT: {
+            if (it == ws->clients_.end()) return;
+            AwsFrameInfo info = {};
+            info.final = 1;
+            info.opcode = WS_TEXT;
+            info.message_opcode = WS_TEXT;
+            info.len = event.body.length();
+            if (ws->handler_) {
+                ws->handler_(ws, &it->second, WS_EVT_DATA, &info, (uint8_t*)event.body.c_str(), event.body.length());
+            }
+            break;
+        }
+        case LAN_WS_CLOSE: {
+            if (it == ws->clients_.end()) return;
+            AsyncWebSocketClient client = it->second;
+            ws->clients_.erase(it);
+            wsOpen[event.id] = false;
+            if (ws->handler_) ws->handler_(ws, &client, WS_EVT_DISCONNECT, nullptr, nullptr, 0);
+            break;
+        }
+        default: break;
+    }
+}
+
+// AsyncTCP calls the handlers from a task of its own; this one sleeps until
+// the next client message is due, and with none pending until one is sent.
+void asyncTcpLoop(void* param) {
+    (void)param;
+    for (;;) {
+        while (server && !pending.empty() && pending.begin()->first <= fakeMicros()) {
+            LanEvent event = pending.begin()->second;
+            pending.erase(pending.begin());
+            if (event.kind == LAN_HTTP) {
+                deliverHttp(event);
+            } else {
+                deliverWs(event);
+            }
+        }
+        unsigned long long next = pending.empty() ? ~0ULL : pending.begin()->first;
+        if (next > fakeMicros()) fakeTaskSleepUntil(next);
+    }
+}
+
+}
+
+void fakeResetLan() {
+    server = nullptr;
+    asyncTask = nullptr;
+    pending.clear();
+    replies.clear();
+    received.clear();
+    wsOpen.clear();
+    nextId = 1;
+    mdnsHost = "";
+    mdnsServices.clear();
+}
+
+// ----------------------- Client side -----------------------
+int fakeLanRequestAt(const char* method, const char* url, const String& token, const String& body,
+                     unsigned long long atUs) {
+    int id = nextId++;
+    if (!server) {
+        replies[id] = {0, String(), atUs}; // connection refused
+        return id;
+    }
+    LanEvent event = {LAN_HTTP, id, strcmp(method, "POST") == 0 ? (WebRequestMethodComposite)HTTP_POST
+                                                                : (WebRequestMethodComposite)HTTP_GET,
+                      String(url), token, body};
+    queue(atUs, event);
+    return id;
+}
+
+const FakeLanReply* fakeLanReply(int request) {
+    auto it = replies.find(request);
+    return it == replies.end() ? nullptr : &it->second;
+}
+
+int fakeWsOpen() {
+    int id = nextId++;
+    if (!server || !server->ws_) return id;
+    queue(fakeMicros(), {LAN_WS_OPEN, id});
+    return id;
+}
+
+void fakeWsSendAt(int client, const String& text, unsigned long long atUs) {
+    LanEvent event = {LAN_WS_TEXT, client};
+    event.body = text;
+    queue(atUs, event);
+}
+
+void fakeWsClose(int client) { queue(fakeMicros(), {LAN_WS_CLOSE, client}); }
+
+bool fakeWsConnected(int client) {
+    auto it = wsOpen.find(client);
+    return it != wsOpen.end() && it->second;
+}
+
+const std::vector<FakeWsMessage>& fakeWsReceived(int client) { return received[client]; }
+
+String fakeMdnsHostname() { return mdnsHost; }
+std::vector<String> fakeMdnsServices() { return mdnsServices; }
+
+// ----------------------- Server side -----------------------
+const String& AsyncWebServerRequest::header(const char* name) const {
+    auto it = headers_.find(name);
+    return it == headers_.end() ? emptyHeader : it->second;
+}
+
+void AsyncWebServerRequest::send(int code, const char* contentType, const String& content) {
+    (void)contentType;
+    if (sentCode_) return;
+    sentCode_ = code;
+    sentBody_ = content;
+}
+
+void AsyncWebSocketClient::text(const char* message) {
+    if (server_) server_->text(id_, message);
+}
+
+void AsyncWebSocketClient::close(uint16_t code, const char* message) {
+    if (server_) server_->close(id_, code, message);
+}
+
+AsyncWebSocketClient* AsyncWebSocket::client(uint32_t id) {
+    auto it = clients_.find(id);
+    return it == clients_.end() ? nullptr : &it->second;
+}
+
+void AsyncWebSocket::text(uint32_t id, const char* message) {
+    if (clients_.count(id)) sendToClient(id, message);
+}
+
+void AsyncWebSocket::textAll(const char* message) {
+    for (auto& c : clients_) sendToClient(c.first, message);
+}
+
+// The disconnect event follows from the TCP task, as on the device.
+void AsyncWebSocket::close(uint32_t id, uint16_t code, const char* message) {
+    (void)code;
+    (void)message;
+    if (!clients_.count(id)) return;
+    LanEvent event = {LAN_WS_CLOSE, (int)id};
+    pending.insert({fakeMicros(), event});
+    fakeTaskWakeBy(asyncTask, fakeMicros());
+}
+
+void AsyncWebServer::on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest) {
+    routes_.push_back({String(uri), method, onRequest, nullptr});
+}
+
+void AsyncWebServer::on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+                        ArUploadHandlerFunction onUpload, ArBodyHandlerFunction onBody) {
+    (void)onUpload;
+    routes_.push_back({String(uri), method, onRequest, onBody});
+}
+
+AsyncWebHandler& AsyncWebServer::addHandler(AsyncWebHandler* handler) {
+    if (AsyncWebSocket* ws = dynamic_cast<AsyncWebSocket*>(handler)) ws_ = ws;
+    return *handler;
+}
+
+void AsyncWebServer::begin() {
+    server = this;
+    if (!asyncTask) xTaskCreatePinnedToCore(asyncTcpLoop, "async_tcp", 8192, nullptr, 3, &asyncTask, tskNO_AFFINITY);
+}
+
+void AsyncWebServer::end() {
+    if (server == this) server = nullptr;
+}
+
+bool MDNSResponder::begin(const char* hostName) {
+    mdnsHost = hostName;
+    return true;
+}
+
+void MDNSResponder::end() {
+    mdnsHost = "";
+    mdnsServices.clear();
+}
+
+bool MDNSResponder::addService(const char* service, const char* proto, uint16_t port) {
+    mdnsServices.push_back("_" + String(service) + "._" + String(proto) + ":" + String((int)port));
+    return true;
+}
+
+bool MDNSResponder::addServiceTxt(const char* service, const char* proto, const char* key, const char* value) {
+    (void)service;
+    (void)proto;
+    (void)key;
+    (void)value;
+    return true;
+}
@@ -0,0 +1,342 @@
+#include <ucontext.h>
+#include <deque>
+#include <memory>
+#include <Arduino.h>
+#include "fakeBoard.h"
+
+// Host stack per task, sized so host code never overflows it. The high-water
+// mark is reported against the requested depth, from the host bytes touched.
+const size_t kFakeTaskStackBytes = 256 * 1024;
+const uint8_t kStackPaint = 0xA5;
+const unsigned long long kNever = ~0ULL;
+
+struct FakeQueue {
+    size_t length;
+    size_t itemSize;
+    std::deque<std::vector<uint8_t>> items;
+};
+
+struct FakeTask {
+    std::string name;
+    TaskFunction_t fn;
+    void* param;
+    UBaseType_t priority;
+    int core;
+    uint32_t stackDepth;
+    size_t order;
+    std::unique_ptr<uint8_t[]> stack;
+    ucontext_t ctx;
+    unsigned long long wakeUs;
+    FakeQueue* waitingOn;
+    uint32_t notified;
+    bool waitingNotify;
+    bool finished;
+    unsigned long runs;
+    std::vector<double> latenessMs;
+    std::vector<double> heldMs;
+};
+
+namespace {
+
+std::vector<std::unique_ptr<FakeTask>> tasks;
+std::vector<std::unique_ptr<FakeQueue>> queues;
+FakeTask* current = nullptr;
+ucontext_t schedulerCtx;
+bool restartRequested = false;
+unsigned long long idleSinceUs = 0; // when the last task run ended
+
+struct FakeEvent {
+    unsigned long long atUs;
+    void (*fn)();
+};
+std::vector<FakeEvent> events;
+
+void taskEntry(unsigned int hi, unsigned int lo) {
+    FakeTask* task = (FakeTask*)(((uintptr_t)hi << 32) | (uintptr_t)lo);
+    try {
+        task->fn(task->param);
+    } catch (const FakeRestart&) {
+        restartRequested = true;
+    }
+    task->finished = true; // a FreeRTOS task must never return; treat it as deleted
+}
+
+void yieldToScheduler() {
+    swapcontext(&current->ctx, &schedulerCtx);
+}
+
+size_t stackUsed(const FakeTask& task) {
+    size_t untouched = 0;
+    while (untouched < kFakeTaskStackBytes && task.stack[untouched] == kStackPaint) untouched++;
+    return kFakeTaskStackBytes - untouched;
+}
+
+FakeTask* nextDue() {
+    FakeTask* best = nullptr;
+    for (auto& t : tasks) {
+        if (t->finished) continue;
+        if (!best || t->wakeUs < best->wakeUs ||
+            (t->wakeUs == best->wakeUs && t->priority > best->priority)) {
+            best = t.get();
+        }
+    }
+    return best;
+}
+
+void wakeWaiters(FakeQueue* queue) {
+    for (auto& t : tasks) {
+        if (t->waitingOn == queue && t.get() != current) t->wakeUs = std::min(t->wakeUs, fakeMicros());
+    }
+}
+
+// Blocks the calling task on `queue` until it changes or `wait` ticks pass.
+bool waitOnQueue(FakeQueue* queue, TickType_t wait) {
+    if (wait == 0) return false;
+    if (!current) {
+        if (wait != portMAX_DELAY) fakeAdvanceMillis(wait);
+        return false;
+    }
+    current->waitingOn = queue;
+    current->wakeUs = wait == portMAX_DELAY ? kNever : fakeMicros() + (unsigned long long)wait * 1000ULL;
+    yieldToScheduler();
+    current->waitingOn = nullptr;
+    return true;
+}
+
+}
+
+bool fakeInTask() { return current != nullptr; }
+
+unsigned long long fakeIdleSinceUs() { return idleSinceUs; }
+
+void fakeTaskSleepUntil(unsigned long long us) {
+    if (!current) {
+        if (us > fakeMicros()) fakeAdvanceMicros(us - fakeMicros());
+        return;
+    }
+    current->wakeUs = us;
+    yieldToScheduler();
+}
+
+void fakeTaskWakeBy(TaskHandle_t task, unsigned long long us) {
+    if (task && task != current && !task->finished) task->wakeUs = std::min(task->wakeUs, us);
+}
+
+void fakeBlockMicros(unsigned long long us) {
+    fakeTaskSleepUntil(fakeMicros() + us);
+}
+
+void fakeAtMicros(unsigned long long us, void (*fn)()) {
+    events.push_back({us, fn});
+}
+
+// Fires the hardware events due by `untilUs` that come before every task
+// wake, on a clock moved to each; their interrupts may wake a task earlier.
+static void fireEvents(unsigned long long untilUs) {
+    while (!events.empty()) {
+        size_t first = 0;
+        for (size_t i = 1; i < events.size(); i++) {
+            if (events[i].atUs < events[first].atUs) first = i;
+        }
+        FakeEvent event = events[first];
+        FakeTask* task = nextDue();
+        if (event.atUs > untilUs || (task && task->wakeUs <= event.atUs)) return;
+        events.erase(events.begin() + first);
+        if (event.atUs > fakeMicros()) fakeAdvanceMicros(event.atUs - fakeMicros());
+        event.fn();
+    }
+}
+
+void fakeRunTasksUntil(unsigned long long untilUs) {
+    while (true) {
+        fireEvents(untilUs);
+        FakeTask* task = nextDue();
+        if (!task || task->wakeUs > untilUs) break;
+        if (task->wakeUs > fakeMicros()) fakeAdvanceMicros(task->wakeUs - fakeMicros());
+        fakeAdvanceMicros(fakePowerIdle(idleSinceUs, fakeMicros()));
+        task->latenessMs.push_back((fakeMicros() - task->wakeUs) / 1000.0);
+        task->wakeUs = kNever;
+        unsigned long long resumed = fakeMicros();
+        current = task;
+        swapcontext(&schedulerCtx, &task->ctx);
+        current = nullptr;
+        task->runs++;
+        task->heldMs.push_back((fakeMicros() - resumed) / 1000.0);
+        fakePowerRun(fakeMicros() - resumed);
+        idleSinceUs = fakeMicros();
+        if (restartRequested) {
+            restartRequested = false;
+            throw FakeRestart();
+        }
+    }
+    if (untilUs > fakeMicros()) fakeAdvanceMicros(untilUs - fakeMicros());
+}
+
+void fakeRunTasksFor(unsigned long ms) {
+    fakeRunTasksUntil(fakeMicros() + (unsigned long long)ms * 1000ULL);
+}
+
+void fakeResetRtos() {
+    // Stacks of tasks that never finished are dropped with whatever their
+    // frames still own; fine for a test process.
+    tasks.clear();
+    queues.clear();
+    events.clear();
+    current = nullptr;
+    restartRequested = false;
+    idleSinceUs = 0;
+}
+
+static void loopTaskEntry(void* param) {
+    void (*loopFn)() = (void (*)())param;
+    for (;;) loopFn();
+}
+
+void fakeStartLoopTask(void (*loopFn)()) {
+    xTaskCreatePinnedToCore(loopTaskEntry, "loopTask", 8192, (void*)loopFn, 1, nullptr, 1);
+}
+
+std::vector<FakeTaskInfo> fakeTasks() {
+    std::vector<FakeTaskInfo> out;
+    for (auto& t : tasks) {
+        out.push_back({String(t->name.c_str()), t->core, t->priority, t->stackDepth, stackUsed(*t), t->runs,
+                       t->latenessMs, t->heldMs});
+    }
+    return out;
+}
+
+// ----------------------- Tasks -----------------------
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackDepth, void* param,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core) {
+    auto task = std::make_unique<FakeTask>();
+    task->name = name;
+    task->fn = fn;
+    task->param = param;
+    task->priority = priority;
+    task->core = core;
+    task->stackDepth = stackDepth;
+    task->order = tasks.size();
+    task->stack.reset(new uint8_t[kFakeTaskStackBytes]);
+    memset(task->stack.get(), kStackPaint, kFakeTaskStackBytes);
+    task->wakeUs = fakeMicros();
+    task->waitingOn = nullptr;
+    task->notified = 0;
+    task->waitingNotify = false;
+    task->finished = false;
+    task->runs = 0;
+    getcontext(&task->ctx);
+    task->ctx.uc_stack.ss_sp = task->stack.get();
+    task->ctx.uc_stack.ss_size = kFakeTaskStackBytes;
+    task->ctx.uc_link = &schedulerCtx;
+    uintptr_t p = (uintptr_t)task.get();
+    makecontext(&task->ctx, (void (*)())taskEntry, 2, (unsigned int)(p >> 32), (unsigned int)(p & 0xFFFFFFFF));
+    if (handle) *handle = task.get();
+    tasks.push_back(std::move(task));
+    return pdPASS;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    fakeTaskSleepUntil(fakeMicros() + (unsigned long long)ticks * 1000ULL);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    FakeTask* t = task ? task : current;
+    if (!t) return;
+    t->finished = true;
+    if (t == current) yieldToScheduler();
+}
+
+TickType_t xTaskGetTickCount() {
+    return (TickType_t)(fakeMicros() / 1000ULL);
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    FakeTask* t = task ? task : current;
+    if (!t) return 0;
+    size_t used = stackUsed(*t);
+    return used >= t->stackDepth ? 0 : (UBaseType_t)(t->stackDepth - used);
+}
+
+const char* pcTaskGetName(TaskHandle_t task) {
+    FakeTask* t = task ? task : current;
+    return t ? t->name.c_str() : "loopTask";
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    task->notified++;
+    if (task->waitingNotify && task != current) task->wakeUs = std::min(task->wakeUs, fakeMicros());
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken) {
+    if (higherPriorityTaskWoken) *higherPriorityTaskWoken = pdFALSE;
+    xTaskNotifyGive(task);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t wait) {
+    if (!current) return 0;
+    if (current->notified == 0 && wait != 0) {
+        current->waitingNotify = true;
+        current->wakeUs = wait == portMAX_DELAY ? kNever : fakeMicros() + (unsigned long long)wait * 1000ULL;
+        yieldToScheduler();
+        current->waitingNotify = false;
+    }
+    uint32_t count = current->notified;
+    current->notified = clearOnExit || count == 0 ? 0 : count - 1;
+    return count;
+}
+
+// ----------------------- Queues -----------------------
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    queues.push_back(std::make_unique<FakeQueue>());
+    queues.back()->length = length;
+    queues.back()->itemSize = itemSize;
+    return queues.back().get();
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t wait) {
+    unsigned long long deadline = wait == portMAX_DELAY ? kNever : fakeMicros() + (unsigned long long)wait * 1000ULL;
+    while (queue->items.size() >= queue->length) {
+        if (fakeMicros() >= deadline || !waitOnQueue(queue, wait)) return errQUEUE_FULL;
+    }
+    const uint8_t* bytes = (const uint8_t*)item;
+    queue->items.emplace_back(bytes, bytes + queue->itemSize);
+    wakeWaiters(queue);
+    return pdPASS;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* higherPriorityTaskWoken) {
+    if (higherPriorityTaskWoken) *higherPriorityTaskWoken = pdFALSE;
+    if (queue->items.size() >= queue->length) return errQUEUE_FULL;
+    const uint8_t* bytes = (const uint8_t*)item;
+    queue->items.emplace_back(bytes, bytes + queue->itemSize);
+    wakeWaiters(queue);
+    return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t wait) {
+    unsigned long long deadline = wait == portMAX_DELAY ? kNever : fakeMicros() + (unsigned long long)wait * 1000ULL;
+    while (queue->items.empty()) {
+        if (fakeMicros() >= deadline) return pdFALSE;
+        TickType_t left = wait == portMAX_DELAY ? wait : (TickType_t)((deadline - fakeMicros() + 999) / 1000);
+        if (!waitOnQueue(queue, left)) return pdFALSE;
+    }
+    memcpy(item, queue->items.front().data(), queue->itemSize);
+    queue->items.pop_front();
+    wakeWaiters(queue);
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    return (UBaseType_t)queue->items.size();
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue) {
+    return (UBaseType_t)(queue->length - queue->items.size());
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+    queue->items.clear();
+    wakeWaiters(queue);
+    return pdPASS;
+}
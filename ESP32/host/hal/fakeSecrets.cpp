@@ -0,0 +1,9 @@
+#include "secrets.h"
+
+const char* debugssid = "";
+const char* debugpass = "";
+const char* root_ca = "";
+const String ApiKey = "host-api-key";
+const String DbUrl = "https://breezio-host.firebaseio.com/";
+const String AuthEmail = "host@breezio.local";
+const String AuthPass = "host";
@@ -0,0 +1,25 @@
+// Stands in for InitSetup.cpp on the host: the device is always provisioned,
+// so setup() goes straight to the STA path and starts joining as
+// connectToWifi() does.
+#include <WiFi.h>
+#include "InitSetup.h"
+#include "sensors.h"
+
+bool isProvisioned() {
+    return true;
+}
+
+void connectToWifi() {
+    if (WiFi.status() == WL_CONNECTED) return;
+    WiFi.disconnect();
+    WiFi.setAutoReconnect(true);
+    WiFi.begin("home", "hunter22");
+}
+
+void initSetup() {
+    initSensors();
+    connectToWifi();
+}
+
+void handleWebRequests() {
+}
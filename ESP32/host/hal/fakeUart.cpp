@@ -0,0 +1,167 @@
+#include <deque>
+#include <string>
+#include <vector>
+#include <Arduino.h>
+#include "driver/uart.h"
+#include "fakeBoard.h"
+
+// The FIFO holds 128 bytes; the driver's default full threshold and timeout.
+const int kFakeUartFullThreshold = 120;
+const int kFakeUartTimeoutSymbols = 10;
+
+bool fakeChipAsleepAt(unsigned long long us);
+bool fakeUartWakes(int port);
+void fakeUartWoke();
+
+namespace {
+
+struct Arrival {
+    unsigned long long startUs; // the first byte on the line
+    unsigned long long atUs;
+    std::vector<uint8_t> bytes;
+    bool timeout;
+};
+
+struct FakeUartPort {
+    bool installed;
+    QueueHandle_t events;
+    size_t ringSize;
+    int baud = 115200;
+    int fullThreshold = kFakeUartFullThreshold;
+    int timeoutSymbols = kFakeUartTimeoutSymbols;
+    int wakeThreshold = 0;
+    std::deque<uint8_t> ring;
+    std::deque<Arrival> wire;
+    unsigned long long lineFreeUs;
+    std::string sent;
+};
+
+FakeUartPort ports[UART_NUM_MAX];
+
+double byteUs(const FakeUartPort& port) {
+    return 10e6 / port.baud; // 8N1
+}
+
+void postEvent(FakeUartPort& port, uart_event_type_t type, size_t size, bool timeout) {
+    if (!port.events) return;
+    uart_event_t event = {type, size, timeout};
+    xQueueSendFromISR(port.events, &event, nullptr); // dropped when full, as the driver does
+}
+
+// The rx interrupt: what has arrived moves from the FIFO to the ring.
+// Bytes that came in light sleep are lost, all of them unless the port may
+// wake the chip, which then takes kFakeLightSleepWakeUs to come up.
+void deliver() {
+    for (int p = 0; p < UART_NUM_MAX; p++) {
+        FakeUartPort& port = ports[p];
+        while (!port.wire.empty() && port.wire.front().atUs <= fakeMicros()) {
+            Arrival arrival = std::move(port.wire.front());
+            port.wire.pop_front();
+            if (!port.installed) continue;
+            if (fakeChipAsleepAt(arrival.startUs)) {
+                if (!fakeUartWakes(p) || !port.wakeThreshold) continue;
+                fakeUartWoke();
+                size_t lost = std::min(arrival.bytes.size(), (size_t)ceil(kFakeLightSleepWakeUs / byteUs(port)));
+                arrival.bytes.erase(arrival.bytes.begin(), arrival.bytes.begin() + lost);
+                if (arrival.bytes.empty()) continue;
+            }
+            size_t room = port.ringSize - port.ring.size();
+            size_t n = std::min(room, arrival.bytes.size());
+            port.ring.insert(port.ring.end(), arrival.bytes.begin(), arrival.bytes.begin() + n);
+            if (n) postEvent(port, UART_DATA, n, arrival.timeout);
+            if (n < arrival.bytes.size()) postEvent(port, UART_BUFFER_FULL, 0, false);
+        }
+    }
+}
+
+}
+
+void fakeResetUart() {
+    for (FakeUartPort& port : ports) port = FakeUartPort();
+}
+
+void fakeUartReceive(int port, const uint8_t* data, size_t len) {
+    if (port < 0 || port >= UART_NUM_MAX || len == 0) return;
+    FakeUartPort& p = ports[port];
+    unsigned long long start = std::max(fakeMicros(), p.lineFreeUs);
+    for (size_t offset = 0; offset < len; offset += p.fullThreshold) {
+        size_t n = std::min(len - offset, (size_t)p.fullThreshold);
+        bool last = offset + n == len;
+        unsigned long long at = start + (unsigned long long)((offset + n) * byteUs(p));
+        // A partly filled FIFO waits for the line to stay idle.
+        if (last && n < (size_t)p.fullThreshold) at += (unsigned long long)(p.timeoutSymbols * byteUs(p));
+        unsigned long long firstUs = start + (unsigned long long)(offset * byteUs(p));
+        p.wire.push_back({firstUs, at, std::vector<uint8_t>(data + offset, data + offset + n), last});
+        fakeAtMicros(at, deliver);
+    }
+    p.lineFreeUs = start + (unsigned long long)(len * byteUs(p));
+}
+
+std::string fakeUartTakeSent(int port) {
+    std::string out;
+    if (port >= 0 && port < UART_NUM_MAX) out.swap(ports[port].sent);
+    return out;
+}
+
+esp_err_t uart_driver_install(uart_port_t port, int rx_buffer_size, int tx_buffer_size, int queue_size,
+                              QueueHandle_t* uart_queue, int intr_alloc_flags) {
+    (void)tx_buffer_size; (void)intr_alloc_flags;
+    if (port < 0 || port >= UART_NUM_MAX || ports[port].installed) return ESP_FAIL;
+    FakeUartPort& p = ports[port];
+    p.installed = true;
+    p.ringSize = rx_buffer_size;
+    p.events = queue_size > 0 ? xQueueCreate(queue_size, sizeof(uart_event_t)) : nullptr;
+    if (uart_queue) *uart_queue = p.events;
+    return ESP_OK;
+}
+
+esp_err_t uart_param_config(uart_port_t port, const uart_config_t* config) {
+    if (port < 0 || port >= UART_NUM_MAX) return ESP_FAIL;
+    ports[port].baud = config->baud_rate;
+    return ESP_OK;
+}
+
+esp_err_t uart_set_pin(uart_port_t port, int tx, int rx, int rts, int cts) {
+    (void)tx; (void)rx; (void)rts; (void)cts;
+    return port >= 0 && port < UART_NUM_MAX ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t uart_set_rx_full_threshold(uart_port_t port, int threshold) {
+    if (port < 0 || port >= UART_NUM_MAX || threshold < 1 || threshold > 127) return ESP_FAIL;
+    ports[port].fullThreshold = threshold;
+    return ESP_OK;
+}
+
+esp_err_t uart_set_wakeup_threshold(uart_port_t port, int wakeup_threshold) {
+    if (port < 0 || port >= UART_NUM_MAX || wakeup_threshold < 3 || wakeup_threshold > 0x3FF) return ESP_FAIL;
+    ports[port].wakeThreshold = wakeup_threshold;
+    return ESP_OK;
+}
+
+esp_err_t uart_set_rx_timeout(uart_port_t port, uint8_t tout_thresh) {
+    if (port < 0 || port >= UART_NUM_MAX) return ESP_FAIL;
+    ports[port].timeoutSymbols = tout_thresh;
+    return ESP_OK;
+}
+
+int uart_read_bytes(uart_port_t port, void* buf, uint32_t length, TickType_t ticks_to_wait) {
+    (void)ticks_to_wait;
+    if (port < 0 || port >= UART_NUM_MAX || !ports[port].installed) return -1;
+    FakeUartPort& p = ports[port];
+    size_t n = std::min((size_t)length, p.ring.size());
+    std::copy(p.ring.begin(), p.ring.begin() + n, (uint8_t*)buf);
+    p.ring.erase(p.ring.begin(), p.ring.begin() + n);
+    return (int)n;
+}
+
+int uart_write_bytes(uart_port_t port, const void* src, size_t size) {
+    if (port < 0 || port >= UART_NUM_MAX || !ports[port].installed) return -1;
+    ports[port].sent.append((const char*)src, size);
+    return (int)size;
+}
+
+esp_err_t uart_flush_input(uart_port_t port) {
+    if (port < 0 || port >= UART_NUM_MAX) return ESP_FAIL;
+    ports[port].ring.clear();
+    return ESP_OK;
+}
@@ -0,0 +1,24 @@
+#ifndef HOST_FREERTOS_QUEUE_H
+#define HOST_FREERTOS_QUEUE_H
+
+// Host stand-in for FreeRTOS queues: fixed-size items copied in and out. A
+// task that blocks on a queue is resumed as soon as the queue changes or its
+// timeout passes.
+
+#include "FreeRTOS.h"
+
+typedef struct FakeQueue* QueueHandle_t;
+
+#define errQUEUE_FULL 0
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t wait);
+// Interrupt handlers run outside any task, between scheduler steps.
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* higherPriorityTaskWoken);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t wait);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue);
+BaseType_t xQueueReset(QueueHandle_t queue);
+#define xQueueSendToBack xQueueSend
+
+#endif
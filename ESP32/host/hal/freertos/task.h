@@ -0,0 +1,29 @@
+#ifndef HOST_FREERTOS_TASK_H
+#define HOST_FREERTOS_TASK_H
+
+// Host stand-in for FreeRTOS tasks. Tasks are cooperative coroutines on the
+// virtual clock: they run until they block (vTaskDelay, a queue wait, delay()
+// or an RTDB round trip) and fakeRunTasksUntil() resumes whichever is due
+// next. ESP-IDF stack depths are in bytes; the host gives every task a
+// larger stack of its own and measures the high-water mark the same way
+// FreeRTOS does, by painting it.
+
+#include "FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void*);
+typedef struct FakeTask* TaskHandle_t;
+
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackDepth, void* param,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelete(TaskHandle_t task);
+TickType_t xTaskGetTickCount();
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+const char* pcTaskGetName(TaskHandle_t task);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t wait);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken);
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef HOST_IR_ELECTRA_H
+#define HOST_IR_ELECTRA_H
+
+#include <IRsend.h>
+
+const uint8_t kElectraAcCool = 1;
+const uint8_t kElectraAcFanAuto = 5;
+
+// Approximate air time of one state frame: 104-bit frame, 9166/4470 us header, ~1.74 ms per bit.
+const unsigned long kElectraAcFrameUs = 196000;
+const uint16_t kElectraAcStateLength = 13;
+
+class IRElectraAc {
+public:
+    explicit IRElectraAc(uint16_t pin) : pin_(pin) {}
+    void begin() {}
+    void setMode(uint8_t mode) { mode_ = mode; }
+    void setFan(uint8_t fan) { fan_ = fan; }
+    void setTemp(uint8_t temp) { temp_ = temp; }
+    void setPower(bool on) { power_ = on; }
+    uint8_t getTemp() const { return temp_; }
+    bool getPower() const { return power_; }
+    // Enough of the real state layout for the frame to change with the settings.
+    uint8_t* getRaw() {
+        for (uint16_t i = 0; i < kElectraAcStateLength; i++) state_[i] = 0;
+        state_[0] = 0xC3;
+        state_[1] = (uint8_t)((temp_ - 8) << 3);
+        state_[6] = (uint8_t)(mode_ << 5);
+        state_[9] = power_ ? 0x20 : 0;
+        state_[4] = (uint8_t)(fan_ << 5);
+        uint8_t sum = 0;
+        for (uint16_t i = 0; i < kElectraAcStateLength - 1; i++) sum += state_[i];
+        state_[kElectraAcStateLength - 1] = sum;
+        return state_;
+    }
+    void send(uint16_t repeat = 0) { (void)repeat; fakeIrEmit("Electra", kElectraAcFrameUs); }
+private:
+    uint16_t pin_;
+    uint8_t mode_ = 0;
+    uint8_t fan_ = 0;
+    uint8_t temp_ = 24;
+    bool power_ = false;
+    uint8_t state_[kElectraAcStateLength] = {};
+};
+
+#endif
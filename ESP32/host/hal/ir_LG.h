@@ -0,0 +1,39 @@
+#ifndef HOST_IR_LG_H
+#define HOST_IR_LG_H
+
+#include <IRsend.h>
+
+const uint8_t kLgAcCool = 0;
+const uint8_t kLgAcFanAuto = 5;
+
+// Approximate air time of one state frame: 28-bit frame, 8500/4250 us header.
+const unsigned long kLgAcFrameUs = 59000;
+
+class IRLgAc {
+public:
+    explicit IRLgAc(uint16_t pin) : pin_(pin) {}
+    void begin() {}
+    void setMode(uint8_t mode) { mode_ = mode; }
+    void setFan(uint8_t fan) { fan_ = fan; }
+    void setTemp(uint8_t temp) { temp_ = temp; }
+    void setPower(bool on) { power_ = on; }
+    uint8_t getTemp() const { return temp_; }
+    bool getPower() const { return power_; }
+    // 28-bit code: signature, power, mode, temperature, fan, checksum nibble.
+    uint32_t getRaw() const {
+        uint32_t raw = (0x88u << 20) | ((power_ ? 0u : 3u) << 18) | ((uint32_t)mode_ << 12) |
+                       ((uint32_t)(temp_ - 15) << 8) | ((uint32_t)fan_ << 4);
+        uint8_t sum = 0;
+        for (int shift = 4; shift < 20; shift += 4) sum += (raw >> shift) & 0xF;
+        return raw | (sum & 0xF);
+    }
+    void send(uint16_t repeat = 0) { (void)repeat; fakeIrEmit("LG", kLgAcFrameUs); }
+private:
+    uint16_t pin_;
+    uint8_t mode_ = 0;
+    uint8_t fan_ = 0;
+    uint8_t temp_ = 24;
+    bool power_ = false;
+};
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef HOST_IR_SAMSUNG_H
+#define HOST_IR_SAMSUNG_H
+
+#include <IRsend.h>
+
+const uint8_t kSamsungAcCool = 1;
+const uint8_t kSamsungAcFanAuto = 0;
+
+// Approximate air time of one state frame: two 56-bit sections with section headers.
+const unsigned long kSamsungAcFrameUs = 213000;
+
+class IRSamsungAc {
+public:
+    explicit IRSamsungAc(uint16_t pin) : pin_(pin) {}
+    void begin() {}
+    void setMode(uint8_t mode) { mode_ = mode; }
+    void setFan(uint8_t fan) { fan_ = fan; }
+    void setTemp(uint8_t temp) { temp_ = temp; }
+    void setPower(bool on) { power_ = on; }
+    uint8_t getTemp() const { return temp_; }
+    bool getPower() const { return power_; }
+    void send(uint16_t repeat = 0) { (void)repeat; fakeIrEmit("Samsung", kSamsungAcFrameUs); }
+private:
+    uint16_t pin_;
+    uint8_t mode_ = 0;
+    uint8_t fan_ = 0;
+    uint8_t temp_ = 24;
+    bool power_ = false;
+};
+
+#endif
@@ -0,0 +1,136 @@
+// The CCS811 driver: the sensor task reads a result only when the data-ready
+// interrupt says there is one, or the poll finds one a failed read left
+// behind, eCO2 and TVOC reach the cloud with the other sensor fields when
+// they move past their thresholds, the DHT readings are written to the
+// sensor for compensation, and the baseline is restored after the warm-up
+// and saved once a day. The device boots once and every test
+// runs against it, in order.
+
+#include <Adafruit_CCS811.h>
+#include "hostTest.h"
+#include "deviceFixture.h"
+#include "airQuality.h"
+#include "parameters.h"
+
+void setup();
+void loop();
+
+static const uint16_t kSavedBaseline = 0x9A3C;
+
+static void bootDevice() {
+    fakeReset();
+    fakeSetSerialEcho(false);
+    fakeSetWallClock(1752468900);
+    fakeSetAirSensorPresent(true);
+    fakeSetAir(650, 120);
+    seedFixtureDevice("Electra");
+    Preferences prefs;
+    prefs.begin("air", false);
+    prefs.putUInt("baseline", kSavedBaseline);
+    prefs.end();
+    setup();
+    fakeStartLoopTask(loop);
+    fakeRunTasksFor(5000); // through the cloud bring-up
+}
+
+static long cloudInt(const char* field) {
+    FirebaseJsonData value;
+    if (!fakeRtdbGet(String(kFixtureDevicePath) + "/sensors/" + field, value)) return -1;
+    return value.intValue;
+}
+
+static void testStarted() {
+    CHECK(airQualityPresent());
+    CHECK_EQ(fakeAirSensor.driveMode, CCS811_DRIVE_MODE_10SEC);
+    CHECK(fakeAirSensor.interrupt);
+    CHECK_EQ(fakeAirSensor.envWrites, 1);
+    CHECK(fabsf(fakeAirSensor.temperature - 24.0f) < 0.01f);
+    CHECK(fabsf(fakeAirSensor.humidity - 50.0f) < 0.01f);
+    CHECK_EQ(fakeAirSensor.restoredBaseline, 0); // not before the warm-up
+}
+
+// Nothing but the interrupt makes the task look at the sensor: three
+// transfers per result (the status twice and the result), and a result is
+// never left unread.
+static void testReadsOnInterruptOnly() {
+    unsigned long transfers = fakeStats.i2cTransfers;
+    unsigned long results = fakeAirSensor.results;
+    unsigned long reads = fakeAirSensor.reads;
+    fakeRunTasksFor(10 * 60000UL);
+    CHECK_EQ(fakeAirSensor.results - results, 60);
+    CHECK_EQ(fakeAirSensor.reads - reads, 60);
+    CHECK_EQ(fakeStats.i2cTransfers - transfers, 3 * 60);
+    CHECK_EQ(fakeGetPin(CCS811_INT_PIN), HIGH);
+    CHECK(airQualityValid());
+    CHECK_EQ(airQualityStats().errors, 0);
+}
+
+// A failed read leaves nINT low, so no edge follows it; the poll reads the
+// next result and they keep coming on the interrupt after that.
+static void testResumesAfterFailedRead() {
+    unsigned long errors = airQualityStats().errors;
+    fakeAirSensor.failReads = 1;
+    fakeRunTasksFor(10000);
+    CHECK_EQ(airQualityStats().errors - errors, 1);
+    CHECK_EQ(fakeGetPin(CCS811_INT_PIN), LOW);
+    unsigned long reads = fakeAirSensor.reads;
+    fakeRunTasksFor(AIR_POLL_MS);
+    CHECK(fakeAirSensor.reads - reads >= 1);
+    reads = fakeAirSensor.reads;
+    fakeRunTasksFor(60000);
+    CHECK_EQ(fakeAirSensor.reads - reads, 6);
+    CHECK_EQ(airQualityStats().errors - errors, 1);
+}
+
+static void testUploadsPastThreshold() {
+    CHECK_EQ(cloudInt("eco2"), 650);
+    CHECK_EQ(cloudInt("tvoc"), 120);
+    fakeSetAir(690, 150); // within both thresholds
+    fakeRunTasksFor(3 * 60000UL);
+    CHECK_EQ(airQualityEco2(), 650);
+    CHECK_EQ(cloudInt("eco2"), 650);
+    CHECK_EQ(cloudInt("tvoc"), 120);
+    fakeSetAir(1200, 400);
+    fakeRunTasksFor(2 * 60000UL);
+    // The last step reported is within a threshold of the air.
+    CHECK_EQ(cloudInt("eco2"), airQualityEco2());
+    CHECK_EQ(cloudInt("tvoc"), airQualityTvoc());
+    CHECK(abs(cloudInt("eco2") - 1200) < ECO2_CHANGE_THRESHOLD);
+    CHECK(abs(cloudInt("tvoc") - 400) < TVOC_CHANGE_THRESHOLD);
+}
+
+static void testCompensationFollowsRoom() {
+    unsigned long writes = fakeAirSensor.envWrites;
+    fakeSetRoom(27.0f, 60.0f);
+    fakeRunTasksFor(5 * 60000UL);
+    CHECK(fabsf(fakeAirSensor.temperature - 27.0f) < AIR_ENV_STEP);
+    CHECK(fabsf(fakeAirSensor.humidity - 60.0f) < AIR_ENV_STEP);
+    // A write per half step on the way, not one per read.
+    CHECK(fakeAirSensor.envWrites - writes <= 26);
+    writes = fakeAirSensor.envWrites;
+    fakeRunTasksFor(5 * 60000UL);
+    CHECK_EQ(fakeAirSensor.envWrites, writes);
+}
+
+static void testBaselineRestoredAndSaved() {
+    fakeRunTasksUntil(AIR_BASELINE_RESTORE_MS * 1000ULL);
+    CHECK_EQ(fakeAirSensor.restoredBaseline, kSavedBaseline);
+    fakeAirSensor.baseline = 0x77E1; // what the sensor learned since
+    fakeRunTasksUntil((AIR_BASELINE_SAVE_MS + 60000UL) * 1000ULL);
+    CHECK_EQ(airQualityStats().baselineSaves, 1);
+    Preferences prefs;
+    prefs.begin("air", true);
+    CHECK_EQ(prefs.getUInt("baseline", 0), 0x77E1);
+    prefs.end();
+}
+
+int main() {
+    bootDevice();
+    RUN_TEST(testStarted);
+    RUN_TEST(testReadsOnInterruptOnly);
+    RUN_TEST(testResumesAfterFailedRead);
+    RUN_TEST(testUploadsPastThreshold);
+    RUN_TEST(testCompensationFollowsRoom);
+    RUN_TEST(testBaselineRestoredAndSaved);
+    return hostTestResult();
+}
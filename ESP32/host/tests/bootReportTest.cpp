@@ -0,0 +1,102 @@
+// The staged boot from a cold start: setup() returns without waiting on the
+// network, with the AC under local control; the phases are reached in order
+// behind it; nothing is sent before the stream is open; a change made
+// locally before the cloud answered survives its state; and the state
+// snapshot left in NVS brings the same state back. The firmware's tasks
+// live for the whole process, so the device boots once.
+
+#include <Preferences.h>
+#include "hostTest.h"
+#include "deviceFixture.h"
+#include "FirestoreServices.h"
+#include "bootReport.h"
+#include "configStore.h"
+#include "deviceTasks.h"
+#include "rtdbPublisher.h"
+
+void setup();
+void loop();
+
+static void bootDevice() {
+    fakeReset();
+    fakeSetSerialEcho(false);
+    fakeSetWallClock(1752468900);
+    seedFixtureDevice("Custom");
+    FirebaseJson status;
+    status.set("status/lightsOn", true);
+    status.set("status/currentTimer", 45);
+    fakeRtdbSeed(kFixtureDevicePath, status);
+    fakeColdBoot();
+    setup();
+    fakeStartLoopTask(loop);
+}
+
+static void testSetupDoesNotWait() {
+    CHECK(fakeMicros() < 100000ULL);
+    CHECK(deviceTasksRunning());
+    CHECK(bootReached(BOOT_STATE));
+    CHECK(bootReached(BOOT_CONTROL));
+    CHECK(!bootReached(BOOT_WIFI));
+    CHECK_EQ(fakeStats.delayedUs, 0);
+}
+
+static void testLocalChangeSurvivesCloudState() {
+    // From the LAN, say, while the station is still joining.
+    fakeRunTasksFor(500);
+    FirebaseJson command = fixtureCommand("switch_relay");
+    CHECK(postCommandJson(command));
+    fakeRunTasksFor(100);
+    CHECK(relay_on);
+
+    while (!bootReached(BOOT_STREAM) && fakeMicros() < 20000000ULL) {
+        CHECK_EQ(rtdbPublisherStats().flushes, 0);
+        fakeRunTasksFor(10);
+    }
+    CHECK(bootReached(BOOT_STREAM));
+    CHECK(relay_on);        // here since boot, the node still says off
+    CHECK(lights_on);       // from the node
+    CHECK_EQ(duration, 45); // from the node
+    fakeRunTasksFor(2000);
+    FirebaseJsonData result;
+    CHECK(fakeRtdbGet(String(kFixtureDevicePath) + "/result", result));
+    CHECK(result.stringValue == "Success"); // held until the stream was open
+}
+
+static void testPhasesInOrder() {
+    fakeRunTasksFor(5000);
+    for (int i = 0; i < BOOT_PHASES; i++) CHECK(bootReached((BootPhase)i));
+    CHECK(bootPhaseMs(BOOT_WIFI) >= kFakeWifiJoinMs);
+    CHECK(bootPhaseMs(BOOT_TIME) >= bootPhaseMs(BOOT_WIFI) + kFakeSntpMs);
+    CHECK(bootPhaseMs(BOOT_AUTH) >= bootPhaseMs(BOOT_WIFI) + kFakeAuthMs);
+    CHECK(bootPhaseMs(BOOT_CLOUD_STATE) > bootPhaseMs(BOOT_AUTH));
+    CHECK(bootPhaseMs(BOOT_STREAM) > bootPhaseMs(BOOT_CLOUD_STATE));
+    CHECK(cloudConnected());
+}
+
+static void testSnapshotRestoresTheState() {
+    fakeRunTasksFor(CONFIG_COMMIT_DELAY_MS + 1000);
+    Preferences prefs;
+    prefs.begin("state", true);
+    CHECK(prefs.isKey("last"));
+    prefs.end();
+
+    // What the next boot does, before the tasks start.
+    lights_on = false;
+    relay_on = false;
+    duration = 30;
+    loadConfigStore();
+    restoreCachedState();
+    CHECK(lights_on);
+    CHECK(relay_on);
+    CHECK_EQ(duration, 45);
+    CHECK(model == MODEL_CUSTOM);
+}
+
+int main() {
+    bootDevice();
+    RUN_TEST(testSetupDoesNotWait);
+    RUN_TEST(testLocalChangeSurvivesCloudState);
+    RUN_TEST(testPhasesInOrder);
+    RUN_TEST(testSnapshotRestoresTheState);
+    return hostTestResult();
+}
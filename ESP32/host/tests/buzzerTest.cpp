@@ -0,0 +1,65 @@
+// Timing of the buzzer sequencer as seen on the LEDC channel: notes change on
+// their deadlines from handleBuzzer(), patterns queue back to back, and a late
+// loop() does not stretch a pattern.
+
+#include "hostTest.h"
+#include "deviceFixture.h"
+#include "buzzer.h"
+
+// Runs loop()-style polling every stepMs until the queue drains.
+static void drain(unsigned long stepMs) {
+    while (buzzerBusy()) {
+        fakeAdvanceMillis(stepMs);
+        handleBuzzer();
+    }
+}
+
+static void testMaintenanceTimeline() {
+    fakeReset();
+    initBuzzer();
+    size_t first = fakeTones().size();
+    unsigned long long t0 = fakeMicros();
+    CHECK(playBuzzerPattern(BUZZER_MAINTENANCE));
+    CHECK_EQ(fakeMicros(), t0);
+    drain(1);
+
+    const std::vector<FakeTone>& tones = fakeTones();
+    CHECK_EQ(tones.size() - first, 8);
+    unsigned int expectHz[] = {784, 0, 784, 0, 784, 0, 784, 0};
+    unsigned long expectMs[] = {0, 1000, 1250, 2250, 2500, 3500, 3750, 5000};
+    for (size_t i = 0; i < 8 && first + i < tones.size(); i++) {
+        CHECK_EQ(tones[first + i].freqHz, expectHz[i]);
+        CHECK_EQ((tones[first + i].atUs - t0) / 1000, expectMs[i]);
+        CHECK_EQ(tones[first + i].channel, BUZZER_LEDC_CHANNEL);
+    }
+    CHECK_EQ(buzzerPatternMs(BUZZER_MAINTENANCE), 5000);
+}
+
+static void testPatternsQueue() {
+    fakeReset();
+    initBuzzer();
+    for (int i = 0; i < BUZZER_QUEUE; i++) CHECK(playBuzzerPattern(BUZZER_ACK));
+    CHECK(!playBuzzerPattern(BUZZER_ERROR));
+    unsigned long long t0 = fakeMicros();
+    drain(1);
+    CHECK_EQ((fakeMicros() - t0) / 1000, BUZZER_QUEUE * buzzerPatternMs(BUZZER_ACK));
+    CHECK_EQ(fakeTones().back().freqHz, 0);
+}
+
+static void testLateLoopKeepsPatternLength() {
+    fakeReset();
+    initBuzzer();
+    unsigned long long t0 = fakeMicros();
+    playBuzzerPattern(BUZZER_ERROR);
+    fakeAdvanceMillis(230); // one slow loop() past the first note
+    handleBuzzer();
+    drain(1);
+    CHECK_EQ((fakeTones().back().atUs - t0) / 1000, buzzerPatternMs(BUZZER_ERROR));
+}
+
+int main() {
+    RUN_TEST(testMaintenanceTimeline);
+    RUN_TEST(testPatternsQueue);
+    RUN_TEST(testLateLoopKeepsPatternLength);
+    return hostTestResult();
+}
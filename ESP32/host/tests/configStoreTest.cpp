@@ -0,0 +1,250 @@
+// The cached config store: NVS is read once at boot and never on a get,
+// changes go out together after a quiet period (bounded when they keep
+// coming), a bool, number or blob changed back costs no write, CONFIG_COMMIT_NOW
+// writes before returning, and power toggles on a running device no longer
+// open Preferences in the command path.
+
+#include <Preferences.h>
+#include "hostTest.h"
+#include "deviceFixture.h"
+#include "configStore.h"
+#include "deadlines.h"
+#include "FirestoreServices.h"
+#include "deviceState.h"
+
+void setup();
+void loop();
+
+static bool nvsBool(const char* space, const char* key, bool fallback) {
+    Preferences prefs;
+    prefs.begin(space, true);
+    bool value = prefs.getBool(key, fallback);
+    prefs.end();
+    return value;
+}
+
+static String nvsString(const char* space, const char* key) {
+    Preferences prefs;
+    prefs.begin(space, true);
+    String value = prefs.getString(key, "");
+    prefs.end();
+    return value;
+}
+
+// Runs the control deadlines for `ms` of virtual time, 100 ms at a time.
+static void runControlFor(unsigned long ms) {
+    for (unsigned long t = 0; t < ms; t += 100) {
+        fakeAdvanceMillis(100);
+        runDueDeadlines(controlDeadlines);
+    }
+}
+
+static void start() {
+    fakeReset();
+    fakeSetSerialEcho(false);
+    Preferences prefs;
+    prefs.begin("setup", false);
+    prefs.putString("ssid", "home");
+    prefs.putString("pass", "hunter22");
+    prefs.putBool("provisioned", true);
+    prefs.end();
+    prefs.begin("eco", false);
+    prefs.putBool("ecoCanTurnOn", false);
+    prefs.end();
+    loadConfigStore();
+    fakeStats = FakeStats();
+}
+
+static void testLoadsOnce() {
+    start();
+    CHECK(configBool(CONFIG_PROVISIONED));
+    CHECK(strcmp(configString(CONFIG_SSID), "home") == 0);
+    CHECK(strcmp(configString(CONFIG_PASS), "hunter22") == 0);
+    CHECK(strcmp(configString(CONFIG_NAME), "") == 0);
+    CHECK(!configBool(CONFIG_ECO_CAN_TURN_ON));
+    for (int i = 0; i < 100; i++) configBool(CONFIG_ECO_CAN_TURN_ON);
+    CHECK_EQ(fakeStats.nvsOpens, 0);
+    CHECK_EQ(fakeStats.nvsReads, 0);
+}
+
+static void testCommitsAfterQuietPeriod() {
+    start();
+    ConfigStoreStats before = configStoreStats();
+    setConfigBool(CONFIG_ECO_CAN_TURN_ON, true);
+    runControlFor(3000);
+    setConfigString(CONFIG_NAME, "Bedroom");
+    setConfigString(CONFIG_NAME, "Bedroom"); // unchanged, not dirty again
+    runControlFor(CONFIG_COMMIT_DELAY_MS - 500);
+    CHECK_EQ(fakeStats.nvsWrites, 0);
+    CHECK(configDirty());
+    runControlFor(1000);
+    CHECK(!configDirty());
+    CHECK_EQ(fakeStats.nvsWrites, 2);
+    CHECK_EQ(fakeStats.nvsOpens, 2); // one session for "setup", one for "eco"
+    CHECK_EQ(configStoreStats().commits - before.commits, 1);
+    CHECK(nvsBool("eco", "ecoCanTurnOn", false));
+    CHECK(nvsString("setup", "name") == "Bedroom");
+}
+
+static void testFlipBackWritesNothing() {
+    start();
+    ConfigStoreStats before = configStoreStats();
+    setConfigBool(CONFIG_ECO_CAN_TURN_ON, true);
+    setConfigBool(CONFIG_ECO_CAN_TURN_ON, false);
+    setConfigBool(CONFIG_ECO_CAN_TURN_ON, true);
+    setConfigBool(CONFIG_ECO_CAN_TURN_ON, false);
+    runControlFor(CONFIG_COMMIT_DELAY_MS + 1000);
+    CHECK(!configDirty());
+    CHECK_EQ(fakeStats.nvsOpens, 0);
+    CHECK_EQ(fakeStats.nvsWrites, 0);
+    CHECK_EQ(configStoreStats().unchanged - before.unchanged, 1);
+}
+
+static void testCommitDelayIsBounded() {
+    start();
+    // A change every 2 s never leaves a quiet period.
+    unsigned long long firstAt = fakeMicros();
+    unsigned long long committedAt = 0;
+    for (int i = 0; i < 60 && !committedAt; i++) {
+        setConfigString(CONFIG_NAME, String(i).c_str());
+        for (int step = 0; step < 20 && !committedAt; step++) {
+            runControlFor(100);
+            if (fakeStats.nvsOpens) committedAt = fakeMicros();
+        }
+    }
+    CHECK(committedAt != 0);
+    CHECK(committedAt - firstAt <= (CONFIG_COMMIT_MAX_MS + 100) * 1000ULL);
+    CHECK(nvsString("setup", "name") != "");
+}
+
+static void testCommitNow() {
+    start();
+    setConfigString(CONFIG_LAN_TOKEN, "Zk3q8Hd2kPz0bXvLm4T9wY", CONFIG_COMMIT_NOW);
+    CHECK(!configDirty());
+    CHECK_EQ(fakeStats.nvsWrites, 1);
+    CHECK(nvsString("lan", "token") == "Zk3q8Hd2kPz0bXvLm4T9wY");
+    // A pending change goes with it.
+    setConfigBool(CONFIG_ECO_CAN_TURN_ON, true);
+    flushConfigStore();
+    CHECK(nvsBool("eco", "ecoCanTurnOn", false));
+}
+
+static void testPowerTogglesStayOffFlash() {
+    fakeReset();
+    fakeSetSerialEcho(false);
+    fakeSetWallClock(1752468900);
+    seedFixtureDevice("Custom");
+    setup();
+    fakeStartLoopTask(loop);
+    fakeRunTasksFor(5000);
+    fakeRunTasksFor(CONFIG_COMMIT_DELAY_MS + 1000); // the first state snapshot
+    fakeStats = FakeStats();
+
+    // On, off and on again within the commit delay: nothing is written from
+    // the command path, eco is back where NVS has it, and only the state
+    // snapshot (the AC is on now) is committed.
+    for (int i = 0; i < 3; i++) {
+        fakePushCommand(fixtureCommand("switch_power"));
+        fakeRunTasksFor(1000);
+    }
+    CHECK_EQ(fakeStats.nvsOpens, 0);
+    fakeRunTasksFor(CONFIG_COMMIT_DELAY_MS + 1000);
+    CHECK_EQ(fakeStats.nvsWrites, 1);
+    CHECK_EQ(fakeStats.nvsOpens, 1);
+
+    fakeStats = FakeStats();
+    fakePushCommand(fixtureCommand("switch_power")); // off: eco may not turn it back on
+    fakeRunTasksFor(1000);
+    CHECK_EQ(fakeStats.nvsWrites, 0);
+    fakeRunTasksFor(CONFIG_COMMIT_DELAY_MS);
+    CHECK_EQ(fakeStats.nvsWrites, 2); // eco and the snapshot, in one commit
+    CHECK(!nvsBool("eco", "ecoCanTurnOn", true));
+}
+
+// The snapshot of the state is a blob: read back only at its own size, and
+// one that ends up as NVS has it is not written.
+static void testStateBlob() {
+    start();
+    uint32_t value = 0;
+    CHECK(!configBytes(CONFIG_LAST_STATE, &value, sizeof(value)));
+    uint32_t saved = 0xB0071234;
+    setConfigBytes(CONFIG_LAST_STATE, &saved, sizeof(saved));
+    runControlFor(CONFIG_COMMIT_DELAY_MS + 1000);
+    CHECK_EQ(fakeStats.nvsWrites, 1);
+
+    loadConfigStore();
+    CHECK(configBytes(CONFIG_LAST_STATE, &value, sizeof(value)));
+    CHECK(value == saved);
+    uint16_t shorter;
+    CHECK(!configBytes(CONFIG_LAST_STATE, &shorter, sizeof(shorter)));
+
+    uint32_t changed = 1;
+    setConfigBytes(CONFIG_LAST_STATE, &changed, sizeof(changed));
+    setConfigBytes(CONFIG_LAST_STATE, &saved, sizeof(saved));
+    runControlFor(CONFIG_COMMIT_DELAY_MS + 1000);
+    CHECK_EQ(fakeStats.nvsWrites, 1);
+}
+
+// Numbers read 0 until set, and one set back to what NVS has is not written.
+static void testNumbers() {
+    start();
+    CHECK_EQ(configNumber(CONFIG_AIR_BASELINE), 0);
+    setConfigNumber(CONFIG_AIR_BASELINE, 0x9A3C, CONFIG_COMMIT_NOW);
+    CHECK_EQ(fakeStats.nvsWrites, 1);
+    loadConfigStore();
+    CHECK_EQ(configNumber(CONFIG_AIR_BASELINE), 0x9A3C);
+    setConfigNumber(CONFIG_AIR_BASELINE, 1);
+    setConfigNumber(CONFIG_AIR_BASELINE, 0x9A3C);
+    runControlFor(CONFIG_COMMIT_DELAY_MS + 1000);
+    CHECK_EQ(fakeStats.nvsWrites, 1);
+}
+
+// A factory reset leaves nothing of the previous owner: the saved state
+// would otherwise win over the model the next owner provisions.
+static void testResetForgetsPreviousOwner() {
+    saveLastState();
+    flushConfigStore();
+    Preferences prefs;
+    prefs.begin("state", true);
+    CHECK(prefs.isKey("last"));
+    prefs.end();
+    setConfigBool(CONFIG_ECO_CAN_TURN_ON, true); // pending, dropped with the rest
+
+    bool restarted = false;
+    try {
+        resetDevice();
+    } catch (const FakeRestart&) {
+        restarted = true;
+    }
+    CHECK(restarted);
+    CHECK(!configDirty());
+    CHECK(!configBool(CONFIG_PROVISIONED));
+    CHECK(strcmp(configString(CONFIG_MODEL), "") == 0);
+    prefs.begin("state", true);
+    CHECK(!prefs.isKey("last"));
+    prefs.end();
+    CHECK(!nvsBool("setup", "provisioned", false));
+    CHECK(configBool(CONFIG_ECO_CAN_TURN_ON)); // the default again
+    CHECK(nvsBool("eco", "ecoCanTurnOn", true));
+
+    // Provisioned again by the next owner, with another model.
+    setConfigString(CONFIG_MODEL, "LG");
+    setConfigBool(CONFIG_PROVISIONED, true, CONFIG_COMMIT_NOW);
+    loadConfigStore();
+    model = MODEL_CUSTOM;
+    restoreCachedState();
+    CHECK_EQ(model, MODEL_LG);
+}
+
+int main() {
+    RUN_TEST(testLoadsOnce);
+    RUN_TEST(testCommitsAfterQuietPeriod);
+    RUN_TEST(testFlipBackWritesNothing);
+    RUN_TEST(testCommitDelayIsBounded);
+    RUN_TEST(testCommitNow);
+    RUN_TEST(testStateBlob);
+    RUN_TEST(testNumbers);
+    RUN_TEST(testPowerTogglesStayOffFlash);
+    RUN_TEST(testResetForgetsPreviousOwner);
+    return hostTestResult();
+}
@@ -0,0 +1,106 @@
+// The deadline queue: jobs run earliest first and only once due, re-arming
+// moves a job, periodic jobs keep their phase when run late and skip runs
+// they fell too far behind on, and lateness is recorded per job.
+
+#include "hostTest.h"
+#include "deviceFixture.h"
+#include "deadlines.h"
+
+static char order[16];
+static int orderLen = 0;
+
+static void runA() { order[orderLen++] = 'a'; }
+static void runB() { order[orderLen++] = 'b'; }
+static void runC() { order[orderLen++] = 'c'; }
+
+static DeadlineQueue queue = {"test"};
+static Deadline jobA = {"a", runA};
+static Deadline jobB = {"b", runB};
+static Deadline jobC = {"c", runC};
+
+static void start() {
+    fakeReset();
+    fakeSetSerialEcho(false);
+    cancelDeadline(jobA);
+    cancelDeadline(jobB);
+    cancelDeadline(jobC);
+    jobA.periodMs = jobB.periodMs = jobC.periodMs = 0;
+    jobA.stats = jobB.stats = jobC.stats = DeadlineStats();
+    orderLen = 0;
+}
+
+static void testRunsEarliestFirst() {
+    start();
+    CHECK_EQ(deadlineDueInMs(queue), DEADLINE_IDLE_MS);
+    armDeadline(queue, jobA, 300);
+    armDeadline(queue, jobB, 100);
+    armDeadline(queue, jobC, 200);
+    CHECK_EQ(deadlineDueInMs(queue), 100);
+    runDueDeadlines(queue);
+    CHECK_EQ(orderLen, 0);
+    fakeAdvanceMillis(250);
+    runDueDeadlines(queue);
+    CHECK_EQ(orderLen, 2);
+    CHECK(order[0] == 'b' && order[1] == 'c');
+    CHECK_EQ(deadlineDueInMs(queue), 50);
+    CHECK(!deadlineArmed(jobB));
+    CHECK(deadlineArmed(jobA));
+}
+
+static void testRearmAndCancel() {
+    start();
+    armDeadline(queue, jobA, 100);
+    armDeadline(queue, jobB, 200);
+    armDeadline(queue, jobA, 500); // moves, does not duplicate
+    CHECK_EQ(deadlineDueInMs(queue), 200);
+    cancelDeadline(jobB);
+    CHECK_EQ(deadlineDueInMs(queue), 500);
+    fakeAdvanceMillis(1000);
+    runDueDeadlines(queue);
+    CHECK_EQ(orderLen, 1);
+    CHECK(order[0] == 'a');
+    CHECK_EQ(deadlineDueInMs(queue), DEADLINE_IDLE_MS);
+}
+
+static void testPeriodicKeepsPhase() {
+    start();
+    jobA.periodMs = 1000;
+    armDeadline(queue, jobA, 1000);
+    fakeAdvanceMillis(1030); // 30 ms late
+    runDueDeadlines(queue);
+    CHECK_EQ(deadlineDueInMs(queue), 970);
+    fakeAdvanceMillis(970);
+    runDueDeadlines(queue);
+    CHECK_EQ(jobA.stats.runs, 2);
+    CHECK_EQ(jobA.stats.lateMaxMs, 30);
+    CHECK_EQ(jobA.stats.jitterMaxMs, 30);
+    // Three periods behind: one run, then back on a period from now.
+    fakeAdvanceMillis(3500);
+    runDueDeadlines(queue);
+    CHECK_EQ(jobA.stats.runs, 3);
+    CHECK_EQ(deadlineDueInMs(queue), 1000);
+}
+
+static Deadline selfArming = {"self"};
+static void rearmNow() {
+    order[orderLen++] = 's';
+    armDeadline(queue, selfArming, 0);
+}
+
+static void testSelfRearmDoesNotSpin() {
+    start();
+    selfArming.run = rearmNow;
+    armDeadline(queue, selfArming, 0);
+    runDueDeadlines(queue);
+    CHECK_EQ(orderLen, 1);
+    CHECK_EQ(deadlineDueInMs(queue), 0);
+    cancelDeadline(selfArming);
+}
+
+int main() {
+    RUN_TEST(testRunsEarliestFirst);
+    RUN_TEST(testRearmAndCancel);
+    RUN_TEST(testPeriodicKeepsPhase);
+    RUN_TEST(testSelfRearmDoesNotSpin);
+    return hostTestResult();
+}
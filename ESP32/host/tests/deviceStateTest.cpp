@@ -0,0 +1,50 @@
+// RTDB string <-> enum conversion for the device state.
+
+#include "hostTest.h"
+#include "deviceState.h"
+
+static void testNamesRoundTrip() {
+    for (uint8_t m = 0; m < AC_MODES; m++) {
+        AcMode parsed = AC_MODES;
+        CHECK(parseAcMode(acModeName((AcMode)m), parsed));
+        CHECK_EQ(parsed, m);
+    }
+    for (uint8_t f = 0; f < IDLE_FLAGS; f++) {
+        IdleFlag parsed = IDLE_FLAGS;
+        CHECK(parseIdleFlag(idleFlagName((IdleFlag)f), parsed));
+        CHECK_EQ(parsed, f);
+    }
+    for (uint8_t m = 0; m < AC_MODELS; m++) {
+        AcModel parsed = AC_MODELS;
+        CHECK(parseAcModel(acModelName((AcModel)m), parsed));
+        CHECK_EQ(parsed, m);
+    }
+}
+
+static void testUnknownNamesAreRejected() {
+    AcMode mode = MODE_ECO;
+    CHECK(!parseAcMode("turbo", mode));
+    CHECK(!parseAcMode("Eco", mode)); // the app writes modes in lower case
+    CHECK(!parseAcMode(nullptr, mode));
+    CHECK_EQ(mode, MODE_ECO);
+    IdleFlag flag = IDLE_CONTINUE;
+    CHECK(!parseIdleFlag("", flag));
+    CHECK_EQ(flag, IDLE_CONTINUE);
+}
+
+static void testModelIgnoresCase() {
+    AcModel model = MODEL_ELECTRA;
+    CHECK(parseAcModel("custom", model));
+    CHECK_EQ(model, MODEL_CUSTOM);
+    CHECK(parseAcModel("lg", model));
+    CHECK_EQ(model, MODEL_LG);
+    CHECK(!parseAcModel("Daikin", model));
+    CHECK_EQ(model, MODEL_LG);
+}
+
+int main() {
+    RUN_TEST(testNamesRoundTrip);
+    RUN_TEST(testUnknownNamesAreRejected);
+    RUN_TEST(testModelIgnoresCase);
+    return hostTestResult();
+}
@@ -0,0 +1,84 @@
+// The task split: commands reach the IR LED while the network task is stuck
+// in a round trip, cloud writes still land in order, unknown commands report
+// failure, and schedules fetched by the network task are applied by the
+// control task. The firmware's queues and
+// tasks live for the whole process, so the device boots once and every test
+// runs against it.
+
+#include "hostTest.h"
+#include "deviceFixture.h"
+#include "deviceTasks.h"
+#include "scheduleEngine.h"
+
+void setup();
+void loop();
+
+static void bootDevice() {
+    fakeReset();
+    fakeSetSerialEcho(false);
+    fakeSetWallClock(1752468900);
+    seedFixtureDevice("Custom");
+    setup();
+    fakeStartLoopTask(loop);
+    fakeRunTasksFor(5000); // through the cloud bring-up
+}
+
+static void testIrIsNotHeldByRoundTrips() {
+    fakeSetRtdbLatencyMs(2000); // a very slow TLS round trip
+    fakePushCommand(fixtureCommand("temp_up"));   // result write keeps the network task busy
+    unsigned long long second = fakeMicros() + 500000ULL;
+    fakePushCommandAt(fixtureCommand("temp_down"), second);
+    second = fakeRadioDeliverAt(second); // held by the AP until the next beacon
+    size_t frames = fakeIrFrames().size();
+    fakeRunTasksUntil(second + 1000);
+    CHECK_EQ(fakeIrFrames().size(), frames + 2);
+    CHECK(fakeIrFrames().back().atUs <= second + 1000);
+    fakeSetRtdbLatencyMs(kFakeRtdbLatencyMs);
+    fakeRunTasksFor(10000); // let the slow writes drain
+}
+
+static void testResultsReachTheCloud() {
+    FirebaseJson cleared;
+    cleared.set("result", "pending");
+    fakeRtdbSeed(kFixtureDevicePath, cleared);
+    fakePushCommand(fixtureCommand("switch_lights"));
+    fakeRunTasksFor(1000);
+    FirebaseJsonData result;
+    CHECK(fakeRtdbGet(String(kFixtureDevicePath) + "/result", result));
+    CHECK(result.stringValue == "Success");
+}
+
+static void testUnknownCommandsFail() {
+    FirebaseJson commands[2] = {fixtureCommand("open_window"), fixtureModeCommand("turbo")};
+    for (int i = 0; i < 2; i++) {
+        FirebaseJson cleared;
+        cleared.set("result", "pending");
+        fakeRtdbSeed(kFixtureDevicePath, cleared);
+        fakePushCommand(commands[i]);
+        fakeRunTasksFor(1000);
+        FirebaseJsonData result;
+        fakeRtdbGet(String(kFixtureDevicePath) + "/result", result);
+        CHECK(result.stringValue == "Failed");
+    }
+    CHECK(mode == MODE_REGULAR);
+}
+
+static void testScheduleFetchIsAppliedByControl() {
+    FirebaseJson edit;
+    edit.set("schedule/monday/start", 900);
+    fakeRtdbSeed(kFixtureDevicePath, edit);
+    fakePushCommand(fixtureCommand("apply_schedule"));
+    fakeRunTasksFor(1000);
+    CHECK_EQ(schedule.mon.count, 1);
+    CHECK_EQ(schedule.mon.intervals[0].start, 900);
+    CHECK_EQ(scheduleEventCount(), 10); // Monday to Friday, on and off
+}
+
+int main() {
+    bootDevice();
+    RUN_TEST(testIrIsNotHeldByRoundTrips);
+    RUN_TEST(testResultsReachTheCloud);
+    RUN_TEST(testUnknownCommandsFail);
+    RUN_TEST(testScheduleFetchIsAppliedByControl);
+    return hostTestResult();
+}
@@ -0,0 +1,37 @@
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+
+// Minimal assertion helpers for the host test executables.
+inline int hostTestFailures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            hostTestFailures++; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(a, b) \
+    do { \
+        long long va_ = (long long)(a), vb_ = (long long)(b); \
+        if (va_ != vb_) { \
+            fprintf(stderr, "%s:%d: CHECK_EQ failed: %s (%lld) != %s (%lld)\n", __FILE__, __LINE__, #a, va_, #b, vb_); \
+            hostTestFailures++; \
+        } \
+    } while (0)
+
+#define RUN_TEST(fn) \
+    do { \
+        int before_ = hostTestFailures; \
+        fn(); \
+        printf("%s %s\n", hostTestFailures == before_ ? "[ OK ]" : "[FAIL]", #fn); \
+    } while (0)
+
+inline int hostTestResult() {
+    return hostTestFailures == 0 ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,113 @@
+// Round trips, corruption handling and legacy migration of the binary IR
+// code store, its size against the old comma-separated format, and the
+// RAM frame cache.
+
+#include "hostTest.h"
+#include "deviceFixture.h"
+
+static String toCsv(const uint16_t* ticks, uint16_t n) {
+    String csv;
+    for (uint16_t i = 0; i < n; i++) {
+        if (i) csv += ",";
+        csv += String(ticks[i] * kRawTick);
+    }
+    return csv;
+}
+
+static void testRoundTrip() {
+    uint16_t ticks[IR_CAPTURE_BUFFER];
+    uint16_t n = fixtureFrameTicks(7, ticks);
+    uint8_t code[IR_CODE_MAX_BYTES];
+    size_t len = encodeIrCode(ticks, n, kRawTick, IR_CARRIER_KHZ, code, sizeof(code));
+    CHECK(len > IR_CODE_HEADER_SIZE);
+
+    uint16_t us[IR_CAPTURE_BUFFER];
+    uint8_t khz = 0;
+    CHECK_EQ(decodeIrCode(code, len, us, IR_CAPTURE_BUFFER, &khz), n);
+    CHECK_EQ(khz, IR_CARRIER_KHZ);
+    for (uint16_t i = 0; i < n; i++) CHECK_EQ(us[i], ticks[i] * kRawTick);
+}
+
+static void testRejectsCorruptCodes() {
+    uint16_t ticks[IR_CAPTURE_BUFFER];
+    uint16_t n = fixtureFrameTicks(9, ticks);
+    uint8_t code[IR_CODE_MAX_BYTES];
+    size_t len = encodeIrCode(ticks, n, kRawTick, IR_CARRIER_KHZ, code, sizeof(code));
+    uint16_t us[IR_CAPTURE_BUFFER];
+
+    CHECK_EQ(decodeIrCode(code, len - 1, us, IR_CAPTURE_BUFFER, nullptr), 0);
+    CHECK_EQ(decodeIrCode(code, len, us, n - 1, nullptr), 0);
+    code[0] = IR_CODE_VERSION + 1;
+    CHECK_EQ(decodeIrCode(code, len, us, IR_CAPTURE_BUFFER, nullptr), 0);
+    CHECK_EQ(encodeIrCode(ticks, n, kRawTick, IR_CARRIER_KHZ, code, 16), 0);
+}
+
+static void testMigratesLegacyCsv() {
+    fakeReset();
+    fakeSetSerialEcho(false);
+    uint16_t ticks[IR_CAPTURE_BUFFER];
+    uint16_t n = fixtureFrameTicks(11, ticks);
+    Preferences prefs;
+    prefs.begin("setup", false);
+    prefs.putString("on", toCsv(ticks, n));
+    prefs.end();
+
+    uint16_t us[IR_CAPTURE_BUFFER];
+    CHECK_EQ(loadIrCode("on", us, IR_CAPTURE_BUFFER, nullptr), n);
+    for (uint16_t i = 0; i < n; i++) CHECK_EQ(us[i], ticks[i] * kRawTick);
+
+    prefs.begin("setup", true);
+    CHECK(prefs.getBytesLength("on") > 0);
+    CHECK(prefs.getString("on", "").isEmpty());
+    prefs.end();
+    unsigned long writes = fakeStats.nvsWrites;
+    CHECK_EQ(loadIrCode("on", us, IR_CAPTURE_BUFFER, nullptr), n);
+    CHECK_EQ(fakeStats.nvsWrites, writes);
+}
+
+static void testLongFramesFitNvs() {
+    // Two back-to-back 224-bit frames, the size of the longer AC protocols.
+    uint16_t ticks[IR_CAPTURE_BUFFER];
+    uint16_t n = fixtureFrameTicks(13, ticks, 224);
+    n += fixtureFrameTicks(14, ticks + n, 224);
+    uint8_t code[IR_CODE_MAX_BYTES];
+    size_t len = encodeIrCode(ticks, n, kRawTick, IR_CARRIER_KHZ, code, sizeof(code));
+    size_t csvLen = toCsv(ticks, n).length();
+    printf("       %u timings: csv %u bytes, binary %u bytes (%.1f%%)\n", n, (unsigned)csvLen,
+           (unsigned)len, 100.0 * len / csvLen);
+    CHECK(len > 0);
+    CHECK(len * 2 < csvLen);
+    CHECK(len < 4000);   // NVS string values top out at 4000 bytes
+}
+
+static void testFrameCacheFollowsRelearn() {
+    fakeReset();
+    fakeSetSerialEcho(false);
+    uint16_t ticks[IR_CAPTURE_BUFFER];
+    uint16_t n = fixtureFrameTicks(21, ticks);
+    saveIrCode("tempUp", ticks, n, kRawTick);
+    loadIrFrames();
+
+    unsigned long reads = fakeStats.nvsReads;
+    const IrFrame* frame = getIrFrame(IR_FRAME_TEMP_UP);
+    CHECK(frame != nullptr);
+    CHECK_EQ(frame->count, n);
+    CHECK(getIrFrame(IR_FRAME_TEMP_DOWN) == nullptr);
+    CHECK_EQ(fakeStats.nvsReads, reads);
+
+    uint16_t shorter = fixtureFrameTicks(22, ticks, 32);
+    saveIrCode("tempUp", ticks, shorter, kRawTick);
+    frame = getIrFrame(IR_FRAME_TEMP_UP);
+    CHECK(frame != nullptr);
+    CHECK_EQ(frame->count, shorter);
+    CHECK_EQ(frame->timings[0], ticks[0] * kRawTick);
+}
+
+int main() {
+    RUN_TEST(testRoundTrip);
+    RUN_TEST(testRejectsCorruptCodes);
+    RUN_TEST(testMigratesLegacyCsv);
+    RUN_TEST(testLongFramesFitNvs);
+    RUN_TEST(testFrameCacheFollowsRelearn);
+    return hostTestResult();
+}
@@ -0,0 +1,60 @@
+// The RMT transmit queue: frames go out without holding the caller, queue
+// behind the one on air, and report completion from handleIrTransmitter().
+
+#include "hostTest.h"
+#include "deviceFixture.h"
+#include "irTransmitter.h"
+
+static int doneCalls = 0;
+static void countDone(void* arg) { doneCalls += *(int*)arg; }
+
+static void testSendDoesNotBlock() {
+    fakeReset();
+    fakeSetSerialEcho(false);
+    initIrTransmitter();
+    uint16_t timings[] = {9000, 4500, 560, 1690, 560};
+    unsigned long long t0 = fakeMicros();
+    CHECK(irTransmit(timings, 5, IR_CARRIER_KHZ, 40000));
+    CHECK_EQ(fakeMicros(), t0);
+    CHECK_EQ(fakeIrFrames().size(), 1);
+    CHECK_EQ(fakeIrFrames()[0].airTimeUs, 9000 + 4500 + 560 + 1690 + 560 + 40000);
+    CHECK(irTransmitterBusy());
+    waitIrTransmitter();
+    CHECK(!irTransmitterBusy());
+}
+
+static void testQueuesBehindFrameOnAir() {
+    fakeReset();
+    fakeSetSerialEcho(false);
+    uint16_t timings[] = {9000, 4500, 560};
+    int weight = 1;
+    doneCalls = 0;
+    for (int i = 0; i < IR_TX_QUEUE; i++) CHECK(irTransmit(timings, 3, IR_CARRIER_KHZ, 1000, countDone, &weight));
+    CHECK(!irTransmit(timings, 3, IR_CARRIER_KHZ));
+    CHECK_EQ(fakeIrFrames().size(), 1);
+
+    handleIrTransmitter();
+    CHECK_EQ(doneCalls, 0);
+    fakeAdvanceMicros(9000 + 4500 + 560 + 1000);
+    handleIrTransmitter();
+    CHECK_EQ(doneCalls, 1);
+    CHECK_EQ(fakeIrFrames().size(), 2);
+    waitIrTransmitter();
+    CHECK_EQ(doneCalls, 2);
+}
+
+static void testLongGapsAreSplit() {
+    fakeReset();
+    fakeSetSerialEcho(false);
+    uint16_t timings[] = {3000, 65000, 3000};
+    CHECK(irTransmit(timings, 3, IR_CARRIER_KHZ, 100000));
+    CHECK_EQ(fakeIrFrames().back().airTimeUs, 3000 + 65000 + 3000 + 100000);
+    waitIrTransmitter();
+}
+
+int main() {
+    RUN_TEST(testSendDoesNotBlock);
+    RUN_TEST(testQueuesBehindFrameOnAir);
+    RUN_TEST(testLongGapsAreSplit);
+    return hostTestResult();
+}
@@ -0,0 +1,173 @@
+// The JSON scanner on its own (paths, arrays, escapes, broken bodies) and
+// the device restoring its last state through it: only the parts it reads
+// come down, the heap holds no parsed tree, both schedule layouts load, a
+// journal from before the restart wins, and apply_schedule reads the
+// schedule alone.
+
+#include <string>
+#include <vector>
+#include "hostTest.h"
+#include "deviceFixture.h"
+#include "FirestoreServices.h"
+#include "bootReport.h"
+#include "jsonScan.h"
+#include "stateJournal.h"
+
+void setup();
+void loop();
+
+struct Seen {
+    std::string path;
+    JsonScanType type;
+    std::string text;
+};
+
+static void collect(const JsonScalar& value, void* context) {
+    ((std::vector<Seen>*)context)->push_back({value.path, value.type, std::string(value.text, value.len)});
+}
+
+static std::vector<Seen> scan(const char* text, const char* base = "", bool* ok = nullptr) {
+    std::vector<Seen> seen;
+    bool result = scanJson(text, base, collect, &seen);
+    if (ok) *ok = result;
+    return seen;
+}
+
+static void testPathsAndTypes() {
+    bool ok;
+    std::vector<Seen> seen = scan(" {\"model\": \"Electra\", \"testing\":false,\n \"hours\":12.5, \"gone\":null} ", "/config", &ok);
+    CHECK(ok);
+    CHECK_EQ(seen.size(), 4);
+    CHECK(seen[0].path == "/config/model" && seen[0].type == JSON_SCAN_STRING && seen[0].text == "Electra");
+    CHECK(seen[1].path == "/config/testing" && seen[1].type == JSON_SCAN_BOOL && seen[1].text == "false");
+    CHECK(seen[2].path == "/config/hours" && seen[2].type == JSON_SCAN_NUMBER && seen[2].text == "12.5");
+    CHECK(seen[3].type == JSON_SCAN_NULL);
+
+    seen = scan("{\"monday\":{\"intervals\":[{\"start\":480,\"end\":600},{\"start\":1320}],\"active\":true},\"empty\":{}}",
+                "/schedule", &ok);
+    CHECK(ok);
+    CHECK_EQ(seen.size(), 4);
+    CHECK(seen[0].path == "/schedule/monday/intervals/[0]/start");
+    CHECK(seen[2].path == "/schedule/monday/intervals/[1]/start");
+    CHECK(seen[3].path == "/schedule/monday/active");
+
+    seen = scan("42", "/status/currentTimer", &ok);
+    CHECK(ok && seen.size() == 1 && seen[0].path == "/status/currentTimer");
+}
+
+static void testValues() {
+    std::vector<Seen> seen;
+    scanJson("{\"a\":30.0,\"b\":-2,\"c\":true,\"d\":0,\"e\":\"tab\\there \\\"q\\\" \\u00e9\"}", "", collect, &seen);
+    JsonScalar value = {"", seen[0].type, seen[0].text.c_str(), seen[0].text.size()};
+    CHECK_EQ(jsonInt(value), 30);
+    value = {"", seen[1].type, seen[1].text.c_str(), seen[1].text.size()};
+    CHECK(jsonFloat(value) == -2.0f);
+    value = {"", seen[2].type, seen[2].text.c_str(), seen[2].text.size()};
+    CHECK(jsonBool(value) && jsonInt(value) == 1);
+    value = {"", seen[3].type, seen[3].text.c_str(), seen[3].text.size()};
+    CHECK(!jsonBool(value));
+    value = {"", seen[4].type, seen[4].text.c_str(), seen[4].text.size()};
+    char text[32];
+    CHECK_EQ(jsonString(value, text, sizeof(text)), 14);
+    CHECK(strcmp(text, "tab\there \"q\" \xe9") == 0);
+    CHECK_EQ(jsonString(value, text, 4), 3); // cut to fit
+    CHECK(strcmp(text, "tab") == 0);
+}
+
+static void testBrokenBodies() {
+    bool ok;
+    std::vector<Seen> seen = scan("{\"a\":1,\"b\":", "", &ok);
+    CHECK(!ok);
+    CHECK_EQ(seen.size(), 1); // what came before the error
+    scan("{\"a\":1} trailing", "", &ok);
+    CHECK(!ok);
+    scan("{\"a\":\"open", "", &ok);
+    CHECK(!ok);
+    scan("[[[[[[[[[[1]]]]]]]]]]", "", &ok);
+    CHECK(!ok); // past JSON_SCAN_MAX_DEPTH
+    std::string key(JSON_SCAN_MAX_PATH, 'k');
+    scan(("{\"" + key + "\":1}").c_str(), "", &ok);
+    CHECK(!ok);
+}
+
+// Boots once against a node holding more than the device reads, with a
+// journal left by the previous run.
+static void bootDevice() {
+    fakeReset();
+    fakeSetSerialEcho(false);
+    fakeSetWallClock(1752468900);
+    seedFixtureDevice("Electra");
+    FirebaseJson node;
+    node.set("status/lightsOn", true);
+    node.set("status/currentTimer", 45);
+    node.set("schedule/monday/intervals/[0]/start", 700);
+    node.set("schedule/monday/intervals/[0]/end", 900);
+    node.set("schedule/monday/intervals/[1]/start", 1800);
+    node.set("schedule/monday/intervals/[1]/end", 2200);
+    for (int hour = 0; hour < 24 * 7; hour++) {
+        node.set("history/" + String(1752000000L + hour * 3600L), String("QUJDREVGR0hJSktMTU5PUFFSU1RVVldYWVo="));
+    }
+    fakeRtdbSeed(kFixtureDevicePath, node);
+
+    initStateJournal();
+    NetRequest journaled = {};
+    journaled.op = NET_SET_FLOAT;
+    snprintf(journaled.path, sizeof(journaled.path), "/maintenance/totalHours");
+    journaled.f = 12.75f;
+    journalWrite(journaled);
+
+    fakeStats = FakeStats();
+    fakeResetHeapPeak();
+    setup();
+    fakeStartLoopTask(loop);
+    // Checked before the schedule, once the clock is set, changes anything.
+    while (!bootReached(BOOT_CLOUD_STATE)) fakeRunTasksFor(10);
+}
+
+static void testBootReadsOnlyTheState() {
+    CHECK_EQ(fakeStats.jsonGets, 0);
+    CHECK(fakeStats.rtdbBytesDown < 2000); // the history alone is over 8 kB
+    CHECK(fakeHeapPeak() < 1024);
+    CHECK(model == MODEL_ELECTRA);
+    CHECK(lights_on);
+    CHECK_EQ(duration, 45);
+    CHECK(totalHours == 12.75f); // from the journal
+
+    CHECK(schedule.mon.active);
+    CHECK_EQ(schedule.mon.count, 2);
+    CHECK_EQ(schedule.mon.intervals[1].start, 1800);
+    CHECK_EQ(schedule.mon.intervals[1].end, 2200);
+    CHECK(!schedule.sun.active);
+    CHECK_EQ(schedule.tue.count, 1); // the old single start/end
+    CHECK_EQ(schedule.tue.intervals[0].start, 800);
+    CHECK_EQ(schedule.tue.intervals[0].end, 1700);
+}
+
+static void testScheduleRefreshReadsTheSchedule() {
+    fakeRunTasksFor(5000);
+    FirebaseJson change;
+    change.set("schedule/sunday/active", true);
+    change.set("schedule/sunday/intervals/[0]/start", 1000);
+    change.set("schedule/sunday/intervals/[0]/end", 1100);
+    fakeRtdbSeed(kFixtureDevicePath, change);
+
+    unsigned long down = fakeStats.rtdbBytesDown;
+    fakeResetHeapPeak();
+    fakePushCommand(fixtureCommand("apply_schedule"));
+    fakeRunTasksFor(2000);
+    CHECK(fakeStats.rtdbBytesDown - down < 1024);
+    CHECK(fakeHeapPeak() < 1024);
+    CHECK(schedule.sun.active);
+    CHECK_EQ(schedule.sun.intervals[0].start, 1000);
+    CHECK_EQ(schedule.mon.count, 2);
+}
+
+int main() {
+    RUN_TEST(testPathsAndTypes);
+    RUN_TEST(testValues);
+    RUN_TEST(testBrokenBodies);
+    bootDevice();
+    RUN_TEST(testBootReadsOnlyTheState);
+    RUN_TEST(testScheduleRefreshReadsTheSchedule);
+    return hostTestResult();
+}
@@ -0,0 +1,201 @@
+// The LAN API in station mode: requests without the token are turned away,
+// an HTTP command takes the same path as one from the stream and reaches
+// the IR LED, a WebSocket client gets the state on login and every write
+// after it, and the device is announced over mDNS with its token in the
+// cloud, with a new token after a factory reset. The device boots once and
+// every test runs against it.
+
+#include "hostTest.h"
+#include "deviceFixture.h"
+#include "lanApi.h"
+#include "configStore.h"
+#include "FirestoreServices.h"
+
+void setup();
+void loop();
+
+static void bootDevice() {
+    fakeReset();
+    fakeSetSerialEcho(false);
+    fakeSetWallClock(1752468900);
+    seedFixtureDevice("Custom");
+    setup();
+    fakeStartLoopTask(loop);
+    fakeRunTasksFor(5000); // through the cloud bring-up
+}
+
+static const FakeLanReply* request(const char* method, const char* url, const String& token, const String& body) {
+    int id = fakeLanRequestAt(method, url, token, body, fakeMicros());
+    fakeRunTasksFor(500);
+    return fakeLanReply(id);
+}
+
+static bool receivedSince(int client, size_t from, const char* text) {
+    const std::vector<FakeWsMessage>& messages = fakeWsReceived(client);
+    for (size_t i = from; i < messages.size(); i++) {
+        if (strstr(messages[i].text.c_str(), text)) return true;
+    }
+    return false;
+}
+
+static void testAnnouncedWithToken() {
+    CHECK(fakeMdnsHostname() == "breezio-246f28aabbcc");
+    CHECK(fakeMdnsServices().size() == 1 && fakeMdnsServices()[0] == "_breezio._tcp:80");
+    CHECK_EQ(strlen(lanToken()), 22);
+    fakeRunTasksFor(60000); // the lazy writes ride along with the heartbeat
+    FirebaseJsonData stored;
+    CHECK(fakeRtdbGet(String(kFixtureDevicePath) + "/lan/token", stored));
+    CHECK(stored.stringValue == lanToken());
+    fakeRtdbGet(String(kFixtureDevicePath) + "/lan/host", stored);
+    CHECK(stored.stringValue == "breezio-246f28aabbcc");
+}
+
+static void testRejectsWithoutToken() {
+    size_t frames = fakeIrFrames().size();
+    unsigned long rejected = lanApiStats().rejected;
+    const FakeLanReply* reply = request("POST", "/command", "", "{\"action\":\"switch_power\"}");
+    CHECK(reply && reply->status == 401);
+    reply = request("POST", "/command", "not-the-token", "{\"action\":\"switch_power\"}");
+    CHECK(reply && reply->status == 401);
+    reply = request("GET", "/state", "", "");
+    CHECK(reply && reply->status == 401);
+    CHECK_EQ(lanApiStats().rejected - rejected, 3);
+    CHECK_EQ(fakeIrFrames().size(), frames);
+
+    int client = fakeWsOpen();
+    fakeWsSendAt(client, "{\"token\":\"guess\"}", fakeMicros());
+    fakeRunTasksFor(500);
+    CHECK(!fakeWsConnected(client));
+    CHECK(fakeWsReceived(client).empty());
+}
+
+static void testHttpCommandReachesIr() {
+    size_t frames = fakeIrFrames().size();
+    unsigned long long sentAt = fakeMicros();
+    const FakeLanReply* reply = request("POST", "/command", lanToken(), "{\"action\":\"switch_power\"}");
+    CHECK(reply && reply->status == 202);
+    CHECK_EQ(fakeIrFrames().size(), frames + 1);
+    // No cloud round trip in the way: on air within a beacon interval.
+    CHECK(fakeIrFrames().back().atUs - sentAt < kFakeDtimUs + 20000);
+
+    reply = request("POST", "/command", lanToken(), "{\"action\":");
+    CHECK(reply && reply->status == 400);
+    reply = request("GET", "/state", lanToken(), "");
+    CHECK(reply && reply->status == 200);
+    CHECK(strstr(reply->body.c_str(), "\"/result\":\"Success\""));
+}
+
+static void testSocketGetsStateAndPushes() {
+    int client = fakeWsOpen();
+    fakeWsSendAt(client, String("{\"token\":\"") + lanToken() + "\"}", fakeMicros());
+    fakeRunTasksFor(500);
+    CHECK(fakeWsConnected(client));
+    CHECK(fakeWsReceived(client).size() == 1 && fakeWsReceived(client)[0].text.startsWith("{\"/"));
+
+    size_t seen = fakeWsReceived(client).size();
+    size_t frames = fakeIrFrames().size();
+    fakeWsSendAt(client, "{\"action\":\"switch_lights\"}", fakeMicros());
+    fakeRunTasksFor(500);
+    CHECK(receivedSince(client, seen, "\"/result\":\"Success\""));
+    CHECK_EQ(fakeIrFrames().size(), frames);
+
+    // So are the results of cloud commands and the device's own writes.
+    seen = fakeWsReceived(client).size();
+    fakePushCommand(fixtureCommand("open_window"));
+    fakeRunTasksFor(500);
+    CHECK(receivedSince(client, seen, "\"/result\":\"Failed\""));
+    fakeSetRoom(27.5f, 61.0f);
+    fakeRunTasksFor(3 * 60000UL); // the sensor filters settle on the new room
+    fakeSetPin(PIRPIN, fakeGetPin(PIRPIN) == HIGH ? LOW : HIGH); // and motion sends them
+    fakeRunTasksFor(20000);
+    CHECK(receivedSince(client, seen, "\"/sensors/roomTemperature\":27.5"));
+    CHECK(receivedSince(client, seen, "\"/sensors/roomHumidity\":61"));
+    fakeWsClose(client);
+    fakeRunTasksFor(100);
+    CHECK(!fakeWsConnected(client));
+}
+
+static void testStaleSocketsMakeRoom() {
+    int idle[LAN_MAX_CLIENTS];
+    for (int& client : idle) client = fakeWsOpen();
+    fakeRunTasksFor(100);
+    int late = fakeWsOpen();
+    fakeRunTasksFor(100);
+    CHECK(!fakeWsConnected(late)); // all slots held, none old enough to evict
+
+    fakeRunTasksFor(LAN_AUTH_TIMEOUT_MS);
+    int client = fakeWsOpen();
+    fakeWsSendAt(client, String("{\"token\":\"") + lanToken() + "\"}", fakeMicros());
+    fakeRunTasksFor(500);
+    CHECK(fakeWsConnected(client));
+    CHECK(!fakeWsConnected(idle[0]));
+    for (int c : idle) fakeWsClose(c);
+    fakeWsClose(client);
+    fakeRunTasksFor(100);
+}
+
+// Every path filled with the longest string, each character escaped: the
+// state still comes back whole, and the values that fit are all there.
+static void testLongestStateFits() {
+    NetRequest r = {};
+    r.op = NET_SET_STRING;
+    memset(r.s, '"', sizeof(r.s) - 1);
+    for (int i = 0; i < LAN_STATE_PATHS; i++) {
+        snprintf(r.path, sizeof(r.path), "/status/longest%016d", i);
+        lanPublish(r);
+    }
+    const FakeLanReply* reply = request("GET", "/state", lanToken(), "");
+    CHECK(reply && reply->status == 200);
+    CHECK(reply->body.startsWith("{\"/") && reply->body.endsWith("\"}"));
+    String escaped = "\"";
+    for (size_t i = 0; i < sizeof(r.s) - 1; i++) escaped += "\\\"";
+    escaped += "\"";
+    CHECK(reply->body.indexOf(String("\"/status/longest") + "0000000000000000\":" + escaped) > 0);
+}
+
+// A factory reset forgets the token: the old one stops working at once,
+// and the next start after provisioning makes and publishes a new one.
+static void testResetMakesNewToken() {
+    String old = lanToken();
+    bool restarted = false;
+    try {
+        resetDevice();
+    } catch (const FakeRestart&) {
+        restarted = true;
+    }
+    CHECK(restarted);
+    CHECK_EQ(strlen(lanToken()), 0);
+    CHECK_EQ(strlen(configString(CONFIG_LAN_TOKEN)), 0);
+    Preferences prefs;
+    prefs.begin("lan", true);
+    CHECK(!prefs.isKey("token"));
+    prefs.end();
+    const FakeLanReply* reply = request("GET", "/state", old, "");
+    CHECK(reply && reply->status == 401);
+    reply = request("GET", "/state", "", "");
+    CHECK(reply && reply->status == 401);
+
+    setConfigBool(CONFIG_PROVISIONED, true, CONFIG_COMMIT_NOW);
+    startLanApi();
+    CHECK_EQ(strlen(lanToken()), 22);
+    CHECK(old != lanToken());
+    CHECK(strcmp(configString(CONFIG_LAN_TOKEN), lanToken()) == 0);
+    fakeRunTasksFor(60000);
+    FirebaseJsonData stored;
+    CHECK(fakeRtdbGet(String(kFixtureDevicePath) + "/lan/token", stored));
+    CHECK(stored.stringValue == lanToken());
+    reply = request("GET", "/state", lanToken(), "");
+    CHECK(reply && reply->status == 200);
+}
+
+int main() {
+    bootDevice();
+    RUN_TEST(testAnnouncedWithToken);
+    RUN_TEST(testRejectsWithoutToken);
+    RUN_TEST(testHttpCommandReachesIr);
+    RUN_TEST(testSocketGetsStateAndPushes);
+    RUN_TEST(testStaleSocketsMakeRoom);
+    RUN_TEST(testLongestStateFits);
+    RUN_TEST(testResetMakesNewToken);
+    return hostTestResult();
+}
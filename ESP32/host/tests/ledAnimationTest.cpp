@@ -0,0 +1,70 @@
+// LED effects advance from handleLedAnimation() on their deadlines instead of
+// delay()ing the caller.
+
+#include "hostTest.h"
+#include "deviceFixture.h"
+#include "ledAnimation.h"
+
+static Adafruit_NeoPixel testStrip(LED_PIXELS_NUM, LED_PIN, NEO_GRB + NEO_KHZ800);
+static const uint32_t kGreen = Adafruit_NeoPixel::Color(0, 255, 0);
+static const uint32_t kRed = Adafruit_NeoPixel::Color(255, 0, 0);
+
+static void settle() {
+    while (ledAnimationRunning()) {
+        fakeAdvanceMillis(10);
+        handleLedAnimation();
+    }
+}
+
+static void testWipeDoesNotBlock() {
+    fakeReset();
+    testStrip.clear();
+    initLedAnimation(testStrip);
+    unsigned long long t0 = fakeMicros();
+    startLedAnimation(LED_EFFECT_WIPE, kGreen);
+    CHECK(fakeMicros() - t0 < 1000);
+    CHECK_EQ(testStrip.getPixelColor(0), kGreen);
+    CHECK_EQ(testStrip.getPixelColor(1), 0);
+
+    handleLedAnimation();
+    CHECK_EQ(testStrip.getPixelColor(1), 0);
+    fakeAdvanceMillis(DELAYVAL);
+    handleLedAnimation();
+    CHECK_EQ(testStrip.getPixelColor(1), kGreen);
+    settle();
+    CHECK_EQ(testStrip.getPixelColor(LED_PIXELS_NUM - 1), kGreen);
+}
+
+static void testFadeBlendsFromCurrentColour() {
+    settle();
+    startLedAnimation(LED_EFFECT_FADE, kRed);
+    uint32_t first = testStrip.getPixelColor(0);
+    CHECK(first != kGreen && first != kRed);
+    CHECK((first >> 16) > 0 && ((first >> 8) & 0xFF) > 0);
+    settle();
+    for (int i = 0; i < LED_PIXELS_NUM; i++) CHECK_EQ(testStrip.getPixelColor(i), kRed);
+
+    unsigned long shows = fakeStats.ledShows;
+    startLedAnimation(LED_EFFECT_FADE, kRed);
+    CHECK(!ledAnimationRunning());
+    CHECK_EQ(fakeStats.ledShows, shows);
+}
+
+static void testPulseRunsUntilReplaced() {
+    startLedAnimation(LED_EFFECT_PULSE, kGreen);
+    for (int i = 0; i < 4 * LED_PULSE_STEPS; i++) {
+        fakeAdvanceMillis(LED_PULSE_STEP_MS);
+        handleLedAnimation();
+    }
+    CHECK(ledAnimationRunning());
+    startLedAnimation(LED_EFFECT_WIPE, 0);
+    settle();
+    for (int i = 0; i < LED_PIXELS_NUM; i++) CHECK_EQ(testStrip.getPixelColor(i), 0);
+}
+
+int main() {
+    RUN_TEST(testWipeDoesNotBlock);
+    RUN_TEST(testFadeBlendsFromCurrentColour);
+    RUN_TEST(testPulseRunsUntilReplaced);
+    return hostTestResult();
+}
@@ -0,0 +1,140 @@
+// The logger: a line is copied into the ring by the caller and formatted by
+// whoever drains it, printf-style, with the level in front; levels above
+// LOG_LEVEL cost nothing, a full ring drops lines and says so, and with the
+// log task running a caller never waits on the UART. The log task lives for
+// the whole process, so it is started once, after the draining-by-hand tests.
+
+#include <string>
+#include "hostTest.h"
+#include "fakeBoard.h"
+#include "log.h"
+
+static std::string flushed() {
+    logFlush();
+    return fakeTakeSerialOutput();
+}
+
+static void testText() {
+    LOG_INFO("✅ Time synchronized");
+    LOG_WARN("⚠️ Stream timed out");
+    LOG_ERROR("🚨 Max stream retry attempts reached.");
+    CHECK(flushed() == "[INFO] ✅ Time synchronized\n"
+                       "[WARN] ⚠️ Stream timed out\n"
+                       "[ERROR] 🚨 Max stream retry attempts reached.\n");
+}
+
+static void testFormat() {
+    LOGF("⏱️ Boot: %-13s %6lu ms", "cloud", 1234UL);
+    LOGF("%d %i %u %x %X %o %c", -42, (int8_t)-1, 4000000000U, 255, 255, 8, 'z');
+    LOGF("%lld %llu %ld %hu %zu", -9000000000LL, 18000000000ULL, -7L, (unsigned short)65535, (size_t)12);
+    LOGF("%.1f %5.2f %e %g", 23.45f, 3.14159, 1500.0, 0.5);
+    LOGF("%+d %05d %-4d| %#x", 7, 42, 3, 255);
+    LOGF("100%% done, %s", "ok");
+    LOGF("no args");
+    CHECK(flushed() == "[INFO] ⏱️ Boot: cloud           1234 ms\n"
+                       "[INFO] -42 -1 4000000000 ff FF 10 z\n"
+                       "[INFO] -9000000000 18000000000 -7 65535 12\n"
+                       "[INFO] 23.5  3.14 1.500000e+03 0.5\n"
+                       "[INFO] +7 00042 3   | 0xff\n"
+                       "[INFO] 100% done, ok\n"
+                       "[INFO] no args\n");
+}
+
+static void testStringsCopied() {
+    {
+        String key = "tempUp";
+        LOGF("✅ Captured %s IR signal.", (key + "!").c_str()); // a temporary
+        key = "gone";
+    }
+    std::string longText(300, 'x');
+    LOGF("%s|%d", longText.c_str(), 5); // past the record: the string is cut, the rest dropped
+    LOGF("%s", (const char*)nullptr);
+    LOGF("%d and %d", 1); // too few arguments
+    std::string out = flushed();
+    CHECK(out.find("[INFO] ✅ Captured tempUp! IR signal.\n") == 0);
+    size_t xs = out.find("xxx");
+    CHECK(xs != std::string::npos);
+    CHECK(out.find('\n', xs) - xs < LOG_RECORD_MAX);
+    CHECK(out.find("[INFO] (null)\n") != std::string::npos);
+    CHECK(out.find("[INFO] 1 and ?d\n") != std::string::npos);
+}
+
+static int evaluated = 0;
+static int sideEffect() { return ++evaluated; }
+
+static void testLevels() {
+    LOG_DEBUG("🔹 not shown");
+    LOGF_DEBUG("🔹 Signal %d", sideEffect());
+    LOGF_WARN("⚠️ shown %d", 1);
+    LOGF_ERROR("❌ shown %d", 2);
+    CHECK_EQ(evaluated, 0);
+    CHECK(flushed() == "[WARN] ⚠️ shown 1\n[ERROR] ❌ shown 2\n");
+}
+
+static void testFullRingDrops() {
+    LogStats before = logStats();
+    for (int i = 0; i < 500; i++) LOGF("📈 History: %u blocks, %s", (unsigned)i, "uploaded");
+    LogStats full = logStats();
+    CHECK(full.dropped > before.dropped);
+    CHECK(full.ringPeak <= LOG_RING_BYTES);
+    CHECK(full.ringPeak > LOG_RING_BYTES - LOG_RECORD_MAX);
+    std::string out = flushed();
+    CHECK(out.find("[INFO] 📈 History: 0 blocks, uploaded\n") == 0);
+    char dropped[64];
+    snprintf(dropped, sizeof(dropped), "[WARN] ⚠️ %lu log lines dropped\n", full.dropped - before.dropped);
+    CHECK(out.find(dropped) != std::string::npos);
+    // Room again once drained, across the end of the ring.
+    for (int i = 0; i < 100; i++) LOGF("%d", i);
+    out = flushed();
+    CHECK(out.find("[INFO] 0\n") == 0);
+    CHECK(out.find("[INFO] 99\n") != std::string::npos);
+    CHECK_EQ(logStats().dropped, full.dropped);
+}
+
+static unsigned long long callerHeldUs = 0;
+
+static void callerTask(void*) {
+    for (int burst = 0; burst < 50; burst++) {
+        unsigned long long start = fakeMicros();
+        for (int i = 0; i < 8; i++) LOGF("⏲️ %s/%s: %d runs, late avg %lu max %lu ms", "network", "report", burst, 1UL, 3UL);
+        callerHeldUs += fakeMicros() - start;
+        vTaskDelay(100); // the UART needs about 40 ms for a burst
+    }
+    vTaskDelete(nullptr);
+}
+
+static void testTaskDrains() {
+    fakeStats.serialBlockedUs = 0;
+    unsigned long dropped = logStats().dropped;
+    startLogTask();
+    xTaskCreatePinnedToCore(callerTask, "caller", 4096, nullptr, 2, nullptr, 1);
+    fakeRunTasksFor(50 * 100 + 100);
+    CHECK_EQ(callerHeldUs, 0);
+    CHECK(fakeStats.serialBlockedUs > 0); // 8 lines of 60 bytes overrun the FIFO: the log task waits
+    std::string out = fakeTakeSerialOutput();
+    size_t at = 0;
+    for (int burst = 0; burst < 50; burst++) {
+        char line[80];
+        snprintf(line, sizeof(line), "[INFO] ⏲️ network/report: %d runs, late avg 1 max 3 ms\n", burst);
+        for (int i = 0; i < 8; i++) {
+            size_t found = out.find(line, at);
+            CHECK(found == at);
+            if (found != at) return;
+            at = found + strlen(line);
+        }
+    }
+    CHECK_EQ(at, out.size());
+    CHECK_EQ(logStats().dropped, dropped);
+}
+
+int main() {
+    fakeReset();
+    fakeSetSerialEcho(false);
+    RUN_TEST(testText);
+    RUN_TEST(testFormat);
+    RUN_TEST(testStringsCopied);
+    RUN_TEST(testLevels);
+    RUN_TEST(testFullRingDrops);
+    RUN_TEST(testTaskDrains);
+    return hostTestResult();
+}
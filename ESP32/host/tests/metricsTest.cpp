@@ -0,0 +1,120 @@
+// The metrics registry: timings land in the bucket at or above them and the
+// percentiles read off the buckets never exceed the largest sample; on a
+// running device the Firebase calls, IR frames, commands and task wakes are
+// recorded, a stream timeout is counted, and /diagnostics carries it all on
+// its slow cadence. The firmware's tasks live for the whole process, so the
+// device boots once, after the registry-only tests.
+
+#include "hostTest.h"
+#include "deviceFixture.h"
+#include "deviceTasks.h"
+#include "metrics.h"
+
+void setup();
+void loop();
+
+// METRIC_LOOP only records loop() in setup mode, so it is free to poke at.
+static void testBuckets() {
+    recordMetricUs(METRIC_LOOP, 0);
+    recordMetricUs(METRIC_LOOP, 100);   // at a bound: that bucket
+    recordMetricUs(METRIC_LOOP, 101);   // just above: the next
+    recordMetricUs(METRIC_LOOP, 20000000); // past the last bound
+    MetricHistogram h = metricHistogram(METRIC_LOOP);
+    CHECK_EQ(h.count, 4);
+    CHECK_EQ(h.buckets[0], 2);
+    CHECK_EQ(h.buckets[1], 1);
+    CHECK_EQ(h.buckets[METRIC_BUCKETS - 1], 1);
+    CHECK_EQ(h.maxUs, 20000000);
+    CHECK(h.sumUs == 20000201ULL);
+    CHECK(metricBucketUs(METRIC_BUCKETS - 1) == UINT32_MAX);
+}
+
+static void testPercentiles() {
+    MetricHistogram empty = {};
+    CHECK_EQ(metricPercentileUs(empty, 50), 0);
+
+    for (int i = 0; i < 96; i++) recordMetricUs(METRIC_LOOP, 2500);
+    MetricHistogram h = metricHistogram(METRIC_LOOP);
+    CHECK_EQ(h.count, 100);
+    CHECK_EQ(metricPercentileUs(h, 50), 3000);     // the 2.5 ms bucket
+    CHECK_EQ(metricPercentileUs(h, 99), 3000);
+    CHECK_EQ(metricPercentileUs(h, 100), 20000000); // capped at the max, not UINT32_MAX
+
+    MetricHistogram small = {};
+    small.buckets[4] = 1; // one sample of 5 ms: the 10 ms bound is capped
+    small.count = 1;
+    small.maxUs = 5000;
+    CHECK_EQ(metricPercentileUs(small, 90), 5000);
+}
+
+static void bootDevice() {
+    fakeReset();
+    fakeSetSerialEcho(false);
+    fakeSetWallClock(1752468900);
+    fakeSetPin(PIRPIN, LOW);
+    seedFixtureDevice("Electra");
+    setup();
+    fakeStartLoopTask(loop);
+    fakeRunTasksFor(5000); // through the cloud bring-up
+}
+
+static void testDeviceRecords() {
+    CHECK_EQ(metricHistogram(METRIC_RTDB_READ).count, 4); // config, status, maintenance, schedule
+    CHECK_EQ(metricHistogram(METRIC_RTDB_STREAM).count, 1);
+    CHECK(metricHistogram(METRIC_NETWORK_RUN).count > 0);
+    CHECK(metricHistogram(METRIC_CONTROL_RUN).count > 0);
+    CHECK(metricHistogram(METRIC_SENSOR_RUN).count > 0);
+
+    unsigned long commands = metricCount(METRIC_COMMANDS);
+    unsigned long writes = metricHistogram(METRIC_RTDB_WRITE).count;
+    fakePushCommand(fixtureCommand("switch_power"));
+    fakeRunTasksFor(2000);
+    CHECK_EQ(metricCount(METRIC_COMMANDS), commands + 1);
+    CHECK(metricHistogram(METRIC_RTDB_WRITE).count > writes); // the result
+    MetricHistogram ir = metricHistogram(METRIC_IR_SEND);
+    CHECK_EQ(ir.count, 1);
+    CHECK(ir.maxUs >= 100000); // an Electra frame and its gap are on air for longer
+    CHECK_EQ(metricCount(METRIC_IR_DROPPED), 0);
+}
+
+static void testStreamTimeoutCounted() {
+    fakeSetStreamConnected(false);
+    fakeRunTasksFor(1500);
+    fakeSetStreamConnected(true);
+    fakeRunTasksFor(1000);
+    CHECK(metricCount(METRIC_STREAM_TIMEOUTS) >= 1);
+    CHECK(metricCount(METRIC_STREAM_RECONNECTS) >= 1);
+    CHECK_EQ(metricHistogram(METRIC_RTDB_STREAM).count, 1 + metricCount(METRIC_STREAM_RECONNECTS));
+    CHECK_EQ(metricCount(METRIC_RTDB_ERRORS), 0);
+}
+
+static void testDiagnosticsPublished() {
+    FirebaseJsonData value;
+    CHECK(!fakeRtdbGet(String(kFixtureDevicePath) + "/diagnostics/uptime", value));
+    fakeRunTasksFor(DIAGNOSTICS_INTERVAL_MS);
+    CHECK(fakeRtdbGet(String(kFixtureDevicePath) + "/diagnostics/uptime", value));
+    CHECK(value.intValue >= (int)(DIAGNOSTICS_INTERVAL_MS / 1000));
+    CHECK(fakeRtdbGet(String(kFixtureDevicePath) + "/diagnostics/commands", value));
+    CHECK_EQ(value.intValue, 1);
+    CHECK(fakeRtdbGet(String(kFixtureDevicePath) + "/diagnostics/streamReconnects", value));
+    CHECK_EQ(value.intValue, metricCount(METRIC_STREAM_RECONNECTS));
+    CHECK(fakeRtdbGet(String(kFixtureDevicePath) + "/diagnostics/heapFree", value));
+    CHECK(value.intValue > 0);
+    CHECK(fakeRtdbGet(String(kFixtureDevicePath) + "/diagnostics/stackControl", value));
+    CHECK(value.intValue > 0 && value.intValue < CONTROL_TASK_STACK);
+    // count,p50,p90,max in us
+    CHECK(fakeRtdbGet(String(kFixtureDevicePath) + "/diagnostics/rtdbStream", value));
+    CHECK(value.stringValue.startsWith(String(1 + metricCount(METRIC_STREAM_RECONNECTS)) + ","));
+    CHECK(fakeRtdbGet(String(kFixtureDevicePath) + "/diagnostics/irSend", value));
+    CHECK(value.stringValue.startsWith("1,"));
+}
+
+int main() {
+    RUN_TEST(testBuckets);
+    RUN_TEST(testPercentiles);
+    bootDevice();
+    RUN_TEST(testDeviceRecords);
+    RUN_TEST(testStreamTimeoutCounted);
+    RUN_TEST(testDiagnosticsPublished);
+    return hostTestResult();
+}
@@ -0,0 +1,201 @@
+// The occupancy estimate and motion mode on top of it: each source's
+// confidence halves every half-life, the surest source sets the score, the
+// vacancy time is where the combined score crosses
+// OCCUPANCY_VACANT, and motion mode prompts and switches off on that score,
+// so a person the radar still sees is never switched off, and the AC
+// turned on by the schedule counts as someone there. The control task
+// is stood in for by calling handleMode() whenever its deadline is due; the
+// radar task runs for real, once started.
+
+#include <vector>
+#include <driver/uart.h>
+#include "hostTest.h"
+#include "deviceFixture.h"
+#include "FirestoreServices.h"
+#include "modeHandler.h"
+#include "command.h"
+#include "occupancy.h"
+#include "deadlines.h"
+#include "radar.h"
+#include "ntpTime.h"
+#include "scheduleEngine.h"
+#include "parameters.h"
+
+static const unsigned long kHalfLife = 10 * 60000UL;
+static const unsigned long kPromptMs = IDLE_THRESHOLD_MS * MINUTES_CONVERT;
+static const unsigned long kOffMs = SHUTDOWN_WAIT_MS * MINUTES_CONVERT;
+
+static Occupancy fresh() {
+    Occupancy occupancy = {};
+    occupancy.halfLifeMs = kHalfLife;
+    return occupancy;
+}
+
+static void testScoreDecays() {
+    Occupancy occupancy = fresh();
+    CHECK_EQ(occupancyScore(occupancy, 5000), 0);
+    CHECK_EQ(occupancyVacantInMs(occupancy, 5000), 0);
+    noteOccupancy(occupancy, OCCUPANCY_PIR, 5000);
+    CHECK_EQ(occupancyScore(occupancy, 5000), 1000);
+    CHECK_EQ(occupancyScore(occupancy, 5000 + kHalfLife), 500);
+    CHECK_EQ(occupancyScore(occupancy, 5000 + 2 * kHalfLife), 250);
+    CHECK_EQ(occupancyScore(occupancy, 5000 + 3 * kHalfLife), OCCUPANCY_VACANT);
+    // Vacant once three half-lives have strictly passed, as the idle
+    // threshold was counted from the last motion.
+    CHECK_EQ(occupancyVacantInMs(occupancy, 5000), 3 * kHalfLife + 1);
+    CHECK_EQ(occupancyVacantInMs(occupancy, 5000 + kHalfLife), 2 * kHalfLife + 1);
+    CHECK_EQ(occupancyVacantInMs(occupancy, 5001 + 3 * kHalfLife), 0);
+}
+
+static void testSurestSourceCounts() {
+    Occupancy occupancy = fresh();
+    noteOccupancy(occupancy, OCCUPANCY_COMMAND, 0);
+    CHECK_EQ(occupancyScore(occupancy, 0), OCCUPANCY_COMMAND_WEIGHT);
+    unsigned long commandOnly = occupancyVacantInMs(occupancy, 0);
+    CHECK(commandOnly > 2 * kHalfLife && commandOnly < 3 * kHalfLife);
+    // A PIR edge and a radar sighting of the same walk out say no more
+    // than one of them.
+    noteOccupancy(occupancy, OCCUPANCY_PIR, 0);
+    noteOccupancy(occupancy, OCCUPANCY_RADAR, 0);
+    CHECK_EQ(occupancyScore(occupancy, 0), 1000);
+    CHECK_EQ(occupancyVacantInMs(occupancy, 0), 3 * kHalfLife + 1);
+    // A command now outweighs the PIR a half-life ago.
+    noteOccupancy(occupancy, OCCUPANCY_COMMAND, kHalfLife);
+    CHECK_EQ(occupancyScore(occupancy, kHalfLife), OCCUPANCY_COMMAND_WEIGHT);
+    CHECK_EQ(occupancyVacantInMs(occupancy, kHalfLife), commandOnly);
+}
+
+static void testOlderEvidenceIgnored() {
+    Occupancy occupancy = fresh();
+    noteOccupancy(occupancy, OCCUPANCY_RADAR, 90000);
+    noteOccupancy(occupancy, OCCUPANCY_RADAR, 60000); // reported late
+    CHECK_EQ(occupancy.lastMs[OCCUPANCY_RADAR], 90000);
+    CHECK_EQ(occupancyScore(occupancy, 80000), 1000); // not ahead of the evidence
+    CHECK_EQ(occupancyScore(occupancy, 90000 + kHalfLife), 500);
+}
+
+// The control task's part: handleMode() whenever its deadline comes up,
+// and `frame` from the radar every 100 ms if given.
+static void runFor(unsigned long ms, const std::vector<uint8_t>* frame = nullptr) {
+    for (unsigned long t = 0; t < ms; t += 100) {
+        if (frame) fakeUartReceive(RADAR_UART, frame->data(), frame->size());
+        fakeRunTasksFor(100);
+        if (deadlineDueInMs(controlDeadlines) == 0) handleMode();
+    }
+}
+
+static void startMotionMode() {
+    fakeSetPin(PIRPIN, LOW);
+    mode = MODE_MOTION;
+    acPowered = true;
+    idleFlag = IDLE_ACTIVE;
+}
+
+static void testPirOnly() {
+    fakeReset();
+    fakeSetSerialEcho(false);
+    fakeSetWallClock(1752468900);
+    model = MODEL_LG;
+    initIR();
+    fakeRunTasksFor(60000);
+    startMotionMode();
+    noteMotion();
+    handleMode();
+    CHECK_EQ(deadlineDueInMs(controlDeadlines), kPromptMs + 1);
+    runFor(kPromptMs - 1000);
+    CHECK_EQ(idleFlag, IDLE_ACTIVE);
+    runFor(2000);
+    CHECK_EQ(idleFlag, IDLE_USER_PROMPT);
+    // Someone walks past: the prompt is withdrawn and the count starts over.
+    runFor(5 * 60000UL);
+    noteMotion();
+    handleMode();
+    CHECK_EQ(idleFlag, IDLE_ACTIVE);
+    runFor(kPromptMs + 1000);
+    CHECK_EQ(idleFlag, IDLE_USER_PROMPT);
+    CHECK(acPowered);
+    runFor(kOffMs + 1000);
+    CHECK(!acPowered);
+}
+
+// A PIR output held high is motion as of every look, not only its edge.
+static void testPirHeld() {
+    runFor(3 * kPromptMs); // the earlier evidence long gone
+    startMotionMode();
+    fakeSetPin(PIRPIN, HIGH);
+    handleMode();
+    runFor(kPromptMs + kOffMs);
+    CHECK_EQ(idleFlag, IDLE_ACTIVE);
+    CHECK(acPowered);
+    fakeSetPin(PIRPIN, LOW);
+    runFor(kPromptMs + 1000);
+    CHECK_EQ(idleFlag, IDLE_USER_PROMPT);
+}
+
+// The schedule turning the AC on in motion mode is evidence like a command:
+// nobody has to walk past before the idle count starts.
+static void testScheduledPowerOnCounts() {
+    runFor(3 * kPromptMs);
+    struct tm now;
+    startTimeSync();
+    while (!getLocalTime(&now, 0)) fakeAdvanceMillis(100);
+    fakeSetWallClock(1752440400 + 10 * 3600); // Monday 10:00 local
+    mode = MODE_MOTION;
+    acPowered = false;
+    idleFlag = IDLE_ACTIVE;
+    WeeklySchedule week = {};
+    week.mon.active = true;
+    week.mon.count = 1;
+    week.mon.intervals[0] = {800, 1700};
+    compileSchedule(week);
+    handleSchedule();
+    CHECK(acPowered);
+    handleMode();
+    runFor(kPromptMs / 2);
+    CHECK_EQ(idleFlag, IDLE_ACTIVE);
+    runFor(kPromptMs / 2);
+    CHECK_EQ(idleFlag, IDLE_USER_PROMPT);
+    compileSchedule(WeeklySchedule{});
+}
+
+static std::vector<uint8_t> stillPersonFrame() {
+    // x 0, y +1800 mm, speed 0, resolution 360.
+    return {0xAA, 0xFF, 0x03, 0x00,
+            0x00, 0x00, 0x08, 0x87, 0x00, 0x80, 0x68, 0x01,
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+            0x55, 0xCC};
+}
+
+// Someone reading without moving: the PIR goes quiet, the radar keeps
+// tracking them, and motion mode leaves the AC on until the radar loses
+// them too.
+static void testRadarKeepsStillPersonIn() {
+    runFor(3 * kPromptMs);
+    startRadar();
+    startMotionMode();
+    noteMotion();
+    handleMode();
+    std::vector<uint8_t> frame = stillPersonFrame();
+    runFor(2 * (kPromptMs + kOffMs), &frame);
+    CHECK_EQ(radarPresence().people, 1);
+    CHECK_EQ(idleFlag, IDLE_ACTIVE);
+    CHECK(acPowered);
+    unsigned long leftMs = millis();
+    runFor(kPromptMs - 1000);
+    CHECK_EQ(idleFlag, IDLE_ACTIVE);
+    runFor(2000 + RADAR_TRACK_TIMEOUT_MS);
+    CHECK_EQ(idleFlag, IDLE_USER_PROMPT);
+    CHECK(millis() - leftMs <= kPromptMs + 1000 + RADAR_TRACK_TIMEOUT_MS);
+}
+
+int main() {
+    RUN_TEST(testScoreDecays);
+    RUN_TEST(testSurestSourceCounts);
+    RUN_TEST(testOlderEvidenceIgnored);
+    RUN_TEST(testPirOnly);
+    RUN_TEST(testPirHeld);
+    RUN_TEST(testScheduledPowerOnCounts);
+    RUN_TEST(testRadarKeepsStillPersonIn);
+    return hostTestResult();
+}
@@ -0,0 +1,72 @@
+// Light sleep on the booted device: an idle device sleeps through most of
+// each second, a held awake reason keeps it up, and the PIR wake level
+// follows the pin so a long motion pulse does not keep the chip awake.
+
+#include "hostTest.h"
+#include "deviceFixture.h"
+#include "parameters.h"
+#include "powerSave.h"
+
+void setup();
+void loop();
+
+static void bootDevice() {
+    fakeReset();
+    fakeSetSerialEcho(false);
+    fakeSetWallClock(1752440400);
+    fakeSetPin(PIRPIN, LOW);
+    seedFixtureDevice("Electra");
+    setup();
+    fakeStartLoopTask(loop);
+    fakeRunTasksFor(5000); // through the cloud bring-up
+}
+
+static void testIdleDeviceSleeps() {
+    CHECK(powerSaveLevel() == POWER_LIGHT_SLEEP);
+    fakePower = FakePower();
+    fakeRunTasksFor(10000);
+    CHECK(fakePower.lightSleeps > 0);
+    CHECK(fakePower.sleptUs > 9000000ULL);
+}
+
+static void testHoldAwakeBlocksSleep() {
+    holdAwake(AWAKE_IR, true);
+    holdAwake(AWAKE_BUZZER, true);
+    holdAwake(AWAKE_IR, false); // the buzzer still holds it
+    fakePower = FakePower();
+    fakeRunTasksFor(5000);
+    CHECK_EQ(fakePower.lightSleeps, 0);
+    holdAwake(AWAKE_BUZZER, false);
+    fakeRunTasksFor(5000);
+    CHECK(fakePower.lightSleeps > 0);
+}
+
+static void testPirPulseDoesNotPinAwake() {
+    fakeSetPin(PIRPIN, HIGH);
+    fakeRunTasksFor(100);
+    fakePower = FakePower();
+    fakeRunTasksFor(5000);
+    CHECK(fakePower.sleptUs > 4000000ULL);
+    fakeSetPin(PIRPIN, LOW);
+    fakeRunTasksFor(100);
+    fakePower = FakePower();
+    fakeRunTasksFor(5000);
+    CHECK(fakePower.sleptUs > 4000000ULL);
+}
+
+static void testModemSleepNeverLightSleeps() {
+    setPowerSave(POWER_MODEM_SLEEP);
+    fakePower = FakePower();
+    fakeRunTasksFor(5000);
+    CHECK_EQ(fakePower.lightSleeps, 0);
+    setPowerSave(POWER_LIGHT_SLEEP);
+}
+
+int main() {
+    bootDevice();
+    RUN_TEST(testIdleDeviceSleeps);
+    RUN_TEST(testHoldAwakeBlocksSleep);
+    RUN_TEST(testPirPulseDoesNotPinAwake);
+    RUN_TEST(testModemSleepNeverLightSleeps);
+    return hostTestResult();
+}
@@ -0,0 +1,329 @@
+// The RD-03D driver: the parser finds frames in a captured byte stream
+// however it is split across reads, skips what is not a frame and
+// resynchronises after a broken one; the tracker confirms, gates and
+// expires people; and the radar task takes a burst of frames in one wake,
+// survives an overflowing ring, holds off light sleep only for its listen
+// windows and is woken by the UART once the radar is silent. The
+// radar task lives for the whole process, so it is started once, after the
+// parser and tracker tests.
+
+#include <vector>
+#include <driver/uart.h>
+#include <esp_pm.h>
+#include "hostTest.h"
+#include "fakeBoard.h"
+#include "radar.h"
+
+// Captured from a module at power-up: the tail of its boot noise, the ACK
+// of the multi-target command, then two frames, the second with three
+// people (x -120, 880, -2300 mm; y 1450, 2610, 900 mm).
+static const uint8_t kCaptured[] = {
+    0x00, 0x3F, 0xFF,
+    0xFD, 0xFC, 0xFB, 0xFA, 0x04, 0x00, 0x90, 0x01, 0x00, 0x00, 0x04, 0x03, 0x02, 0x01,
+    0xAA, 0xFF, 0x03, 0x00,
+    0x78, 0x00, 0xAA, 0x85, 0x00, 0x80, 0x68, 0x01,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x55, 0xCC,
+    0xAA, 0xFF, 0x03, 0x00,
+    0x78, 0x00, 0xB4, 0x85, 0x10, 0x80, 0x68, 0x01,
+    0x70, 0x83, 0x32, 0x8A, 0x0C, 0x00, 0x68, 0x01,
+    0xFC, 0x08, 0x84, 0x83, 0x00, 0x80, 0x68, 0x01,
+    0x55, 0xCC,
+};
+static const size_t kCapturedNoise = 17;
+
+static std::vector<RadarFrame> frames;
+
+static void collect(const RadarFrame& frame) {
+    frames.push_back(frame);
+}
+
+static RadarParser newParser() {
+    frames.clear();
+    RadarParser parser = {};
+    parser.onFrame = collect;
+    return parser;
+}
+
+static void putValue(std::vector<uint8_t>& out, int16_t value) {
+    uint16_t raw = value >= 0 ? 0x8000 | value : -value;
+    out.push_back(raw & 0xFF);
+    out.push_back(raw >> 8);
+}
+
+static std::vector<uint8_t> frameBytes(std::vector<RadarTarget> targets) {
+    std::vector<uint8_t> out = {0xAA, 0xFF, 0x03, 0x00};
+    for (size_t i = 0; i < RADAR_TARGETS; i++) {
+        if (i < targets.size()) {
+            putValue(out, targets[i].x);
+            putValue(out, targets[i].y);
+            putValue(out, targets[i].speed);
+            out.push_back(targets[i].resolution & 0xFF);
+            out.push_back(targets[i].resolution >> 8);
+        } else {
+            out.insert(out.end(), 8, 0);
+        }
+    }
+    out.push_back(0x55);
+    out.push_back(0xCC);
+    return out;
+}
+
+static void testDecodesCapturedStream() {
+    RadarParser parser = newParser();
+    feedRadarParser(parser, kCaptured, sizeof(kCaptured));
+    CHECK_EQ(parser.stats.frames, 2);
+    CHECK_EQ(parser.stats.skipped, kCapturedNoise);
+    CHECK_EQ(parser.stats.badFrames, 0);
+    CHECK_EQ(parser.have, 0);
+    CHECK_EQ(frames.size(), 2);
+    CHECK_EQ(frames[0].count, 1);
+    CHECK_EQ(frames[0].targets[0].x, -120);
+    CHECK_EQ(frames[0].targets[0].y, 1450);
+    CHECK_EQ(frames[0].targets[0].speed, 0);
+    CHECK_EQ(frames[0].targets[0].resolution, 360);
+    CHECK_EQ(frames[1].count, 3);
+    CHECK_EQ(frames[1].targets[0].y, 1460);
+    CHECK_EQ(frames[1].targets[0].speed, 16);
+    CHECK_EQ(frames[1].targets[1].x, 880);
+    CHECK_EQ(frames[1].targets[1].y, 2610);
+    CHECK_EQ(frames[1].targets[1].speed, -12);
+    CHECK_EQ(frames[1].targets[2].x, -2300);
+    CHECK_EQ(frames[1].targets[2].y, 900);
+}
+
+// Every way of cutting the stream in two, and byte by byte, gives the same
+// frames as reading it whole.
+static void testSplitAcrossReads() {
+    for (size_t cut = 1; cut < sizeof(kCaptured); cut++) {
+        RadarParser parser = newParser();
+        feedRadarParser(parser, kCaptured, cut);
+        feedRadarParser(parser, kCaptured + cut, sizeof(kCaptured) - cut);
+        CHECK_EQ(parser.stats.frames, 2);
+        CHECK_EQ(parser.stats.skipped, kCapturedNoise);
+        CHECK_EQ(frames.size(), 2);
+        CHECK_EQ(frames[1].targets[2].x, -2300);
+    }
+    RadarParser parser = newParser();
+    for (uint8_t byte : kCaptured) feedRadarParser(parser, &byte, 1);
+    CHECK_EQ(parser.stats.frames, 2);
+    CHECK_EQ(parser.stats.skipped, kCapturedNoise);
+    CHECK_EQ(frames[1].count, 3);
+}
+
+// A frame cut short by a dropped byte run, and one with a broken tail: each
+// is counted and the next frame is still found, whole or fed byte by byte.
+static void testResynchronises() {
+    std::vector<uint8_t> good = frameBytes({{300, 2000, 0, 360}});
+    std::vector<uint8_t> stream(good.begin(), good.begin() + 10);
+    stream.insert(stream.end(), good.begin(), good.end());
+    std::vector<uint8_t> broken = good;
+    broken[RADAR_FRAME_BYTES - 1] = 0x00;
+    stream.insert(stream.end(), broken.begin(), broken.end());
+    stream.insert(stream.end(), good.begin(), good.end());
+
+    RadarParser whole = newParser();
+    feedRadarParser(whole, stream.data(), stream.size());
+    CHECK_EQ(whole.stats.frames, 2);
+    CHECK_EQ(whole.stats.badFrames, 2);
+    CHECK_EQ(whole.stats.skipped, 10 + RADAR_FRAME_BYTES);
+    CHECK_EQ(frames.size(), 2);
+    CHECK_EQ(frames[1].targets[0].x, 300);
+
+    RadarParser bytewise = newParser();
+    for (uint8_t byte : stream) feedRadarParser(bytewise, &byte, 1);
+    CHECK_EQ(bytewise.stats.frames, 2);
+    CHECK_EQ(bytewise.stats.badFrames, 2);
+    CHECK_EQ(bytewise.stats.skipped, 10 + RADAR_FRAME_BYTES);
+}
+
+static RadarFrame frameOf(std::vector<RadarTarget> targets) {
+    RadarFrame frame = {};
+    for (const RadarTarget& target : targets) frame.targets[frame.count++] = target;
+    return frame;
+}
+
+static void testTrackerConfirmsAndExpires() {
+    RadarTracker tracker = {};
+    unsigned long now = 1000;
+    for (int i = 0; i < RADAR_TRACK_CONFIRM; i++) {
+        CHECK(!radarTrackConfirmed(tracker.tracks[0]));
+        updateRadarTracker(tracker, frameOf({{-120, (int16_t)(1450 + 20 * i), 20, 360}}), now);
+        now += 100;
+    }
+    const RadarTrack& track = tracker.tracks[0];
+    CHECK(radarTrackConfirmed(track));
+    CHECK_EQ(track.id, 1);
+    CHECK(abs(track.distance - 1480) < 30);
+    CHECK(abs(track.angle + 47) < 3);
+    CHECK_EQ(track.speed, 20);
+    CHECK_EQ(tracker.tracks[1].id, 0);
+
+    expireRadarTracks(tracker, track.seenMs + RADAR_TRACK_TIMEOUT_MS - 1);
+    CHECK_EQ(tracker.tracks[0].id, 1);
+    expireRadarTracks(tracker, track.seenMs + RADAR_TRACK_TIMEOUT_MS);
+    CHECK_EQ(tracker.tracks[0].id, 0);
+}
+
+// Two people keep their own tracks as they move, a target outside every
+// gate starts a new one, and with the slots full a new target only takes
+// over an unconfirmed track.
+static void testTrackerGates() {
+    RadarTracker tracker = {};
+    unsigned long now = 0;
+    for (int i = 0; i < RADAR_TRACK_CONFIRM; i++, now += 100) {
+        updateRadarTracker(tracker, frameOf({{(int16_t)(-500 + 30 * i), 1500, 0, 360},
+                                             {(int16_t)(600 - 30 * i), 2500, 0, 360}}), now);
+    }
+    CHECK(radarTrackConfirmed(tracker.tracks[0]));
+    CHECK(radarTrackConfirmed(tracker.tracks[1]));
+    CHECK_EQ(tracker.tracks[0].id, 1);
+    CHECK_EQ(tracker.tracks[1].id, 2);
+    CHECK(tracker.tracks[0].distance < tracker.tracks[1].distance);
+
+    // Listed the other way round, each still lands on its own track.
+    updateRadarTracker(tracker, frameOf({{540, 2500, 0, 360}, {-410, 1500, 0, 360}}), now);
+    CHECK(tracker.tracks[0].angle < 0);
+    CHECK(tracker.tracks[1].angle > 0);
+    CHECK_EQ(tracker.tracks[2].id, 0);
+
+    // A jump of two metres is someone else.
+    now += 100;
+    updateRadarTracker(tracker, frameOf({{-410, 3500, 0, 360}, {540, 2500, 0, 360}}), now);
+    CHECK_EQ(tracker.tracks[2].id, 3);
+    CHECK_EQ(tracker.tracks[2].hits, 1);
+    CHECK_EQ(tracker.tracks[0].seenMs, now - 100);
+
+    now += 100;
+    updateRadarTracker(tracker, frameOf({{0, 5000, 0, 360}}), now);
+    CHECK_EQ(tracker.tracks[2].id, 4); // replaced the unconfirmed one
+    CHECK_EQ(tracker.tracks[0].id, 1);
+    CHECK_EQ(tracker.tracks[1].id, 2);
+}
+
+static void sendFrame(const std::vector<uint8_t>& bytes) {
+    fakeUartReceive(RADAR_UART, bytes.data(), bytes.size());
+}
+
+// The radar at 10 Hz with one person walking towards it and another
+// standing still; then a batch for the task to take the last frames.
+static int16_t walkerY = 3000;
+
+static void streamFor(unsigned long ms) {
+    for (unsigned long t = 0; t < ms; t += 100) {
+        sendFrame(frameBytes({{-120, walkerY, -20, 360}, {900, 2600, 0, 360}}));
+        walkerY -= 20;
+        fakeRunTasksFor(100);
+    }
+    fakeRunTasksFor(RADAR_BATCH_MS);
+}
+
+static void testTaskTracksStream() {
+    fakeReset();
+    startRadar();
+    std::string sent = fakeUartTakeSent(RADAR_UART);
+    const uint8_t multiTarget[] = {0xFD, 0xFC, 0xFB, 0xFA, 0x02, 0x00, 0x90, 0x00, 0x04, 0x03, 0x02, 0x01};
+    CHECK(sent == std::string((const char*)multiTarget, sizeof(multiTarget)));
+    fakeRunTasksFor(1000);
+    CHECK_EQ(radarStats().wakes, 0); // nothing on the line, nothing to do
+    CHECK(!radarPresence().streaming);
+
+    fakeUartReceive(RADAR_UART, kCaptured, kCapturedNoise); // the ACK
+    streamFor(10000);
+    RadarStats stats = radarStats();
+    // A listen window every RADAR_LISTEN_MS + RADAR_REST_MS, the frames of
+    // each but the one cut by the start of the window taken.
+    const unsigned long cycleMs = RADAR_LISTEN_MS + RADAR_REST_MS;
+    CHECK(stats.listens >= 10000 / cycleMs && stats.listens <= 10000 / cycleMs + 2);
+    CHECK(stats.parser.frames >= (stats.listens - 1) * (RADAR_LISTEN_MS / 100 - 1));
+    CHECK(stats.parser.frames <= stats.listens * RADAR_LISTEN_MS / 100);
+    CHECK_EQ(stats.parser.badFrames, 0);
+    CHECK_EQ(stats.overflows, 0);
+    // A wake per batch, not per frame.
+    CHECK(stats.wakes <= stats.listens * (RADAR_LISTEN_MS / RADAR_BATCH_MS + 1));
+    RadarPresence presence = radarPresence();
+    CHECK(presence.streaming);
+    CHECK_EQ(presence.people, 2);
+    // The walker, as of the last window.
+    CHECK(presence.nearestMm > 1000 && presence.nearestMm < 1100 + 20 * cycleMs / 100);
+    CHECK(presence.moving);
+    CHECK(millis() - presence.seenMs <= cycleMs);
+}
+
+static void untilListening() {
+    unsigned long listens = radarStats().listens;
+    while (radarStats().listens == listens) fakeRunTasksFor(10);
+}
+
+// More than the ring holds during a listen window: it is flushed and the
+// frames after it are read as before. What piles up during a rest is
+// dropped anyway.
+static void testOverflowFlushes() {
+    std::vector<uint8_t> burst;
+    for (int i = 0; i < 2 * RADAR_RX_BUFFER / RADAR_FRAME_BYTES; i++) {
+        std::vector<uint8_t> frame = frameBytes({{-120, walkerY, 0, 360}});
+        burst.insert(burst.end(), frame.begin(), frame.end());
+    }
+    untilListening();
+    fakeUartReceive(RADAR_UART, burst.data(), burst.size());
+    fakeRunTasksFor(RADAR_LISTEN_MS);
+    RadarStats stats = radarStats();
+    CHECK(stats.overflows >= 1);
+    unsigned long frames = stats.parser.frames;
+    streamFor(3000);
+    CHECK(radarStats().parser.frames - frames >= 2 * (RADAR_LISTEN_MS / 100 - 1));
+    CHECK_EQ(radarPresence().people, 2);
+}
+
+// Once the radar goes quiet a listen window hears nothing, the people time
+// out, and the task sleeps until the next byte.
+static void testSilenceReleases() {
+    fakeRunTasksFor(2 * (RADAR_LISTEN_MS + RADAR_REST_MS) + RADAR_TRACK_TIMEOUT_MS);
+    RadarPresence presence = radarPresence();
+    CHECK(!presence.streaming);
+    CHECK_EQ(presence.people, 0);
+    CHECK(presence.seenMs > 0); // still says when someone was last there
+    unsigned long wakes = radarStats().wakes;
+    fakeRunTasksFor(60000);
+    CHECK_EQ(radarStats().wakes, wakes);
+}
+
+// With light sleep on, the radar keeps the chip awake only for its listen
+// windows, and a radar that starts streaming while the chip sleeps wakes it
+// through the UART.
+static void testLightSleepBetweenWindows() {
+    esp_pm_config_esp32_t config = {240, 80, true};
+    esp_pm_configure(&config);
+    fakePower = FakePower();
+    unsigned long long startUs = fakeMicros();
+    streamFor(15000);
+    RadarPresence presence = radarPresence();
+    CHECK(presence.streaming);
+    CHECK_EQ(presence.people, 2);
+    double awake = 1 - (double)fakePower.sleptUs / (fakeMicros() - startUs);
+    CHECK(awake < (double)(RADAR_LISTEN_MS + 100) / (RADAR_LISTEN_MS + RADAR_REST_MS));
+
+    // Silent, then back: the bytes that woke the chip are lost, the frames
+    // after them are not.
+    fakeRunTasksFor(2 * (RADAR_LISTEN_MS + RADAR_REST_MS) + RADAR_TRACK_TIMEOUT_MS);
+    CHECK(!radarPresence().streaming);
+    CHECK_EQ(radarPresence().people, 0);
+    fakeRunTasksFor(60000);
+    streamFor(2 * (RADAR_LISTEN_MS + RADAR_REST_MS));
+    CHECK(radarPresence().streaming);
+    CHECK_EQ(radarPresence().people, 2);
+}
+
+int main() {
+    RUN_TEST(testDecodesCapturedStream);
+    RUN_TEST(testSplitAcrossReads);
+    RUN_TEST(testResynchronises);
+    RUN_TEST(testTrackerConfirmsAndExpires);
+    RUN_TEST(testTrackerGates);
+    RUN_TEST(testTaskTracksStream);
+    RUN_TEST(testOverflowFlushes);
+    RUN_TEST(testSilenceReleases);
+    RUN_TEST(testLightSleepBetweenWindows);
+    return hostTestResult();
+}
@@ -0,0 +1,95 @@
+// Write combining in the RTDB publisher: repeated writes to a path collapse
+// to the last value, urgent writes carry everything staged with them, and a
+// failed flush is retried without losing values.
+
+#include "hostTest.h"
+#include "deviceFixture.h"
+#include "rtdbPublisher.h"
+
+static const char* const kBase = "/devices/publisher";
+
+static NetRequest stringWrite(const char* path, const char* value, PublishPriority priority) {
+    NetRequest r = {};
+    r.op = NET_SET_STRING;
+    r.priority = priority;
+    snprintf(r.path, sizeof(r.path), "%s", path);
+    snprintf(r.s, sizeof(r.s), "%s", value);
+    return r;
+}
+
+static String stored(const char* path) {
+    FirebaseJsonData out;
+    fakeRtdbGet(String(kBase) + path, out);
+    return out.stringValue;
+}
+
+static void start() {
+    fakeReset();
+    fakeSetSerialEcho(false);
+    initRtdbPublisher(kBase);
+    rtdbPublisherOnline();
+}
+
+static void testRepeatedWritesCollapse() {
+    start();
+    PublisherStats before = rtdbPublisherStats();
+    rtdbPublish(stringWrite("/status/mode", "eco", PUBLISH_SOON));
+    rtdbPublish(stringWrite("/status/mode", "timer", PUBLISH_SOON));
+    rtdbPublish(stringWrite("/status/idleFlag", "idle", PUBLISH_SOON));
+    CHECK_EQ(rtdbPublisherStaged(), 2);
+    CHECK(handleRtdbPublisher());
+    CHECK_EQ(fakeStats.rtdbRequests, 0); // not due yet
+    fakeAdvanceMillis(PUBLISH_SOON_MS);
+    CHECK(handleRtdbPublisher());
+    CHECK_EQ(fakeStats.rtdbRequests, 1);
+    CHECK(stored("/status/mode") == "timer");
+    CHECK(stored("/status/idleFlag") == "idle");
+    CHECK_EQ(rtdbPublisherStats().coalesced - before.coalesced, 1);
+    CHECK_EQ(rtdbPublisherStaged(), 0);
+}
+
+static void testUrgentWriteCarriesLazyOnes() {
+    start();
+    NetRequest sensors = {};
+    sensors.op = NET_SENSORS;
+    sensors.priority = PUBLISH_LAZY;
+    snprintf(sensors.path, sizeof(sensors.path), "/sensors");
+    sensors.sensors.temperature = 25.5f;
+    sensors.sensors.humidity = 48.0f;
+    sensors.sensors.motion = true;
+    rtdbPublish(sensors);
+    CHECK_EQ(rtdbPublisherStaged(), 3);
+    CHECK_EQ(rtdbPublisherDueInMs(), PUBLISH_LAZY_MS);
+    fakeAdvanceMillis(2000);
+    rtdbPublish(stringWrite("/result", "Success", PUBLISH_NOW));
+    CHECK_EQ(rtdbPublisherDueInMs(), 0);
+    CHECK(handleRtdbPublisher());
+    CHECK_EQ(fakeStats.rtdbRequests, 1);
+    CHECK(stored("/result") == "Success");
+    FirebaseJsonData motion;
+    CHECK(fakeRtdbGet(String(kBase) + "/sensors/motion", motion));
+    CHECK(motion.boolValue);
+}
+
+static void testFailedFlushIsRetried() {
+    start();
+    fakeSetWifiConnected(false);
+    rtdbPublish(stringWrite("/result", "Failed", PUBLISH_NOW));
+    CHECK(!handleRtdbPublisher());
+    CHECK_EQ(rtdbPublisherStaged(), 1);
+    fakeSetWifiConnected(true);
+    rtdbPublish(stringWrite("/result", "Success", PUBLISH_NOW));
+    CHECK(handleRtdbPublisher()); // waits out the retry delay
+    CHECK_EQ(fakeStats.rtdbRequests, 1);
+    fakeAdvanceMillis(PUBLISH_RETRY_MS);
+    CHECK(handleRtdbPublisher());
+    CHECK_EQ(fakeStats.rtdbRequests, 2);
+    CHECK(stored("/result") == "Success");
+}
+
+int main() {
+    RUN_TEST(testRepeatedWritesCollapse);
+    RUN_TEST(testUrgentWriteCarriesLazyOnes);
+    RUN_TEST(testFailedFlushIsRetried);
+    return hostTestResult();
+}
@@ -0,0 +1,112 @@
+// The compiled schedule: merged intervals, spans past midnight and across the
+// end of the week, transitions on the exact minute, and the catch-up when a
+// schedule arrives in the middle of an interval.
+
+#include "hostTest.h"
+#include "deviceFixture.h"
+#include "command.h"
+#include "ntpTime.h"
+#include "scheduleEngine.h"
+
+static const time_t kMonday0000 = 1752440400; // Monday 00:00 local (UTC+3)
+
+static void day(DaySchedule& d, std::initializer_list<ScheduleInterval> intervals) {
+    d.active = true;
+    d.count = 0;
+    for (const ScheduleInterval& i : intervals) d.intervals[d.count++] = i;
+}
+
+static void start(time_t wallClock) {
+    fakeReset();
+    fakeSetSerialEcho(false);
+    struct tm now;
+    startTimeSync();
+    while (!getLocalTime(&now, 0)) fakeAdvanceMillis(100);
+    fakeSetWallClock(wallClock);
+    model = MODEL_LG;
+    mode = MODE_REGULAR;
+    acPowered = false;
+    initIR();
+}
+
+// Runs the control tick every 10 ms until acPowered flips or `limitMs` passes.
+static unsigned long long runUntilPowerFlips(unsigned long limitMs) {
+    bool was = acPowered;
+    for (unsigned long t = 0; t < limitMs && acPowered == was; t += 10) {
+        handleSchedule();
+        if (acPowered == was) fakeAdvanceMillis(10);
+    }
+    return fakeMicros();
+}
+
+static void testCompiledTransitions() {
+    start(kMonday0000);
+    WeeklySchedule week = {};
+    day(week.mon, {{800, 1200}, {1100, 1400}, {2200, 200}});
+    day(week.sat, {{2300, 100}});
+    compileSchedule(week);
+    const uint16_t mon = 24 * 60;
+    const uint16_t sat = 6 * 24 * 60;
+    ScheduleEvent expect[] = {
+        {60, false},                                       // Saturday night ends Sunday 01:00
+        {mon + 8 * 60, true}, {mon + 14 * 60, false},      // 08:00-12:00 and 11:00-14:00 merged
+        {mon + 22 * 60, true}, {mon + 26 * 60, false},     // 22:00 to Tuesday 02:00
+        {sat + 23 * 60, true},
+    };
+    CHECK_EQ(scheduleEventCount(), 6);
+    for (int i = 0; i < 6 && i < scheduleEventCount(); i++) {
+        CHECK_EQ(scheduleEvents()[i].minute, expect[i].minute);
+        CHECK_EQ(scheduleEvents()[i].on, expect[i].on);
+    }
+}
+
+static void testFiresOnTheMinute() {
+    start(kMonday0000 + 7 * 3600 + 58 * 60 + 17); // 07:58:17
+    WeeklySchedule week = {};
+    day(week.mon, {{800, 801}});
+    compileSchedule(week);
+    unsigned long long on = runUntilPowerFlips(5 * 60 * 1000);
+    CHECK(acPowered);
+    unsigned long long edge = (unsigned long long)(60 + 43) * 1000000ULL;
+    CHECK(on >= edge && on <= edge + 10000);
+    unsigned long long off = runUntilPowerFlips(5 * 60 * 1000);
+    CHECK(!acPowered);
+    CHECK(off >= edge + 60000000ULL && off <= edge + 60010000ULL);
+}
+
+static void testCatchUpInsideInterval() {
+    start(kMonday0000 + 23 * 3600); // Monday 23:00, inside 22:00-02:00
+    WeeklySchedule week = {};
+    day(week.mon, {{2200, 200}});
+    compileSchedule(week);
+    handleSchedule();
+    CHECK(acPowered);
+    // Compiling again does not toggle the AC back off.
+    compileSchedule(week);
+    handleSchedule();
+    CHECK(acPowered);
+}
+
+static void testSleepsUntilTheNextTransition() {
+    start(kMonday0000 + 6 * 3600); // 06:00:00
+    WeeklySchedule week = {};
+    day(week.mon, {{630, 700}});
+    compileSchedule(week);
+    handleSchedule();
+    CHECK_EQ(scheduleDueInMs(), SCHEDULE_RESYNC_MS);
+    fakeAdvanceMillis(SCHEDULE_RESYNC_MS);
+    handleSchedule();
+    CHECK_EQ(scheduleDueInMs(), SCHEDULE_RESYNC_MS);
+    fakeAdvanceMillis(SCHEDULE_RESYNC_MS);
+    handleSchedule();
+    CHECK_EQ(scheduleDueInMs(), 9 * 60 * 1000 + 59 * 1000); // wakes at 06:29:59
+    CHECK(!acPowered);
+}
+
+int main() {
+    RUN_TEST(testCompiledTransitions);
+    RUN_TEST(testFiresOnTheMinute);
+    RUN_TEST(testCatchUpInsideInterval);
+    RUN_TEST(testSleepsUntilTheNextTransition);
+    return hostTestResult();
+}
@@ -0,0 +1,176 @@
+// The sensor filter, stage by stage and on recorded DHT11 traces: failed and
+// out-of-range reads are dropped and a lost sensor starts over, the median
+// removes single glitches, the EMA and the rate limit smooth steps in fixed
+// point, and the reported value only follows past the hysteresis band.
+
+#include "hostTest.h"
+#include "sensorFilter.h"
+
+// Every stage off, so a test turns on the one it looks at.
+static const SensorFilterConfig passThrough = {-1000, 6000, 1, 256, 0, 0};
+
+static int feed(SensorFilter& filter, const float* trace, int n) {
+    int changes = 0;
+    for (int i = 0; i < n; i++) changes += filterReading(filter, trace[i]);
+    return changes;
+}
+
+static void testFaultsAreDropped() {
+    SensorFilter filter = {&passThrough};
+    CHECK(isnan(filteredValue(filter)));
+    CHECK(!filterReading(filter, NAN));
+    CHECK(filterReading(filter, 24.0f));
+    CHECK_EQ(filter.filtered, 2400);
+    CHECK(!filterReading(filter, NAN));
+    CHECK(!filterReading(filter, 0.0f - 20.0f)); // below min
+    CHECK(!filterReading(filter, 255.0f));       // above max
+    CHECK_EQ(filter.rejected, 4);
+    CHECK_EQ(filter.faults, 3);
+    CHECK(filter.valid);
+    CHECK_EQ(filter.reported, 2400);
+    CHECK(filterReading(filter, 24.5f));
+    CHECK_EQ(filter.faults, 0);
+}
+
+static void testLostSensorStartsOver() {
+    static const SensorFilterConfig config = {-1000, 6000, 5, 64, 50, 50};
+    SensorFilter filter = {&config};
+    filterReading(filter, 24.0f);
+    for (int i = 0; i < SENSOR_FAULT_LIMIT - 1; i++) filterReading(filter, NAN);
+    CHECK(filter.valid);
+    filterReading(filter, NAN);
+    CHECK(!filter.valid);
+    CHECK(isnan(reportedValue(filter)));
+    for (int i = 0; i < 5; i++) filterReading(filter, NAN); // stays lost, no wrap
+    CHECK(!filter.valid);
+    // The room changed meanwhile: the first read is taken as it is.
+    CHECK(filterReading(filter, 28.0f));
+    CHECK_EQ(filter.filtered, 2800);
+    CHECK_EQ(filter.reported, 2800);
+    CHECK(!filterReading(filter, 28.0f));
+    CHECK_EQ(filter.filtered, 2800);
+}
+
+static void testMedianRemovesGlitches() {
+    static const SensorFilterConfig config = {-1000, 6000, 5, 256, 0, 0};
+    SensorFilter filter = {&config};
+    const float trace[] = {25.0f, 25.0f, 26.0f, 25.0f, 25.0f, 24.0f, 25.0f, 25.1f, 25.1f};
+    CHECK_EQ(feed(filter, trace, 7), 1); // only the first read
+    CHECK_EQ(filter.filtered, 2500);
+    // A lasting change gets through once it is most of the window.
+    filterReading(filter, 25.1f);
+    CHECK_EQ(filter.filtered, 2500);
+    filterReading(filter, 25.1f);
+    filterReading(filter, 25.1f);
+    CHECK_EQ(filter.filtered, 2510);
+}
+
+static void testEmaKeepsFraction() {
+    static const SensorFilterConfig config = {-1000, 6000, 1, 64, 0, 0};
+    SensorFilter filter = {&config};
+    filterReading(filter, 20.0f);
+    filterReading(filter, 30.0f);
+    CHECK_EQ(filter.filtered, 2250); // a quarter of the way
+    filterReading(filter, 30.0f);
+    CHECK_EQ(filter.filtered, 2438);
+    // A step smaller than the weight can express still arrives.
+    SensorFilter small = {&config};
+    filterReading(small, 20.0f);
+    for (int i = 0; i < 60; i++) filterReading(small, 20.01f);
+    CHECK_EQ(small.filtered, 2001);
+    for (int i = 0; i < 60; i++) filterReading(small, -5.0f);
+    CHECK_EQ(small.filtered, -500);
+}
+
+static void testRateLimit() {
+    static const SensorFilterConfig config = {-1000, 6000, 1, 256, 50, 0};
+    SensorFilter filter = {&config};
+    filterReading(filter, 25.0f);
+    filterReading(filter, 30.0f);
+    CHECK_EQ(filter.filtered, 2550);
+    filterReading(filter, 30.0f);
+    CHECK_EQ(filter.filtered, 2600);
+    filterReading(filter, 25.8f);
+    CHECK_EQ(filter.filtered, 2580);
+}
+
+static void testHysteresis() {
+    static const SensorFilterConfig config = {-1000, 6000, 1, 256, 0, 50};
+    SensorFilter filter = {&config};
+    filterReading(filter, 25.0f);
+    CHECK(!filterReading(filter, 25.4f));
+    CHECK(!filterReading(filter, 24.6f));
+    CHECK_EQ(filter.reported, 2500);
+    CHECK(filterReading(filter, 24.5f));
+    CHECK_EQ(filter.reported, 2450);
+    CHECK(!filterReading(filter, 24.9f));
+    CHECK(filterReading(filter, 25.0f));
+    CHECK_EQ(reportedValue(filter) * 100, 2500);
+}
+
+// Temperature and humidity from a DHT11 on a desk, one read every five
+// seconds for four minutes: the room is steady at first and then the AC
+// pulls it down by a degree. Each trace has a failed read and a glitch.
+static const float tempTrace[] = {
+    25.1f, 25.2f, 25.1f, 25.2f, 25.2f, 25.1f, 25.2f, 25.3f, 25.2f, 25.1f, 25.2f, 25.2f,
+    25.1f, NAN,   25.2f, 25.2f, 26.3f, 25.1f, 25.2f, 25.2f, 25.1f, 25.2f, 25.1f, 25.2f,
+    25.0f, 25.0f, 24.9f, 24.9f, 24.8f, 24.8f, 24.7f, 24.7f, 24.6f, 24.5f, 24.5f, 24.4f,
+    24.3f, 24.3f, 24.2f, 24.2f, 24.1f, 24.2f, 24.1f, 24.2f, 24.1f, 24.1f, 24.2f, 24.1f,
+};
+static const float humTrace[] = {
+    55, 56, 55, 55, 54, 55, 62, 55, 55, 54, 55, 56, 55, NAN, 55, 54, 55, 55, 56, 55, 55, 54, 55, 55,
+    55, 55, 54, 55, 54, 54, 53, 54, 53, 53, 54, 53, 52, 53, 53, 52, 53, 52, 52, 53, 52, 52, 53, 52,
+};
+
+// What the firmware did before: every read a change past the threshold
+// from the last one reported, failed reads taken as 0.
+static int thresholdChanges(const float* trace, int n, float threshold) {
+    float reported = 0;
+    int changes = 0;
+    for (int i = 0; i < n; i++) {
+        float value = isnan(trace[i]) ? 0 : trace[i];
+        if (fabsf(value - reported) >= threshold) {
+            reported = value;
+            changes++;
+        }
+    }
+    return changes;
+}
+
+static void testRecordedTraces() {
+    static const SensorFilterConfig tempConfig = {-1000, 6000, 5, 64, 50, 50};
+    static const SensorFilterConfig humConfig = {100, 10000, 5, 64, 200, 200};
+    const int n = sizeof(tempTrace) / sizeof(tempTrace[0]);
+
+    SensorFilter temp = {&tempConfig};
+    int tempChanges = 0;
+    int32_t lowest = 10000, highest = -10000;
+    for (int i = 0; i < n; i++) {
+        tempChanges += filterReading(temp, tempTrace[i]);
+        lowest = min(lowest, temp.filtered);
+        highest = max(highest, temp.filtered);
+    }
+    CHECK_EQ(thresholdChanges(tempTrace, n, 0.5f), 7);
+    CHECK_EQ(tempChanges, 2); // the first read and the cool-down
+    CHECK(highest <= 2520);   // the glitch did not get through
+    CHECK(lowest >= 2400);
+    CHECK_EQ(temp.rejected, 1);
+    CHECK(abs(temp.filtered - 2410) <= 20);
+    CHECK(abs(temp.reported - 2410) < 50);
+
+    SensorFilter hum = {&humConfig};
+    CHECK_EQ(thresholdChanges(humTrace, n, 2.0f), 6);
+    CHECK_EQ(feed(hum, humTrace, n), 2);
+    CHECK(abs(hum.filtered - 5250) <= 50);
+}
+
+int main() {
+    RUN_TEST(testFaultsAreDropped);
+    RUN_TEST(testLostSensorStartsOver);
+    RUN_TEST(testMedianRemovesGlitches);
+    RUN_TEST(testEmaKeepsFraction);
+    RUN_TEST(testRateLimit);
+    RUN_TEST(testHysteresis);
+    RUN_TEST(testRecordedTraces);
+    return hostTestResult();
+}
@@ -0,0 +1,167 @@
+// Room history end to end: the hourly batch lands under /history as base64
+// blocks that decode back to one sample a minute, large steps and failed
+// reads take the long sample form, and a day of failing writes spills to
+// LittleFS and is uploaded in full once writes go through again, unless a
+// factory reset drops it first.
+
+#include <LittleFS.h>
+#include "hostTest.h"
+#include "deviceFixture.h"
+#include "parameters.h"
+#include "sensorHistory.h"
+#include "FirestoreServices.h"
+
+void setup();
+void loop();
+
+static void bootDevice() {
+    fakeReset();
+    fakeSetSerialEcho(false);
+    fakeSetWallClock(1752440400);
+    fakeSetPin(PIRPIN, LOW);
+    seedFixtureDevice("Electra");
+    setup();
+    fakeStartLoopTask(loop);
+    fakeRunTasksFor(5000); // through the cloud bring-up
+}
+
+static std::vector<uint8_t> fromBase64(const String& text) {
+    std::vector<uint8_t> out;
+    uint32_t bits = 0;
+    int count = 0;
+    for (const char* c = text.c_str(); *c && *c != '='; c++) {
+        const char* digits = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        bits = bits << 6 | (uint32_t)(strchr(digits, *c) - digits);
+        if ((count += 6) >= 8) {
+            count -= 8;
+            out.push_back(bits >> count & 0xFF);
+        }
+    }
+    return out;
+}
+
+// Every uploaded sample from `fromEpoch` on, in time order.
+static std::vector<HistorySample> uploadedSince(uint32_t fromEpoch) {
+    std::vector<HistorySample> all;
+    String node = String(kFixtureDevicePath) + "/history";
+    for (const String& key : fakeRtdbKeys(node)) {
+        FirebaseJsonData value;
+        fakeRtdbGet(node + "/" + key, value);
+        std::vector<uint8_t> block = fromBase64(value.stringValue);
+        CHECK(block.size() <= HISTORY_BLOCK_BYTES);
+        HistorySample samples[HISTORY_BLOCK_BYTES];
+        size_t n = decodeHistoryBlock(block.data(), block.size(), samples, HISTORY_BLOCK_BYTES);
+        CHECK_EQ(samples[0].epoch, key.toInt());
+        for (size_t i = 0; i < n; i++) {
+            if (samples[i].epoch >= fromEpoch) all.push_back(samples[i]);
+        }
+    }
+    return all;
+}
+
+static void testHourIsOneDecodableBatch() {
+    uint32_t start = time(nullptr);
+    unsigned long requests = fakeStats.rtdbRequests;
+    fakeSetRoom(23.4f, 47.0f);
+    fakeRunTasksFor(30 * 60000UL);
+    fakeSetPin(PIRPIN, HIGH);
+    fakeRunTasksFor(2 * 60000UL);
+    fakeSetPin(PIRPIN, LOW);
+    fakeRunTasksFor(29 * 60000UL);
+
+    std::vector<HistorySample> samples = uploadedSince(start + 60);
+    CHECK(samples.size() >= 58 && samples.size() <= 60);
+    int motion = 0;
+    for (size_t i = 0; i < samples.size(); i++) {
+        CHECK_EQ(samples[i].tempDeci, 234);
+        CHECK_EQ(samples[i].humidity, 47);
+        if (i > 0) CHECK_EQ(samples[i].epoch - samples[i - 1].epoch, 60);
+        motion += samples[i].motion;
+    }
+    CHECK(motion >= 2 && motion <= 3);
+    // The batch shares its request with whatever the publisher had staged.
+    CHECK(sensorHistoryStats().uploads >= 1);
+    CHECK(fakeStats.rtdbRequests - requests <= 130);
+}
+
+static void testStepsAndFailedReads() {
+    uint32_t start = time(nullptr);
+    fakeSetRoom(21.0f, 40.0f);
+    fakeRunTasksFor(10 * 60000UL);
+    fakeSetRoom(26.5f, 62.0f); // outside the one-byte deltas
+    fakeRunTasksFor(10 * 60000UL);
+    uint32_t failedFrom = time(nullptr);
+    fakeSetRoom(NAN, NAN); // DHT not answering
+    fakeRunTasksFor(3 * 60000UL);
+    fakeSetRoom(26.5f, 62.0f);
+    fakeRunTasksFor(40 * 60000UL);
+
+    std::vector<HistorySample> samples = uploadedSince(start + 120);
+    bool sawLongForm = false;
+    bool sawGap = false;
+    for (size_t i = 1; i < samples.size(); i++) {
+        const HistorySample& s = samples[i];
+        CHECK(s.tempDeci == 210 || s.tempDeci == 265 || (s.tempDeci > 210 && s.tempDeci < 265));
+        if (abs(s.tempDeci - samples[i - 1].tempDeci) > 4) sawLongForm = true;
+        uint32_t step = s.epoch - samples[i - 1].epoch;
+        CHECK_EQ(step % 60, 0);
+        if (step > 60) {
+            sawGap = true;
+            CHECK(samples[i - 1].epoch < failedFrom + 60 && s.epoch > failedFrom + 120);
+        }
+    }
+    CHECK(sawLongForm);
+    CHECK(sawGap);
+}
+
+static void testDayOfflineCatchesUp() {
+    uint32_t start = time(nullptr);
+    fakeSetRoom(24.0f, 50.0f);
+    fakeSetRtdbFailing(true); // writes fail, the device stays up
+    for (int minute = 0; minute < 24 * 60; minute++) {
+        fakeSetRoom(24.0f + (minute / 7 % 9) * 0.1f, 50.0f + (minute / 31 % 3));
+        fakeRunTasksFor(60000);
+    }
+    uint32_t back = time(nullptr);
+    CHECK(historyFlashFiles() >= 1);
+    CHECK(sensorHistoryStats().spills >= 1);
+    CHECK(LittleFS.usedBytes() > 0);
+    fakeSetRtdbFailing(false);
+    fakeRunTasksFor(70 * 60000UL);
+
+    CHECK_EQ(historyFlashFiles(), 0);
+    std::vector<HistorySample> samples = uploadedSince(start + 60);
+    size_t offline = 0;
+    for (size_t i = 0; i < samples.size(); i++) {
+        if (samples[i].epoch < back) offline++;
+        if (i > 0) CHECK_EQ(samples[i].epoch - samples[i - 1].epoch, 60);
+    }
+    CHECK(offline >= 24 * 60 - 2);
+}
+
+static void testResetDropsSpilledHistory() {
+    fakeSetRtdbFailing(true);
+    fakeRunTasksFor(3 * HISTORY_UPLOAD_INTERVAL);
+    CHECK(historyFlashFiles() >= 1);
+
+    bool restarted = false;
+    try {
+        resetDevice();
+    } catch (const FakeRestart&) {
+        restarted = true;
+    }
+    CHECK(restarted);
+    fakeSetRtdbFailing(false);
+    CHECK_EQ(historyFlashFiles(), 0);
+    File dir = LittleFS.open(HISTORY_DIR);
+    CHECK(!dir.openNextFile());
+}
+
+int main() {
+    bootDevice();
+    RUN_TEST(testHourIsOneDecodableBatch);
+    RUN_TEST(testStepsAndFailedReads);
+    RUN_TEST(testDayOfflineCatchesUp);
+    RUN_TEST(testResetDropsSpilledHistory);
+    return hostTestResult();
+}
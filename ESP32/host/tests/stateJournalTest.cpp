@@ -0,0 +1,198 @@
+// The offline journal behind the publisher: writes made while flushes fail
+// land on flash coalesced by path, transient ones stay out, a full
+// publisher loses nothing, and the next good flush replays the journal in
+// one request and removes it. A journal left by a restart goes up first and
+// is laid over the device node before the last state is restored, unless
+// a factory reset came in between.
+
+#include <LittleFS.h>
+#include "hostTest.h"
+#include "deviceFixture.h"
+#include "rtdbPublisher.h"
+#include "stateJournal.h"
+#include "FirestoreServices.h"
+
+static const char* const kBase = "/devices/journal";
+
+static NetRequest boolWrite(const char* path, bool value) {
+    NetRequest r = {};
+    r.op = NET_SET_BOOL;
+    r.priority = PUBLISH_SOON;
+    snprintf(r.path, sizeof(r.path), "%s", path);
+    r.b = value;
+    return r;
+}
+
+static NetRequest stringWrite(const char* path, const char* value) {
+    NetRequest r = {};
+    r.op = NET_SET_STRING;
+    r.priority = PUBLISH_SOON;
+    snprintf(r.path, sizeof(r.path), "%s", path);
+    snprintf(r.s, sizeof(r.s), "%s", value);
+    return r;
+}
+
+static FirebaseJsonData stored(const char* path) {
+    FirebaseJsonData out;
+    fakeRtdbGet(String(kBase) + path, out);
+    return out;
+}
+
+static void start() {
+    fakeReset();
+    fakeSetSerialEcho(false);
+    initRtdbPublisher(kBase);
+    rtdbPublisherOnline();
+}
+
+// Lets the failing flush happen, then brings the database back and waits
+// out the retry delay.
+static void recover() {
+    fakeSetRtdbFailing(false);
+    fakeAdvanceMillis(PUBLISH_RETRY_MS);
+    CHECK(handleRtdbPublisher());
+}
+
+static void testOfflineWritesReplayOnce() {
+    start();
+    fakeSetRtdbFailing(true);
+    rtdbPublish(boolWrite("/status/powered", true));
+    fakeAdvanceMillis(PUBLISH_SOON_MS);
+    CHECK(!handleRtdbPublisher());
+    CHECK(journalPending());
+    rtdbPublish(boolWrite("/status/powered", false));
+    rtdbPublish(boolWrite("/status/powered", true));
+    rtdbPublish(stringWrite("/status/mode", "eco"));
+    NetRequest heartbeat = {};
+    heartbeat.op = NET_SET_INT;
+    heartbeat.transient = true;
+    snprintf(heartbeat.path, sizeof(heartbeat.path), "/status/online");
+    heartbeat.i = 1752440400;
+    rtdbPublish(heartbeat);
+
+    NetRequest journal[JOURNAL_MAX_PATHS];
+    size_t n = loadJournal(journal, JOURNAL_MAX_PATHS);
+    CHECK_EQ(n, 2);
+    CHECK(strcmp(journal[0].path, "/status/powered") == 0 && journal[0].b);
+    CHECK(strcmp(journal[1].s, "eco") == 0);
+
+    unsigned long requests = fakeStats.rtdbRequests;
+    recover();
+    CHECK_EQ(fakeStats.rtdbRequests - requests, 1);
+    CHECK(stored("/status/powered").boolValue);
+    CHECK(stored("/status/mode").stringValue == "eco");
+    CHECK(!journalPending());
+    CHECK(!LittleFS.exists(JOURNAL_FILE));
+}
+
+static void testFullPublisherLosesNothing() {
+    start();
+    fakeSetRtdbFailing(true);
+    char path[32];
+    for (int i = 0; i < PUBLISH_SLOTS + 4; i++) {
+        snprintf(path, sizeof(path), "/status/flag%d", i);
+        rtdbPublish(boolWrite(path, true));
+    }
+    recover();
+    for (int i = 0; i < PUBLISH_SLOTS + 4; i++) {
+        snprintf(path, sizeof(path), "/status/flag%d", i);
+        CHECK(stored(path).boolValue);
+    }
+    CHECK(!journalPending());
+}
+
+static void testJournalStaysCompact() {
+    start();
+    fakeSetRtdbFailing(true);
+    rtdbPublish(stringWrite("/status/idleFlag", "idle"));
+    fakeAdvanceMillis(PUBLISH_SOON_MS);
+    CHECK(!handleRtdbPublisher());
+    char value[8];
+    for (int i = 0; i < 500; i++) {
+        snprintf(value, sizeof(value), "v%d", i);
+        rtdbPublish(stringWrite("/status/mode", value));
+    }
+    File file = LittleFS.open(JOURNAL_FILE);
+    CHECK(file.size() <= JOURNAL_COMPACT_BYTES + 64);
+    file.close();
+    NetRequest journal[JOURNAL_MAX_PATHS];
+    CHECK_EQ(loadJournal(journal, JOURNAL_MAX_PATHS), 2);
+    CHECK(strcmp(journal[1].s, "v499") == 0);
+    recover();
+    CHECK(stored("/status/mode").stringValue == "v499");
+}
+
+static void testJournalFromBeforeRestart() {
+    fakeReset();
+    fakeSetSerialEcho(false);
+    initStateJournal();
+    journalWrite(boolWrite("/status/powered", true));
+    journalWrite(stringWrite("/status/idleFlag", "shutting_down"));
+
+    // The restored state sees the journal over what the cloud still holds.
+    FirebaseJson node;
+    node.set("status/powered", false);
+    node.set("status/mode", "regular");
+    addJournalTo(node);
+    FirebaseJsonData result;
+    node.get(result, "status/powered");
+    CHECK(result.boolValue);
+    node.get(result, "status/mode");
+    CHECK(result.stringValue == "regular");
+
+    unsigned long replays = rtdbPublisherStats().replays;
+    initRtdbPublisher(kBase);
+    rtdbPublisherOnline();
+    CHECK_EQ(rtdbPublisherDueInMs(), 0);
+    CHECK(handleRtdbPublisher());
+    CHECK_EQ(fakeStats.rtdbRequests, 1);
+    CHECK(stored("/status/powered").boolValue);
+    CHECK(stored("/status/idleFlag").stringValue == "shutting_down");
+    CHECK(!journalPending());
+    CHECK_EQ(rtdbPublisherStats().replays - replays, 1);
+}
+
+static void testResetDropsJournal() {
+    fakeReset();
+    fakeSetSerialEcho(false);
+    initStateJournal();
+    journalWrite(boolWrite("/status/relay", true));
+    CHECK(journalPending());
+
+    bool restarted = false;
+    try {
+        resetDevice();
+    } catch (const FakeRestart&) {
+        restarted = true;
+    }
+    CHECK(restarted);
+    CHECK(!LittleFS.exists(JOURNAL_FILE));
+    journalWrite(boolWrite("/status/lights", true)); // after the reset, before the restart
+    CHECK(!LittleFS.exists(JOURNAL_FILE));
+
+    // The next boot finds nothing to lay over the new owner's node.
+    initStateJournal();
+    CHECK(!journalPending());
+    FirebaseJson node;
+    node.set("status/relay", false);
+    addJournalTo(node);
+    FirebaseJsonData result;
+    node.get(result, "status/relay");
+    CHECK(!result.boolValue);
+    unsigned long requests = fakeStats.rtdbRequests;
+    initRtdbPublisher(kBase);
+    rtdbPublisherOnline();
+    handleRtdbPublisher();
+    CHECK_EQ(fakeStats.rtdbRequests, requests);
+    CHECK(!stored("/status/relay").success);
+    CHECK(!stored("/status/lights").success);
+}
+
+int main() {
+    RUN_TEST(testOfflineWritesReplayOnce);
+    RUN_TEST(testFullPublisherLosesNothing);
+    RUN_TEST(testJournalStaysCompact);
+    RUN_TEST(testJournalFromBeforeRestart);
+    RUN_TEST(testResetDropsJournal);
+    return hostTestResult();
+}
@@ -0,0 +1,150 @@
+#include <IRrecv.h>
+#include <Preferences.h>
+#include "irCodes.h"
+#include "log.h"
+
+static uint8_t codeBuffer[IR_CODE_MAX_BYTES];
+static uint16_t legacyTicks[IR_CAPTURE_BUFFER];
+static IrFrame irFrames[IR_FRAME_KEYS];
+static const char* const irFrameNames[IR_FRAME_KEYS] = {"on", "off", "tempUp", "tempDown"};
+
+static void invalidateIrFrame(const char* key) {
+  for (int i = 0; i < IR_FRAME_KEYS; i++) {
+    if (strcmp(irFrameNames[i], key) == 0) irFrames[i].loaded = false;
+  }
+}
+
+static size_t putVarint(uint32_t value, uint8_t* out, size_t pos, size_t outSize) {
+  while (value >= 0x80) {
+    if (pos >= outSize) return 0;
+    out[pos++] = (value & 0x7F) | 0x80;
+    value >>= 7;
+  }
+  if (pos >= outSize) return 0;
+  out[pos++] = value;
+  return pos;
+}
+
+size_t encodeIrCode(const volatile uint16_t* ticks, uint16_t count, uint8_t tickUs, uint8_t carrierKhz,
+                    uint8_t* out, size_t outSize) {
+  if (count == 0 || tickUs == 0 || outSize < IR_CODE_HEADER_SIZE) return 0;
+  out[0] = IR_CODE_VERSION;
+  out[1] = carrierKhz;
+  out[2] = tickUs;
+  out[3] = 0;
+  out[4] = count & 0xFF;
+  out[5] = count >> 8;
+
+  size_t pos = IR_CODE_HEADER_SIZE;
+  uint16_t prev[2] = {0, 0}; // last mark, last space
+  for (uint16_t i = 0; i < count; i++) {
+    int32_t delta = (int32_t)ticks[i] - prev[i & 1];
+    prev[i & 1] = ticks[i];
+    uint32_t zigzag = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+    pos = putVarint(zigzag, out, pos, outSize);
+    if (pos == 0) return 0;
+  }
+  return pos;
+}
+
+uint16_t decodeIrCode(const uint8_t* code, size_t len, uint16_t* timingsUs, uint16_t maxTimings,
+                      uint8_t* carrierKhz) {
+  if (len < IR_CODE_HEADER_SIZE || code[0] != IR_CODE_VERSION || code[2] == 0) return 0;
+  uint16_t count = code[4] | (code[5] << 8);
+  if (count == 0 || count > maxTimings) return 0;
+  uint8_t tickUs = code[2];
+
+  size_t pos = IR_CODE_HEADER_SIZE;
+  int32_t prev[2] = {0, 0};
+  for (uint16_t i = 0; i < count; i++) {
+    uint32_t zigzag = 0;
+    for (uint8_t shift = 0;; shift += 7) {
+      if (pos >= len || shift > 21) return 0;
+      uint8_t next = code[pos++];
+      zigzag |= (uint32_t)(next & 0x7F) << shift;
+      if (!(next & 0x80)) break;
+    }
+    int32_t value = prev[i & 1] + (int32_t)((zigzag >> 1) ^ -(int32_t)(zigzag & 1));
+    if (value < 0 || value > 0xFFFF) return 0;
+    prev[i & 1] = value;
+    uint32_t us = (uint32_t)value * tickUs;
+    timingsUs[i] = us > 0xFFFF ? 0xFFFF : us;
+  }
+  if (carrierKhz) *carrierKhz = code[1];
+  return count;
+}
+
+bool saveIrCode(const char* key, const volatile uint16_t* ticks, uint16_t count, uint8_t tickUs) {
+  size_t len = encodeIrCode(ticks, count, tickUs, IR_CARRIER_KHZ, codeBuffer, sizeof(codeBuffer));
+  if (len == 0) {
+    LOGF_ERROR("❌ IR code for %s does not fit (%u timings)", key, count);
+    return false;
+  }
+  Preferences prefs;
+  prefs.begin("setup", false);
+  prefs.remove(key); // may still hold a legacy CSV string
+  bool saved = prefs.putBytes(key, codeBuffer, len) == len;
+  prefs.end();
+  invalidateIrFrame(key);
+  LOGF("💾 Stored %s: %u timings in %u bytes", key, count, (unsigned)len);
+  return saved;
+}
+
+// Codes learned before the binary format were saved as "9000,4500,560,...".
+// They are converted once, the first time they are loaded.
+static uint16_t migrateLegacyIrCode(const char* key, const String& csv) {
+  uint16_t count = 0;
+  const char* p = csv.c_str();
+  while (*p && count < IR_CAPTURE_BUFFER) {
+    char* end;
+    long us = strtol(p, &end, 10);
+    if (end == p) break;
+    legacyTicks[count++] = (us + kRawTick / 2) / kRawTick;
+    p = *end == ',' ? end + 1 : end;
+  }
+  if (count == 0 || !saveIrCode(key, legacyTicks, count, kRawTick)) return 0;
+  LOGF("♻️ Migrated legacy IR code %s", key);
+  return count;
+}
+
+uint16_t loadIrCode(const char* key, uint16_t* timingsUs, uint16_t maxTimings, uint8_t* carrierKhz) {
+  Preferences prefs;
+  prefs.begin("setup", true);
+  size_t len = prefs.getBytesLength(key);
+  if (len == 0) {
+    String csv = prefs.getString(key, "");
+    prefs.end();
+    if (csv.isEmpty() || migrateLegacyIrCode(key, csv) == 0) return 0;
+    prefs.begin("setup", true);
+    len = prefs.getBytesLength(key);
+  }
+  if (len > sizeof(codeBuffer)) len = 0;
+  len = len ? prefs.getBytes(key, codeBuffer, len) : 0;
+  prefs.end();
+  return decodeIrCode(codeBuffer, len, timingsUs, maxTimings, carrierKhz);
+}
+
+const char* irFrameName(IrFrameKey key) {
+  return irFrameNames[key];
+}
+
+static void loadIrFrame(IrFrameKey key) {
+  IrFrame& frame = irFrames[key];
+  frame.carrierKhz = IR_CARRIER_KHZ;
+  frame.count = loadIrCode(irFrameNames[key], frame.timings, IR_CAPTURE_BUFFER, &frame.carrierKhz);
+  frame.loaded = true; // a missing code is cached too, so it is not looked up on every press
+}
+
+void loadIrFrames() {
+  int cached = 0;
+  for (int i = 0; i < IR_FRAME_KEYS; i++) {
+    loadIrFrame((IrFrameKey)i);
+    if (irFrames[i].count) cached++;
+  }
+  LOGF("📦 Cached %d/%d learned IR frames", cached, IR_FRAME_KEYS);
+}
+
+const IrFrame* getIrFrame(IrFrameKey key) {
+  if (!irFrames[key].loaded) loadIrFrame(key);
+  return irFrames[key].count ? &irFrames[key] : nullptr;
+}
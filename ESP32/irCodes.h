@@ -0,0 +1,47 @@
+#ifndef IR_CODES_H
+#define IR_CODES_H
+
+#include <Arduino.h>
+#include "parameters.h"
+
+// Learned IR codes are stored in the "setup" namespace as compact blobs:
+//   [version][carrier kHz][tick us][reserved][count lo][count hi]
+// followed by one varint per timing. Timings are kept in receiver ticks and
+// each one is delta-coded against the previous timing of the same kind
+// (mark vs space), zigzagged, then LEB128-encoded.
+
+#define IR_CODE_VERSION 1
+#define IR_CODE_HEADER_SIZE 6
+#define IR_CODE_MAX_BYTES (IR_CODE_HEADER_SIZE + 3 * IR_CAPTURE_BUFFER)
+
+size_t encodeIrCode(const volatile uint16_t* ticks, uint16_t count, uint8_t tickUs, uint8_t carrierKhz,
+                    uint8_t* out, size_t outSize);
+uint16_t decodeIrCode(const uint8_t* code, size_t len, uint16_t* timingsUs, uint16_t maxTimings,
+                      uint8_t* carrierKhz);
+
+bool saveIrCode(const char* key, const volatile uint16_t* ticks, uint16_t count, uint8_t tickUs);
+uint16_t loadIrCode(const char* key, uint16_t* timingsUs, uint16_t maxTimings, uint8_t* carrierKhz);
+
+// The Custom model's four learned frames, decoded once into RAM so a command
+// reaches the IR LED without touching flash. saveIrCode() drops the cached
+// copy of the key it rewrites; the next getIrFrame() reloads it.
+enum IrFrameKey {
+  IR_FRAME_ON,
+  IR_FRAME_OFF,
+  IR_FRAME_TEMP_UP,
+  IR_FRAME_TEMP_DOWN,
+  IR_FRAME_KEYS
+};
+
+struct IrFrame {
+  bool loaded;
+  uint8_t carrierKhz;
+  uint16_t count;
+  uint16_t timings[IR_CAPTURE_BUFFER];
+};
+
+const char* irFrameName(IrFrameKey key);
+void loadIrFrames();
+const IrFrame* getIrFrame(IrFrameKey key);
+
+#endif
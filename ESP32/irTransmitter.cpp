@@ -0,0 +1,210 @@
+#include <driver/rmt.h>
+#include "irTransmitter.h"
+#include "deadlines.h"
+#include "powerSave.h"
+#include "metrics.h"
+#include "log.h"
+
+#define IR_TX_CHANNEL RMT_CHANNEL_0
+#define IR_TX_MAX_ITEMS (IR_CAPTURE_BUFFER / 2 + 8)
+#define IR_TX_MAX_DURATION 32767 // 15-bit item duration, in 1 us ticks
+#define IR_TX_DUTY_PERCENT 50 // IRsend's default, as sendRaw() and send() use
+#define RMT_SOURCE_CLOCK_HZ 80000000
+
+// Electra / LG timings, as in IRremoteESP8266.
+#define ELECTRA_HDR_MARK 9166
+#define ELECTRA_HDR_SPACE 4470
+#define ELECTRA_BIT_MARK 646
+#define ELECTRA_ONE_SPACE 1647
+#define ELECTRA_ZERO_SPACE 547
+#define ELECTRA_MAX_BYTES 13
+#define LG_HDR_MARK 8500
+#define LG_HDR_SPACE 4250
+#define LG_BIT_MARK 550
+#define LG_ONE_SPACE 1600
+#define LG_ZERO_SPACE 550
+#define LG_BITS 28
+#define LG_MIN_GAP 39750
+#define LG_MIN_MESSAGE 108050
+
+struct IrTxSlot {
+  rmt_item32_t items[IR_TX_MAX_ITEMS];
+  uint16_t halves; // mark/space durations written so far
+  uint32_t airUs;
+  unsigned long queuedUs;
+  uint8_t carrierKhz;
+  IrTxDoneCallback done;
+  void* arg;
+};
+
+// The RMT driver reads the items while the frame is on air, so they live in
+// static slots until the frame completes.
+static IrTxSlot txSlots[IR_TX_QUEUE];
+static uint8_t txHead = 0;   // slot on air (or next to go)
+static uint8_t txQueued = 0; // slots in use, including the one on air
+static bool txActive = false;
+static bool txReady = false;
+static uint16_t protocolTimings[2 + 16 * ELECTRA_MAX_BYTES + 1];
+static Deadline irDeadline = {"ir", handleIrTransmitter};
+
+void initIrTransmitter() {
+  if (txReady) return;
+  rmt_config_t config = {};
+  config.rmt_mode = RMT_MODE_TX;
+  config.channel = IR_TX_CHANNEL;
+  config.gpio_num = (gpio_num_t)IRLED;
+  config.clk_div = 80; // 1 us per tick
+  config.mem_block_num = 1;
+  config.tx_config.carrier_freq_hz = IR_CARRIER_KHZ * 1000;
+  config.tx_config.carrier_level = RMT_CARRIER_LEVEL_HIGH;
+  config.tx_config.idle_level = RMT_IDLE_LEVEL_LOW;
+  config.tx_config.carrier_duty_percent = IR_TX_DUTY_PERCENT;
+  config.tx_config.carrier_en = true;
+  config.tx_config.idle_output_en = true;
+  txReady = rmt_config(&config) == ESP_OK && rmt_driver_install(IR_TX_CHANNEL, 0, 0) == ESP_OK;
+  if (txReady) {
+    LOG_INFO("✅ RMT IR transmitter ready");
+  } else {
+    LOG_ERROR("❌ RMT IR transmitter init failed");
+  }
+}
+
+static bool appendPulse(IrTxSlot& slot, bool mark, uint32_t us) {
+  slot.airUs += us;
+  while (us > 0) {
+    uint16_t duration = us > IR_TX_MAX_DURATION ? IR_TX_MAX_DURATION : us;
+    us -= duration;
+    if (slot.halves / 2 >= IR_TX_MAX_ITEMS) return false;
+    rmt_item32_t& item = slot.items[slot.halves / 2];
+    if (slot.halves & 1) {
+      item.duration1 = duration;
+      item.level1 = mark;
+    } else {
+      item.duration0 = duration;
+      item.level0 = mark;
+      item.duration1 = 0;
+      item.level1 = 0;
+    }
+    slot.halves++;
+  }
+  return true;
+}
+
+static void startSlot(IrTxSlot& slot) {
+  // A bit-banged send may have taken the pin over since the last frame.
+  rmt_set_gpio(IR_TX_CHANNEL, RMT_MODE_TX, (gpio_num_t)IRLED, false);
+  uint16_t period = RMT_SOURCE_CLOCK_HZ / (slot.carrierKhz * 1000UL);
+  uint16_t high = period * IR_TX_DUTY_PERCENT / 100;
+  rmt_set_tx_carrier(IR_TX_CHANNEL, true, high, period - high, RMT_CARRIER_LEVEL_HIGH);
+  txActive = rmt_write_items(IR_TX_CHANNEL, slot.items, (slot.halves + 1) / 2, false) == ESP_OK;
+  if (!txActive) {
+    LOG_ERROR("❌ RMT refused IR frame");
+    return;
+  }
+  holdAwake(AWAKE_IR, true); // the RMT stops in light sleep
+  armDeadline(controlDeadlines, irDeadline, (slot.airUs + 999) / 1000);
+}
+
+static void finishSlot() {
+  IrTxSlot& slot = txSlots[txHead];
+  txActive = false;
+  txHead = (txHead + 1) % IR_TX_QUEUE;
+  txQueued--;
+  if (txQueued == 0) holdAwake(AWAKE_IR, false);
+  recordMetricUs(METRIC_IR_SEND, micros() - slot.queuedUs);
+  if (slot.done) slot.done(slot.arg);
+}
+
+void handleIrTransmitter() {
+  if (txQueued == 0) return;
+  if (txActive) {
+    if (rmt_wait_tx_done(IR_TX_CHANNEL, 0) != ESP_OK) {
+      armDeadline(controlDeadlines, irDeadline, 1);
+      return;
+    }
+    finishSlot();
+    if (txQueued == 0) return;
+  }
+  startSlot(txSlots[txHead]);
+  if (!txActive) {
+    countMetric(METRIC_IR_DROPPED);
+    finishSlot(); // drop it rather than retry forever
+  }
+}
+
+bool irTransmitterBusy() {
+  return txQueued > 0;
+}
+
+void waitIrTransmitter() {
+  while (txQueued > 0) {
+    if (txActive) rmt_wait_tx_done(IR_TX_CHANNEL, portMAX_DELAY);
+    handleIrTransmitter();
+  }
+}
+
+bool irTransmit(const uint16_t* timingsUs, uint16_t count, uint8_t carrierKhz, uint32_t gapUs,
+                IrTxDoneCallback done, void* arg) {
+  if (!txReady || count == 0 || carrierKhz == 0) return false;
+  handleIrTransmitter();
+  if (txQueued == IR_TX_QUEUE) {
+    countMetric(METRIC_IR_DROPPED);
+    LOG_ERROR("🚫 IR transmit queue full, frame dropped");
+    return false;
+  }
+  IrTxSlot& slot = txSlots[(txHead + txQueued) % IR_TX_QUEUE];
+  slot.halves = 0;
+  slot.airUs = 0;
+  slot.queuedUs = micros();
+  slot.carrierKhz = carrierKhz;
+  slot.done = done;
+  slot.arg = arg;
+  bool fits = true;
+  for (uint16_t i = 0; i < count && fits; i++) {
+    fits = appendPulse(slot, !(i & 1), timingsUs[i]);
+  }
+  // Frames end on a mark; the trailing space holds the carrier off between messages.
+  if (fits) fits = appendPulse(slot, false, gapUs);
+  if (!fits) {
+    countMetric(METRIC_IR_DROPPED);
+    LOGF_ERROR("❌ IR frame of %u timings does not fit the RMT buffer", count);
+    return false;
+  }
+  txQueued++;
+  if (!txActive) handleIrTransmitter();
+  return true;
+}
+
+static uint16_t appendBits(uint16_t pos, uint32_t data, uint8_t nbits, bool msbFirst, uint16_t bitMark,
+                           uint16_t oneSpace, uint16_t zeroSpace) {
+  for (uint8_t i = 0; i < nbits; i++) {
+    bool bit = msbFirst ? (data >> (nbits - 1 - i)) & 1 : (data >> i) & 1;
+    protocolTimings[pos++] = bitMark;
+    protocolTimings[pos++] = bit ? oneSpace : zeroSpace;
+  }
+  return pos;
+}
+
+bool irTransmitElectra(const uint8_t* state, uint16_t nbytes) {
+  if (nbytes > ELECTRA_MAX_BYTES) return false;
+  uint16_t pos = 0;
+  protocolTimings[pos++] = ELECTRA_HDR_MARK;
+  protocolTimings[pos++] = ELECTRA_HDR_SPACE;
+  for (uint16_t i = 0; i < nbytes; i++) {
+    pos = appendBits(pos, state[i], 8, false, ELECTRA_BIT_MARK, ELECTRA_ONE_SPACE, ELECTRA_ZERO_SPACE);
+  }
+  protocolTimings[pos++] = ELECTRA_BIT_MARK;
+  return irTransmit(protocolTimings, pos, IR_CARRIER_KHZ);
+}
+
+bool irTransmitLg(uint32_t data) {
+  uint16_t pos = 0;
+  protocolTimings[pos++] = LG_HDR_MARK;
+  protocolTimings[pos++] = LG_HDR_SPACE;
+  pos = appendBits(pos, data, LG_BITS, true, LG_BIT_MARK, LG_ONE_SPACE, LG_ZERO_SPACE);
+  protocolTimings[pos++] = LG_BIT_MARK;
+  uint32_t airTime = 0;
+  for (uint16_t i = 0; i < pos; i++) airTime += protocolTimings[i];
+  uint32_t gap = airTime + LG_MIN_GAP < LG_MIN_MESSAGE ? LG_MIN_MESSAGE - airTime : LG_MIN_GAP;
+  return irTransmit(protocolTimings, pos, IR_CARRIER_KHZ, gap);
+}
@@ -0,0 +1,32 @@
+#ifndef IR_TRANSMITTER_H
+#define IR_TRANSMITTER_H
+
+#include <Arduino.h>
+#include "parameters.h"
+
+// IR frames are handed to the RMT peripheral, which generates the carrier and
+// clocks the marks/spaces out on its own, so the CPU is free while a frame is
+// on air. A frame sent while another is going out waits in a small queue;
+// handleIrTransmitter() runs on a control deadline set to the frame's air
+// time, starts the next frame and runs the completion callbacks.
+
+#define IR_TX_QUEUE 2
+#define IR_TX_MESSAGE_GAP_US 100000 // silence kept after a raw frame
+
+typedef void (*IrTxDoneCallback)(void* arg);
+
+void initIrTransmitter();
+void handleIrTransmitter();
+bool irTransmitterBusy();
+void waitIrTransmitter(); // blocks until the queue drains, e.g. before a bit-banged send
+
+// Queues a raw mark/space frame in microseconds. Returns false if the queue is
+// full or the frame does not fit the RMT buffer.
+bool irTransmit(const uint16_t* timingsUs, uint16_t count, uint8_t carrierKhz,
+                uint32_t gapUs = IR_TX_MESSAGE_GAP_US, IrTxDoneCallback done = nullptr, void* arg = nullptr);
+
+// Protocol encoders for the state the library classes hold (getRaw()).
+bool irTransmitElectra(const uint8_t* state, uint16_t nbytes);
+bool irTransmitLg(uint32_t data);
+
+#endif
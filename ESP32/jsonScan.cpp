@@ -0,0 +1,202 @@
+#include "jsonScan.h"
+
+namespace {
+
+struct Scanner {
+  const char* p;
+  char path[JSON_SCAN_MAX_PATH];
+  size_t pathLen;
+  JsonScanCallback callback;
+  void* context;
+};
+
+void skipSpace(Scanner& s) {
+  while (*s.p == ' ' || *s.p == '\t' || *s.p == '\n' || *s.p == '\r') s.p++;
+}
+
+// Leaves s.p after the closing quote.
+bool scanString(Scanner& s, const char*& start, size_t& len) {
+  if (*s.p != '"') return false;
+  start = ++s.p;
+  while (*s.p != '"') {
+    if (*s.p == '\0') return false;
+    if (*s.p == '\\' && *++s.p == '\0') return false;
+    s.p++;
+  }
+  len = s.p - start;
+  s.p++;
+  return true;
+}
+
+bool pushSegment(Scanner& s, const char* segment, size_t len) {
+  if (s.pathLen + 1 + len >= sizeof(s.path)) return false;
+  s.path[s.pathLen++] = '/';
+  memcpy(s.path + s.pathLen, segment, len);
+  s.pathLen += len;
+  s.path[s.pathLen] = '\0';
+  return true;
+}
+
+void popTo(Scanner& s, size_t len) {
+  s.pathLen = len;
+  s.path[len] = '\0';
+}
+
+void report(Scanner& s, JsonScanType type, const char* text, size_t len) {
+  JsonScalar value = {s.path, type, text, len};
+  s.callback(value, s.context);
+}
+
+bool scanValue(Scanner& s, int depth);
+
+bool scanObject(Scanner& s, int depth) {
+  size_t parent = s.pathLen;
+  s.p++;
+  skipSpace(s);
+  if (*s.p == '}') {
+    s.p++;
+    return true;
+  }
+  for (;;) {
+    const char* key;
+    size_t keyLen;
+    skipSpace(s);
+    if (!scanString(s, key, keyLen) || !pushSegment(s, key, keyLen)) return false;
+    skipSpace(s);
+    if (*s.p++ != ':' || !scanValue(s, depth + 1)) return false;
+    popTo(s, parent);
+    skipSpace(s);
+    if (*s.p == '}') {
+      s.p++;
+      return true;
+    }
+    if (*s.p++ != ',') return false;
+  }
+}
+
+bool scanArray(Scanner& s, int depth) {
+  size_t parent = s.pathLen;
+  s.p++;
+  skipSpace(s);
+  if (*s.p == ']') {
+    s.p++;
+    return true;
+  }
+  for (int i = 0;; i++) {
+    char index[12];
+    int len = snprintf(index, sizeof(index), "[%d]", i);
+    if (!pushSegment(s, index, len) || !scanValue(s, depth + 1)) return false;
+    popTo(s, parent);
+    skipSpace(s);
+    if (*s.p == ']') {
+      s.p++;
+      return true;
+    }
+    if (*s.p++ != ',') return false;
+  }
+}
+
+bool scanLiteral(Scanner& s, const char* word, JsonScanType type) {
+  size_t len = strlen(word);
+  if (strncmp(s.p, word, len) != 0) return false;
+  report(s, type, s.p, len);
+  s.p += len;
+  return true;
+}
+
+bool scanValue(Scanner& s, int depth) {
+  if (depth > JSON_SCAN_MAX_DEPTH) return false;
+  skipSpace(s);
+  switch (*s.p) {
+    case '{': return scanObject(s, depth);
+    case '[': return scanArray(s, depth);
+    case '"': {
+      const char* text;
+      size_t len;
+      if (!scanString(s, text, len)) return false;
+      report(s, JSON_SCAN_STRING, text, len);
+      return true;
+    }
+    case 't': return scanLiteral(s, "true", JSON_SCAN_BOOL);
+    case 'f': return scanLiteral(s, "false", JSON_SCAN_BOOL);
+    case 'n': return scanLiteral(s, "null", JSON_SCAN_NULL);
+    default: {
+      const char* start = s.p;
+      while (*s.p && strchr("+-.eE0123456789", *s.p)) s.p++;
+      if (s.p == start) return false;
+      report(s, JSON_SCAN_NUMBER, start, s.p - start);
+      return true;
+    }
+  }
+}
+
+}
+
+bool scanJson(const char* text, const char* base, JsonScanCallback callback, void* context) {
+  Scanner s;
+  s.p = text;
+  s.callback = callback;
+  s.context = context;
+  s.pathLen = snprintf(s.path, sizeof(s.path), "%s", base);
+  if (s.pathLen >= sizeof(s.path)) return false;
+  if (!scanValue(s, 0)) return false;
+  skipSpace(s);
+  return *s.p == '\0';
+}
+
+long long jsonInt(const JsonScalar& value) {
+  if (value.type == JSON_SCAN_BOOL) return value.text[0] == 't';
+  if (value.type == JSON_SCAN_NULL) return 0;
+  // A number may come back as 30.0 after a round trip through the app.
+  return (long long)strtod(value.text, nullptr);
+}
+
+float jsonFloat(const JsonScalar& value) {
+  if (value.type == JSON_SCAN_BOOL) return value.text[0] == 't';
+  if (value.type == JSON_SCAN_NULL) return 0;
+  return strtof(value.text, nullptr);
+}
+
+bool jsonBool(const JsonScalar& value) {
+  if (value.type == JSON_SCAN_BOOL) return value.text[0] == 't';
+  if (value.type == JSON_SCAN_NUMBER) return strtod(value.text, nullptr) != 0;
+  return false;
+}
+
+size_t jsonString(const JsonScalar& value, char* out, size_t size) {
+  if (size == 0) return 0;
+  size_t n = 0;
+  if (value.type != JSON_SCAN_STRING) {
+    // A model or mode saved as a bare number still reads as its text.
+    n = value.type == JSON_SCAN_NULL ? 0 : (value.len < size ? value.len : size - 1);
+    memcpy(out, value.text, n);
+    out[n] = '\0';
+    return n;
+  }
+  for (size_t i = 0; i < value.len && n + 1 < size; i++) {
+    char c = value.text[i];
+    if (c == '\\' && i + 1 < value.len) {
+      c = value.text[++i];
+      switch (c) {
+        case 'n': c = '\n'; break;
+        case 't': c = '\t'; break;
+        case 'r': c = '\r'; break;
+        case 'b': c = '\b'; break;
+        case 'f': c = '\f'; break;
+        case 'u': {
+          // Only what fits a byte; the device stores no other text.
+          if (i + 4 >= value.len) break;
+          char hex[5] = {value.text[i + 1], value.text[i + 2], value.text[i + 3], value.text[i + 4], '\0'};
+          long code = strtol(hex, nullptr, 16);
+          c = code < 0x100 ? (char)code : '?';
+          i += 4;
+          break;
+        }
+        default: break; // \" \\ \/
+      }
+    }
+    out[n++] = c;
+  }
+  out[n] = '\0';
+  return n;
+}
@@ -0,0 +1,41 @@
+#ifndef JSON_SCAN_H
+#define JSON_SCAN_H
+
+#include <Arduino.h>
+
+// One pass over a JSON body without building a tree: every scalar is
+// reported with its path, in document order, and nothing is allocated. The
+// path of a value is the base followed by /key for object members and
+// /[i] for array elements, the way FirebaseJson names them:
+//
+//   scanJson("{\"monday\":{\"intervals\":[{\"start\":480}]}}", "/schedule", ...)
+//   -> "/schedule/monday/intervals/[0]/start" = 480
+//
+// Reads of the device node (FirestoreServices.cpp) go through this instead
+// of FirebaseJson, which keeps a node per value on the heap.
+
+#define JSON_SCAN_MAX_PATH 64
+#define JSON_SCAN_MAX_DEPTH 8
+
+enum JsonScanType : uint8_t { JSON_SCAN_STRING, JSON_SCAN_NUMBER, JSON_SCAN_BOOL, JSON_SCAN_NULL };
+
+struct JsonScalar {
+  const char* path;  // valid during the callback only
+  JsonScanType type;
+  const char* text;  // into the body; strings without the quotes, still escaped
+  size_t len;
+};
+
+typedef void (*JsonScanCallback)(const JsonScalar& value, void* context);
+
+// False if the body is not valid JSON or nests past the limits above;
+// values before the error have been reported.
+bool scanJson(const char* text, const char* base, JsonScanCallback callback, void* context);
+
+long long jsonInt(const JsonScalar& value);
+float jsonFloat(const JsonScalar& value);
+bool jsonBool(const JsonScalar& value); // true, or a nonzero number
+// Unescaped into `out`, cut to fit; returns the length written.
+size_t jsonString(const JsonScalar& value, char* out, size_t size);
+
+#endif
@@ -0,0 +1,386 @@
+#include <WiFi.h>
+#include <ESPAsyncWebServer.h>
+#include <ESPmDNS.h>
+#include <Firebase_ESP_Client.h>
+#include "lanApi.h"
+#include "FirestoreServices.h"
+#include "configStore.h"
+#include "log.h"
+
+struct LanClient {
+  uint32_t id; // 0 when free
+  bool authed;
+  unsigned long since;
+};
+
+static AsyncWebServer lanServer(LAN_HTTP_PORT);
+static AsyncWebSocket lanSocket("/ws");
+static const size_t kTokenChars = (LAN_TOKEN_BYTES * 8 + 5) / 6;
+static char token[kTokenChars + 1];
+static char hostName[24];
+static bool started = false;
+static LanStats stats;
+
+// Written by the tasks that post writes and read by the AsyncTCP task,
+// under `lock`.
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+static NetRequest state[LAN_STATE_PATHS];
+static size_t stateCount = 0;
+static LanClient clients[LAN_MAX_CLIENTS];
+
+// The longest `"path":value`: a full path and a full string, every
+// character of it escaped, with its terminator.
+static const size_t kValueMax = sizeof(NetRequest::path) + 2 * sizeof(NetRequest::s) + 4;
+
+static NetRequest stateCopy[LAN_STATE_PATHS]; // AsyncTCP task only
+static char stateJson[LAN_STATE_PATHS * kValueMax + 2];
+
+static void makeToken() {
+  static const char digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+  uint8_t bytes[LAN_TOKEN_BYTES + 2] = {};
+  for (int i = 0; i < LAN_TOKEN_BYTES; i += 4) {
+    uint32_t r = esp_random();
+    memcpy(bytes + i, &r, min(4, LAN_TOKEN_BYTES - i));
+  }
+  size_t n = 0;
+  for (int i = 0; i < LAN_TOKEN_BYTES; i += 3) {
+    uint32_t bits = bytes[i] << 16 | bytes[i + 1] << 8 | bytes[i + 2];
+    for (int k = 0; k < 4 && n < kTokenChars; k++) token[n++] = digits[bits >> (18 - 6 * k) & 0x3F];
+  }
+  token[n] = '\0';
+}
+
+static void loadToken() {
+  const char* stored = configString(CONFIG_LAN_TOKEN);
+  if (strlen(stored) == kTokenChars) {
+    snprintf(token, sizeof(token), "%s", stored);
+  } else {
+    makeToken();
+    setConfigString(CONFIG_LAN_TOKEN, token, CONFIG_COMMIT_NOW);
+    LOG_INFO("🔑 New LAN token created");
+  }
+}
+
+// Compares the whole token whatever the input, so timing gives nothing away.
+// Nothing matches while there is no token (after a factory reset).
+static bool tokenMatches(const char* given, size_t len) {
+  size_t expected = strlen(token);
+  uint8_t diff = len != expected || expected == 0;
+  for (size_t i = 0; i < expected; i++) diff |= token[i] ^ (i < len ? given[i] : 0);
+  return diff == 0;
+}
+
+static bool authorized(AsyncWebServerRequest* request) {
+  const String& header = request->header("Authorization");
+  bool ok = header.startsWith("Bearer ") && tokenMatches(header.c_str() + 7, header.length() - 7);
+  if (!ok) stats.rejected++;
+  return ok;
+}
+
+// `"path":value`, as the RTDB holds it; 0 if that does not fit in `size`.
+static size_t formatValue(char* out, size_t size, const NetRequest& r) {
+  int n = -1;
+  switch (r.op) {
+    case NET_SET_STRING: {
+      char escaped[2 * sizeof(r.s)];
+      size_t e = 0;
+      for (const char* c = r.s; *c && e + 2 < sizeof(escaped); c++) {
+        if (*c == '"' || *c == '\\') escaped[e++] = '\\';
+        escaped[e++] = *c;
+      }
+      escaped[e] = '\0';
+      n = snprintf(out, size, "\"%s\":\"%s\"", r.path, escaped);
+      break;
+    }
+    case NET_SET_BOOL: n = snprintf(out, size, "\"%s\":%s", r.path, r.b ? "true" : "false"); break;
+    case NET_SET_INT: n = snprintf(out, size, "\"%s\":%lld", r.path, r.i); break;
+    case NET_SET_FLOAT: n = snprintf(out, size, "\"%s\":%g", r.path, r.f); break;
+    default: break;
+  }
+  return n > 0 && (size_t)n < size ? n : 0;
+}
+
+// Every value written this boot, as one object. A value that would not fit
+// whole is left out.
+static const char* stateSnapshot() {
+  portENTER_CRITICAL(&lock);
+  size_t count = stateCount;
+  memcpy(stateCopy, state, count * sizeof(NetRequest));
+  portEXIT_CRITICAL(&lock);
+  size_t n = 0;
+  stateJson[n++] = '{';
+  for (size_t i = 0; i < count; i++) {
+    char value[kValueMax];
+    size_t len = formatValue(value, sizeof(value), stateCopy[i]);
+    size_t comma = n > 1;
+    // Room for the closing brace and the terminator too.
+    if (!len || n + comma + len + 2 > sizeof(stateJson)) continue;
+    if (comma) stateJson[n++] = ',';
+    memcpy(stateJson + n, value, len);
+    n += len;
+  }
+  stateJson[n++] = '}';
+  stateJson[n] = '\0';
+  return stateJson;
+}
+
+static void rememberValue(const NetRequest& r) {
+  portENTER_CRITICAL(&lock);
+  size_t i = 0;
+  while (i < stateCount && strcmp(state[i].path, r.path) != 0) i++;
+  if (i < LAN_STATE_PATHS) {
+    state[i] = r;
+    if (i == stateCount) stateCount++;
+  }
+  portEXIT_CRITICAL(&lock);
+}
+
+static void pushValue(const NetRequest& r) {
+  rememberValue(r);
+  char message[kValueMax + 1];
+  message[0] = '{';
+  size_t len = formatValue(message + 1, sizeof(message) - 2, r);
+  if (!len) return;
+  size_t n = 1 + len;
+  message[n++] = '}';
+  message[n] = '\0';
+  uint32_t ids[LAN_MAX_CLIENTS];
+  size_t count = 0;
+  portENTER_CRITICAL(&lock);
+  for (const LanClient& c : clients) {
+    if (c.id && c.authed) ids[count++] = c.id;
+  }
+  portEXIT_CRITICAL(&lock);
+  for (size_t i = 0; i < count; i++) {
+    lanSocket.text(ids[i], message);
+    stats.pushes++;
+  }
+}
+
+// Points field at parent/name; false, with nothing written, if that does
+// not fit in the path.
+static bool fieldPath(NetRequest& field, const char* parent, const char* name) {
+  int n = snprintf(field.path, sizeof(field.path), "%s/%s", parent, name);
+  if (n > 0 && (size_t)n < sizeof(field.path)) return true;
+  LOGF_WARN("⚠️ Sensor path too long: %s/%s", parent, name);
+  return false;
+}
+
+void lanPublish(const NetRequest& request) {
+  if (!started || request.op == NET_FETCH_SCHEDULE || request.op == NET_HISTORY) return;
+  if (request.op != NET_SENSORS) {
+    pushValue(request);
+    return;
+  }
+  // Same fields as rtdbPublish() writes.
+  NetRequest field = request;
+  field.op = NET_SET_FLOAT;
+  if (!fieldPath(field, request.path, "roomTemperature")) return;
+  field.f = request.sensors.temperature;
+  pushValue(field);
+  if (!fieldPath(field, request.path, "roomHumidity")) return;
+  field.f = request.sensors.humidity;
+  pushValue(field);
+  field.op = NET_SET_BOOL;
+  if (!fieldPath(field, request.path, "motion")) return;
+  field.b = request.sensors.motion;
+  pushValue(field);
+  if (!request.sensors.air) return;
+  field.op = NET_SET_INT;
+  if (!fieldPath(field, request.path, "eco2")) return;
+  field.i = request.sensors.eco2;
+  pushValue(field);
+  if (!fieldPath(field, request.path, "tvoc")) return;
+  field.i = request.sensors.tvoc;
+  pushValue(field);
+}
+
+static bool queueCommand(const char* json) {
+  FirebaseJson command;
+  if (!command.setJsonData(json)) return false;
+  LOG_INFO("📦 Received LAN Command - Executing...");
+  if (!postCommandJson(command)) return false;
+  stats.commands++;
+  return true;
+}
+
+// ----------------------- WebSocket -----------------------
+// A new socket takes a free slot, or one whose client never authenticated.
+static bool admitClient(uint32_t id) {
+  uint32_t evict = 0;
+  bool admitted = false;
+  unsigned long now = millis();
+  portENTER_CRITICAL(&lock);
+  for (LanClient& c : clients) {
+    if (!c.id || (!c.authed && now - c.since >= LAN_AUTH_TIMEOUT_MS)) {
+      evict = c.id;
+      c = {id, false, now};
+      admitted = true;
+      break;
+    }
+  }
+  portEXIT_CRITICAL(&lock);
+  if (evict) lanSocket.close(evict);
+  return admitted;
+}
+
+static LanClient* findClient(uint32_t id) {
+  for (LanClient& c : clients) {
+    if (c.id == id) return &c;
+  }
+  return nullptr;
+}
+
+static void onSocketMessage(AsyncWebSocketClient* client, const char* text) {
+  portENTER_CRITICAL(&lock);
+  LanClient* slot = findClient(client->id());
+  bool authed = slot && slot->authed;
+  portEXIT_CRITICAL(&lock);
+  if (!slot) return;
+  if (authed) {
+    if (!queueCommand(text)) client->text("{\"/result\":\"Failed\"}");
+    return;
+  }
+  FirebaseJson hello;
+  FirebaseJsonData given;
+  if (!hello.setJsonData(text) || !hello.get(given, "token") ||
+      !tokenMatches(given.stringValue.c_str(), given.stringValue.length())) {
+    stats.rejected++;
+    client->close();
+    return;
+  }
+  portENTER_CRITICAL(&lock);
+  slot->authed = true;
+  portEXIT_CRITICAL(&lock);
+  client->text(stateSnapshot());
+}
+
+static void onSocketEvent(AsyncWebSocket* /*socket*/, AsyncWebSocketClient* client, AwsEventType type, void* arg,
+                          uint8_t* data, size_t len) {
+  switch (type) {
+    case WS_EVT_CONNECT:
+      if (!admitClient(client->id())) client->close();
+      break;
+    case WS_EVT_DISCONNECT: {
+      portENTER_CRITICAL(&lock);
+      LanClient* slot = findClient(client->id());
+      if (slot) *slot = {};
+      portEXIT_CRITICAL(&lock);
+      break;
+    }
+    case WS_EVT_DATA: {
+      // Commands and tokens fit one frame; anything else is dropped.
+      AwsFrameInfo* info = (AwsFrameInfo*)arg;
+      if (!info->final || info->index != 0 || info->len != len || info->opcode != WS_TEXT || len >= LAN_MAX_BODY) {
+        return;
+      }
+      char text[LAN_MAX_BODY];
+      memcpy(text, data, len);
+      text[len] = '\0';
+      onSocketMessage(client, text);
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+// ----------------------- HTTP -----------------------
+// The body handler leaves the status for the request handler to send.
+static void onCommandBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+  if (request->_tempObject) return;
+  int* status = (int*)malloc(sizeof(int));
+  if (!status) return;
+  request->_tempObject = status;
+  if (index != 0 || len != total || len >= LAN_MAX_BODY) {
+    *status = 413;
+    return;
+  }
+  if (!authorized(request)) {
+    *status = 401;
+    return;
+  }
+  char text[LAN_MAX_BODY];
+  memcpy(text, data, len);
+  text[len] = '\0';
+  FirebaseJson command;
+  if (!command.setJsonData(text)) {
+    *status = 400;
+  } else if (!postCommandJson(command)) {
+    *status = 503;
+  } else {
+    stats.commands++;
+    *status = 202;
+  }
+}
+
+static void onCommandRequest(AsyncWebServerRequest* request) {
+  int status = request->_tempObject ? *(int*)request->_tempObject : 400;
+  if (status == 401 || (!request->_tempObject && !authorized(request))) {
+    request->send(401, "application/json", "{\"error\":\"unauthorized\"}");
+    return;
+  }
+  if (status == 202) LOG_INFO("📦 Received LAN Command - Executing...");
+  request->send(status, "application/json", status == 202 ? "{\"queued\":true}" : "{\"queued\":false}");
+}
+
+static void onStateRequest(AsyncWebServerRequest* request) {
+  if (!authorized(request)) {
+    request->send(401, "application/json", "{\"error\":\"unauthorized\"}");
+    return;
+  }
+  request->send(200, "application/json", stateSnapshot());
+}
+
+static void publishLanInfo(const char* path, const char* value) {
+  NetRequest request = {};
+  request.op = NET_SET_STRING;
+  request.priority = PUBLISH_LAZY;
+  snprintf(request.path, sizeof(request.path), "%s", path);
+  snprintf(request.s, sizeof(request.s), "%s", value);
+  postNetRequest(request);
+}
+
+void startLanApi() {
+  if (started) {
+    if (token[0]) return;
+    loadToken(); // reset since the start
+    publishLanInfo("/lan/token", token);
+    return;
+  }
+  loadToken();
+  String mac = WiFi.macAddress();
+  mac.replace(":", "");
+  mac.toLowerCase();
+  snprintf(hostName, sizeof(hostName), "breezio-%s", mac.c_str());
+  if (MDNS.begin(hostName)) {
+    MDNS.addService("breezio", "tcp", LAN_HTTP_PORT);
+    MDNS.addServiceTxt("breezio", "tcp", "ws", "/ws");
+  } else {
+    LOG_WARN("⚠️ mDNS failed to start, the app has to use the IP address");
+  }
+
+  lanServer.on("/command", HTTP_POST, onCommandRequest, nullptr, onCommandBody);
+  lanServer.on("/state", HTTP_GET, onStateRequest);
+  lanSocket.onEvent(onSocketEvent);
+  lanServer.addHandler(&lanSocket);
+  lanServer.begin();
+  started = true;
+
+  publishLanInfo("/lan/token", token);
+  publishLanInfo("/lan/host", hostName);
+  publishLanInfo("/lan/ip", WiFi.localIP().toString().c_str());
+  LOGF("🏠 LAN API on http://%s.local:%d", hostName, LAN_HTTP_PORT);
+}
+
+void resetLanApi() {
+  token[0] = '\0';
+}
+
+const char* lanToken() {
+  return token;
+}
+
+LanStats lanApiStats() {
+  return stats;
+}
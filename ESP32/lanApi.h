@@ -0,0 +1,49 @@
+#ifndef LAN_API_H
+#define LAN_API_H
+
+#include <Arduino.h>
+#include "deviceTasks.h"
+
+// Local control for phones on the same Wi-Fi, in station mode. Commands go
+// through postCommandJson() like the ones from the RTDB stream, without the
+// round trip through the cloud:
+//
+//   POST /command  the command JSON the app writes to /command; 202 once
+//                  queued, 400 unreadable, 401 bad token, 503 queue full
+//   GET  /state    every value written this boot, as {"/status/mode": ...}
+//   /ws            WebSocket. The first message is {"token": "..."}; the
+//                  device answers with /state and then pushes every write
+//                  in the same shape. Later messages are commands.
+//
+// HTTP requests carry "Authorization: Bearer <token>". The token is made on
+// first boot and again after a factory reset, kept in NVS and written to
+// /lan/token, where only the owner's
+// app can read it. The device announces itself over mDNS as the /lan/host
+// name with a _breezio._tcp service.
+//
+// The server is ESPAsyncWebServer: its handlers run on the AsyncTCP task and
+// only queue commands, so no device task polls a socket and light sleep is
+// unaffected.
+
+#define LAN_HTTP_PORT 80
+#define LAN_MAX_CLIENTS 4
+#define LAN_AUTH_TIMEOUT_MS 5000 // an unauthenticated socket may be evicted after this
+#define LAN_MAX_BODY 512
+#define LAN_STATE_PATHS 28
+#define LAN_TOKEN_BYTES 16 // 22 base64url characters
+
+struct LanStats {
+  unsigned long commands; // queued from HTTP or WebSocket
+  unsigned long rejected; // bad or missing token
+  unsigned long pushes;   // WebSocket messages sent
+};
+
+void startLanApi(); // after startDeviceTasks(); makes and publishes a token if there is none
+// Factory reset: the token in RAM is forgotten, so no request passes until
+// the restart; the stored one goes with resetConfigStore().
+void resetLanApi();
+void lanPublish(const NetRequest& request); // from postNetRequest(), any task
+const char* lanToken();
+LanStats lanApiStats();
+
+#endif
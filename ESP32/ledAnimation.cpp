@@ -0,0 +1,94 @@
+#include "ledAnimation.h"
+#include "deadlines.h"
+
+static Adafruit_NeoPixel* ledStrip = nullptr;
+static LedEffect ledEffect = LED_EFFECT_WIPE;
+static uint32_t ledTarget = 0;
+static uint32_t ledFrom[LED_PIXELS_NUM];
+static uint16_t ledStep = 0;
+static uint16_t ledSteps = 0; // 0 when idle
+static uint16_t ledStepMs = 0;
+static unsigned long ledNextMs = 0;
+static Deadline ledDeadline = {"led", handleLedAnimation};
+
+static uint32_t blend(uint32_t from, uint32_t to, uint16_t num, uint16_t den) {
+  uint32_t out = 0;
+  for (int shift = 0; shift <= 16; shift += 8) {
+    int32_t a = (from >> shift) & 0xFF;
+    int32_t b = (to >> shift) & 0xFF;
+    out |= (uint32_t)(a + (b - a) * num / den) << shift;
+  }
+  return out;
+}
+
+static void applyStep() {
+  switch (ledEffect) {
+    case LED_EFFECT_WIPE:
+      ledStrip->setPixelColor(ledStep, ledTarget);
+      break;
+    case LED_EFFECT_FADE:
+      for (int i = 0; i < LED_PIXELS_NUM; i++) {
+        ledStrip->setPixelColor(i, blend(ledFrom[i], ledTarget, ledStep + 1, ledSteps));
+      }
+      break;
+    case LED_EFFECT_PULSE: {
+      uint16_t level = ledStep < LED_PULSE_STEPS ? ledStep + 1 : 2 * LED_PULSE_STEPS - ledStep - 1;
+      uint32_t color = blend(0, ledTarget, level, LED_PULSE_STEPS);
+      for (int i = 0; i < LED_PIXELS_NUM; i++) ledStrip->setPixelColor(i, color);
+      break;
+    }
+  }
+  ledStrip->show();
+}
+
+void initLedAnimation(Adafruit_NeoPixel& strip) {
+  ledStrip = &strip;
+  ledSteps = 0;
+}
+
+void startLedAnimation(LedEffect effect, uint32_t color) {
+  if (ledStrip == nullptr) return;
+  bool settled = ledSteps == 0;
+  for (int i = 0; i < LED_PIXELS_NUM; i++) {
+    ledFrom[i] = ledStrip->getPixelColor(i);
+    if (ledFrom[i] != color) settled = false;
+  }
+  if (settled && effect != LED_EFFECT_PULSE) return; // already showing it
+  ledEffect = effect;
+  ledTarget = color;
+  ledStep = 0;
+  switch (effect) {
+    case LED_EFFECT_WIPE:
+      ledSteps = LED_PIXELS_NUM;
+      ledStepMs = DELAYVAL;
+      break;
+    case LED_EFFECT_FADE:
+      ledSteps = LED_FADE_STEPS;
+      ledStepMs = LED_FADE_STEP_MS;
+      break;
+    case LED_EFFECT_PULSE:
+      ledSteps = 2 * LED_PULSE_STEPS;
+      ledStepMs = LED_PULSE_STEP_MS;
+      break;
+  }
+  ledNextMs = millis();
+  handleLedAnimation(); // first frame goes out now
+}
+
+void handleLedAnimation() {
+  if (ledSteps == 0 || (long)(millis() - ledNextMs) < 0) return;
+  applyStep();
+  ledNextMs = millis() + ledStepMs;
+  if (++ledStep == ledSteps) {
+    if (ledEffect != LED_EFFECT_PULSE) {
+      ledSteps = 0;
+      return;
+    }
+    ledStep = 0;
+  }
+  armDeadline(controlDeadlines, ledDeadline, ledStepMs);
+}
+
+bool ledAnimationRunning() {
+  return ledSteps != 0;
+}
@@ -0,0 +1,28 @@
+#ifndef LED_ANIMATION_H
+#define LED_ANIMATION_H
+
+#include <Arduino.h>
+#include <Adafruit_NeoPixel.h>
+#include "parameters.h"
+
+// Deadline-driven NeoPixel effects. startLedAnimation() only records the
+// target; handleLedAnimation() applies the next frame once its deadline on
+// controlDeadlines passes, so no effect ever delay()s the control task. Starting a
+// new effect replaces the running one from whatever the strip shows now.
+enum LedEffect {
+  LED_EFFECT_WIPE,  // pixels switch to the colour one by one
+  LED_EFFECT_FADE,  // every pixel blends from its current colour
+  LED_EFFECT_PULSE  // the colour breathes until another effect starts
+};
+
+#define LED_FADE_STEPS 8
+#define LED_FADE_STEP_MS 30
+#define LED_PULSE_STEPS 25 // per half period
+#define LED_PULSE_STEP_MS 40
+
+void initLedAnimation(Adafruit_NeoPixel& strip);
+void startLedAnimation(LedEffect effect, uint32_t color);
+void handleLedAnimation();
+bool ledAnimationRunning();
+
+#endif
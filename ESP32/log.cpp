@@ -0,0 +1,257 @@
+#include <atomic>
+#include "log.h"
+
+// The ring holds records back to back, each starting on a 4-byte boundary:
+//
+//   header  length (with padding), level, state
+//   body    the text or format pointer, the argument count, then per
+//           argument its type and 8 bytes, or for a string its length and
+//           the bytes with their terminator
+//
+// Writers reserve space by moving `head` with a compare-and-swap, copy the
+// record in and then set its state, so several tasks can log at once
+// without a lock. A record that would run past the end is preceded by a pad
+// record to the end. The log task reads from `tail` up to the first record
+// not yet complete, and zeroes what it has read, so a header in the next
+// lap reads as not yet complete until its writer sets it.
+
+enum LogState : uint8_t { LOG_WRITING, LOG_TEXT, LOG_FORMAT, LOG_PAD };
+
+struct LogHeader {
+  uint16_t length;
+  uint8_t level;
+  uint8_t state;
+};
+
+static uint8_t ring[LOG_RING_BYTES] __attribute__((aligned(4)));
+static std::atomic<uint32_t> head(0); // reserved up to, never wraps back
+static std::atomic<uint32_t> tail(0); // read up to
+static std::atomic<uint32_t> dropped(0);
+static std::atomic<uint32_t> ringPeak(0); // raised by any writer, so kept apart from stats
+static std::atomic<bool> draining(false);
+static TaskHandle_t logTask = nullptr;
+static LogStats stats;
+
+static const char* const levelTags[] = {"", "[ERROR] ", "[WARN] ", "[INFO] ", "[DEBUG] "};
+
+static bool reserve(uint32_t length, uint32_t& at) {
+  uint32_t start = head.load(std::memory_order_relaxed);
+  for (;;) {
+    uint32_t toEnd = LOG_RING_BYTES - start % LOG_RING_BYTES;
+    uint32_t needed = length <= toEnd ? length : toEnd + length;
+    uint32_t used = start + needed - tail.load(std::memory_order_acquire);
+    if (used > LOG_RING_BYTES) return false;
+    if (head.compare_exchange_weak(start, start + needed, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+      uint32_t peak = ringPeak.load(std::memory_order_relaxed);
+      while (used > peak && !ringPeak.compare_exchange_weak(peak, used, std::memory_order_relaxed)) continue;
+      if (needed == length) {
+        at = start;
+      } else {
+        LogHeader* pad = (LogHeader*)&ring[start % LOG_RING_BYTES];
+        pad->length = toEnd;
+        __atomic_store_n(&pad->state, (uint8_t)LOG_PAD, __ATOMIC_RELEASE);
+        at = start + toEnd;
+      }
+      return true;
+    }
+  }
+}
+
+static void commit(uint8_t level, LogState state, const uint8_t* body, uint32_t bodyLength) {
+  uint32_t length = (sizeof(LogHeader) + bodyLength + 3) & ~3u;
+  uint32_t at;
+  if (!reserve(length, at)) {
+    dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  LogHeader* header = (LogHeader*)&ring[at % LOG_RING_BYTES];
+  memcpy(header + 1, body, bodyLength);
+  header->length = length;
+  header->level = level;
+  __atomic_store_n(&header->state, (uint8_t)state, __ATOMIC_RELEASE);
+  if (logTask) xTaskNotifyGive(logTask);
+}
+
+void logText(uint8_t level, const char* text) {
+  commit(level, LOG_TEXT, (const uint8_t*)&text, sizeof(text));
+}
+
+void logArgs(uint8_t level, const char* fmt, const LogArg* args, uint8_t count) {
+  uint8_t body[LOG_RECORD_MAX - sizeof(LogHeader)];
+  size_t at = 0;
+  memcpy(body, &fmt, sizeof(fmt));
+  at += sizeof(fmt);
+  uint8_t& written = body[at++];
+  written = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    const LogArg& arg = args[i];
+    if (arg.type == LOG_ARG_STR) {
+      const char* s = arg.s ? arg.s : "(null)";
+      size_t room = sizeof(body) - at;
+      if (room < 3) break;
+      size_t len = strnlen(s, min(room - 3, (size_t)255));
+      body[at++] = LOG_ARG_STR;
+      body[at++] = len;
+      memcpy(&body[at], s, len);
+      at += len;
+      body[at++] = '\0';
+    } else {
+      if (sizeof(body) - at < 9) break;
+      body[at++] = arg.type;
+      memcpy(&body[at], &arg.u, 8);
+      at += 8;
+    }
+    written++;
+  }
+  commit(level, LOG_FORMAT, body, at);
+}
+
+// Formats one conversion of `fmt` from `arg`, returning how far it read.
+static size_t formatOne(char* out, size_t room, const char* fmt, const uint8_t* arg, size_t& used) {
+  char spec[16] = "%";
+  size_t n = 1;
+  size_t i = 1;
+  while (fmt[i] && strchr("-+ #0", fmt[i]) && n < 6) spec[n++] = fmt[i++];
+  while (fmt[i] && (isdigit((unsigned char)fmt[i]) || fmt[i] == '.') && n < 12) spec[n++] = fmt[i++];
+  while (fmt[i] && strchr("hlLqjzt", fmt[i])) i++;
+  char conversion = fmt[i];
+  if (!conversion) return i;
+  i++;
+  LogArgType type = (LogArgType)arg[0];
+  union {
+    long long i;
+    unsigned long long u;
+    double d;
+    const void* p;
+  } value = {};
+  if (type != LOG_ARG_STR) memcpy(&value.u, arg + 1, 8);
+  int printed = 0;
+  switch (conversion) {
+    case 'd': case 'i':
+      spec[n++] = 'l'; spec[n++] = 'l'; spec[n++] = 'd'; spec[n] = '\0';
+      printed = snprintf(out, room, spec, type == LOG_ARG_DOUBLE ? (long long)value.d : value.i);
+      break;
+    case 'u': case 'x': case 'X': case 'o':
+      spec[n++] = 'l'; spec[n++] = 'l'; spec[n++] = conversion; spec[n] = '\0';
+      printed = snprintf(out, room, spec, type == LOG_ARG_DOUBLE ? (unsigned long long)value.d : value.u);
+      break;
+    case 'c':
+      spec[n++] = 'c'; spec[n] = '\0';
+      printed = snprintf(out, room, spec, (int)value.i);
+      break;
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G':
+      spec[n++] = conversion; spec[n] = '\0';
+      printed = snprintf(out, room, spec, type == LOG_ARG_DOUBLE ? value.d
+                                          : type == LOG_ARG_INT ? (double)value.i : (double)value.u);
+      break;
+    case 's':
+      spec[n++] = 's'; spec[n] = '\0';
+      printed = snprintf(out, room, spec, type == LOG_ARG_STR ? (const char*)arg + 2 : "?");
+      break;
+    case 'p':
+      spec[n++] = 'p'; spec[n] = '\0';
+      printed = snprintf(out, room, spec, value.p);
+      break;
+    default:
+      printed = snprintf(out, room, "%%%c", conversion);
+      break;
+  }
+  used = printed < 0 ? 0 : min((size_t)printed, room - 1);
+  return i;
+}
+
+static void formatRecord(char* line, size_t size, const uint8_t* body) {
+  const char* fmt;
+  memcpy(&fmt, body, sizeof(fmt));
+  const uint8_t* arg = body + sizeof(fmt) + 1;
+  uint8_t args = body[sizeof(fmt)];
+  size_t at = 0;
+  while (*fmt && at < size - 1) {
+    if (*fmt != '%') {
+      line[at++] = *fmt++;
+      continue;
+    }
+    if (fmt[1] == '%') {
+      line[at++] = '%';
+      fmt += 2;
+      continue;
+    }
+    if (args == 0) {
+      line[at++] = '?';
+      fmt++;
+      continue;
+    }
+    size_t used = 0;
+    fmt += formatOne(line + at, size - at, fmt, arg, used);
+    at += used;
+    arg += arg[0] == LOG_ARG_STR ? 2 + arg[1] + 1 : 9;
+    args--;
+  }
+  line[at] = '\0';
+}
+
+static void writeRecord(const LogHeader* header) {
+  const uint8_t* body = (const uint8_t*)(header + 1);
+  const char* text;
+  char line[LOG_LINE_MAX];
+  if (header->state == LOG_TEXT) {
+    memcpy(&text, body, sizeof(text));
+  } else {
+    formatRecord(line, sizeof(line), body);
+    text = line;
+  }
+  const char* tag = header->level <= LOG_LEVEL_DEBUG ? levelTags[header->level] : "";
+  stats.bytes += Serial.print(tag);
+  stats.bytes += Serial.println(text);
+  stats.records++;
+}
+
+// One reader at a time: the log task, or logFlush() from another task.
+static void drain() {
+  bool idle = false;
+  if (!draining.compare_exchange_strong(idle, true, std::memory_order_acquire)) return;
+  uint32_t at = tail.load(std::memory_order_relaxed);
+  while (at != head.load(std::memory_order_acquire)) {
+    LogHeader* header = (LogHeader*)&ring[at % LOG_RING_BYTES];
+    uint8_t state = __atomic_load_n(&header->state, __ATOMIC_ACQUIRE);
+    if (state == LOG_WRITING) break; // its writer will notify again
+    uint16_t length = header->length;
+    if (state != LOG_PAD) writeRecord(header);
+    memset(header, 0, length);
+    at += length;
+    tail.store(at, std::memory_order_release);
+  }
+  uint32_t lost = dropped.exchange(0, std::memory_order_relaxed);
+  if (lost) {
+    stats.dropped += lost;
+    char line[48];
+    snprintf(line, sizeof(line), "[WARN] ⚠️ %lu log lines dropped", (unsigned long)lost);
+    stats.bytes += Serial.println(line);
+  }
+  draining.store(false, std::memory_order_release);
+}
+
+static void logTaskLoop(void* param) {
+  (void)param;
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    drain();
+  }
+}
+
+void startLogTask() {
+  if (logTask) return;
+  xTaskCreatePinnedToCore(logTaskLoop, "log", LOG_TASK_STACK, nullptr, LOG_TASK_PRIORITY, &logTask, LOG_TASK_CORE);
+  xTaskNotifyGive(logTask); // whatever was logged before it started
+}
+
+void logFlush() {
+  drain();
+}
+
+LogStats logStats() {
+  LogStats copy = stats;
+  copy.dropped += dropped.load(std::memory_order_relaxed);
+  copy.ringPeak = ringPeak.load(std::memory_order_relaxed);
+  return copy;
+}
@@ -1,4 +1,102 @@
-#define LOG_INFO(x)    Serial.println(String("[INFO] ") + x)
-#define LOG_WARN(x)    Serial.println(String("[WARN] ") + x)
-#define LOG_ERROR(x)   Serial.println(String("[ERROR] ") + x)
-#define LOGF(fmt, ...) do { char buf[128]; snprintf(buf, sizeof(buf), fmt, ##__VA_ARGS__); Serial.println(buf); } while(0)
\ No newline at end of file
+#ifndef LOG_H
+#define LOG_H
+
+#include <Arduino.h>
+#include <type_traits>
+
+// Logging that costs the caller a copy and never the heap or the UART. A
+// call copies its format string pointer and its arguments, in binary, into
+// a lock-free ring (log.cpp); the log task formats them and writes them to
+// Serial at the lowest priority, so no other task waits on 115200 baud.
+//
+//   LOG_INFO(text)      text is kept by pointer, so it must be a string
+//                       literal (anything else does not compile); printed
+//                       as is
+//   LOGF(fmt, ...)      printf-style: d i u x X o c s f e g p with flags,
+//                       width, precision and length modifiers; %s arguments
+//                       are copied, so c_str() of a temporary is fine
+//
+// Levels above LOG_LEVEL are compiled out, strings and arguments included;
+// a file may define LOG_LEVEL before including this. A line that finds the
+// ring full is dropped and counted. logFlush() writes out what is queued
+// from the calling task, before a restart.
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#define LOG_RING_BYTES 4096 // a power of two
+#define LOG_RECORD_MAX 192
+#define LOG_LINE_MAX 160
+#define LOG_TASK_STACK 4096
+#define LOG_TASK_PRIORITY 0
+#define LOG_TASK_CORE 0
+
+enum LogArgType : uint8_t { LOG_ARG_INT, LOG_ARG_UINT, LOG_ARG_DOUBLE, LOG_ARG_STR, LOG_ARG_PTR };
+
+struct LogArg {
+  LogArgType type;
+  union {
+    long long i;
+    unsigned long long u;
+    double d;
+    const char* s;
+    const void* p;
+  };
+};
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value, LogArg>::type logArg(T v) {
+  LogArg arg;
+  if (std::is_signed<T>::value) {
+    arg.type = LOG_ARG_INT;
+    arg.i = (long long)v;
+  } else {
+    arg.type = LOG_ARG_UINT;
+    arg.u = (unsigned long long)v;
+  }
+  return arg;
+}
+inline LogArg logArg(double v) { LogArg arg; arg.type = LOG_ARG_DOUBLE; arg.d = v; return arg; }
+inline LogArg logArg(const char* v) { LogArg arg; arg.type = LOG_ARG_STR; arg.s = v; return arg; }
+inline LogArg logArg(char* v) { return logArg((const char*)v); }
+inline LogArg logArg(const void* v) { LogArg arg; arg.type = LOG_ARG_PTR; arg.p = v; return arg; }
+
+struct LogStats {
+  unsigned long records;
+  unsigned long dropped;
+  unsigned long bytes;     // written to Serial
+  unsigned long ringPeak;  // most ring bytes in use at once
+};
+
+void logText(uint8_t level, const char* text);
+void logArgs(uint8_t level, const char* fmt, const LogArg* args, uint8_t count);
+
+template <typename... Args>
+inline void logFormat(uint8_t level, const char* fmt, Args... args) {
+  LogArg list[sizeof...(Args) + 1] = {logArg(args)...};
+  logArgs(level, fmt, list, sizeof...(Args));
+}
+
+void startLogTask(); // right after Serial.begin()
+void logFlush();
+LogStats logStats();
+
+#define LOG_AT(level, call) do { if (LOG_LEVEL >= (level)) call; } while (0)
+
+#define LOG_ERROR(x)   LOG_AT(LOG_LEVEL_ERROR, logText(LOG_LEVEL_ERROR, "" x))
+#define LOG_WARN(x)    LOG_AT(LOG_LEVEL_WARN, logText(LOG_LEVEL_WARN, "" x))
+#define LOG_INFO(x)    LOG_AT(LOG_LEVEL_INFO, logText(LOG_LEVEL_INFO, "" x))
+#define LOG_DEBUG(x)   LOG_AT(LOG_LEVEL_DEBUG, logText(LOG_LEVEL_DEBUG, "" x))
+#define LOGF_ERROR(fmt, ...) LOG_AT(LOG_LEVEL_ERROR, logFormat(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__))
+#define LOGF_WARN(fmt, ...)  LOG_AT(LOG_LEVEL_WARN, logFormat(LOG_LEVEL_WARN, fmt, ##__VA_ARGS__))
+#define LOGF(fmt, ...)       LOG_AT(LOG_LEVEL_INFO, logFormat(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__))
+#define LOGF_DEBUG(fmt, ...) LOG_AT(LOG_LEVEL_DEBUG, logFormat(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__))
+
+#endif
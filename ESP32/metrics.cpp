@@ -0,0 +1,124 @@
+#include <Firebase_ESP_Client.h>
+#include "metrics.h"
+#include "rtdbPublisher.h"
+#include "log.h"
+
+// Names as they appear on serial and under /diagnostics.
+static const char* const counterNames[METRIC_COUNTERS] = {
+  "streamTimeouts", "streamReconnects", "rtdbErrors", "commands", "irDropped",
+};
+static const char* const gaugeNames[METRIC_GAUGES] = {
+  "heapFree", "heapMinFree", "heapLargest", "stackNetwork", "stackControl", "stackSensor",
+};
+static const char* const timerNames[METRIC_TIMERS] = {
+  "rtdbRead", "rtdbStream", "rtdbWrite", "irSend", "loop", "networkRun", "controlRun", "sensorRun",
+};
+
+// 100 us to 10 s in steps of about 3x; the last bucket takes the rest.
+static const uint32_t bucketUs[METRIC_BUCKETS] = {
+  100, 300, 1000, 3000, 10000, 30000, 100000, 300000, 1000000, 3000000, 10000000, UINT32_MAX,
+};
+
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+static unsigned long counters[METRIC_COUNTERS];
+static uint32_t gauges[METRIC_GAUGES];
+static MetricHistogram timers[METRIC_TIMERS];
+
+void countMetric(MetricCounter counter) {
+  portENTER_CRITICAL(&lock);
+  counters[counter]++;
+  portEXIT_CRITICAL(&lock);
+}
+
+void setMetricGauge(MetricGauge gauge, uint32_t value) {
+  gauges[gauge] = value; // one aligned word
+}
+
+void recordMetricUs(MetricTimer timer, uint32_t us) {
+  uint8_t bucket = 0;
+  while (us > bucketUs[bucket]) bucket++;
+  portENTER_CRITICAL(&lock);
+  MetricHistogram& histogram = timers[timer];
+  histogram.buckets[bucket]++;
+  histogram.count++;
+  histogram.sumUs += us;
+  if (us > histogram.maxUs) histogram.maxUs = us;
+  portEXIT_CRITICAL(&lock);
+}
+
+unsigned long metricCount(MetricCounter counter) {
+  return counters[counter];
+}
+
+uint32_t metricGauge(MetricGauge gauge) {
+  return gauges[gauge];
+}
+
+MetricHistogram metricHistogram(MetricTimer timer) {
+  portENTER_CRITICAL(&lock);
+  MetricHistogram copy = timers[timer];
+  portEXIT_CRITICAL(&lock);
+  return copy;
+}
+
+uint32_t metricBucketUs(uint8_t bucket) {
+  return bucketUs[bucket];
+}
+
+uint32_t metricPercentileUs(const MetricHistogram& histogram, uint8_t percent) {
+  if (histogram.count == 0) return 0;
+  uint32_t wanted = ((uint64_t)histogram.count * percent + 99) / 100;
+  uint32_t seen = 0;
+  for (uint8_t i = 0; i < METRIC_BUCKETS; i++) {
+    seen += histogram.buckets[i];
+    if (seen >= wanted) return min(bucketUs[i], histogram.maxUs);
+  }
+  return histogram.maxUs;
+}
+
+void sampleMetrics() {
+  setMetricGauge(METRIC_HEAP_FREE, ESP.getFreeHeap());
+  setMetricGauge(METRIC_HEAP_MIN_FREE, ESP.getMinFreeHeap());
+  setMetricGauge(METRIC_HEAP_LARGEST, ESP.getMaxAllocHeap());
+}
+
+void logMetrics() {
+  for (int i = 0; i < METRIC_COUNTERS; i++) LOGF("📊 %-16s %lu", counterNames[i], counters[i]);
+  for (int i = 0; i < METRIC_GAUGES; i++) LOGF("📊 %-16s %lu", gaugeNames[i], (unsigned long)gauges[i]);
+  for (int i = 0; i < METRIC_TIMERS; i++) {
+    MetricHistogram h = metricHistogram((MetricTimer)i);
+    if (h.count == 0) continue;
+    LOGF("📊 %-16s n=%lu avg=%lu p50<=%lu p90<=%lu p99<=%lu max=%lu us", timerNames[i], (unsigned long)h.count,
+         (unsigned long)(h.sumUs / h.count), (unsigned long)metricPercentileUs(h, 50),
+         (unsigned long)metricPercentileUs(h, 90), (unsigned long)metricPercentileUs(h, 99),
+         (unsigned long)h.maxUs);
+  }
+}
+
+// Counters and gauges as numbers; a timer as "count,p50,p90,max" in us, so
+// the whole node is a couple of dozen short values.
+bool publishMetrics() {
+  FirebaseJson json;
+  char path[40];
+  char value[48];
+  json.set("diagnostics/uptime", (unsigned long)(millis() / 1000));
+  for (int i = 0; i < METRIC_COUNTERS; i++) {
+    snprintf(path, sizeof(path), "diagnostics/%s", counterNames[i]);
+    json.set(path, counters[i]);
+  }
+  for (int i = 0; i < METRIC_GAUGES; i++) {
+    snprintf(path, sizeof(path), "diagnostics/%s", gaugeNames[i]);
+    json.set(path, (unsigned long)gauges[i]);
+  }
+  for (int i = 0; i < METRIC_TIMERS; i++) {
+    MetricHistogram h = metricHistogram((MetricTimer)i);
+    snprintf(path, sizeof(path), "diagnostics/%s", timerNames[i]);
+    snprintf(value, sizeof(value), "%lu,%lu,%lu,%lu", (unsigned long)h.count,
+             (unsigned long)metricPercentileUs(h, 50), (unsigned long)metricPercentileUs(h, 90),
+             (unsigned long)h.maxUs);
+    json.set(path, value);
+  }
+  bool ok = rtdbUpdateNode(json);
+  if (ok) LOG_INFO("📊 Diagnostics sent");
+  return ok;
+}
@@ -0,0 +1,80 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+
+// Runtime metrics, kept on all the time. Every metric is a fixed slot named
+// by an enum, so recording one is an index, a compare loop over a dozen
+// bucket bounds and a short critical section: no allocation, no lookup by
+// name, safe from any task (not from an ISR).
+//
+//   counters    events since boot
+//   gauges      the last sampled value; heap and task stacks are sampled by
+//               sampleMetrics() right before a report
+//   timers      durations in microseconds, in fixed log-spaced buckets, with
+//               count, sum and max; percentiles read off the buckets
+//
+// Everything is cumulative since boot. logMetrics() writes it to serial with
+// the task report, and publishMetrics() sends it, one value per metric, to
+// /diagnostics every DIAGNOSTICS_INTERVAL_MS from the network task.
+
+#define METRIC_BUCKETS 12
+#define DIAGNOSTICS_INTERVAL_MS (15 * 60 * 1000UL)
+
+enum MetricCounter : uint8_t {
+  METRIC_STREAM_TIMEOUTS,   // the command stream timed out
+  METRIC_STREAM_RECONNECTS, // and was opened again
+  METRIC_RTDB_ERRORS,       // failed reads and writes, not missing paths
+  METRIC_COMMANDS,          // commands executed, from any source
+  METRIC_IR_DROPPED,        // frames the transmitter could not send
+  METRIC_COUNTERS
+};
+
+enum MetricGauge : uint8_t {
+  METRIC_HEAP_FREE,
+  METRIC_HEAP_MIN_FREE,      // lowest since boot
+  METRIC_HEAP_LARGEST,       // largest block malloc() can return
+  METRIC_STACK_NETWORK,      // stack bytes never touched, per device task
+  METRIC_STACK_CONTROL,
+  METRIC_STACK_SENSOR,
+  METRIC_GAUGES
+};
+
+enum MetricTimer : uint8_t {
+  METRIC_RTDB_READ,   // accessFbdo: reads of the device node
+  METRIC_RTDB_STREAM, // commandFbdo: opening the command stream
+  METRIC_RTDB_WRITE,  // publishFbdo: every updateNode
+  METRIC_IR_SEND,     // a frame handed to the transmitter until it is off the air
+  METRIC_LOOP,        // loop() in setup mode
+  METRIC_NETWORK_RUN, // one wake of a device task, from its queue or deadline
+  METRIC_CONTROL_RUN, // to going back to sleep
+  METRIC_SENSOR_RUN,
+  METRIC_TIMERS
+};
+
+struct MetricHistogram {
+  uint32_t buckets[METRIC_BUCKETS]; // counts at or below metricBucketUs(i)
+  uint32_t count;
+  uint64_t sumUs;
+  uint32_t maxUs;
+};
+
+void countMetric(MetricCounter counter);
+void setMetricGauge(MetricGauge gauge, uint32_t value);
+void recordMetricUs(MetricTimer timer, uint32_t us);
+
+unsigned long metricCount(MetricCounter counter);
+uint32_t metricGauge(MetricGauge gauge);
+MetricHistogram metricHistogram(MetricTimer timer);
+uint32_t metricBucketUs(uint8_t bucket); // upper bound, UINT32_MAX for the last
+// The bucket bound below which `percent` of the samples fall, capped at the
+// largest seen; 0 with no samples.
+uint32_t metricPercentileUs(const MetricHistogram& histogram, uint8_t percent);
+
+// Heap gauges here; the task stacks come from deviceTasks.cpp.
+void sampleMetrics();
+void logMetrics();
+// Network task. Sends /diagnostics in one updateNode; false if it failed.
+bool publishMetrics();
+
+#endif
@@ -1,14 +1,15 @@
-#include "firestoreServices.h"
+#include "FirestoreServices.h"
 #include "modeHandler.h"
 #include "parameters.h"
 #include "log.h"
 #include "command.h"
-#include "ntpTime.h"
+#include "deadlines.h"
 #include "sensors.h"
+#include "occupancy.h"
+#include "radar.h"
 
 
 //Motion Mode Flags
-unsigned long lastMotionMillis = 0;
 unsigned long idleStartMillis = 0;
 unsigned long motionModeActivated = 0;
 
@@ -19,98 +20,82 @@ unsigned long ecoCycleStartMillis = 0;
 unsigned long timerStartMillis = 0;
 unsigned long timerDurationMillis = 0;
 
-//Scheduler Flags
-String currentDay;
-int currentTime;
-bool alreadyTurnedOn = false;
-bool alreadyTurnedOff = false;
+// Wakes the control task when the active mode next needs a look.
+static Deadline modeDeadline = {"mode"};
+// Kept in every mode, so motion mode starts from what the room did before.
+static Occupancy occupancy;
 
-void handleSchedule(){
-  if(isNewDay(currentDay)){
-    alreadyTurnedOn = false;
-    alreadyTurnedOff = false;
-  }
-  int dayIndex = dayNameToIndex(currentDay);
-  DaySchedule* dayPtrs[] = {
-    &schedule.sun, &schedule.mon, &schedule.tue, &schedule.wed,
-    &schedule.thu, &schedule.fri, &schedule.sat
-  };
-  if (!dayPtrs[dayIndex]->active) return;
-  int startTime = dayPtrs[dayIndex]->startHour;
-  int endTime = dayPtrs[dayIndex]->endHour;
-  currentTime = getCurrentHourMinute();
-  if (currentTime >= startTime && currentTime < endTime && !alreadyTurnedOn){
-    LOG_INFO("Schedule Started");
-    alreadyTurnedOn = true;
-    if(acPowered) return;
-    if(mode == "timer"){
-      mode = "regular";
-      notifyUser("reset_mode");
-    }
-    execute("switch_power");
-    notifyUser("system_switch_power");
-  }
-  else if(currentTime >= endTime && !alreadyTurnedOff){
-    LOG_INFO("Schedule Ended");
-    alreadyTurnedOff = true;
-    ecoCanTurnOn = false;
-    if(!acPowered) return;
-    execute("switch_power");
-    notifyUser("system_switch_power");
-  }
+void noteMotion(){
+  noteOccupancy(occupancy, OCCUPANCY_PIR, millis());
+}
+
+void noteCommand(){
+  noteOccupancy(occupancy, OCCUPANCY_COMMAND, millis());
+}
+
+// Milliseconds from `start` until `span` has strictly passed.
+static unsigned long leftUntilPassed(unsigned long start, unsigned long span){
+  unsigned long elapsed = millis() - start;
+  return elapsed > span ? 0 : span - elapsed + 1;
 }
 
-void handleMotionMode(){
+// The handlers return how long until they need to run again, 0 for not
+// until something else changes.
+unsigned long handleMotionMode(){
   unsigned long now = millis();
-  if(!acPowered) return;
-  if (readMotionSensor()) {
-    lastMotionMillis = now;
-    if (idleFlag == "user_prompt") {
-      LOG_INFO("🚶 Motion resumed — resetting idle status");
-      idleFlag = "active";
+  if(!acPowered) return 0;
+  int motionPromptMillis = testMode ? 1 : IDLE_THRESHOLD_MS;
+  int autoOffMillis = testMode ? 1 : SHUTDOWN_WAIT_MS;
+  // A PIR edge alone keeps the room occupied for the idle threshold.
+  occupancy.halfLifeMs = (unsigned long)motionPromptMillis * MINUTES_CONVERT / OCCUPANCY_HALF_LIVES;
+  // Edges arrive from the PIR interrupt; an output still held high counts as
+  // of this look, and the radar as of when it last saw someone.
+  if (readMotionSensor()) noteMotion();
+  RadarPresence radar = radarPresence();
+  if (radar.seenMs) noteOccupancy(occupancy, OCCUPANCY_RADAR, radar.seenMs);
+  unsigned long vacantInMs = occupancyVacantInMs(occupancy, now);
+  if (vacantInMs) {
+    if (idleFlag == IDLE_USER_PROMPT) {
+      LOG_INFO("🚶 Presence resumed — resetting idle status");
+      idleFlag = IDLE_ACTIVE;
     }
-    return;
+    return idleFlag == IDLE_CONTINUE ? 0 : vacantInMs;
   }
-  if (idleFlag == "continue") return;
-  // 30 minutes idle passed
-  int motionPromptMillis = testMode ? 1 : IDLE_THRESHOLD_MS;
-  if (idleFlag == "active" && (now - lastMotionMillis > motionPromptMillis * MINUTES_CONVERT)) {
-    LOGF("🕒 %d mins idle — prompting user via RTDB", motionPromptMillis);
-    idleFlag = "user_prompt";
+  if (idleFlag == IDLE_CONTINUE) return 0;
+  // Nobody seen for 30 minutes
+  if (idleFlag == IDLE_ACTIVE) {
+    LOGF("🕒 %d mins without anyone seen — prompting user via RTDB", motionPromptMillis);
+    idleFlag = IDLE_USER_PROMPT;
     notifyUser("motion");
     idleStartMillis = now;
-    return;
   }
-  // 45 minutes total idle & user didn't respond
-  int autoOffMillis = testMode ? 1 : SHUTDOWN_WAIT_MS;
-  if (idleFlag == "user_prompt" && (now - idleStartMillis > autoOffMillis * MINUTES_CONVERT)) {
-    execute("switch_power");
+  // 15 more minutes & user didn't respond
+  if (now - idleStartMillis > autoOffMillis * MINUTES_CONVERT) {
+    execute(ACTION_SWITCH_POWER);
     notifyUser("system_switch_power_due_to_motion");
+    return 0;
   }
+  return leftUntilPassed(idleStartMillis, autoOffMillis * MINUTES_CONVERT);
 }
 
-void resetOtherFlags(const String& mode){
-  if (mode != "motion" || !acPowered) {
-    // Reset motion mode timers and flags
-    lastMotionMillis = 0;
-    idleStartMillis = 0;
-    idleFlag = "active";
-  }
-  if (mode != "eco") {
-    // Reset eco mode timers and flags
-    ecoCycleStartMillis = 0;
-  }
-  if(mode != "timer" || !acPowered){
-    // Reset timer mode timers and flags
-    timerStartMillis = 0;
-  }
+void resetMotionMode(){
+  idleStartMillis = 0;
+  idleFlag = IDLE_ACTIVE;
 }
 
-void handleEcoMode(){
+void resetEcoMode(){
+  ecoCycleStartMillis = 0;
+}
+
+void resetTimerMode(){
+  timerStartMillis = 0;
+}
+
+unsigned long handleEcoMode(){
   unsigned long now = millis();
   if (!acPowered && !ecoCanTurnOn){
     ecoCycleStartMillis = now;
-    return;
+    return 0;
   }
   if (ecoCycleStartMillis == 0 && acPowered) {
     ecoCycleStartMillis = now;
@@ -120,21 +105,23 @@ void handleEcoMode(){
   int ecoOffDuration = testMode ? 1 : ECO_OFF_DURATION;
   if (acPowered && (now - ecoCycleStartMillis > ecoOnDuration * MINUTES_CONVERT)) {
     LOGF("🌿 ECO mode — %d minutes passed, turning AC OFF", ecoOnDuration);
-    execute("eco_switch_power");
+    execute(ACTION_ECO_SWITCH_POWER);
     notifyUser("system_switch_power");
     ecoCycleStartMillis = now;
   }
   else if (!acPowered && (now - ecoCycleStartMillis > ecoOffDuration * MINUTES_CONVERT)) {
     LOGF("🌿 ECO mode — %d mins OFF passed, turning AC ON", ecoOffDuration);
-    execute("eco_switch_power");
+    execute(ACTION_ECO_SWITCH_POWER);
     notifyUser("system_switch_power");
     ecoCycleStartMillis = 0;
+    return 1; // the next wake starts the on phase
   }
+  return leftUntilPassed(ecoCycleStartMillis, (acPowered ? ecoOnDuration : ecoOffDuration) * MINUTES_CONVERT);
 }
 
-void handleTimerMode(){
+unsigned long handleTimerMode(){
   unsigned long now = millis();
-  if (!acPowered) return;
+  if (!acPowered) return 0;
   timerDurationMillis = duration * MINUTES_CONVERT;
   if (timerStartMillis == 0){
     timerStartMillis = now;
@@ -142,18 +129,42 @@ void handleTimerMode(){
   }
   if (acPowered && (now - timerStartMillis >= timerDurationMillis)) {
       LOG_WARN("⏰ Timer expired — turning off AC");
-      execute("switch_power");
+      execute(ACTION_SWITCH_POWER);
       notifyUser("system_switch_power");
+      return 0;
+  }
+  return timerDurationMillis - (now - timerStartMillis);
+}
+
+// Per mode: the handler run while it is active, and the reset of its timers
+// and flags while it is not (or, with resetWhenOff, while the AC is off).
+struct ModeEntry {
+  unsigned long (*handle)();
+  void (*reset)();
+  bool resetWhenOff;
+};
+
+static const ModeEntry modeTable[AC_MODES] = {
+  {nullptr, nullptr, false},                 // MODE_REGULAR
+  {handleTimerMode, resetTimerMode, true},   // MODE_TIMER
+  {handleEcoMode, resetEcoMode, false},      // MODE_ECO
+  {handleMotionMode, resetMotionMode, true}, // MODE_MOTION
+};
+
+void resetOtherFlags(AcMode active){
+  for (uint8_t m = 0; m < AC_MODES; m++) {
+    const ModeEntry& entry = modeTable[m];
+    if (entry.reset && (m != active || (entry.resetWhenOff && !acPowered))) entry.reset();
   }
 }
 
 void handleMode(){
   resetOtherFlags(mode);
-  handleSchedule();
-  if(mode == "timer") handleTimerMode();
-  else if(mode == "eco") handleEcoMode();
-  else if(mode == "motion") handleMotionMode();
-  else{ //mode = "regular"
-    return;
+  unsigned long nextMs = 0;
+  if (mode < AC_MODES && modeTable[mode].handle) nextMs = modeTable[mode].handle();
+  if (nextMs) {
+    armDeadline(controlDeadlines, modeDeadline, nextMs);
+  } else {
+    cancelDeadline(modeDeadline);
   }
 }
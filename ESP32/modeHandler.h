@@ -3,10 +3,14 @@
 
 #include <Arduino.h> 
 
-extern unsigned long lastMotionMillis;
-extern bool alreadyTurnedOn;
-extern bool alreadyTurnedOff;
-
+// Control task, after every wake: runs the active mode and arms the wake for
+// when it next needs to look (a timer running out, the eco phase ending, an
+// idle threshold).
 void handleMode();
+// Evidence for the occupancy estimate (occupancy.h) motion mode acts on:
+// motion mode prompts once the room is vacant and switches the AC off
+// SHUTDOWN_WAIT_MS later, unless someone shows up first.
+void noteMotion(); // a PIR edge, from the control queue
+void noteCommand(); // a command, or the AC turned on or put in motion mode; control task or boot
 
 #endif
\ No newline at end of file
@@ -10,9 +10,9 @@ extern const long  gmtOffset_sec;
 extern const int   daylightOffset_sec;
 extern struct tm timeinfo;
 
-void initTime();
-bool isNewDay(String& currentDayName);
-int dayNameToIndex(const String& dayName);
-int getCurrentHourMinute();
+// SNTP runs in the background once the station is up; until it answers,
+// time() counts from boot and the schedule waits (scheduleEngine.cpp).
+void startTimeSync();
+bool timeSynced(); // logs the time the first time it is true
 
-#endif
\ No newline at end of file
+#endif
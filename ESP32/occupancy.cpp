@@ -0,0 +1,41 @@
+#include "occupancy.h"
+
+static const uint16_t weights[OCCUPANCY_SOURCES] = {
+    OCCUPANCY_PIR_WEIGHT, OCCUPANCY_RADAR_WEIGHT, OCCUPANCY_COMMAND_WEIGHT,
+};
+
+void noteOccupancy(Occupancy& occupancy, OccupancySource source, unsigned long atMs) {
+  if (source >= OCCUPANCY_SOURCES) return;
+  if (occupancy.seen[source] && (long)(atMs - occupancy.lastMs[source]) <= 0) return;
+  occupancy.lastMs[source] = atMs;
+  occupancy.seen[source] = true;
+}
+
+uint16_t occupancyScore(const Occupancy& occupancy, unsigned long nowMs) {
+  if (!occupancy.halfLifeMs) return 0;
+  float score = 0;
+  for (uint8_t s = 0; s < OCCUPANCY_SOURCES; s++) {
+    if (!occupancy.seen[s]) continue;
+    long age = (long)(nowMs - occupancy.lastMs[s]);
+    float halvings = age > 0 ? (float)age / occupancy.halfLifeMs : 0.0f;
+    score = max(score, weights[s] * exp2f(-halvings));
+  }
+  return (uint16_t)score;
+}
+
+unsigned long occupancyVacantInMs(const Occupancy& occupancy, unsigned long nowMs) {
+  if (occupancyScore(occupancy, nowMs) < OCCUPANCY_VACANT) return 0;
+  // The score only falls from here, and a full source is below it one
+  // half-life after it crosses.
+  unsigned long lo = 0;
+  unsigned long hi = occupancy.halfLifeMs * (OCCUPANCY_HALF_LIVES + 1);
+  while (hi - lo > 1) {
+    unsigned long mid = lo + (hi - lo) / 2;
+    if (occupancyScore(occupancy, nowMs + mid) < OCCUPANCY_VACANT) {
+      hi = mid;
+    } else {
+      lo = mid;
+    }
+  }
+  return hi;
+}
@@ -0,0 +1,43 @@
+#ifndef OCCUPANCY_H
+#define OCCUPANCY_H
+
+#include <Arduino.h>
+
+// How sure the device is that someone is in the room, from 0 to
+// OCCUPANCY_FULL, fused from the evidence each source last gave:
+//
+//   PIR      a rising edge, or the output held high when motion mode looks
+//   radar    a confirmed track (radar.h), as of when the radar last saw it
+//   command  a command from the user, who may not be in the room
+//
+// Each source's confidence is its weight, halved every halfLifeMs since its
+// last evidence, and the room is as occupied as the surest source says: two
+// sensors seeing the same person walk out do not add up to more. Below
+// OCCUPANCY_VACANT the room is vacant, so a PIR edge or a radar sighting
+// keeps it occupied for OCCUPANCY_HALF_LIVES half-lives and a command for a
+// little less. An Occupancy starts zeroed and is used from one task.
+
+#define OCCUPANCY_FULL 1000
+#define OCCUPANCY_HALF_LIVES 3
+#define OCCUPANCY_VACANT (OCCUPANCY_FULL >> OCCUPANCY_HALF_LIVES)
+#define OCCUPANCY_PIR_WEIGHT 1000
+#define OCCUPANCY_RADAR_WEIGHT 1000
+#define OCCUPANCY_COMMAND_WEIGHT 700 // vacant after about 2.5 half-lives
+
+enum OccupancySource : uint8_t { OCCUPANCY_PIR, OCCUPANCY_RADAR, OCCUPANCY_COMMAND, OCCUPANCY_SOURCES };
+
+struct Occupancy {
+  unsigned long halfLifeMs;
+  unsigned long lastMs[OCCUPANCY_SOURCES];
+  bool seen[OCCUPANCY_SOURCES];
+};
+
+// Evidence at `atMs`, which may lie in the past; older than what the source
+// already gave, it is ignored.
+void noteOccupancy(Occupancy& occupancy, OccupancySource source, unsigned long atMs);
+uint16_t occupancyScore(const Occupancy& occupancy, unsigned long nowMs);
+// Milliseconds from nowMs until the score drops below OCCUPANCY_VACANT
+// without new evidence, 0 if it already has.
+unsigned long occupancyVacantInMs(const Occupancy& occupancy, unsigned long nowMs);
+
+#endif
@@ -13,21 +13,35 @@
 #define HOURS_UPDATE_INTERVAL 15 // 15 minutes
 #define TEMP_CHANGE_THRESHOLD 0.5  // °C
 #define HUM_CHANGE_THRESHOLD 2.0  // %
-#define MINUTES_CONVERT (60 * 1000)
+#define ECO2_CHANGE_THRESHOLD 100 // ppm
+#define TVOC_CHANGE_THRESHOLD 50  // ppb
+#define MINUTES_CONVERT (60 * 1000UL)
 #define HEARTBEAT_INTERVAL 30000
 #define SENSORS_INTERVAL 15000
 #define READ_INTERVAL 5000
+#define HISTORY_SAMPLE_INTERVAL 60000 // one history sample a minute
+#define HISTORY_UPLOAD_INTERVAL (60 * MINUTES_CONVERT) // history batch upload
 #define DELAYVAL 100
+#define BUTTON_POLL_MS 50
+
+//IR Learning
+#define IR_CAPTURE_BUFFER 1024 // raw timings per learned code
+#define IR_CAPTURE_TIMEOUT_MS 50 // silence that ends a captured frame
+#define IR_CARRIER_KHZ 38
 
 //Sensors
 #define RESET_BUTTON_PIN 32
 #define IRLED 18
 #define IRREC 19
 #define BUZZER 25
+#define BUZZER_LEDC_CHANNEL 4
 #define DHTPIN 27
 #define DHTTYPE DHT11
 #define PIRPIN 33
 #define LED_PIN 4
+#define CCS811_INT_PIN 23 // nINT, open drain; the CCS811's nWAKE is tied low
+#define RADAR_RX_PIN 16 // UART1, from the RD-03D's TX
+#define RADAR_TX_PIN 17
 #define RELAY_PIN 26 
 #define LED_PIXELS_NUM 3
 
@@ -0,0 +1,79 @@
+#include <WiFi.h>
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+#include <freertos/queue.h>
+#include "powerSave.h"
+#include "deviceTasks.h"
+#include "parameters.h"
+#include "log.h"
+
+static QueueHandle_t buttonQueue = nullptr;
+static esp_pm_lock_handle_t awakeLock = nullptr;
+static uint8_t awakeReasons = 0;
+static PowerSave level = POWER_MODEM_SLEEP;
+
+static void IRAM_ATTR onButton() {
+  uint8_t pressed = 1;
+  BaseType_t woken = pdFALSE;
+  xQueueSendFromISR(buttonQueue, &pressed, &woken);
+  portYIELD_FROM_ISR(woken);
+}
+
+// The PIR holds its output high for seconds, so its level wake follows the
+// pin: wake on high while it is low, on low while it is high. A wake level
+// that matched already would wake the chip straight out of every sleep.
+static void IRAM_ATTR onPirChange() {
+  bool high = digitalRead(PIRPIN) == HIGH;
+  gpio_wakeup_enable((gpio_num_t)PIRPIN, high ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+  if (high) postMotionFromISR();
+}
+
+void initWakeSources() {
+  if (buttonQueue) return;
+  buttonQueue = xQueueCreate(1, sizeof(uint8_t));
+  attachInterrupt(digitalPinToInterrupt(RESET_BUTTON_PIN), onButton, FALLING);
+  attachInterrupt(digitalPinToInterrupt(PIRPIN), onPirChange, CHANGE);
+  gpio_wakeup_enable((gpio_num_t)RESET_BUTTON_PIN, GPIO_INTR_LOW_LEVEL);
+  gpio_wakeup_enable((gpio_num_t)PIRPIN, digitalRead(PIRPIN) == HIGH ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+  esp_sleep_enable_gpio_wakeup();
+  if (esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "awake", &awakeLock) != ESP_OK) awakeLock = nullptr;
+}
+
+void setPowerSave(PowerSave requested) {
+  esp_pm_config_esp32_t pm = {};
+  pm.max_freq_mhz = POWER_MAX_FREQ_MHZ;
+  pm.min_freq_mhz = requested == POWER_LIGHT_SLEEP ? POWER_MIN_FREQ_MHZ : POWER_MAX_FREQ_MHZ;
+  pm.light_sleep_enable = requested == POWER_LIGHT_SLEEP;
+  if (esp_pm_configure(&pm) != ESP_OK && requested == POWER_LIGHT_SLEEP) {
+    LOG_WARN("⚠️ Power management not available, staying on modem sleep");
+    requested = POWER_MODEM_SLEEP;
+  }
+  WiFi.setSleep(requested != POWER_AWAKE);
+  level = requested;
+  LOGF("🔋 Power save: %s", level == POWER_AWAKE ? "awake" : level == POWER_MODEM_SLEEP ? "modem sleep" : "light sleep");
+}
+
+PowerSave powerSaveLevel() {
+  return level;
+}
+
+void holdAwake(AwakeReason reason, bool hold) {
+  uint8_t was = awakeReasons;
+  awakeReasons = hold ? awakeReasons | reason : awakeReasons & ~reason;
+  if (!awakeLock || (was == 0) == (awakeReasons == 0)) return;
+  if (awakeReasons) {
+    esp_pm_lock_acquire(awakeLock);
+  } else {
+    esp_pm_lock_release(awakeLock);
+  }
+}
+
+bool waitForButton(unsigned long waitMs) {
+  if (!buttonQueue) {
+    delay(min(waitMs, (unsigned long)BUTTON_POLL_MS));
+    return false;
+  }
+  uint8_t pressed;
+  return xQueueReceive(buttonQueue, &pressed, pdMS_TO_TICKS(waitMs)) == pdTRUE;
+}
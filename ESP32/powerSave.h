@@ -0,0 +1,39 @@
+#ifndef POWER_SAVE_H
+#define POWER_SAVE_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+
+// Once connected, the chip light-sleeps whenever every task is blocked: the
+// device tasks wait on their deadline queues (deadlines.h) and loop() waits
+// for the reset button. It wakes for the next deadline, a PIR or button edge,
+// or the DTIM beacon that carries command stream traffic under modem sleep.
+//
+// Light sleep stops the APB clock, so the RMT (IR) and LEDC (buzzer) hold
+// holdAwake() while they are running. Power management needs an Arduino core
+// built with CONFIG_PM_ENABLE; without it the device stays on modem sleep.
+
+enum PowerSave : uint8_t {
+  POWER_AWAKE,       // radio always listening, CPU never sleeps
+  POWER_MODEM_SLEEP, // radio wakes for DTIM beacons (the Arduino default)
+  POWER_LIGHT_SLEEP, // modem sleep plus automatic light sleep when idle
+};
+
+enum AwakeReason : uint8_t {
+  AWAKE_IR = 0x01,
+  AWAKE_BUZZER = 0x02,
+};
+
+#define POWER_SAVE_DEFAULT POWER_LIGHT_SLEEP
+#define POWER_MAX_FREQ_MHZ 240
+#define POWER_MIN_FREQ_MHZ 80
+
+// Interrupts for the reset button and the PIR; setup(), before the tasks.
+void initWakeSources();
+void setPowerSave(PowerSave level);
+PowerSave powerSaveLevel();
+void holdAwake(AwakeReason reason, bool hold);
+// Blocks loop() until the reset button is pressed or `waitMs` passes.
+bool waitForButton(unsigned long waitMs);
+
+#endif
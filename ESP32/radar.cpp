@@ -0,0 +1,355 @@
+#include <driver/uart.h>
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include "radar.h"
+#include "parameters.h"
+#include "log.h"
+
+static const uint8_t frameHeader[] = {0xAA, 0xFF, 0x03, 0x00};
+static const uint8_t frameTail[] = {0x55, 0xCC};
+// Multi-target detection, as the module's protocol sends it.
+static const uint8_t multiTargetCommand[] = {0xFD, 0xFC, 0xFB, 0xFA, 0x02, 0x00, 0x90, 0x00, 0x04, 0x03, 0x02, 0x01};
+
+// ----------------------- Parser -----------------------
+
+static int16_t signMagnitude(const uint8_t* p) {
+  uint16_t raw = p[0] | p[1] << 8;
+  int16_t magnitude = raw & 0x7FFF;
+  return raw & 0x8000 ? magnitude : -magnitude;
+}
+
+bool decodeRadarFrame(const uint8_t* bytes, RadarFrame& frame) {
+  if (memcmp(bytes, frameHeader, sizeof(frameHeader)) != 0) return false;
+  if (memcmp(bytes + RADAR_FRAME_BYTES - sizeof(frameTail), frameTail, sizeof(frameTail)) != 0) return false;
+  frame.count = 0;
+  for (uint8_t i = 0; i < RADAR_TARGETS; i++) {
+    const uint8_t* t = bytes + sizeof(frameHeader) + i * 8;
+    bool empty = true;
+    for (uint8_t b = 0; b < 8; b++) empty &= t[b] == 0;
+    if (empty) continue;
+    RadarTarget& target = frame.targets[frame.count++];
+    target.x = signMagnitude(t);
+    target.y = signMagnitude(t + 2);
+    target.speed = signMagnitude(t + 4);
+    target.resolution = t[6] | t[7] << 8;
+  }
+  return true;
+}
+
+// The first offset from `from` where a header starts, or where the bytes
+// left are the start of one.
+static size_t findHeader(const uint8_t* data, size_t from, size_t len) {
+  for (size_t i = from; i < len; i++) {
+    size_t n = min(len - i, sizeof(frameHeader));
+    if (memcmp(data + i, frameHeader, n) == 0) return i;
+  }
+  return len;
+}
+
+// Emits the frame at `bytes` if it is one; counts a header without its tail.
+static bool takeFrame(RadarParser& parser, const uint8_t* bytes) {
+  RadarFrame frame;
+  if (!decodeRadarFrame(bytes, frame)) {
+    parser.stats.badFrames++;
+    return false;
+  }
+  parser.stats.frames++;
+  if (parser.onFrame) parser.onFrame(frame);
+  return true;
+}
+
+void feedRadarParser(RadarParser& parser, const uint8_t* data, size_t len) {
+  size_t i = 0;
+  // A frame begun in an earlier call: fill it up, and if it was not one,
+  // resynchronise within the bytes taken for it.
+  while (parser.have) {
+    size_t take = min((size_t)(RADAR_FRAME_BYTES - parser.have), len - i);
+    memcpy(parser.partial + parser.have, data + i, take);
+    parser.have += take;
+    i += take;
+    if (parser.have < RADAR_FRAME_BYTES) return;
+    if (takeFrame(parser, parser.partial)) {
+      parser.have = 0;
+      break;
+    }
+    size_t next = findHeader(parser.partial, 1, RADAR_FRAME_BYTES);
+    parser.stats.skipped += next;
+    parser.have = RADAR_FRAME_BYTES - next;
+    memmove(parser.partial, parser.partial + next, parser.have);
+  }
+  // Whole frames straight from `data`.
+  while (i < len) {
+    size_t start = findHeader(data, i, len);
+    parser.stats.skipped += start - i;
+    if (len - start < RADAR_FRAME_BYTES) {
+      parser.have = len - start;
+      memcpy(parser.partial, data + start, parser.have);
+      return;
+    }
+    if (takeFrame(parser, data + start)) {
+      i = start + RADAR_FRAME_BYTES;
+    } else {
+      parser.stats.skipped++;
+      i = start + 1;
+    }
+  }
+}
+
+void resetRadarParser(RadarParser& parser) {
+  parser.have = 0;
+}
+
+// ----------------------- Tracker -----------------------
+
+bool radarTrackConfirmed(const RadarTrack& track) {
+  return track.id && track.hits >= RADAR_TRACK_CONFIRM;
+}
+
+// Inside the gate when the distance and angle differences, each against its
+// own gate, add up to less than one.
+static uint32_t matchCost(const RadarTrack& track, uint16_t distance, int16_t angle) {
+  uint32_t dd = abs((int32_t)track.distance - distance);
+  uint32_t da = abs((int32_t)track.angle - angle);
+  return dd * RADAR_GATE_DECIDEG + da * RADAR_GATE_MM;
+}
+
+void updateRadarTracker(RadarTracker& tracker, const RadarFrame& frame, unsigned long nowMs) {
+  const uint32_t gate = (uint32_t)RADAR_GATE_MM * RADAR_GATE_DECIDEG;
+  uint16_t distance[RADAR_TARGETS];
+  int16_t angle[RADAR_TARGETS];
+  for (uint8_t t = 0; t < frame.count; t++) {
+    const RadarTarget& target = frame.targets[t];
+    distance[t] = (uint16_t)min(65535.0f, sqrtf((float)target.x * target.x + (float)target.y * target.y));
+    angle[t] = (int16_t)lroundf(atan2f(target.x, target.y) * 1800.0f / (float)M_PI);
+  }
+
+  // Greedy: the closest pair inside the gate first, until none is left.
+  bool targetUsed[RADAR_TARGETS] = {};
+  bool trackUsed[RADAR_TRACKS] = {};
+  for (;;) {
+    uint32_t best = gate;
+    int bestTarget = -1, bestTrack = -1;
+    for (uint8_t t = 0; t < frame.count; t++) {
+      if (targetUsed[t]) continue;
+      for (uint8_t k = 0; k < RADAR_TRACKS; k++) {
+        if (trackUsed[k] || !tracker.tracks[k].id) continue;
+        uint32_t cost = matchCost(tracker.tracks[k], distance[t], angle[t]);
+        if (cost < best) {
+          best = cost;
+          bestTarget = t;
+          bestTrack = k;
+        }
+      }
+    }
+    if (bestTarget < 0) break;
+    targetUsed[bestTarget] = trackUsed[bestTrack] = true;
+    RadarTrack& track = tracker.tracks[bestTrack];
+    track.distance = (track.distance + distance[bestTarget] + 1) / 2;
+    track.angle = (int16_t)(((int32_t)track.angle + angle[bestTarget]) / 2);
+    track.speed = frame.targets[bestTarget].speed;
+    if (track.hits < RADAR_TRACK_CONFIRM) track.hits++;
+    track.seenMs = nowMs;
+  }
+
+  // Targets left over start tracks, in a free slot or over the stalest
+  // unconfirmed one.
+  for (uint8_t t = 0; t < frame.count; t++) {
+    if (targetUsed[t]) continue;
+    RadarTrack* slot = nullptr;
+    for (RadarTrack& track : tracker.tracks) {
+      if (!track.id) {
+        slot = &track;
+        break;
+      }
+      if (!radarTrackConfirmed(track) && !trackUsed[&track - tracker.tracks] &&
+          (!slot || track.seenMs < slot->seenMs)) {
+        slot = &track;
+      }
+    }
+    if (!slot) continue;
+    if (++tracker.lastId == 0) tracker.lastId = 1;
+    *slot = {tracker.lastId, 1, distance[t], angle[t], frame.targets[t].speed, nowMs};
+    trackUsed[slot - tracker.tracks] = true;
+  }
+}
+
+void expireRadarTracks(RadarTracker& tracker, unsigned long nowMs) {
+  for (RadarTrack& track : tracker.tracks) {
+    if (track.id && nowMs - track.seenMs >= RADAR_TRACK_TIMEOUT_MS) track = RadarTrack();
+  }
+}
+
+// ----------------------- Task -----------------------
+
+static QueueHandle_t uartEvents = nullptr;
+static esp_pm_lock_handle_t listenLock = nullptr;
+static bool uartWakeup = false;
+static RadarParser parser;
+static RadarTracker tracker;
+static bool streaming = false;
+// Written by the radar task, copied out by the others under `lock`.
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+static RadarPresence presence;
+static RadarStats stats;
+
+static void onFrame(const RadarFrame& frame) {
+  updateRadarTracker(tracker, frame, millis());
+}
+
+static void drainUart() {
+  uint8_t chunk[RADAR_READ_CHUNK];
+  int n;
+  while ((n = uart_read_bytes(RADAR_UART, chunk, sizeof(chunk), 0)) > 0) {
+    feedRadarParser(parser, chunk, n);
+    stats.bytes += n;
+  }
+}
+
+static void handleEvent(const uart_event_t& event) {
+  stats.events++;
+  if (event.type == UART_FIFO_OVF || event.type == UART_BUFFER_FULL) {
+    // What is buffered is no longer contiguous with what follows.
+    uart_flush_input(RADAR_UART);
+    xQueueReset(uartEvents);
+    resetRadarParser(parser);
+    stats.overflows++;
+  }
+}
+
+static void publishPresence() {
+  RadarPresence next = {};
+  next.streaming = streaming;
+  for (const RadarTrack& track : tracker.tracks) {
+    if (!radarTrackConfirmed(track)) continue;
+    next.people++;
+    if (!next.nearestMm || track.distance < next.nearestMm) next.nearestMm = track.distance;
+    next.moving |= abs(track.speed) > RADAR_MOVING_CMS;
+    next.seenMs = max(next.seenMs, track.seenMs);
+  }
+  portENTER_CRITICAL(&lock);
+  if (!next.people) next.seenMs = presence.seenMs;
+  presence = next;
+  stats.parser = parser.stats;
+  portEXIT_CRITICAL(&lock);
+}
+
+// Whether anything came within `wait`.
+static bool takeEvents(TickType_t wait) {
+  uart_event_t event;
+  bool received = xQueueReceive(uartEvents, &event, wait) == pdTRUE;
+  bool any = received;
+  while (received) {
+    handleEvent(event);
+    received = xQueueReceive(uartEvents, &event, 0) == pdTRUE;
+  }
+  return any;
+}
+
+// Starts clean: what the ring holds arrived while the task rested, and
+// partly while the chip slept.
+static void dropBuffered() {
+  uart_flush_input(RADAR_UART);
+  xQueueReset(uartEvents);
+  resetRadarParser(parser);
+}
+
+// Light sleep held off for RADAR_LISTEN_MS, the frames taken in batches.
+// Whether any byte came.
+static bool listen() {
+  if (listenLock) esp_pm_lock_acquire(listenLock);
+  unsigned long bytes = stats.bytes;
+  unsigned long start = millis();
+  stats.listens++;
+  do {
+    vTaskDelay(pdMS_TO_TICKS(RADAR_BATCH_MS));
+    takeEvents(0);
+    drainUart();
+    expireRadarTracks(tracker, millis());
+    stats.wakes++;
+    publishPresence();
+  } while (millis() - start < RADAR_LISTEN_MS);
+  if (listenLock) esp_pm_lock_release(listenLock);
+  return stats.bytes != bytes;
+}
+
+// The frames of a rest would wake the chip ten times a second for nothing,
+// so the UART wakes it only while the radar is silent.
+static void setUartWakeup(bool on) {
+  if (!uartWakeup) return;
+  if (on) {
+    esp_sleep_enable_uart_wakeup(RADAR_UART);
+  } else {
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_UART);
+  }
+}
+
+static void radarTaskLoop(void* param) {
+  (void)param;
+  for (;;) {
+    if (streaming) {
+      vTaskDelay(pdMS_TO_TICKS(RADAR_REST_MS));
+    } else if (uartWakeup) {
+      // Woken only to let the people left over time out.
+      bool tracking = false;
+      for (const RadarTrack& track : tracker.tracks) tracking |= track.id != 0;
+      setUartWakeup(true);
+      bool woke = takeEvents(tracking ? pdMS_TO_TICKS(RADAR_TRACK_TIMEOUT_MS) : portMAX_DELAY);
+      setUartWakeup(false);
+      if (!woke) {
+        expireRadarTracks(tracker, millis());
+        publishPresence();
+        continue;
+      }
+    } else {
+      // A radar that starts up is heard at the next window instead.
+      vTaskDelay(pdMS_TO_TICKS(RADAR_REST_MS));
+    }
+    dropBuffered();
+    bool heard = listen();
+    if (heard && !streaming) LOG_INFO("📡 Radar streaming");
+    if (!heard && streaming) LOG_INFO("📡 Radar silent");
+    streaming = heard;
+    publishPresence();
+  }
+}
+
+void startRadar() {
+  if (uartEvents) return;
+  uart_config_t config = {};
+  config.baud_rate = RADAR_BAUD;
+  config.data_bits = UART_DATA_8_BITS;
+  config.parity = UART_PARITY_DISABLE;
+  config.stop_bits = UART_STOP_BITS_1;
+  config.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+  if (uart_driver_install(RADAR_UART, RADAR_RX_BUFFER, 0, RADAR_EVENT_QUEUE, &uartEvents, 0) != ESP_OK) {
+    LOG_ERROR("❌ Radar UART driver not installed");
+    uartEvents = nullptr;
+    return;
+  }
+  uart_param_config(RADAR_UART, &config);
+  uart_set_pin(RADAR_UART, RADAR_TX_PIN, RADAR_RX_PIN, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+  uart_set_rx_timeout(RADAR_UART, RADAR_RX_TIMEOUT);
+  uart_write_bytes(RADAR_UART, multiTargetCommand, sizeof(multiTargetCommand));
+  if (esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "radar", &listenLock) != ESP_OK) listenLock = nullptr;
+  uartWakeup = uart_set_wakeup_threshold(RADAR_UART, RADAR_WAKE_EDGES) == ESP_OK;
+  if (!uartWakeup) LOG_WARN("⚠️ Radar UART cannot wake the chip, listening every rest instead");
+  parser.onFrame = onFrame;
+  xTaskCreatePinnedToCore(radarTaskLoop, "radar", RADAR_TASK_STACK, nullptr, RADAR_TASK_PRIORITY, nullptr,
+                          RADAR_TASK_CORE);
+}
+
+RadarPresence radarPresence() {
+  portENTER_CRITICAL(&lock);
+  RadarPresence copy = presence;
+  portEXIT_CRITICAL(&lock);
+  return copy;
+}
+
+RadarStats radarStats() {
+  portENTER_CRITICAL(&lock);
+  RadarStats copy = stats;
+  portEXIT_CRITICAL(&lock);
+  return copy;
+}
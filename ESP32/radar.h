@@ -0,0 +1,135 @@
+#ifndef RADAR_H
+#define RADAR_H
+
+#include <Arduino.h>
+#include <driver/uart.h>
+
+// The RD-03D mmWave radar on UART1 at 256000 baud, in multi-target mode.
+// The ESP-IDF UART driver moves received bytes from the FIFO into its ring
+// buffer in the interrupt and posts an event; the radar task (core 0, below
+// the network task) wakes on the event, drains the ring and then sleeps
+// RADAR_BATCH_MS, so a burst of frames costs one wake and the control task
+// on core 1 never sees the radar at all.
+//
+// A frame is 30 bytes:
+//
+//   AA FF 03 00  header
+//   3 x 8 bytes  target: x, y (mm), speed (cm/s), distance resolution (mm),
+//                each u16 little-endian; x, y and speed are sign-magnitude
+//                with bit 15 set for positive; an empty slot is all zeros
+//   55 CC        tail
+//
+// The parser decodes frames where they lie in the bytes it is given; only a
+// frame split across two reads is assembled in the parser. Bytes that do not
+// start a frame are skipped, and a frame with a bad tail is dropped one byte
+// in, so it resynchronises on the next header.
+//
+// The tracker follows up to RADAR_TRACKS people over distance and angle: each
+// frame's targets are matched greedily to the nearest tracks inside the gate,
+// smoothed into them, and a track counts once it was seen RADAR_TRACK_CONFIRM
+// times, until it goes RADAR_TRACK_TIMEOUT_MS unseen.
+//
+// Light sleep stops the UART clock, and the radar streams at 10 Hz for as
+// long as it has power, so the task listens in windows: it holds off light
+// sleep for RADAR_LISTEN_MS, then lets go for RADAR_REST_MS and drops what
+// arrived meanwhile. The chip is kept awake for the radar a third of the time
+// instead of all of it, and people are updated every 1.5 s, well inside
+// RADAR_TRACK_TIMEOUT_MS. A listen window without a byte means the radar
+// is silent; the task then waits without a timeout, and the UART's own
+// light-sleep wakeup (UART0 and UART1 only, hence UART1) brings the chip
+// up on the first bytes, which are lost to the wake.
+
+#define RADAR_UART UART_NUM_1
+#define RADAR_BAUD 256000
+#define RADAR_FRAME_BYTES 30
+#define RADAR_TARGETS 3
+#define RADAR_TRACKS 3
+#define RADAR_RX_BUFFER 1024 // 34 frames, 3.4 s of the radar's output
+#define RADAR_EVENT_QUEUE 16 // a full ring of FIFO reads and the overflow after them
+#define RADAR_RX_TIMEOUT 10 // symbols of silence that end a read
+#define RADAR_READ_CHUNK 128
+#define RADAR_BATCH_MS 250
+#define RADAR_LISTEN_MS 500
+#define RADAR_REST_MS 1000
+#define RADAR_WAKE_EDGES 3 // rising edges on RX that wake the chip
+#define RADAR_GATE_MM 600
+#define RADAR_GATE_DECIDEG 200 // 20°
+#define RADAR_TRACK_CONFIRM 3
+#define RADAR_TRACK_TIMEOUT_MS 1500
+#define RADAR_MOVING_CMS 10 // a track this fast is moving
+#define RADAR_TASK_STACK 3072
+#define RADAR_TASK_PRIORITY 1
+#define RADAR_TASK_CORE 0
+
+struct RadarTarget {
+  int16_t x;           // mm, positive to the radar's right
+  int16_t y;           // mm, ahead
+  int16_t speed;       // cm/s, positive away from the radar
+  uint16_t resolution; // mm
+};
+
+struct RadarFrame {
+  uint8_t count;
+  RadarTarget targets[RADAR_TARGETS];
+};
+
+struct RadarParserStats {
+  unsigned long frames;
+  unsigned long skipped;   // bytes outside any frame
+  unsigned long badFrames; // header without its tail
+};
+
+struct RadarParser {
+  void (*onFrame)(const RadarFrame& frame);
+  uint8_t partial[RADAR_FRAME_BYTES];
+  uint8_t have;            // bytes of a frame begun in an earlier call
+  RadarParserStats stats;
+};
+
+struct RadarTrack {
+  uint8_t id;          // 0 for a free slot
+  uint8_t hits;        // frames it was seen in, up to RADAR_TRACK_CONFIRM
+  uint16_t distance;   // mm
+  int16_t angle;       // 0.1°, positive to the right
+  int16_t speed;       // cm/s
+  unsigned long seenMs;
+};
+
+struct RadarTracker {
+  RadarTrack tracks[RADAR_TRACKS];
+  uint8_t lastId;
+};
+
+// What the other tasks see of the radar.
+struct RadarPresence {
+  bool streaming;     // bytes in the last listen window
+  uint8_t people;     // confirmed tracks
+  uint16_t nearestMm; // of those, 0 if none
+  bool moving;        // any of them faster than RADAR_MOVING_CMS
+  unsigned long seenMs; // when a confirmed track was last updated
+};
+
+struct RadarStats {
+  unsigned long bytes;
+  unsigned long events;
+  unsigned long overflows; // the ring or the FIFO filled up and was flushed
+  unsigned long wakes;     // radar task runs
+  unsigned long listens;   // listen windows
+  RadarParserStats parser;
+};
+
+// Parser and tracker: no hardware, used by the radar task and the host tests.
+void feedRadarParser(RadarParser& parser, const uint8_t* data, size_t len);
+void resetRadarParser(RadarParser& parser);
+bool decodeRadarFrame(const uint8_t* bytes, RadarFrame& frame); // header and tail checked
+void updateRadarTracker(RadarTracker& tracker, const RadarFrame& frame, unsigned long nowMs);
+void expireRadarTracks(RadarTracker& tracker, unsigned long nowMs);
+bool radarTrackConfirmed(const RadarTrack& track);
+
+// Installs the UART driver, switches the radar to multi-target mode and
+// starts its task; setup(), once provisioned.
+void startRadar();
+RadarPresence radarPresence();
+RadarStats radarStats();
+
+#endif
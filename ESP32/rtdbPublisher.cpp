@@ -0,0 +1,262 @@
+#include <Firebase_ESP_Client.h>
+#include "rtdbPublisher.h"
+#include "deadlines.h"
+#include "stateJournal.h"
+#include "metrics.h"
+#include "log.h"
+
+struct PublishSlot {
+  NetRequest request;
+  unsigned long dueMs;
+  bool used;
+};
+
+static FirebaseData publishFbdo;
+static String publishBasePath;
+static PublishSlot slots[PUBLISH_SLOTS];
+static size_t stagedCount = 0;
+static unsigned long retryAtMs = 0;
+static bool retrying = false;
+static bool online = false;
+static bool journaling = false;  // a flush failed; writes go to the journal too
+static unsigned long journalDueMs = 0;
+static PublisherStats stats;
+
+static const unsigned long priorityDelayMs[] = {0, PUBLISH_SOON_MS, PUBLISH_LAZY_MS};
+
+static void flushWhenDue();
+static Deadline flushDeadline = {"publish", flushWhenDue};
+
+// Keeps the network task's flush deadline on the earliest staged value.
+static void armFlush() {
+  if (stagedCount > 0 || (journaling && journalPending())) {
+    armDeadline(networkDeadlines, flushDeadline, rtdbPublisherDueInMs());
+  } else {
+    cancelDeadline(flushDeadline);
+  }
+}
+
+static void flushWhenDue() {
+  handleRtdbPublisher();
+  armFlush();
+}
+
+void initRtdbPublisher(const String& devicePath) {
+  publishBasePath = devicePath;
+  #if defined(ESP32)
+  publishFbdo.setBSSLBufferSize(2048, 1024);
+  #endif
+  initStateJournal();
+  journaling = journalPending();
+  journalDueMs = millis();
+  if (journaling) armFlush();
+}
+
+static bool isDue(unsigned long dueMs, unsigned long now) {
+  return (long)(now - dueMs) >= 0;
+}
+
+static PublishSlot* earliestSlot() {
+  PublishSlot* earliest = nullptr;
+  for (PublishSlot& slot : slots) {
+    if (slot.used && (!earliest || (long)(slot.dueMs - earliest->dueMs) < 0)) earliest = &slot;
+  }
+  return earliest;
+}
+
+// Sends everything staged, along with whatever `json` already holds.
+// When the next flush is due, counting a pending journal as due since the
+// failure (or boot) that left it. False if nothing is waiting.
+static bool nextDue(unsigned long& dueMs) {
+  PublishSlot* earliest = earliestSlot();
+  bool journal = journaling && journalPending();
+  if (!earliest && !journal) return false;
+  dueMs = earliest ? earliest->dueMs : journalDueMs;
+  if (journal && (long)(journalDueMs - dueMs) < 0) dueMs = journalDueMs;
+  return true;
+}
+
+void setPublishValue(FirebaseJson& json, const NetRequest& r) {
+  String key = r.path[0] == '/' ? r.path + 1 : r.path;
+  switch (r.op) {
+    case NET_SET_STRING: json.set(key, String(r.s)); break;
+    case NET_SET_BOOL: json.set(key, r.b); break;
+    case NET_SET_INT: json.set(key, (long)r.i); break;
+    case NET_SET_FLOAT: json.set(key, r.f); break;
+    default: break;
+  }
+}
+
+// Staged values go to the journal when a flush first fails.
+static void startJournaling() {
+  journaling = true;
+  journalDueMs = millis();
+  for (PublishSlot& slot : slots) {
+    if (!slot.used || slot.request.transient) continue;
+    journalWrite(slot.request);
+    stats.journaled++;
+  }
+}
+
+static bool flush(FirebaseJson& json) {
+  if (!online) {
+    if (!journaling) startJournaling();
+    return false;
+  }
+  bool replay = journaling && journalPending();
+  // The journal goes in first so that staged values, which are newer, win.
+  if (replay) addJournalTo(json);
+  for (PublishSlot& slot : slots) {
+    if (slot.used) setPublishValue(json, slot.request);
+  }
+  publishFbdo.clear();
+  unsigned long startUs = micros();
+  bool ok = Firebase.RTDB.updateNode(&publishFbdo, publishBasePath, &json);
+  recordMetricUs(METRIC_RTDB_WRITE, micros() - startUs);
+  stats.flushes++;
+  if (!ok) {
+    stats.failures++;
+    countMetric(METRIC_RTDB_ERRORS);
+    LOGF_ERROR("❌ Failed to publish %u values: %s", (unsigned)stagedCount, publishFbdo.errorReason().c_str());
+    publishFbdo.clear();
+    if (!journaling) startJournaling();
+    return false;
+  }
+  if (replay) {
+    clearJournal();
+    stats.replays++;
+    LOG_INFO("📓 Journal replayed");
+  }
+  journaling = false;
+  for (PublishSlot& slot : slots) {
+    if (!slot.used) continue;
+    if (slot.request.okLog) LOGF("%s", slot.request.okLog);
+    slot.used = false;
+  }
+  stagedCount = 0;
+  publishFbdo.clear();
+  return true;
+}
+
+static bool flush() {
+  FirebaseJson json;
+  return flush(json);
+}
+
+static void stage(const NetRequest& request) {
+  bool journaled = journaling && !request.transient;
+  if (journaled) {
+    journalWrite(request);
+    stats.journaled++;
+  }
+  unsigned long now = millis();
+  unsigned long dueMs = now + priorityDelayMs[request.priority];
+  stats.staged++;
+  PublishSlot* free = nullptr;
+  for (PublishSlot& slot : slots) {
+    if (slot.used && strcmp(slot.request.path, request.path) == 0) {
+      // The older deadline still stands; a more urgent write pulls it in.
+      if ((long)(dueMs - slot.dueMs) < 0) slot.dueMs = dueMs;
+      slot.request = request;
+      stats.coalesced++;
+      armFlush();
+      return;
+    }
+    if (!slot.used && !free) free = &slot;
+  }
+  if (!free) {
+    // Every slot holds a distinct path: send what is staged to make room.
+    if (!flush()) {
+      if (request.transient) {
+        LOGF_WARN("⚠️ Publisher full, %s not sent", request.path);
+      } else if (!journaled) {
+        journalWrite(request); // the failed flush started the journal
+        stats.journaled++;
+      }
+      return;
+    }
+    free = &slots[0];
+  }
+  free->request = request;
+  free->dueMs = dueMs;
+  free->used = true;
+  stagedCount++;
+  armFlush();
+}
+
+// Points field at parent/name; false, with nothing written, if that does
+// not fit in the path.
+static bool fieldPath(NetRequest& field, const char* parent, const char* name) {
+  int n = snprintf(field.path, sizeof(field.path), "%s/%s", parent, name);
+  if (n > 0 && (size_t)n < sizeof(field.path)) return true;
+  LOGF_WARN("⚠️ Sensor path too long: %s/%s", parent, name);
+  return false;
+}
+
+void rtdbPublish(const NetRequest& request) {
+  if (request.op != NET_SENSORS) {
+    stage(request);
+    return;
+  }
+  NetRequest field = request;
+  field.op = NET_SET_FLOAT;
+  if (!fieldPath(field, request.path, "roomTemperature")) return;
+  field.f = request.sensors.temperature;
+  stage(field);
+  field.okLog = nullptr;
+  if (!fieldPath(field, request.path, "roomHumidity")) return;
+  field.f = request.sensors.humidity;
+  stage(field);
+  field.op = NET_SET_BOOL;
+  if (!fieldPath(field, request.path, "motion")) return;
+  field.b = request.sensors.motion;
+  stage(field);
+  if (!request.sensors.air) return;
+  field.op = NET_SET_INT;
+  if (!fieldPath(field, request.path, "eco2")) return;
+  field.i = request.sensors.eco2;
+  stage(field);
+  if (!fieldPath(field, request.path, "tvoc")) return;
+  field.i = request.sensors.tvoc;
+  stage(field);
+}
+
+void rtdbPublisherOnline() {
+  online = true;
+  retrying = false;
+  armFlush();
+}
+
+bool handleRtdbPublisher() {
+  unsigned long dueMs;
+  if (!nextDue(dueMs)) return true;
+  unsigned long now = millis();
+  if (!isDue(dueMs, now)) return true;
+  if (retrying && !isDue(retryAtMs, now)) return true;
+  retrying = !flush();
+  retryAtMs = now + PUBLISH_RETRY_MS;
+  return !retrying;
+}
+
+unsigned long rtdbPublisherDueInMs() {
+  unsigned long dueMs;
+  if (!nextDue(dueMs)) return PUBLISH_LAZY_MS;
+  unsigned long now = millis();
+  if (retrying && (long)(retryAtMs - dueMs) > 0) dueMs = retryAtMs;
+  return isDue(dueMs, now) ? 0 : dueMs - now;
+}
+
+bool rtdbUpdateNode(FirebaseJson& json) {
+  bool ok = flush(json);
+  if (ok) retrying = false;
+  armFlush();
+  return ok;
+}
+
+size_t rtdbPublisherStaged() {
+  return stagedCount;
+}
+
+const PublisherStats& rtdbPublisherStats() {
+  return stats;
+}
@@ -0,0 +1,63 @@
+#ifndef RTDB_PUBLISHER_H
+#define RTDB_PUBLISHER_H
+
+#include <Arduino.h>
+#include <Firebase_ESP_Client.h>
+#include "deviceTasks.h"
+
+// Write-combining publisher for the network task. Every RTDB write is staged
+// by path, and a later write to a path replaces the staged value. When the
+// earliest deadline passes, everything staged goes out as a single multi-path
+// updateNode on the device node, so values that are not urgent ride along
+// with the ones that are:
+//
+//   PUBLISH_NOW   command results, sent once the network queue is drained
+//   PUBLISH_SOON  status changes, within PUBLISH_SOON_MS
+//   PUBLISH_LAZY  sensors and counters, within PUBLISH_LAZY_MS, which
+//                 normally means together with the heartbeat
+//
+// A failed flush keeps its values staged and is retried after
+// PUBLISH_RETRY_MS. Values written in the meantime still replace them, and
+// from the failure until the next successful flush every write also goes to
+// the flash journal in stateJournal.h, which that flush carries. The flush
+// runs on the network task's deadline queue, re-armed whenever the earliest
+// deadline changes.
+//
+// Until rtdbPublisherOnline(), while the device boots without the cloud, a
+// flush sends nothing and counts as failed, so writes are journaled.
+
+#define PUBLISH_SLOTS 14 // room for the five sensor fields besides the status
+#define PUBLISH_SOON_MS 1000
+#define PUBLISH_LAZY_MS 30000
+#define PUBLISH_RETRY_MS 5000
+
+struct PublisherStats {
+  unsigned long staged;    // values handed to rtdbPublish()
+  unsigned long coalesced; // values that replaced a staged one
+  unsigned long flushes;   // updateNode requests sent
+  unsigned long failures;
+  unsigned long journaled; // values appended to the journal
+  unsigned long replays;   // journals carried by a successful flush
+};
+
+// Also picks up a journal left from before a restart, flushed first thing.
+void initRtdbPublisher(const String& devicePath);
+// The stream is open: what is staged and journaled goes out now.
+void rtdbPublisherOnline();
+// Stages a write request; NET_SENSORS is staged as its fields, three or,
+// with air quality, five.
+void rtdbPublish(const NetRequest& request);
+// Flushes when a deadline has passed. Returns false if the flush failed.
+bool handleRtdbPublisher();
+// Sends `json` (keys below the device node) right away in one updateNode,
+// and takes everything staged along. Returns false if it failed; staged
+// values then stay staged.
+bool rtdbUpdateNode(FirebaseJson& json);
+// Milliseconds until the next flush is due, or PUBLISH_LAZY_MS when idle.
+unsigned long rtdbPublisherDueInMs();
+// Sets the value a write request carries in `json`, keyed below the device node.
+void setPublishValue(FirebaseJson& json, const NetRequest& request);
+size_t rtdbPublisherStaged();
+const PublisherStats& rtdbPublisherStats();
+
+#endif
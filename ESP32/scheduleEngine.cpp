@@ -0,0 +1,184 @@
+#include "scheduleEngine.h"
+#include "command.h"
+#include "deadlines.h"
+#include "log.h"
+
+struct MinuteRange {
+  uint16_t start;
+  uint16_t end; // exclusive, may be SCHEDULE_WEEK_MINUTES
+};
+
+static ScheduleEvent events[SCHEDULE_MAX_EVENTS];
+static uint8_t eventCount = 0;
+static bool alwaysOn = false;
+static bool catchUp = false;
+static int lastMinute = -1;
+static unsigned long nextCheckMs = 0;
+static Deadline scheduleDeadline = {"schedule", handleSchedule};
+
+static void checkAgainIn(unsigned long ms) {
+  nextCheckMs = millis() + ms;
+  armDeadline(controlDeadlines, scheduleDeadline, ms);
+}
+
+static int hhmmToMinutes(int hhmm) {
+  int hours = hhmm / 100;
+  int minutes = hhmm % 100;
+  if (hhmm < 0 || hours > 24 || minutes > 59 || (hours == 24 && minutes != 0)) return -1;
+  return hours * 60 + minutes;
+}
+
+static void addRange(MinuteRange* ranges, uint8_t& count, int start, int end) {
+  if (end <= SCHEDULE_WEEK_MINUTES) {
+    ranges[count++] = {(uint16_t)start, (uint16_t)end};
+    return;
+  }
+  // Saturday night into Sunday morning.
+  ranges[count++] = {(uint16_t)start, SCHEDULE_WEEK_MINUTES};
+  ranges[count++] = {0, (uint16_t)(end - SCHEDULE_WEEK_MINUTES)};
+}
+
+void compileSchedule(const WeeklySchedule& week) {
+  const DaySchedule* days[] = {&week.sun, &week.mon, &week.tue, &week.wed, &week.thu, &week.fri, &week.sat};
+  MinuteRange ranges[SCHEDULE_MAX_EVENTS];
+  uint8_t rangeCount = 0;
+  for (int d = 0; d < 7; d++) {
+    if (!days[d]->active) continue;
+    for (uint8_t i = 0; i < days[d]->count && i < SCHEDULE_MAX_INTERVALS; i++) {
+      int start = hhmmToMinutes(days[d]->intervals[i].start);
+      int end = hhmmToMinutes(days[d]->intervals[i].end);
+      if (start < 0 || start == 24 * 60 || end < 0) {
+        LOGF_WARN("⚠️ Ignoring schedule interval %d-%d on day %d", days[d]->intervals[i].start,
+             days[d]->intervals[i].end, d);
+        continue;
+      }
+      if (end <= start) end += 24 * 60; // runs past midnight
+      addRange(ranges, rangeCount, d * 24 * 60 + start, d * 24 * 60 + end);
+    }
+  }
+
+  // Sort by start (insertion sort, at most a few dozen ranges) and merge.
+  for (uint8_t i = 1; i < rangeCount; i++) {
+    MinuteRange r = ranges[i];
+    uint8_t j = i;
+    for (; j > 0 && ranges[j - 1].start > r.start; j--) ranges[j] = ranges[j - 1];
+    ranges[j] = r;
+  }
+  uint8_t merged = 0;
+  for (uint8_t i = 0; i < rangeCount; i++) {
+    if (merged > 0 && ranges[i].start <= ranges[merged - 1].end) {
+      if (ranges[i].end > ranges[merged - 1].end) ranges[merged - 1].end = ranges[i].end;
+    } else {
+      ranges[merged++] = ranges[i];
+    }
+  }
+
+  alwaysOn = merged == 1 && ranges[0].start == 0 && ranges[0].end == SCHEDULE_WEEK_MINUTES;
+  eventCount = 0;
+  if (!alwaysOn) {
+    // A span that covers the week boundary has no transition there. Its
+    // Sunday-morning end still sorts first, before every start.
+    bool wraps = merged > 1 && ranges[0].start == 0 && ranges[merged - 1].end == SCHEDULE_WEEK_MINUTES;
+    for (uint8_t i = 0; i < merged; i++) {
+      if (!(wraps && i == 0)) events[eventCount++] = {ranges[i].start, true};
+      if (!(wraps && i == merged - 1)) events[eventCount++] = {(uint16_t)(ranges[i].end % SCHEDULE_WEEK_MINUTES), false};
+    }
+  }
+  catchUp = true;
+  checkAgainIn(0);
+  LOGF("📅 Schedule compiled: %u transitions", eventCount);
+}
+
+// True if the last transition at or before `minute` switched on.
+static bool scheduledOnAt(int minute) {
+  if (alwaysOn) return true;
+  if (eventCount == 0) return false;
+  int last = eventCount - 1; // before the first event of the week: last one of the previous week
+  for (uint8_t i = 0; i < eventCount && events[i].minute <= minute; i++) last = i;
+  return events[last].on;
+}
+
+static void fireTransition(bool on) {
+  if (on) {
+    LOG_INFO("Schedule Started");
+    if (acPowered) return;
+    if (mode == MODE_TIMER) {
+      mode = MODE_REGULAR;
+      notifyUser("reset_mode");
+    }
+    execute(ACTION_SWITCH_POWER);
+    notifyUser("system_switch_power");
+  } else {
+    LOG_INFO("Schedule Ended");
+    ecoCanTurnOn = false;
+    if (!acPowered) return;
+    execute(ACTION_SWITCH_POWER);
+    notifyUser("system_switch_power");
+  }
+}
+
+// Fires the transitions in (from, to], wrapping at the end of the week.
+static void fireBetween(int from, int to) {
+  for (uint8_t i = 0; i < eventCount; i++) {
+    int m = events[i].minute;
+    bool inRange = from <= to ? (m > from && m <= to) : (m > from || m <= to);
+    if (inRange) fireTransition(events[i].on);
+  }
+}
+
+// Seconds until the first transition after `minute`, from `second` into it.
+static unsigned long secondsToNextEvent(int minute, int second) {
+  if (eventCount == 0) return SCHEDULE_RESYNC_MS / 1000;
+  int next = -1;
+  for (uint8_t i = 0; i < eventCount; i++) {
+    if (events[i].minute > minute) {
+      next = events[i].minute;
+      break;
+    }
+  }
+  int delta = next >= 0 ? next - minute : events[0].minute + SCHEDULE_WEEK_MINUTES - minute;
+  return (unsigned long)delta * 60 - second;
+}
+
+void handleSchedule() {
+  unsigned long nowMs = millis();
+  if ((long)(nowMs - nextCheckMs) < 0) return;
+
+  struct tm now;
+  if (!getLocalTime(&now, 0) || now.tm_year < 120) {
+    checkAgainIn(1000); // no valid time yet
+    return;
+  }
+  int minute = now.tm_wday * 24 * 60 + now.tm_hour * 60 + now.tm_min;
+  if (catchUp) {
+    catchUp = false;
+    if (scheduledOnAt(minute)) fireTransition(true);
+  } else if (lastMinute >= 0 && minute != lastMinute) {
+    int elapsed = (minute - lastMinute + SCHEDULE_WEEK_MINUTES) % SCHEDULE_WEEK_MINUTES;
+    if (elapsed <= SCHEDULE_MAX_CATCHUP_MIN) {
+      fireBetween(lastMinute, minute);
+    } else {
+      LOGF_WARN("⚠️ Clock moved %d minutes, schedule re-anchored", elapsed);
+    }
+  }
+  lastMinute = minute;
+
+  // Sleep until a second before the transition, then poll every
+  // SCHEDULE_EDGE_POLL_MS so it fires as soon as the minute turns over.
+  unsigned long seconds = secondsToNextEvent(minute, now.tm_sec);
+  unsigned long sleepMs = seconds > 1 ? (seconds - 1) * 1000UL : SCHEDULE_EDGE_POLL_MS;
+  checkAgainIn(min(sleepMs, SCHEDULE_RESYNC_MS));
+}
+
+unsigned long scheduleDueInMs() {
+  long left = (long)(nextCheckMs - millis());
+  return left > 0 ? (unsigned long)left : 0;
+}
+
+uint8_t scheduleEventCount() {
+  return eventCount;
+}
+
+const ScheduleEvent* scheduleEvents() {
+  return events;
+}
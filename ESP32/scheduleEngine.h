@@ -0,0 +1,33 @@
+#ifndef SCHEDULE_ENGINE_H
+#define SCHEDULE_ENGINE_H
+
+#include <Arduino.h>
+#include "FirestoreServices.h"
+
+// The weekly schedule compiled into a sorted list of on/off transitions, in
+// minutes since Sunday 00:00 local time. Overlapping intervals are merged and
+// an interval whose end is not after its start runs past midnight (Saturday
+// night wraps into Sunday). handleSchedule() runs on a control deadline set
+// for when the next transition is due, and fires it within
+// SCHEDULE_EDGE_POLL_MS of the minute turning over.
+
+#define SCHEDULE_MAX_EVENTS (7 * SCHEDULE_MAX_INTERVALS * 2)
+#define SCHEDULE_WEEK_MINUTES (7 * 24 * 60)
+#define SCHEDULE_RESYNC_MS (10 * 60 * 1000UL) // re-reads the clock at least this often
+#define SCHEDULE_MAX_CATCHUP_MIN 15           // larger clock jumps skip the transitions in between
+#define SCHEDULE_EDGE_POLL_MS 10              // clock reads in the last second before a transition
+
+struct ScheduleEvent {
+  uint16_t minute; // of the week, Sunday 00:00 = 0
+  bool on;
+};
+
+// Replaces the transitions. If the AC should be on right now, the next
+// handleSchedule() turns it on, as a schedule edge would.
+void compileSchedule(const WeeklySchedule& week);
+void handleSchedule(); // control task
+unsigned long scheduleDueInMs();
+uint8_t scheduleEventCount();
+const ScheduleEvent* scheduleEvents();
+
+#endif
@@ -0,0 +1,78 @@
+#include "sensorFilter.h"
+
+int32_t sensorFixed(float value) {
+  return lroundf(value * 100);
+}
+
+// x / 256, to the nearest, halves away from zero.
+static int32_t roundQ8(int64_t x) {
+  return (int32_t)(x >= 0 ? (x + 128) / 256 : (x - 128) / 256);
+}
+
+void resetSensorFilter(SensorFilter& filter) {
+  const SensorFilterConfig* config = filter.config;
+  filter = SensorFilter();
+  filter.config = config;
+}
+
+static void start(SensorFilter& filter, int32_t value) {
+  for (uint8_t i = 0; i < SENSOR_MEDIAN_MAX; i++) filter.window[i] = value;
+  filter.next = 0;
+  filter.emaQ8 = value * 256;
+  filter.filtered = value;
+  filter.reported = value;
+  filter.valid = true;
+}
+
+static int32_t median(SensorFilter& filter, int32_t value) {
+  uint8_t n = filter.config->median;
+  if (n <= 1) return value;
+  filter.window[filter.next] = value;
+  filter.next = (filter.next + 1) % n;
+  int32_t sorted[SENSOR_MEDIAN_MAX];
+  for (uint8_t i = 0; i < n; i++) {
+    int32_t v = filter.window[i];
+    uint8_t j = i;
+    for (; j > 0 && sorted[j - 1] > v; j--) sorted[j] = sorted[j - 1];
+    sorted[j] = v;
+  }
+  return sorted[n / 2];
+}
+
+static int32_t ema(SensorFilter& filter, int32_t value) {
+  filter.emaQ8 += roundQ8((int64_t)(value * 256 - filter.emaQ8) * filter.config->emaWeight);
+  return roundQ8(filter.emaQ8);
+}
+
+static int32_t rateLimit(const SensorFilter& filter, int32_t value) {
+  int32_t step = filter.config->maxStep;
+  if (step == 0) return value;
+  return constrain(value, filter.filtered - step, filter.filtered + step);
+}
+
+bool filterReading(SensorFilter& filter, float reading) {
+  const SensorFilterConfig& config = *filter.config;
+  int32_t value = isnan(reading) ? 0 : sensorFixed(reading);
+  if (isnan(reading) || value < config.min || value > config.max) {
+    filter.rejected++;
+    if (filter.faults < SENSOR_FAULT_LIMIT && ++filter.faults == SENSOR_FAULT_LIMIT) filter.valid = false;
+    return false;
+  }
+  filter.faults = 0;
+  if (!filter.valid) {
+    start(filter, value);
+    return true;
+  }
+  filter.filtered = rateLimit(filter, ema(filter, median(filter, value)));
+  if (filter.filtered == filter.reported || abs(filter.filtered - filter.reported) < config.band) return false;
+  filter.reported = filter.filtered;
+  return true;
+}
+
+float filteredValue(const SensorFilter& filter) {
+  return filter.valid ? filter.filtered / 100.0f : NAN;
+}
+
+float reportedValue(const SensorFilter& filter) {
+  return filter.valid ? filter.reported / 100.0f : NAN;
+}
@@ -0,0 +1,55 @@
+#ifndef SENSOR_FILTER_H
+#define SENSOR_FILTER_H
+
+#include <Arduino.h>
+
+// The path of a DHT reading to the value the device reports, in fixed point
+// (hundredths of a degree or a percent), one stage after another:
+//
+//   fault      a failed read (NaN) or one outside [min, max] is dropped;
+//              after SENSOR_FAULT_LIMIT in a row the value is lost and the
+//              next good read starts the filter over
+//   median     of the last `median` good reads, which removes single glitches
+//   ema        weight `emaWeight`/256 for the new value
+//   rate       at most `maxStep` per read, for what gets past the median
+//   hysteresis the reported value follows only once the filtered one has
+//              moved `band` away from it
+//
+// A stage whose parameter is 1 (median), 256 (emaWeight) or 0 (maxStep,
+// band) passes its input through. A filter is a SensorFilter initialised
+// with its config, the rest zero; it is used from one task.
+
+#define SENSOR_MEDIAN_MAX 7
+#define SENSOR_FAULT_LIMIT 12 // a minute of reads
+
+struct SensorFilterConfig {
+  int32_t min;       // hundredths
+  int32_t max;
+  uint8_t median;    // odd, up to SENSOR_MEDIAN_MAX
+  uint16_t emaWeight;
+  int32_t maxStep;
+  int32_t band;
+};
+
+struct SensorFilter {
+  const SensorFilterConfig* config = nullptr;
+  int32_t window[SENSOR_MEDIAN_MAX] = {};
+  uint8_t next = 0;
+  int32_t emaQ8 = 0;    // hundredths << 8, so small steps are not rounded away
+  int32_t filtered = 0;
+  int32_t reported = 0;
+  bool valid = false;   // `filtered` and `reported` hold a value
+  uint8_t faults = 0;   // in a row
+  unsigned long rejected = 0;
+};
+
+// Runs one reading through the stages; true if the reported value changed.
+bool filterReading(SensorFilter& filter, float reading);
+void resetSensorFilter(SensorFilter& filter);
+
+int32_t sensorFixed(float value);
+// The filtered and the reported value as floats, NAN while there is none.
+float filteredValue(const SensorFilter& filter);
+float reportedValue(const SensorFilter& filter);
+
+#endif
@@ -0,0 +1,361 @@
+#include <LittleFS.h>
+#include <base64.h>
+#include <Firebase_ESP_Client.h>
+#include <freertos/queue.h>
+#include "sensorHistory.h"
+#include "rtdbPublisher.h"
+#include "deviceTasks.h"
+#include "parameters.h"
+#include "log.h"
+
+struct HistoryBlock {
+  uint16_t len;
+  uint8_t bytes[HISTORY_BLOCK_BYTES];
+};
+
+// Sensor task: the open block, closed blocks waiting for upload, and the
+// running mean for the next sample.
+static HistoryBlock openBlock;
+static HistoryBlock ring[HISTORY_RAM_BLOCKS];
+static uint8_t ringHead = 0;
+static uint8_t ringCount = 0;
+static uint32_t expectedEpoch = 0;
+static int16_t lastTemp = 0;
+static uint8_t lastHum = 0;
+static float tempSum = 0;
+static float humSum = 0;
+static uint8_t reads = 0;
+static bool motionSeen = false;
+static uint8_t flashFiles = 0;
+static bool lastUploadOk = true;
+static bool catchingUp = false; // flash files went up; RAM goes next
+static HistoryStats stats;
+
+// Handed to the network task with NET_HISTORY and left alone until it
+// answers on uploadAcks.
+static HistoryBlock outbox[HISTORY_RAM_BLOCKS];
+static uint8_t outboxCount = 0;
+static bool outboxBusy = false;
+static char outboxFile[32];
+static uint32_t outboxLastEpoch = 0;
+static QueueHandle_t uploadAcks = nullptr;
+
+static uint32_t getU32(const uint8_t* p) {
+  return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint16_t getU16(const uint8_t* p) {
+  return p[0] | p[1] << 8;
+}
+
+static uint32_t blockEpoch(const HistoryBlock& block) {
+  return getU32(block.bytes);
+}
+
+static uint8_t putVarint(uint8_t* out, uint32_t v) {
+  uint8_t n = 0;
+  while (v >= 0x80) {
+    out[n++] = (v & 0x7F) | 0x80;
+    v >>= 7;
+  }
+  out[n++] = v;
+  return n;
+}
+
+static bool getVarint(const uint8_t* in, size_t len, size_t& pos, uint32_t& v) {
+  v = 0;
+  for (uint8_t shift = 0; pos < len && shift < 32; shift += 7) {
+    uint8_t b = in[pos++];
+    v |= (uint32_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) return true;
+  }
+  return false;
+}
+
+static uint32_t zigzag(int32_t v) {
+  return (uint32_t)(v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t unzigzag(uint32_t v) {
+  return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+// ----------------------- Flash -----------------------
+
+static String oldestFile() {
+  String oldest;
+  File dir = LittleFS.open(HISTORY_DIR);
+  for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+    String name = f.name();
+    if (oldest.length() == 0 || name < oldest) oldest = name;
+  }
+  return oldest.length() ? String(HISTORY_DIR) + "/" + oldest : oldest;
+}
+
+static void removeFile(const String& path) {
+  if (LittleFS.remove(path) && flashFiles > 0) flashFiles--;
+}
+
+// Writes the ring as one file of length-prefixed blocks, named after its
+// first block, and empties it.
+static void spillRing() {
+  if (flashFiles >= HISTORY_FLASH_FILES) {
+    removeFile(oldestFile());
+    stats.dropped++;
+    LOG_WARN("⚠️ History flash full, oldest file dropped");
+  }
+  char path[32];
+  snprintf(path, sizeof(path), HISTORY_DIR "/%010lu", (unsigned long)blockEpoch(ring[ringHead]));
+  File file = LittleFS.open(path, FILE_WRITE);
+  if (!file) {
+    LOGF_ERROR("❌ Failed to spill history to %s", path);
+  } else {
+    for (uint8_t i = 0; i < ringCount; i++) {
+      const HistoryBlock& block = ring[(ringHead + i) % HISTORY_RAM_BLOCKS];
+      file.write((const uint8_t*)&block.len, sizeof(block.len));
+      file.write(block.bytes, block.len);
+    }
+    file.close();
+    flashFiles++;
+    stats.spills++;
+  }
+  ringHead = ringCount = 0;
+}
+
+static bool loadFile(const String& path) {
+  File file = LittleFS.open(path, FILE_READ);
+  if (!file) return false;
+  outboxCount = 0;
+  uint16_t len;
+  while (outboxCount < HISTORY_RAM_BLOCKS && file.read((uint8_t*)&len, sizeof(len)) == sizeof(len)) {
+    if (len > HISTORY_BLOCK_BYTES) break;
+    HistoryBlock& block = outbox[outboxCount];
+    block.len = file.read(block.bytes, len);
+    if (block.len != len) break;
+    outboxCount++;
+  }
+  file.close();
+  snprintf(outboxFile, sizeof(outboxFile), "%s", path.c_str());
+  return outboxCount > 0;
+}
+
+// ----------------------- Encoding -----------------------
+
+static void closeBlock() {
+  if (openBlock.len == 0) return;
+  if (ringCount == HISTORY_RAM_BLOCKS) spillRing();
+  ring[(ringHead + ringCount++) % HISTORY_RAM_BLOCKS] = openBlock;
+  openBlock.len = 0;
+  stats.blocks++;
+}
+
+static void startBlock(const HistorySample& s) {
+  uint8_t* p = openBlock.bytes;
+  uint16_t interval = HISTORY_SAMPLE_INTERVAL / 1000;
+  p[0] = s.epoch;
+  p[1] = s.epoch >> 8;
+  p[2] = s.epoch >> 16;
+  p[3] = s.epoch >> 24;
+  p[4] = interval;
+  p[5] = interval >> 8;
+  p[6] = s.tempDeci;
+  p[7] = s.tempDeci >> 8;
+  p[8] = s.humidity;
+  p[9] = s.motion;
+  openBlock.len = HISTORY_HEADER_BYTES;
+  expectedEpoch = s.epoch + interval;
+  stats.bytesEncoded += HISTORY_HEADER_BYTES;
+}
+
+static void appendSample(const HistorySample& s) {
+  stats.samples++;
+  uint32_t interval = HISTORY_SAMPLE_INTERVAL / 1000;
+  long early = (long)(expectedEpoch - s.epoch);
+  if (openBlock.len == 0 || early > (long)interval / 2) {
+    closeBlock(); // also when the clock stepped back
+    startBlock(s);
+    lastTemp = s.tempDeci;
+    lastHum = s.humidity;
+    return;
+  }
+  uint32_t skipped = early >= 0 ? 0 : (uint32_t)(-early + interval / 2) / interval;
+  int32_t dT = s.tempDeci - lastTemp;
+  int32_t dH = s.humidity - lastHum;
+  uint8_t sample[1 + 3 * 5];
+  uint8_t n = 0;
+  if (skipped == 0 && dT >= -4 && dT <= 3 && dH >= -4 && dH <= 3) {
+    sample[n++] = (s.motion ? 0x40 : 0) | (dT + 4) << 3 | (dH + 4);
+  } else {
+    sample[n++] = 0x80 | (s.motion ? 0x40 : 0) | (skipped ? 0x01 : 0);
+    if (skipped) n += putVarint(sample + n, skipped);
+    n += putVarint(sample + n, zigzag(dT));
+    n += putVarint(sample + n, zigzag(dH));
+  }
+  if (openBlock.len + n > HISTORY_BLOCK_BYTES) {
+    closeBlock();
+    startBlock(s);
+  } else {
+    memcpy(openBlock.bytes + openBlock.len, sample, n);
+    openBlock.len += n;
+    expectedEpoch += (skipped + 1) * interval;
+    stats.bytesEncoded += n;
+  }
+  lastTemp = s.tempDeci;
+  lastHum = s.humidity;
+}
+
+size_t decodeHistoryBlock(const uint8_t* block, size_t len, HistorySample* out, size_t max) {
+  if (len < HISTORY_HEADER_BYTES || max == 0) return 0;
+  HistorySample s;
+  s.epoch = getU32(block);
+  uint16_t interval = getU16(block + 4);
+  s.tempDeci = (int16_t)getU16(block + 6);
+  s.humidity = block[8];
+  s.motion = block[9];
+  size_t count = 0;
+  out[count++] = s;
+  size_t pos = HISTORY_HEADER_BYTES;
+  while (pos < len && count < max) {
+    uint8_t b = block[pos++];
+    s.motion = b & 0x40;
+    uint32_t skipped = 0;
+    if (!(b & 0x80)) {
+      s.tempDeci += ((b >> 3) & 0x07) - 4;
+      s.humidity += (b & 0x07) - 4;
+    } else {
+      uint32_t dT, dH;
+      if ((b & 0x01) && !getVarint(block, len, pos, skipped)) break;
+      if (!getVarint(block, len, pos, dT) || !getVarint(block, len, pos, dH)) break;
+      s.tempDeci += unzigzag(dT);
+      s.humidity += unzigzag(dH);
+    }
+    s.epoch += (skipped + 1) * interval;
+    out[count++] = s;
+  }
+  return count;
+}
+
+// ----------------------- Tasks -----------------------
+
+void initSensorHistory() {
+  if (uploadAcks) return;
+  uploadAcks = xQueueCreate(1, sizeof(bool));
+  if (!LittleFS.begin(true)) {
+    LOG_ERROR("❌ LittleFS mount failed, history stays in RAM");
+    return;
+  }
+  if (!LittleFS.exists(HISTORY_DIR)) LittleFS.mkdir(HISTORY_DIR);
+  File dir = LittleFS.open(HISTORY_DIR);
+  for (File f = dir.openNextFile(); f; f = dir.openNextFile()) flashFiles++;
+  if (flashFiles) LOGF("📈 %u history files waiting for upload", flashFiles);
+}
+
+// Picks up the network task's answer to the last batch.
+static void takeUploadAck() {
+  bool ok;
+  if (!outboxBusy || xQueueReceive(uploadAcks, &ok, 0) != pdTRUE) return;
+  outboxBusy = false;
+  lastUploadOk = ok;
+  if (!ok) {
+    // Keep what is waiting on flash, where a restart does not lose it.
+    if (ringCount > 0) spillRing();
+    return;
+  }
+  catchingUp = outboxFile[0] != '\0';
+  if (catchingUp) {
+    removeFile(outboxFile);
+    return;
+  }
+  // The ring may have spilled meanwhile; then the file repeats these
+  // blocks and uploads them again under the same keys.
+  while (ringCount > 0 && (long)(blockEpoch(ring[ringHead]) - outboxLastEpoch) <= 0) {
+    ringHead = (ringHead + 1) % HISTORY_RAM_BLOCKS;
+    ringCount--;
+  }
+}
+
+void noteHistoryReading(float temperature, float humidity, bool motion) {
+  motionSeen |= motion;
+  if (isnan(temperature) || isnan(humidity)) return; // failed read
+  tempSum += temperature;
+  humSum += humidity;
+  reads++;
+}
+
+void recordHistorySample() {
+  takeUploadAck();
+  uint32_t now = time(nullptr);
+  if (reads > 0 && now >= HISTORY_MIN_EPOCH) {
+    HistorySample s;
+    s.epoch = now;
+    s.tempDeci = lroundf(tempSum / reads * 10);
+    s.humidity = lroundf(humSum / reads);
+    s.motion = motionSeen;
+    appendSample(s);
+  }
+  tempSum = humSum = 0;
+  reads = 0;
+  motionSeen = false;
+  // Back online with a backlog: one batch a minute until caught up.
+  if (lastUploadOk && (flashFiles > 0 || catchingUp) && !outboxBusy) queueHistoryUpload();
+}
+
+void queueHistoryUpload() {
+  takeUploadAck();
+  if (outboxBusy) return;
+  outboxFile[0] = '\0';
+  outboxCount = 0;
+  if (flashFiles > 0) {
+    String path = oldestFile();
+    if (!loadFile(path)) {
+      removeFile(path); // unreadable; do not retry it forever
+      return;
+    }
+  } else {
+    // While uploads fail the open block keeps filling instead of closing
+    // a short block every interval.
+    if (lastUploadOk || ringCount == 0) closeBlock();
+    for (uint8_t i = 0; i < ringCount; i++) outbox[outboxCount++] = ring[(ringHead + i) % HISTORY_RAM_BLOCKS];
+  }
+  if (outboxCount == 0) return;
+  outboxLastEpoch = blockEpoch(outbox[outboxCount - 1]);
+  NetRequest request = {};
+  request.op = NET_HISTORY;
+  snprintf(request.path, sizeof(request.path), "/history");
+  outboxBusy = postNetRequest(request);
+}
+
+void uploadHistoryBatch() {
+  FirebaseJson json;
+  size_t bytes = 0;
+  for (uint8_t i = 0; i < outboxCount; i++) {
+    const HistoryBlock& block = outbox[i];
+    json.set("history/" + String((unsigned long)blockEpoch(block)), base64::encode(block.bytes, block.len));
+    bytes += block.len;
+  }
+  bool ok = rtdbUpdateNode(json);
+  if (ok) {
+    stats.uploads++;
+    stats.bytesUploaded += bytes;
+    LOGF("📈 History: %u blocks, %u bytes uploaded", outboxCount, (unsigned)bytes);
+  } else {
+    stats.failures++;
+  }
+  xQueueSend(uploadAcks, &ok, 0);
+}
+
+uint8_t historyFlashFiles() {
+  return flashFiles;
+}
+
+void resetSensorHistory() {
+  for (String path = oldestFile(); path.length() && LittleFS.remove(path);) path = oldestFile();
+  flashFiles = 0;
+  ringHead = ringCount = 0;
+  openBlock.len = 0;
+  catchingUp = false;
+}
+
+const HistoryStats& sensorHistoryStats() {
+  return stats;
+}
@@ -0,0 +1,65 @@
+#ifndef SENSOR_HISTORY_H
+#define SENSOR_HISTORY_H
+
+#include <Arduino.h>
+
+// Room history for the app. The sensor task folds its readings into one
+// sample per HISTORY_SAMPLE_INTERVAL (mean temperature and humidity, motion
+// if any read saw it) and appends it to a delta-encoded block in RAM. Every
+// HISTORY_UPLOAD_INTERVAL the closed blocks go up in a single updateNode,
+// each as /history/<epoch of its first sample> = base64 of the block:
+//
+//   header  u32 epoch, u16 interval s, i16 temperature 0.1 °C, u8 humidity %,
+//           u8 motion (little-endian)
+//   sample  0mtttHHH  motion, dT + 4 and dH + 4: both deltas within -4..3
+//           1m00000s  motion, then a varint of skipped intervals if s, then
+//                     dT and dH as zigzag varints
+//
+// A sample lands one interval after the previous one, plus any skipped.
+// Closed blocks wait in a RAM ring of HISTORY_RAM_BLOCKS. After a failed
+// upload, or when the ring is full, they spill to LittleFS as one file under
+// HISTORY_DIR, and until an upload succeeds the open block grows to
+// HISTORY_BLOCK_BYTES instead of closing every upload interval. Files go up
+// oldest first, one a minute, once uploads work again; past
+// HISTORY_FLASH_FILES the oldest is dropped.
+
+#define HISTORY_BLOCK_BYTES 256
+#define HISTORY_HEADER_BYTES 10
+#define HISTORY_RAM_BLOCKS 4
+#define HISTORY_FLASH_FILES 128
+#define HISTORY_DIR "/history"
+#define HISTORY_MIN_EPOCH 1700000000UL // before this the clock is not set yet
+
+struct HistorySample {
+  uint32_t epoch;
+  int16_t tempDeci; // 0.1 °C
+  uint8_t humidity; // %
+  bool motion;
+};
+
+struct HistoryStats {
+  unsigned long samples;
+  unsigned long blocks;       // closed blocks
+  unsigned long bytesEncoded; // headers plus samples
+  unsigned long spills;       // RAM ring written to flash
+  unsigned long dropped;      // oldest flash files removed for room
+  unsigned long uploads;
+  unsigned long failures;
+  unsigned long bytesUploaded; // encoded blocks, before base64
+};
+
+// Mounts LittleFS and picks up files spilled before a reboot.
+void initSensorHistory();
+void noteHistoryReading(float temperature, float humidity, bool motion); // sensor task; NAN if not read
+void recordHistorySample(); // sensor task, every HISTORY_SAMPLE_INTERVAL
+void queueHistoryUpload();  // sensor task, every HISTORY_UPLOAD_INTERVAL
+void uploadHistoryBatch();  // network task, for NET_HISTORY
+// Decodes up to `max` samples of an encoded block; returns how many.
+size_t decodeHistoryBlock(const uint8_t* block, size_t len, HistorySample* out, size_t max);
+uint8_t historyFlashFiles();
+// Factory reset: removes the spilled files and the blocks waiting in RAM, so
+// the next owner's node gets none of this room's history.
+void resetSensorHistory();
+const HistoryStats& sensorHistoryStats();
+
+#endif
@@ -1,9 +1,11 @@
 #include <DHT.h>
 #include <Adafruit_NeoPixel.h>
-#include "firestoreServices.h"
+#include "FirestoreServices.h"
 #include "parameters.h"
 #include "log.h"
 #include "sensors.h"
+#include "ledAnimation.h"
+#include "buzzer.h"
 
 DHT dht(DHTPIN, DHTTYPE);
 
@@ -11,7 +13,6 @@ Adafruit_NeoPixel strip(LED_PIXELS_NUM, LED_PIN, NEO_GRB + NEO_KHZ800);
 
 void initSensors(){
   pinMode(PIRPIN, INPUT);
-  pinMode(BUZZER, OUTPUT);
   pinMode(RELAY_PIN, OUTPUT);
   pinMode(RESET_BUTTON_PIN, INPUT_PULLUP);
   digitalWrite(RELAY_PIN, HIGH); // Start OFF (OPEN)
@@ -19,25 +20,21 @@ void initSensors(){
   strip.begin();
   strip.clear();
   strip.show();
+  initLedAnimation(strip);
+  initBuzzer();
 }
 
 bool readMotionSensor(){
   return digitalRead(PIRPIN);
 }
 
-void buzz(){
-  tone(BUZZER, 784);
-  delay(5000);
-  noTone(BUZZER);
-}
-
 float readTemperature (){
   static bool firstRead = true;
   float currRoomTemp = dht.readTemperature();
   if (isnan(currRoomTemp)){
     if (firstRead) LOG_ERROR("❌ Failed to read room temperature");
     firstRead = false;
-    return 0.0;
+    return NAN;
   }
   firstRead = true;
   return currRoomTemp;
@@ -49,7 +46,7 @@ float readHumidity(){
   if (isnan(currRoomHumidity)){
     if(firstRead) LOG_ERROR("❌ Failed to read room humidity");
     firstRead = false;
-    return 0.0;
+    return NAN;
   }
   firstRead = true;
   return currRoomHumidity;
@@ -65,22 +62,14 @@ uint32_t chooseColor(){
   }
 }
 
+// Called before lights_on is toggled: wipes the strip on or off.
 void switchLed() {
-  uint32_t color = chooseColor();
-  for(int i=0; i<LED_PIXELS_NUM; i++){
-    strip.setPixelColor(i, lights_on ? 0 : color);
-    strip.show();
-    delay(DELAYVAL);
-  }
+  startLedAnimation(LED_EFFECT_WIPE, lights_on ? 0 : chooseColor());
 }
 
+// Blends towards the colour for the current set point; a no-op if it is already shown.
 void validateLedColor(){
-  uint32_t color = chooseColor();
-  for(int i=0; i<LED_PIXELS_NUM; i++){
-    strip.setPixelColor(i, lights_on ? color : 0);
-    strip.show();
-    delay(DELAYVAL);
-  }
+  startLedAnimation(LED_EFFECT_FADE, lights_on ? chooseColor() : 0);
 }
 
 void switchRelay() {
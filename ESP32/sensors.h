@@ -5,9 +5,9 @@
 
 void initSensors();
 bool readMotionSensor();
+// NAN when the DHT does not answer.
 float readTemperature ();
 float readHumidity();
-void buzz();
 void switchLed();
 void validateLedColor();
 void switchRelay();
@@ -0,0 +1,145 @@
+#include <LittleFS.h>
+#include "stateJournal.h"
+#include "rtdbPublisher.h"
+#include "log.h"
+
+static bool pending = false;
+static bool mounted = false;
+static NetRequest coalesced[JOURNAL_MAX_PATHS];
+
+static bool journaled(NetOp op) {
+  return op == NET_SET_STRING || op == NET_SET_BOOL || op == NET_SET_INT || op == NET_SET_FLOAT;
+}
+
+static size_t encode(const NetRequest& r, uint8_t* out) {
+  size_t n = 0;
+  uint8_t pathLen = strnlen(r.path, sizeof(r.path) - 1);
+  out[n++] = r.op;
+  out[n++] = pathLen;
+  memcpy(out + n, r.path, pathLen);
+  n += pathLen;
+  switch (r.op) {
+    case NET_SET_STRING: {
+      uint8_t len = strnlen(r.s, sizeof(r.s) - 1);
+      out[n++] = len;
+      memcpy(out + n, r.s, len);
+      n += len;
+      break;
+    }
+    case NET_SET_BOOL: out[n++] = r.b; break;
+    case NET_SET_INT: memcpy(out + n, &r.i, sizeof(r.i)); n += sizeof(r.i); break;
+    case NET_SET_FLOAT: memcpy(out + n, &r.f, sizeof(r.f)); n += sizeof(r.f); break;
+    default: break;
+  }
+  return n;
+}
+
+static bool readRecord(File& file, NetRequest& r) {
+  uint8_t head[2];
+  if (file.read(head, 2) != 2 || !journaled((NetOp)head[0]) || head[1] >= sizeof(r.path)) return false;
+  r = {};
+  r.op = (NetOp)head[0];
+  if (file.read((uint8_t*)r.path, head[1]) != head[1]) return false;
+  switch (r.op) {
+    case NET_SET_STRING: {
+      int len = file.read();
+      return len >= 0 && len < (int)sizeof(r.s) && file.read((uint8_t*)r.s, len) == (size_t)len;
+    }
+    case NET_SET_BOOL: {
+      int b = file.read();
+      r.b = b == 1;
+      return b >= 0;
+    }
+    case NET_SET_INT: return file.read((uint8_t*)&r.i, sizeof(r.i)) == sizeof(r.i);
+    case NET_SET_FLOAT: return file.read((uint8_t*)&r.f, sizeof(r.f)) == sizeof(r.f);
+    default: return false;
+  }
+}
+
+static bool append(File& file, const NetRequest& r) {
+  uint8_t record[2 + sizeof(r.path) + 1 + sizeof(r.s)];
+  size_t n = encode(r, record);
+  return file.write(record, n) == n;
+}
+
+// Rewrites the journal with one record per path; the rename replaces the
+// old file only once the new one is complete.
+static void compact() {
+  size_t n = loadJournal(coalesced, JOURNAL_MAX_PATHS);
+  File file = LittleFS.open(JOURNAL_TMP_FILE, FILE_WRITE);
+  if (!file) return;
+  bool ok = true;
+  for (size_t i = 0; i < n && ok; i++) ok = append(file, coalesced[i]);
+  file.close();
+  if (ok && LittleFS.rename(JOURNAL_TMP_FILE, JOURNAL_FILE)) return;
+  LittleFS.remove(JOURNAL_TMP_FILE);
+  LOG_WARN("⚠️ Journal compaction failed");
+}
+
+void initStateJournal() {
+  mounted = LittleFS.begin(true);
+  if (!mounted) {
+    LOG_ERROR("❌ LittleFS mount failed, state writes are not journaled");
+    return;
+  }
+  pending = LittleFS.exists(JOURNAL_FILE);
+  if (pending) LOGF("📓 Journal from before the restart: %u values", (unsigned)loadJournal(coalesced, JOURNAL_MAX_PATHS));
+}
+
+void journalWrite(const NetRequest& request) {
+  if (!mounted || request.transient || !journaled(request.op)) return;
+  File file = LittleFS.open(JOURNAL_FILE, FILE_APPEND);
+  if (!file) return;
+  bool ok = append(file, request);
+  size_t size = file.size();
+  file.close();
+  if (!ok) {
+    LOGF_ERROR("❌ Failed to journal %s", request.path);
+    return;
+  }
+  pending = true;
+  if (size > JOURNAL_COMPACT_BYTES) compact();
+}
+
+bool journalPending() {
+  return pending;
+}
+
+size_t loadJournal(NetRequest* out, size_t max) {
+  File file = LittleFS.open(JOURNAL_FILE, FILE_READ);
+  if (!file) return 0;
+  size_t n = 0;
+  NetRequest r;
+  while (readRecord(file, r)) {
+    size_t i = 0;
+    while (i < n && strcmp(out[i].path, r.path) != 0) i++;
+    if (i < n) {
+      out[i] = r;
+    } else if (n < max) {
+      out[n++] = r;
+    } else {
+      LOGF_WARN("⚠️ Journal holds more than %u paths, %s skipped", (unsigned)max, r.path);
+    }
+  }
+  file.close();
+  return n;
+}
+
+void addJournalTo(FirebaseJson& json) {
+  if (!pending) return;
+  size_t n = loadJournal(coalesced, JOURNAL_MAX_PATHS);
+  for (size_t i = 0; i < n; i++) setPublishValue(json, coalesced[i]);
+}
+
+void clearJournal() {
+  if (pending) LittleFS.remove(JOURNAL_FILE);
+  pending = false;
+}
+
+void resetStateJournal() {
+  if (!mounted) return;
+  mounted = false;
+  LittleFS.remove(JOURNAL_FILE);
+  LittleFS.remove(JOURNAL_TMP_FILE);
+  pending = false;
+}
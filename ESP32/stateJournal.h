@@ -0,0 +1,41 @@
+#ifndef STATE_JOURNAL_H
+#define STATE_JOURNAL_H
+
+#include <Arduino.h>
+#include <Firebase_ESP_Client.h>
+#include "deviceTasks.h"
+
+// Flash copy of the state writes the cloud has not acknowledged yet, so that
+// a dropped connection or a restart does not lose what local automation
+// changed meanwhile. The publisher (rtdbPublisher.h) starts journaling when
+// a flush fails, and from then on appends every write that is not
+// transient. The next successful flush carries the journal, coalesced to
+// the last value per path, and removes it.
+//
+// The journal is one append-only LittleFS file of records:
+//
+//   u8 op, u8 path length, path, value (bool 1 byte, int 8, float 4,
+//   string u8 length + bytes)
+//
+// Once it passes JOURNAL_COMPACT_BYTES it is rewritten with one record per
+// path. A journal found at boot is laid over the device node before the
+// last state is restored, and goes up with the first flush.
+
+#define JOURNAL_FILE "/journal.log"
+#define JOURNAL_TMP_FILE "/journal.tmp"
+#define JOURNAL_COMPACT_BYTES 1024
+#define JOURNAL_MAX_PATHS 24
+
+void initStateJournal();
+void journalWrite(const NetRequest& request); // network task
+bool journalPending();
+// Latest value per journaled path, in order of first write; returns how many.
+size_t loadJournal(NetRequest* out, size_t max);
+// Sets every journaled value in `json`, keyed below the device node.
+void addJournalTo(FirebaseJson& json);
+void clearJournal();
+// Factory reset: removes the journal, so the next owner's node is not
+// overwritten with this one's state, and journals nothing until restart.
+void resetStateJournal();
+
+#endif